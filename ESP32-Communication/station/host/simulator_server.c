@@ -0,0 +1,464 @@
+/* Stand-in for server.py, for load testing many stations on one Linux box.
+ * Speaks the same protocol (rni/rql/rlc -> pni/par/plc) over TCP, serves every connection from one epoll
+ * loop, takes amperage from a load profile and answers rlc with the native load flow (grid/loadflow.c).
+ * Requests end in ';' (or '\n'), a request split over several segments is handled once its end arrived.
+ * "sub,<node id>" subscribes a connection to its node: the current reading is replied right away, and a new
+ * "par" is pushed whenever the reading changes.
+ *
+ * Usage: simulator_server [-p port] [-f load_profile.csv] [-r]
+ *   -p  TCP port (default 6666, same as server.py)
+ *   -f  load profile. One row per line: "seconds,amp_node2,amp_node3,amp_node4,amp_node5,amp_node6".
+ *       A row is active from its seconds until the next row. The last row lasts one second, then the profile loops.
+ *       Without a profile the load from server.py is used: [0, -5, 0, 25, 15]
+ *   -r  hand out node ids round robin when all nodes are taken, instead of -1 (for more stations than nodes)
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "grid/loadflow.h"
+#include "grid/estimate_cache.h"
+
+#define SERVER_PORT 6666
+#define MAX_EVENTS 256
+#define SUBSCRIPTION_CHECK_MS 100   // How often the load profile is checked for changed readings
+#define RX_BUFFER_SIZE 1024
+#define TX_BUFFER_SIZE 1024
+
+#define PROFILE_MAX_ROWS 1024
+#define PROFILE_NODES 5     // Nodes 2 to 6, same as GridSimulator.I_amperage
+#define PROFILE_FIRST_NODE 2
+
+typedef struct connection_t {
+    int fd;
+    int node_id;
+    int subscribed_node_id;     // -1 if not subscribed
+    fixed_t pushed_amperage;    // Last reading sent to a subscribed connection
+    struct connection_t *previous;
+    struct connection_t *next;
+    size_t rx_length;
+    char rx_buffer[RX_BUFFER_SIZE];
+    size_t tx_length;
+    char tx_buffer[TX_BUFFER_SIZE];
+} connection_t;
+
+typedef struct {
+    double seconds;
+    double amperage[PROFILE_NODES];
+} profile_row_t;
+
+static profile_row_t profile[PROFILE_MAX_ROWS] = { {0, {0, -5, 0, 25, 15}} };
+static int profile_rows = 1;
+
+// Same order as GridSimulator.available_nodes
+static const int simulator_nodes[] = {3, 5, 6};
+#define SIMULATOR_NODE_AMOUNT (int)(sizeof(simulator_nodes) / sizeof(simulator_nodes[0]))
+static bool node_taken[SIMULATOR_NODE_AMOUNT];
+static bool round_robin_nodes = false;
+static int next_round_robin_node = 0;
+
+// All open connections, so readings can be pushed to the subscribed ones
+static connection_t *connections = NULL;
+
+static grid_system_t grid_system;
+static estimate_cache_t estimate_cache;
+static struct timespec start_time;
+
+static unsigned long connection_amount = 0;
+static unsigned long request_amount = 0;
+static unsigned long push_amount = 0;
+static volatile sig_atomic_t running = 1;
+
+static void handle_signal(int signal_number) {
+    (void)signal_number;
+    running = 0;
+}
+
+static double elapsed_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start_time.tv_sec) + (now.tv_nsec - start_time.tv_nsec) / 1e9;
+}
+
+static int load_profile(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        perror("Could not open load profile");
+        return -1;
+    }
+
+    char line[256];
+    profile_rows = 0;
+    while (fgets(line, sizeof(line), file) != NULL && profile_rows < PROFILE_MAX_ROWS) {
+        profile_row_t *row = &profile[profile_rows];
+        if (sscanf(line, "%lf,%lf,%lf,%lf,%lf,%lf", &row->seconds, &row->amperage[0], &row->amperage[1], &row->amperage[2], &row->amperage[3], &row->amperage[4]) == 6) {
+            profile_rows++;
+        }
+    }
+    fclose(file);
+
+    if (profile_rows == 0) {
+        fprintf(stderr, "Load profile %s has no rows\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+// The profile row active right now
+static const profile_row_t *current_profile_row(void) {
+    double period = profile[profile_rows - 1].seconds + 1;
+    double t = elapsed_seconds();
+    t -= period * (long)(t / period);
+
+    const profile_row_t *row = &profile[0];
+    for (int i = 1; i < profile_rows && profile[i].seconds <= t; i++) {
+        row = &profile[i];
+    }
+    return row;
+}
+
+static fixed_t get_amperage_by_node(int node_id) {
+    if (node_id < PROFILE_FIRST_NODE || node_id >= PROFILE_FIRST_NODE + PROFILE_NODES) {
+        return 0;
+    }
+    return fixed_from_double(current_profile_row()->amperage[node_id - PROFILE_FIRST_NODE]);
+}
+
+// "par,<amperage>;" with the decimals of the reading, server.py sends the float as well
+static void format_amperage_reply(char *reply, size_t size, fixed_t amperage) {
+    char text[FIXED_TEXT_SIZE];
+    fixed_format(amperage, FIXED_DECIMALS, text, sizeof(text));
+    snprintf(reply, size, "par,%s;", text);
+}
+
+static int get_node_id(connection_t *connection) {
+    if (connection->node_id != -1) {
+        return connection->node_id;
+    }
+    for (int i = 0; i < SIMULATOR_NODE_AMOUNT; i++) {
+        if (!node_taken[i]) {
+            node_taken[i] = true;
+            connection->node_id = simulator_nodes[i];
+            return connection->node_id;
+        }
+    }
+    if (round_robin_nodes) {
+        return simulator_nodes[next_round_robin_node++ % SIMULATOR_NODE_AMOUNT];
+    }
+    return -1;
+}
+
+static void release_node_id(connection_t *connection) {
+    for (int i = 0; i < SIMULATOR_NODE_AMOUNT; i++) {
+        if (simulator_nodes[i] == connection->node_id) {
+            node_taken[i] = false;
+        }
+    }
+}
+
+static fixed_t estimate_grid(fixed_t amp1, fixed_t amp2, fixed_t amp3, int buyer_index, int seller_index, fixed_t offer) {
+    // Same mapping as server.py: amps_from_esp = [0, amp1, 0, amp2, amp3] for nodes 2 to 6
+    fixed_t load[GRID_MAX_NODES] = {0};
+    load[3] = amp1;
+    load[5] = amp2;
+    load[6] = amp3;
+
+    estimate_cache_key_t key;
+    fixed_t estimate;
+    estimate_cache_make_key(&key, load, buyer_index, seller_index, offer);
+    if (estimate_cache_lookup(&estimate_cache, &key, &estimate)) {
+        return estimate;
+    }
+
+    estimate = loadflow_grid_estimate(&grid_system, load, buyer_index, seller_index, offer);
+    estimate_cache_insert(&estimate_cache, &key, estimate);
+    return estimate;
+}
+
+static int queue_reply(connection_t *connection, const char *reply) {
+    size_t length = strlen(reply);
+    if (connection->tx_length + length > TX_BUFFER_SIZE) {
+        return -1;  // The station does not read its replies
+    }
+    memcpy(connection->tx_buffer + connection->tx_length, reply, length);
+    connection->tx_length += length;
+    return 0;
+}
+
+// Handles one request. Returns -1 if the connection should be closed.
+static int handle_request(connection_t *connection, char *request) {
+    char reply[64];
+    request_amount++;
+
+    if (strncmp(request, "rni", 3) == 0) {
+        snprintf(reply, sizeof(reply), "pni,%d;", get_node_id(connection));
+    } else if (strncmp(request, "rql,", 4) == 0) {
+        format_amperage_reply(reply, sizeof(reply), get_amperage_by_node(atoi(request + 4)));
+    } else if (strncmp(request, "sub,", 4) == 0) {
+        connection->subscribed_node_id = atoi(request + 4);
+        connection->pushed_amperage = get_amperage_by_node(connection->subscribed_node_id);
+        format_amperage_reply(reply, sizeof(reply), connection->pushed_amperage);
+    } else if (strncmp(request, "rlc,", 4) == 0) {
+        // Parsed with the same fixed point code as the stations: amp1,amp2,amp3,buyer,seller,offer
+        const char *fields[6];
+        int field_amount = 0;
+        char *save = NULL;
+        for (char *field = strtok_r(request + 4, ",", &save); field != NULL && field_amount < 6; field = strtok_r(NULL, ",", &save)) {
+            fields[field_amount++] = field;
+        }
+        fixed_t amp1, amp2, amp3, offer;
+        if (field_amount != 6 || fixed_parse(fields[0], &amp1) != 0 || fixed_parse(fields[1], &amp2) != 0
+            || fixed_parse(fields[2], &amp3) != 0 || fixed_parse(fields[5], &offer) != 0) {
+            fprintf(stderr, "Invalid rlc request <%s>\n", request);
+            return -1;
+        }
+        char estimate[FIXED_TEXT_SIZE];
+        fixed_format(estimate_grid(amp1, amp2, amp3, atoi(fields[3]), atoi(fields[4]), offer), FIXED_DECIMALS, estimate, sizeof(estimate));
+        snprintf(reply, sizeof(reply), "plc,%s;", estimate);
+    } else {
+        // Punishment, same as server.py: close the connection
+        fprintf(stderr, "Invalid header <%.3s> received.\n", request);
+        return -1;
+    }
+
+    return queue_reply(connection, reply);
+}
+
+// Handles every complete request in the receive buffer. The start of a request whose end has not arrived yet
+// is kept for the next read. Returns -1 if the connection should be closed.
+static int handle_rx_buffer(connection_t *connection) {
+    size_t start = 0;
+    for (size_t i = 0; i < connection->rx_length; i++) {
+        if (connection->rx_buffer[i] == ';' || connection->rx_buffer[i] == '\n') {
+            connection->rx_buffer[i] = '\0';
+            if (i > start && handle_request(connection, connection->rx_buffer + start) != 0) {
+                return -1;
+            }
+            start = i + 1;
+        }
+    }
+
+    connection->rx_length -= start;
+    memmove(connection->rx_buffer, connection->rx_buffer + start, connection->rx_length);
+    if (connection->rx_length >= RX_BUFFER_SIZE - 1) {
+        fprintf(stderr, "Request without an end in %d bytes\n", RX_BUFFER_SIZE - 1);
+        return -1;
+    }
+    return 0;
+}
+
+static int flush_tx_buffer(connection_t *connection) {
+    while (connection->tx_length > 0) {
+        ssize_t sent = send(connection->fd, connection->tx_buffer, connection->tx_length, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+            return -1;
+        }
+        memmove(connection->tx_buffer, connection->tx_buffer + sent, connection->tx_length - sent);
+        connection->tx_length -= sent;
+    }
+    return 0;
+}
+
+static void close_connection(int epoll_fd, connection_t *connection) {
+    if (connection->previous != NULL) connection->previous->next = connection->next;
+    else connections = connection->next;
+    if (connection->next != NULL) connection->next->previous = connection->previous;
+
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+    close(connection->fd);
+    release_node_id(connection);
+    free(connection);
+}
+
+static void update_interest(int epoll_fd, connection_t *connection) {
+    struct epoll_event event = {
+        .events = EPOLLIN | (connection->tx_length > 0 ? EPOLLOUT : 0),
+        .data.ptr = connection,
+    };
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection->fd, &event);
+}
+
+static void accept_connections(int epoll_fd, int listen_fd) {
+    while (1) {
+        int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) perror("accept");
+            return;
+        }
+
+        connection_t *connection = calloc(1, sizeof(connection_t));
+        if (connection == NULL) {
+            close(fd);
+            continue;
+        }
+        connection->fd = fd;
+        connection->node_id = -1;
+        connection->subscribed_node_id = -1;
+
+        struct epoll_event event = { .events = EPOLLIN, .data.ptr = connection };
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            perror("epoll_ctl");
+            close(fd);
+            free(connection);
+            continue;
+        }
+
+        connection->next = connections;
+        if (connections != NULL) connections->previous = connection;
+        connections = connection;
+        connection_amount++;
+    }
+}
+
+static void handle_connection_event(int epoll_fd, connection_t *connection, uint32_t events) {
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        close_connection(epoll_fd, connection);
+        return;
+    }
+
+    if (events & EPOLLIN) {
+        ssize_t length = recv(connection->fd, connection->rx_buffer + connection->rx_length, RX_BUFFER_SIZE - 1 - connection->rx_length, 0);
+        if (length == 0 || (length < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+            close_connection(epoll_fd, connection);
+            return;
+        }
+        if (length > 0) {
+            connection->rx_length += length;
+            if (handle_rx_buffer(connection) != 0) {
+                flush_tx_buffer(connection);
+                close_connection(epoll_fd, connection);
+                return;
+            }
+        }
+    }
+
+    if (flush_tx_buffer(connection) != 0) {
+        close_connection(epoll_fd, connection);
+        return;
+    }
+    update_interest(epoll_fd, connection);
+}
+
+// Pushes a new reading to every subscribed connection whose node changed
+static void push_changed_readings(int epoll_fd) {
+    static const profile_row_t *previous_row = NULL;
+    const profile_row_t *row = current_profile_row();
+    if (row == previous_row) {
+        return;
+    }
+    previous_row = row;
+
+    connection_t *connection = connections;
+    while (connection != NULL) {
+        connection_t *next = connection->next;
+        if (connection->subscribed_node_id != -1) {
+            fixed_t amperage = get_amperage_by_node(connection->subscribed_node_id);
+            if (amperage != connection->pushed_amperage) {
+                char message[32];
+                format_amperage_reply(message, sizeof(message), amperage);
+                connection->pushed_amperage = amperage;
+                push_amount++;
+                if (queue_reply(connection, message) != 0 || flush_tx_buffer(connection) != 0) {
+                    close_connection(epoll_fd, connection);
+                } else {
+                    update_interest(epoll_fd, connection);
+                }
+            }
+        }
+        connection = next;
+    }
+}
+
+static int create_listen_socket(int port) {
+    int listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (listen_fd < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    int enable = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    struct sockaddr_in address = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+        .sin_port = htons(port),
+    };
+    if (bind(listen_fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(listen_fd, SOMAXCONN) != 0) {
+        perror("bind/listen");
+        close(listen_fd);
+        return -1;
+    }
+    return listen_fd;
+}
+
+int main(int argc, char *argv[]) {
+    int port = SERVER_PORT;
+    int option;
+
+    while ((option = getopt(argc, argv, "p:f:r")) != -1) {
+        switch (option) {
+        case 'p': port = atoi(optarg); break;
+        case 'f': if (load_profile(optarg) != 0) return 1; break;
+        case 'r': round_robin_nodes = true; break;
+        default:
+            fprintf(stderr, "Usage: %s [-p port] [-f load_profile.csv] [-r]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    loadflow_default_system(&grid_system);
+    estimate_cache_init(&estimate_cache);
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+    signal(SIGINT, handle_signal);
+    signal(SIGTERM, handle_signal);
+
+    int listen_fd = create_listen_socket(port);
+    if (listen_fd < 0) return 1;
+
+    int epoll_fd = epoll_create1(0);
+    struct epoll_event listen_event = { .events = EPOLLIN, .data.ptr = NULL };
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &listen_event);
+
+    printf("Server started listening on 0.0.0.0:%d (%d load profile row(s))\n", port, profile_rows);
+    fflush(stdout);
+
+    struct epoll_event events[MAX_EVENTS];
+    while (running) {
+        int event_amount = epoll_wait(epoll_fd, events, MAX_EVENTS, SUBSCRIPTION_CHECK_MS);
+        if (event_amount < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+
+        for (int i = 0; i < event_amount; i++) {
+            if (events[i].data.ptr == NULL) {
+                accept_connections(epoll_fd, listen_fd);
+            } else {
+                handle_connection_event(epoll_fd, events[i].data.ptr, events[i].events);
+            }
+        }
+
+        push_changed_readings(epoll_fd);
+    }
+
+    printf("Exiting. Connections: %lu, requests: %lu, pushed readings: %lu, estimate cache hits: %u, misses: %u, evictions: %u\n",
+        connection_amount, request_amount, push_amount, estimate_cache.metrics.hits, estimate_cache.metrics.misses, estimate_cache.metrics.evictions);
+
+    close(epoll_fd);
+    close(listen_fd);
+    return 0;
+}
@@ -0,0 +1,128 @@
+/* Host test for the binary log ring buffer. */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "diagnostics/binlog.h"
+
+static void test_write_read_format(void) {
+    binlog_record_t record;
+    char text[160];
+    binlog_reset();
+
+    assert(binlog_read(&record) == -1);
+
+    const int32_t args[BINLOG_MAX_ARGS] = {3, 5, 30};
+    assert(binlog_write_at(BINLOG_TRADE_DEAL_RECEIVED, args, 1500) == 0);
+    BINLOG(BINLOG_AMPERAGE_RECEIVED, 7, -12);
+
+    assert(binlog_read(&record) == 0);
+    assert(record.time_us == 1500);
+    assert(record.event == BINLOG_TRADE_DEAL_RECEIVED);
+    binlog_format(&record, text, sizeof(text));
+    assert(strcmp(text, "[1500 us] [BCD] Received trade deal from node 3 for 5 kW with a duration of 30 minute(s)") == 0);
+
+    // Arguments that are not given are zero
+    assert(binlog_read(&record) == 0);
+    assert(record.args[0] == 7 && record.args[1] == -12 && record.args[2] == 0);
+    assert(binlog_read(&record) == -1);
+
+    // Formatting into a small buffer truncates like snprintf
+    int length = binlog_format(&record, text, 12);
+    assert(length > 12 && strlen(text) == 11);
+
+    record.event = BINLOG_EVENT_AMOUNT;
+    binlog_format(&record, text, sizeof(text));
+    assert(strstr(text, "unknown event") != NULL);
+}
+
+static void test_full_ring_drops(void) {
+    binlog_record_t record;
+    binlog_reset();
+
+    for (int i = 0; i < BINLOG_CAPACITY; i++) {
+        assert(BINLOG(BINLOG_PHASE_ACKNOWLEDGED, i) == 0);
+    }
+    assert(BINLOG(BINLOG_PHASE_ACKNOWLEDGED, -1) == -1);
+    assert(binlog_dropped() == 1);
+
+    // Reading frees a slot, and the ring keeps its order when it wraps
+    assert(binlog_read(&record) == 0 && record.args[0] == 0);
+    assert(BINLOG(BINLOG_PHASE_ACKNOWLEDGED, BINLOG_CAPACITY) == 0);
+    for (int i = 1; i <= BINLOG_CAPACITY; i++) {
+        assert(binlog_read(&record) == 0);
+        assert(record.args[0] == i);
+    }
+    assert(binlog_read(&record) == -1);
+}
+
+#define WRITERS 4
+#define RECORDS_PER_WRITER 20000
+
+static int written[WRITERS];
+
+static void *write_many(void *arg) {
+    int writer = (int)(long)arg;
+    for (int i = 0; i < RECORDS_PER_WRITER; i++) {
+        // Retry when the ring is full, so every record has to make it through
+        while (BINLOG(BINLOG_AMPERAGE_RECEIVED, writer, i) != 0) {
+            sched_yield();
+        }
+        written[writer]++;
+    }
+    return NULL;
+}
+
+static void test_concurrent_writers(void) {
+    pthread_t threads[WRITERS];
+    int last[WRITERS];
+    int read[WRITERS];
+    int joined[WRITERS];
+    binlog_record_t record;
+    binlog_reset();
+
+    for (int i = 0; i < WRITERS; i++) {
+        written[i] = 0;
+        last[i] = -1;
+        read[i] = 0;
+        joined[i] = 0;
+        pthread_create(&threads[i], NULL, write_many, (void *)(long)i);
+    }
+
+    // Read while writing. Records of one writer must come out in order and complete
+    int running = 1;
+    while (running) {
+        running = 0;
+        for (int i = 0; i < WRITERS; i++) {
+            if (!joined[i]) joined[i] = (pthread_tryjoin_np(threads[i], NULL) == 0);
+            if (!joined[i]) running = 1;
+        }
+        while (binlog_read(&record) == 0) {
+            int writer = record.args[0];
+            assert(writer >= 0 && writer < WRITERS);
+            assert(record.args[1] > last[writer]);
+            last[writer] = record.args[1];
+            read[writer]++;
+        }
+    }
+    while (binlog_read(&record) == 0) {
+        read[record.args[0]]++;
+    }
+
+    for (int i = 0; i < WRITERS; i++) {
+        assert(written[i] == RECORDS_PER_WRITER);
+        assert(read[i] == written[i]);
+    }
+    printf("concurrent writers: %d records, %u writes dropped on a full ring\n", WRITERS * RECORDS_PER_WRITER, binlog_dropped());
+}
+
+int main(void) {
+    test_write_read_format();
+    test_full_ring_drops();
+    test_concurrent_writers();
+    printf("test_binlog: OK\n");
+    return 0;
+}
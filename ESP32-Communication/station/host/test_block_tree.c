@@ -0,0 +1,247 @@
+/* Host test for the block tree: fork choice, orphans, finality, and two stations receiving the same blocks in a
+ * different order ending up at the same head. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "blockchain/block_tree.h"
+
+#define BLOCKS 120
+
+typedef struct test_block_t {
+    char hash[BLOCK_TREE_HASH_SIZE];
+    char previous_hash[BLOCK_TREE_HASH_SIZE];
+    struct test_block_t *parent;    // Set through the link callback
+    int released;
+} test_block_t;
+
+static test_block_t blocks[BLOCKS];
+static const char base_hash[BLOCK_TREE_HASH_SIZE] = "00000000000000000000000000000000";
+static const char unknown_hash[BLOCK_TREE_HASH_SIZE] = "never arrives";
+
+static void link_block(void *block, void *parent) {
+    ((test_block_t *)block)->parent = parent;
+}
+
+static void release_block(void *block) {
+    ((test_block_t *)block)->released++;
+}
+
+// A block with its own hash, where the first byte orders blocks at the same height
+static test_block_t *make_block(int index, char order, const char previous_hash[BLOCK_TREE_HASH_SIZE]) {
+    test_block_t *block = &blocks[index];
+    memset(block, 0, sizeof(test_block_t));
+    snprintf(block->hash, BLOCK_TREE_HASH_SIZE, "%c-block-%i", order, index);
+    memcpy(block->previous_hash, previous_hash, BLOCK_TREE_HASH_SIZE);
+    return block;
+}
+
+static block_tree_result_t add(block_tree_t *tree, test_block_t *block, int64_t now_ms) {
+    return block_tree_add(tree, block->hash, block->previous_hash, block, now_ms);
+}
+
+static void test_fork_choice(void) {
+    static block_tree_t tree;
+    block_tree_init(&tree, base_hash, 0, link_block, release_block);
+    assert(block_tree_head(&tree) == NULL && block_tree_height(&tree) == 0);
+
+    char hash[BLOCK_TREE_HASH_SIZE];
+    block_tree_head_hash(&tree, hash);
+    assert(memcmp(hash, base_hash, BLOCK_TREE_HASH_SIZE) == 0);
+
+    // Two trades built on the same parent: the lower hash wins, whichever came first
+    test_block_t *root_child = make_block(0, 'm', base_hash);
+    test_block_t *high = make_block(1, 'x', root_child->hash);
+    test_block_t *low = make_block(2, 'c', root_child->hash);
+    assert(add(&tree, root_child, 0) == BLOCK_TREE_CONNECTED);
+    assert(root_child->parent == NULL);
+    assert(add(&tree, high, 0) == BLOCK_TREE_CONNECTED);
+    assert(block_tree_head(&tree) == high);
+    assert(add(&tree, low, 0) == BLOCK_TREE_CONNECTED);
+    assert(block_tree_head(&tree) == low && low->parent == root_child);
+    assert(block_tree_height(&tree) == 2);
+    assert(add(&tree, low, 0) == BLOCK_TREE_REJECTED);
+
+    // The other branch grows longer, and the head moves over to it
+    test_block_t *on_high = make_block(3, 'z', high->hash);
+    assert(add(&tree, on_high, 0) == BLOCK_TREE_CONNECTED);
+    assert(block_tree_head(&tree) == on_high && block_tree_height(&tree) == 3);
+    assert(block_tree_take_final(&tree) == NULL);
+
+    // Once a block on it is final, the losing branch is dropped and nothing can build on it anymore
+    test_block_t *previous = on_high;
+    for (int i = 4; i < 4 + BLOCK_TREE_CONFIRMATIONS - 1; i++) {
+        previous = make_block(i, 'a', previous->hash);
+        assert(add(&tree, previous, 0) == BLOCK_TREE_CONNECTED);
+    }
+    assert(block_tree_take_final(&tree) == root_child);
+    assert(low->released == 0);
+    assert(block_tree_take_final(&tree) == high);
+    assert(block_tree_take_final(&tree) == NULL);
+    assert(low->released == 1 && high->released == 0);
+    assert(!block_tree_contains(&tree, low->hash));
+    test_block_t *on_low = make_block(10, 'a', low->hash);
+    assert(add(&tree, on_low, 0) == BLOCK_TREE_ORPHANED);    // Its parent is gone, so it waits until it expires
+    test_block_t *on_final = make_block(11, 'a', root_child->hash);
+    assert(add(&tree, on_final, 0) == BLOCK_TREE_REJECTED);
+    assert(on_final->released == 0);
+}
+
+static void test_orphans(void) {
+    static block_tree_t tree;
+    block_tree_init(&tree, base_hash, 100, link_block, release_block);
+
+    // Children arrive before their parents
+    test_block_t *first = make_block(0, 'a', base_hash);
+    test_block_t *second = make_block(1, 'a', first->hash);
+    test_block_t *third = make_block(2, 'a', second->hash);
+    assert(add(&tree, third, 0) == BLOCK_TREE_ORPHANED);
+    assert(add(&tree, second, 10) == BLOCK_TREE_ORPHANED);
+    assert(block_tree_orphan_amount(&tree) == 2);
+    assert(block_tree_contains(&tree, third->hash));
+    assert(block_tree_head(&tree) == NULL);
+
+    assert(add(&tree, first, 20) == BLOCK_TREE_CONNECTED);
+    assert(block_tree_orphan_amount(&tree) == 0);
+    assert(block_tree_head(&tree) == third && block_tree_height(&tree) == 103);
+    assert(third->parent == second && second->parent == first);
+
+    // Orphans expire, and the oldest one makes room when the buffer is full
+    test_block_t *waiting = make_block(3, 'a', unknown_hash);
+    assert(add(&tree, waiting, 1000) == BLOCK_TREE_ORPHANED);
+    assert(add(&tree, make_block(4, 'a', unknown_hash), 1000 + BLOCK_TREE_ORPHAN_TIMEOUT_MS + 1) == BLOCK_TREE_ORPHANED);
+    assert(waiting->released == 1);
+    for (int i = 0; i < BLOCK_TREE_ORPHANS; i++) {
+        assert(add(&tree, make_block(10 + i, 'a', unknown_hash), 200000 + i) == BLOCK_TREE_ORPHANED);
+    }
+    assert(blocks[4].released == 1 && blocks[10].released == 0);
+    assert(block_tree_orphan_amount(&tree) == BLOCK_TREE_ORPHANS);
+}
+
+static void test_finality_and_retention(void) {
+    static block_tree_t tree;
+    block_tree_init(&tree, base_hash, 0, link_block, release_block);
+
+    const char *previous_hash = base_hash;
+    for (int i = 0; i < BLOCKS; i++) {
+        test_block_t *block = make_block(i, 'a', previous_hash);
+        assert(add(&tree, block, i) == BLOCK_TREE_CONNECTED);
+        previous_hash = block->hash;
+
+        // Final blocks come out once, oldest first, confirmations behind the head
+        if (i >= BLOCK_TREE_CONFIRMATIONS) {
+            assert(block_tree_take_final(&tree) == &blocks[i - BLOCK_TREE_CONFIRMATIONS]);
+        }
+        assert(block_tree_take_final(&tree) == NULL);
+    }
+
+    // The oldest kept block links to the root, which moved up with the evicted blocks
+    int root = BLOCKS - BLOCK_TREE_CONFIRMATIONS - BLOCK_TREE_RETAINED - 1;
+    assert(blocks[root].released == 1 && blocks[root + 1].released == 0);
+    assert(blocks[root + 1].parent == NULL && blocks[root + 2].parent == &blocks[root + 1]);
+    assert(block_tree_contains(&tree, blocks[root].hash) && !block_tree_contains(&tree, blocks[root - 1].hash));
+    assert(block_tree_root_height(&tree) == (uint32_t)root + 1);
+    for (int i = 0; i < root; i++) {
+        assert(blocks[i].released == 1);
+    }
+}
+
+static void test_reset(void) {
+    static block_tree_t tree;
+    block_tree_init(&tree, base_hash, 0, link_block, release_block);
+
+    test_block_t *first = make_block(0, 'a', base_hash);
+    test_block_t *second = make_block(1, 'a', first->hash);
+    test_block_t *orphan = make_block(2, 'a', unknown_hash);
+    assert(add(&tree, first, 0) == BLOCK_TREE_CONNECTED);
+    assert(add(&tree, second, 0) == BLOCK_TREE_CONNECTED);
+    assert(add(&tree, orphan, 0) == BLOCK_TREE_ORPHANED);
+
+    // Continuing from a snapshot at height 40 drops every block, orphans too
+    static const char snapshot_hash[BLOCK_TREE_HASH_SIZE] = "snapshot tip";
+    block_tree_reset(&tree, snapshot_hash, 40);
+    assert(first->released == 1 && second->released == 1 && orphan->released == 1);
+    assert(block_tree_head(&tree) == NULL && block_tree_height(&tree) == 40 && block_tree_root_height(&tree) == 40);
+    assert(block_tree_orphan_amount(&tree) == 0 && !block_tree_contains(&tree, first->hash));
+
+    // The next block builds on the snapshot tip
+    test_block_t *next = make_block(3, 'a', snapshot_hash);
+    assert(add(&tree, next, 0) == BLOCK_TREE_CONNECTED);
+    assert(block_tree_head(&tree) == next && block_tree_height(&tree) == 41);
+}
+
+static void test_full_of_branches(void) {
+    static block_tree_t tree;
+    block_tree_init(&tree, base_hash, 0, link_block, release_block);
+
+    // Nothing is final yet, so blocks past the capacity have nowhere to go and stay the caller's
+    for (int i = 0; i < BLOCK_TREE_CAPACITY; i++) {
+        assert(add(&tree, make_block(i, 'a', base_hash), 0) == BLOCK_TREE_CONNECTED);
+    }
+    test_block_t *extra = make_block(BLOCK_TREE_CAPACITY, 'a', base_hash);
+    assert(add(&tree, extra, 0) == BLOCK_TREE_REJECTED);
+    assert(extra->released == 0);
+}
+
+// Builds a random tree of blocks, like concurrent trades on stations that were not always in sync
+static int make_random_blocks(void) {
+    int amount = 0;
+    for (int i = 0; i < 40; i++) {
+        const char *previous_hash = (amount == 0) ? base_hash : blocks[amount - 1 - rand() % (amount < 3 ? amount : 3)].hash;
+        make_block(amount, 'a' + rand() % 26, previous_hash);
+        amount++;
+    }
+    return amount;
+}
+
+static void test_convergence(void) {
+    static block_tree_t station_a;
+    static block_tree_t station_b;
+    srand(47);
+
+    for (int round = 0; round < 200; round++) {
+        int amount = make_random_blocks();
+        int order[BLOCKS];
+        for (int i = 0; i < amount; i++) {
+            order[i] = i;
+        }
+
+        block_tree_init(&station_a, base_hash, 0, link_block, release_block);
+        for (int i = 0; i < amount; i++) {
+            add(&station_a, &blocks[i], 0);
+        }
+        void *head = block_tree_head(&station_a);
+        assert(head != NULL);
+
+        // The same blocks in a shuffled order, with the orphan buffer large enough to hold them
+        for (int i = amount - 1; i > 0; i--) {
+            int j = rand() % (i + 1);
+            int swap = order[i];
+            order[i] = order[j];
+            order[j] = swap;
+        }
+        block_tree_init(&station_b, base_hash, 0, link_block, release_block);
+        int orphaned = 0;
+        for (int i = 0; i < amount && orphaned < BLOCK_TREE_ORPHANS; i++) {
+            // Stops at BLOCK_TREE_ORPHANS out of order blocks, so none are pushed out of the buffer
+            if (add(&station_b, &blocks[order[i]], 0) == BLOCK_TREE_ORPHANED) orphaned++;
+        }
+        for (int i = 0; i < amount; i++) {
+            add(&station_b, &blocks[i], 0);
+        }
+        assert(block_tree_head(&station_b) == head);
+        assert(block_tree_height(&station_b) == block_tree_height(&station_a));
+    }
+}
+
+int main(void) {
+    test_fork_choice();
+    test_orphans();
+    test_finality_and_retention();
+    test_full_of_branches();
+    test_reset();
+    test_convergence();
+    printf("test_block_tree: OK\n");
+    return 0;
+}
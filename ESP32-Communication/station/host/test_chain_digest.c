@@ -0,0 +1,132 @@
+/* Host test for the chain state digest: what changes it, the encoding, when a peer is asked for its blocks or its
+ * snapshot, and how often a chain sync is answered. */
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include "blockchain/chain_digest.h"
+
+static const char tip_hash[CHAIN_DIGEST_HASH_SIZE] = "tip of the chain in this test...";
+
+static void test_digest(void) {
+    chain_digest_t digest;
+    chain_digest_t other;
+    chain_digest_make(&digest, 40, tip_hash, 1234);
+    chain_digest_make(&other, 40, tip_hash, 1234);
+    assert(digest.height == 40 && digest.digest == other.digest);
+
+    // Any of the three parts changes it
+    chain_digest_make(&other, 41, tip_hash, 1234);
+    assert(other.digest != digest.digest);
+    chain_digest_make(&other, 40, tip_hash, 1235);
+    assert(other.digest != digest.digest);
+    char forked_hash[CHAIN_DIGEST_HASH_SIZE];
+    memcpy(forked_hash, tip_hash, CHAIN_DIGEST_HASH_SIZE);
+    forked_hash[CHAIN_DIGEST_HASH_SIZE - 1] ^= 1;
+    chain_digest_make(&other, 40, forked_hash, 1234);
+    assert(other.digest != digest.digest);
+
+    uint8_t buffer[CHAIN_DIGEST_ENCODED_SIZE];
+    chain_digest_encode(&digest, buffer);
+    assert(buffer[0] == 40 && buffer[1] == 0);
+    chain_digest_decode(buffer, &other);
+    assert(other.height == digest.height && other.digest == digest.digest);
+}
+
+static void test_observe(void) {
+    chain_digest_peers_t peers;
+    chain_digest_peers_init(&peers);
+    chain_digest_t own;
+    chain_digest_t peer;
+    chain_digest_make(&own, 10, tip_hash, 99);
+
+    // Agreeing peers and ids out of range are never asked
+    for (int i = 0; i < 5; i++) {
+        assert(!chain_digest_observe(&peers, 3, &own, &own, i * 1000));
+    }
+    assert(!chain_digest_observe(&peers, CHAIN_DIGEST_PEERS, &own, &own, 0));
+
+    // A peer one block ahead for a single heartbeat is not asked, one that stays ahead is
+    chain_digest_make(&peer, 11, tip_hash, 99);
+    assert(!chain_digest_observe(&peers, 3, &own, &peer, 0));
+    assert(!chain_digest_observe(&peers, 3, &own, &own, 1000));
+    assert(!chain_digest_observe(&peers, 3, &own, &peer, 2000));
+    assert(chain_digest_observe(&peers, 3, &own, &peer, 3000));
+    assert(peers.announced[3].height == 11);
+
+    // Not again until the retry time passed
+    assert(!chain_digest_observe(&peers, 3, &own, &peer, 3000 + CHAIN_DIGEST_RETRY_MS - 1));
+    assert(chain_digest_observe(&peers, 3, &own, &peer, 3000 + CHAIN_DIGEST_RETRY_MS));
+
+    // Same height on another branch: both sides ask each other
+    chain_digest_make(&peer, 10, tip_hash, 98);
+    assert(!chain_digest_observe(&peers, 4, &own, &peer, 0));
+    assert(chain_digest_observe(&peers, 4, &own, &peer, 1000));
+    chain_digest_peers_t peer_side;
+    chain_digest_peers_init(&peer_side);
+    assert(!chain_digest_observe(&peer_side, 1, &peer, &own, 0));
+    assert(chain_digest_observe(&peer_side, 1, &peer, &own, 1000));
+
+    // A peer that is behind asks this station instead
+    chain_digest_make(&peer, 7, tip_hash, 50);
+    for (int i = 0; i < 5; i++) {
+        assert(!chain_digest_observe(&peers, 5, &own, &peer, i * 1000));
+    }
+}
+
+// A peer whose blocks never connect, because the chains split below the final block
+static void test_divergence(void) {
+    chain_digest_peers_t peers;
+    chain_digest_peers_init(&peers);
+    chain_digest_t own;
+    chain_digest_t peer;
+    chain_digest_make(&own, 10, tip_hash, 99);
+    chain_digest_make(&peer, 12, tip_hash, 77);
+
+    int64_t now_ms = 0;
+    assert(chain_digest_observe(&peers, 2, &own, &peer, now_ms) == CHAIN_DIGEST_SYNC_NONE);
+    for (int i = 0; i < CHAIN_DIGEST_SYNC_ATTEMPTS; i++) {
+        now_ms += CHAIN_DIGEST_RETRY_MS;
+        assert(chain_digest_observe(&peers, 2, &own, &peer, now_ms) == CHAIN_DIGEST_SYNC_BLOCKS);
+    }
+    // The blocks did not change the own chain, so the snapshot is asked for once, and then nothing
+    now_ms += CHAIN_DIGEST_RETRY_MS;
+    assert(chain_digest_observe(&peers, 2, &own, &peer, now_ms) == CHAIN_DIGEST_SYNC_SNAPSHOT);
+    for (int i = 0; i < 10; i++) {
+        now_ms += CHAIN_DIGEST_RETRY_MS;
+        assert(chain_digest_observe(&peers, 2, &own, &peer, now_ms) == CHAIN_DIGEST_SYNC_NONE);
+    }
+
+    // Once the own chain moves the peer is asked for blocks again
+    chain_digest_make(&own, 11, tip_hash, 100);
+    now_ms += CHAIN_DIGEST_RETRY_MS;
+    assert(chain_digest_observe(&peers, 2, &own, &peer, now_ms) == CHAIN_DIGEST_SYNC_BLOCKS);
+}
+
+static void test_replies(void) {
+    chain_digest_replies_t replies;
+    chain_digest_replies_init(&replies);
+
+    // One answer per source in the interval, other sources are not held up
+    assert(chain_digest_may_reply(&replies, 1, 0));
+    assert(!chain_digest_may_reply(&replies, 1, CHAIN_DIGEST_REPLY_MS - 1));
+    assert(chain_digest_may_reply(&replies, 2, 1));
+    assert(chain_digest_may_reply(&replies, 1, CHAIN_DIGEST_REPLY_MS));
+    assert(!chain_digest_may_reply(&replies, 1, CHAIN_DIGEST_REPLY_MS + 1));
+
+    // More sources than entries: the source answered longest ago is forgotten
+    for (uint32_t ip = 10; ip < 10 + CHAIN_DIGEST_REPLY_SOURCES; ip++) {
+        assert(chain_digest_may_reply(&replies, ip, CHAIN_DIGEST_REPLY_MS + 2 + ip));
+    }
+    assert(chain_digest_may_reply(&replies, 1, CHAIN_DIGEST_REPLY_MS + 100));
+    assert(!chain_digest_may_reply(&replies, 10 + CHAIN_DIGEST_REPLY_SOURCES - 1, CHAIN_DIGEST_REPLY_MS + 101));
+}
+
+int main(void) {
+    test_digest();
+    test_observe();
+    test_divergence();
+    test_replies();
+    printf("test_chain_digest: OK\n");
+    return 0;
+}
@@ -0,0 +1,199 @@
+/* Host test for the RCU chain tip: readers check every tip they see while writers append concurrently, and no
+ * block is reclaimed while a reader still holds it. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "blockchain/chain_tip.h"
+
+#define WRITERS 3
+#define READERS 4
+#define APPENDS 2000
+
+typedef struct {
+    uint32_t height;
+    int alive;
+} test_block_t;
+
+static int stop_reading = 0;
+static int reclaimed_blocks = 0;
+
+// The hash a tip at this height must carry, so a torn tip is noticed
+static void hash_for_height(uint32_t height, char hash[CHAIN_TIP_HASH_SIZE]) {
+    for (int i = 0; i < CHAIN_TIP_HASH_SIZE; i++) {
+        hash[i] = (char)(height * 31 + i);
+    }
+}
+
+static void reclaim_block(void *pointer) {
+    test_block_t *block = pointer;
+    assert(block->alive == 1);
+    block->alive = 0;
+    __atomic_fetch_add(&reclaimed_blocks, 1, __ATOMIC_RELAXED);
+    free(block);
+}
+
+static void *reader_thread(void *arg) {
+    (void)arg;
+    uint32_t last_height = 0;
+    while (!__atomic_load_n(&stop_reading, __ATOMIC_ACQUIRE)) {
+        int reader;
+        const chain_tip_t *tip = chain_tip_read_begin(&reader);
+        char expected[CHAIN_TIP_HASH_SIZE];
+        hash_for_height(tip->height, expected);
+        assert(memcmp(tip->hash, expected, CHAIN_TIP_HASH_SIZE) == 0);
+        assert(tip->height >= last_height);     // The tip never goes back
+        last_height = tip->height;
+
+        // Holding the block while the writers go on, it must not be reclaimed meanwhile
+        test_block_t *block = tip->block;
+        sched_yield();
+        if (block != NULL) {
+            assert(block->alive == 1 && block->height == tip->height);
+        }
+        chain_tip_read_end(reader);
+    }
+    return NULL;
+}
+
+static void *writer_thread(void *arg) {
+    (void)arg;
+    for (int i = 0; i < APPENDS; i++) {
+        test_block_t *block = malloc(sizeof(test_block_t));
+        block->alive = 1;
+        while (1) {
+            int reader;
+            const chain_tip_t *tip = chain_tip_read_begin(&reader);
+            chain_tip_t next = { .block = block, .height = tip->height + 1 };
+            block->height = next.height;
+            hash_for_height(next.height, next.hash);
+            test_block_t *replaced = tip->block;
+            int published = chain_tip_publish(tip, &next);
+            chain_tip_read_end(reader);
+
+            if (published == 0) {
+                if (replaced != NULL) {
+                    chain_tip_retire(replaced, reclaim_block);
+                }
+                break;
+            }
+            sched_yield();      // Another writer appended first, try again on the new tip
+        }
+    }
+    return NULL;
+}
+
+static void test_concurrent_appends(void) {
+    chain_tip_t first = { .block = NULL, .height = 0 };
+    hash_for_height(0, first.hash);
+    assert(chain_tip_init(&first) == 0);
+
+    pthread_t readers[READERS];
+    pthread_t writers[WRITERS];
+    for (int i = 0; i < READERS; i++) {
+        pthread_create(&readers[i], NULL, reader_thread, NULL);
+    }
+    for (int i = 0; i < WRITERS; i++) {
+        pthread_create(&writers[i], NULL, writer_thread, NULL);
+    }
+    for (int i = 0; i < WRITERS; i++) {
+        pthread_join(writers[i], NULL);
+    }
+    __atomic_store_n(&stop_reading, 1, __ATOMIC_RELEASE);
+    for (int i = 0; i < READERS; i++) {
+        pthread_join(readers[i], NULL);
+    }
+
+    // No append was lost, and with the readers gone everything but the tip is reclaimed
+    int reader;
+    const chain_tip_t *tip = chain_tip_read_begin(&reader);
+    assert(tip->height == WRITERS * APPENDS);
+    test_block_t *last = tip->block;
+    chain_tip_read_end(reader);
+
+    while (chain_tip_reclaim() > 0) {
+        // Every call moves the epoch on, there are no readers left to hold it
+    }
+    assert(reclaimed_blocks == WRITERS * APPENDS - 1);
+    assert(last->alive == 1);
+}
+
+static void test_reader_holds_back_reclaim(void) {
+    reclaimed_blocks = 0;
+    int holder;
+    const chain_tip_t *held = chain_tip_read_begin(&holder);
+    test_block_t *block = held->block;
+
+    // Replaced and retired while the section is open, so it stays however often the writers try
+    int writer;
+    const chain_tip_t *tip = chain_tip_read_begin(&writer);
+    chain_tip_t next = { .block = NULL, .height = tip->height + 1 };
+    hash_for_height(next.height, next.hash);
+    assert(chain_tip_publish(tip, &next) == 0);
+    assert(chain_tip_publish(tip, &next) == -1);        // tip is not the current one anymore
+    chain_tip_read_end(writer);
+    chain_tip_retire(block, reclaim_block);
+    for (int i = 0; i < 10; i++) {
+        assert(chain_tip_reclaim() == 2);               // The block and the replaced record
+    }
+    assert(reclaimed_blocks == 0 && block->alive == 1 && held->height == next.height - 1);
+
+    chain_tip_read_end(holder);
+    while (chain_tip_reclaim() > 0) {
+        // Every call moves the epoch on, there are no readers left to hold it
+    }
+    assert(reclaimed_blocks == 1);
+}
+
+static void test_retire_beyond_capacity(void) {
+    reclaimed_blocks = 0;
+    int holder;
+    chain_tip_read_begin(&holder);
+
+    // More than the array holds while a reader keeps the epoch back, none of them waits
+    for (int i = 0; i < CHAIN_TIP_RETIRED_CAPACITY * 2; i++) {
+        test_block_t *block = malloc(sizeof(test_block_t));
+        block->alive = 1;
+        assert(chain_tip_retire(block, reclaim_block) == 0);
+    }
+    assert(chain_tip_reclaim() == CHAIN_TIP_RETIRED_CAPACITY * 2);
+    assert(reclaimed_blocks == 0);
+
+    chain_tip_read_end(holder);
+    while (chain_tip_reclaim() > 0) {
+        // Every call moves the epoch on, there are no readers left to hold it
+    }
+    assert(reclaimed_blocks == CHAIN_TIP_RETIRED_CAPACITY * 2);
+}
+
+static void test_slots_taken(void) {
+    int readers[CHAIN_TIP_READERS];
+    for (int i = 0; i < CHAIN_TIP_READERS; i++) {
+        assert(chain_tip_read_begin(&readers[i]) != NULL);
+    }
+
+    // One more reader gets NULL instead of spinning, and a slot once one is left
+    int reader = -1;
+    assert(chain_tip_read_begin(&reader) == NULL && reader == -1);
+    chain_tip_read_end(readers[3]);
+    assert(chain_tip_read_begin(&reader) != NULL && reader == readers[3]);
+
+    chain_tip_read_end(reader);
+    for (int i = 0; i < CHAIN_TIP_READERS; i++) {
+        if (i != 3) {
+            chain_tip_read_end(readers[i]);
+        }
+    }
+}
+
+int main(void) {
+    test_concurrent_appends();
+    test_reader_holds_back_reclaim();
+    test_retire_beyond_capacity();
+    test_slots_taken();
+    printf("test_chain_tip: OK\n");
+    return 0;
+}
@@ -0,0 +1,155 @@
+/* Host test for the glyph atlas, the dashboard snapshot and the dashboard layout. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "graphics/dashboard.h"
+
+#define WRITES 20000
+
+static void test_glyphs(void) {
+    static glyph_atlas_t atlas;
+    glyph_atlas_build(&atlas, 0xFFFF, 0x0000);
+
+    // Column 2 of '!' is set in the rows 0 to 4, the spacing column and row stay background
+    assert(glyph_row(&atlas, '!', 0)[2 * GLYPH_SCALE] == 0xFFFF);
+    assert(glyph_row(&atlas, '!', 0)[0] == 0x0000);
+    assert(glyph_row(&atlas, '!', 5 * GLYPH_SCALE)[2 * GLYPH_SCALE] == 0x0000);
+    assert(glyph_row(&atlas, 'A', 0)[GLYPH_WIDTH - 1] == 0x0000);
+    assert(glyph_row(&atlas, 'A', GLYPH_HEIGHT - 1)[0] == 0x0000);
+
+    // Lower case is drawn as upper case, unknown characters as '?'
+    assert(glyph_row(&atlas, 'a', 3) == glyph_row(&atlas, 'A', 3));
+    assert(glyph_row(&atlas, '~', 3) == glyph_row(&atlas, '?', 3));
+
+    // Text is clipped to the rectangle: "HI" at x 5, drawn into a rectangle starting in the middle of the H
+    uint16_t pixels[GLYPH_HEIGHT * 10];
+    for (int i = 0; i < GLYPH_HEIGHT * 10; i++) {
+        pixels[i] = 0x1234;
+    }
+    glyph_draw_text(&atlas, "HI", 5, 0, 11, 0, 10, GLYPH_HEIGHT, pixels);
+    for (int row = 0; row < GLYPH_HEIGHT; row++) {
+        for (int column = 0; column < 10; column++) {
+            int text_x = 11 + column - 5;
+            const uint16_t *expected = glyph_row(&atlas, (text_x < GLYPH_WIDTH) ? 'H' : 'I', row);
+            assert(pixels[row * 10 + column] == expected[text_x % GLYPH_WIDTH]);
+        }
+    }
+}
+
+static dashboard_snapshot_t snapshot;
+
+// Writes states where chain_height and amperage always belong together
+static void *writer(void *arg) {
+    (void)arg;
+    for (int i = 1; i <= WRITES; i++) {
+        dashboard_state_t *state = dashboard_begin_update(&snapshot);
+        state->chain_height = i;
+        state->amperage = FIXED_FROM_INT(i % 1000);
+        state->grid_load[3] = i;
+        dashboard_end_update(&snapshot);
+        if (i % 64 == 0) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void test_snapshot(void) {
+    dashboard_snapshot_init(&snapshot);
+    dashboard_state_t state;
+    assert(dashboard_read(&snapshot, &state) == 0);
+    assert(state.node_id == -1 && state.trade_open);
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, writer, NULL);
+
+    int last_height = 0;
+    uint32_t last_sequence = 0;
+    while (last_height < WRITES) {
+        uint32_t sequence = dashboard_read(&snapshot, &state);
+        assert((sequence & 1) == 0);
+        assert(state.amperage == FIXED_FROM_INT(state.chain_height % 1000));
+        assert(state.grid_load[3] == state.chain_height);
+        assert(state.chain_height >= last_height);
+        assert(sequence >= last_sequence);
+        last_height = state.chain_height;
+        last_sequence = sequence;
+        sched_yield();
+    }
+    pthread_join(thread, NULL);
+
+    // The sequence only moves with a change
+    assert(dashboard_read(&snapshot, &state) == dashboard_read(&snapshot, &state));
+}
+
+static void test_layout_and_redraw(void) {
+    dashboard_t *dashboard = malloc(sizeof(dashboard_t));
+    static render_memory_t memory;
+    renderer_t renderer;
+    render_backend_t backend = render_memory_backend(&memory);
+    dashboard_state_t state;
+    dashboard_view_t view;
+
+    dashboard_init(dashboard);
+    assert(renderer_init(&renderer, dashboard_paint, dashboard, &backend) == 0);
+
+    memset(&state, 0, sizeof(state));
+    state.node_id = 3;
+    state.chain_height = 7;
+    state.grid_load[2] = FIXED_FROM_INT(-10);
+    state.grid_load[3] = FIXED_FROM_INT(40);
+    dashboard_layout(&state, &view);
+    assert(strcmp(view.text[0], "LASET NODE 3") == 0);
+    assert(strcmp(view.text[2], "CHAIN HEIGHT 7") == 0);
+    assert(strcmp(view.text[7], "GRID LOAD 30.0") == 0);
+    assert(strcmp(view.text[10], " 2  -10.0") == 0);
+    assert(view.bar_width[10] == DASHBOARD_BAR_MAX_WIDTH / 2);
+    assert(view.bar_width[11] == DASHBOARD_BAR_MAX_WIDTH);      // Limited to the full scale
+    assert(view.bar_color[10] != view.bar_color[11]);
+    assert(view.text[11][0] == '>');
+
+    dashboard_update_view(dashboard, &renderer, &view);
+    assert(renderer_flush(&renderer) == RENDER_TILE_ROWS);
+
+    // The title is drawn in the text color, the bar of node 2 in the producing color
+    assert(memory.pixels[1 * SCREEN_WIDTH + 1] == COLOR_SWAP(DASHBOARD_TEXT));     // Top of the L
+    assert(memory.pixels[(10 * GLYPH_HEIGHT + 8) * SCREEN_WIDTH + DASHBOARD_BAR_X + 4] == COLOR_SWAP(DASHBOARD_PRODUCING));
+    assert(memory.pixels[(10 * GLYPH_HEIGHT + 8) * SCREEN_WIDTH + SCREEN_WIDTH - 4] == COLOR_SWAP(DASHBOARD_BACKGROUND));
+
+    // Nothing changed, nothing is redrawn
+    assert(dashboard_update_view(dashboard, &renderer, &view) == 0);
+    assert(renderer_flush(&renderer) == 0);
+
+    // A new chain height only redraws the digits that changed
+    state.chain_height = 8;
+    dashboard_layout(&state, &view);
+    assert(dashboard_update_view(dashboard, &renderer, &view) == 1);
+    uint32_t pixels_before = renderer.stats.pixels;
+    assert(renderer_flush(&renderer) == 1);
+    assert(renderer.stats.pixels - pixels_before <= 2 * RENDER_TILE_SIZE * RENDER_TILE_SIZE);
+
+    // A block in voting shows its votes
+    state.phase_amount = 4;
+    state.quorum = 2;
+    state.phase_votes[0] = 2;
+    state.phase_votes[1] = 1;
+    dashboard_layout(&state, &view);
+    assert(strcmp(view.text[19], "VOTES #100") == 0);
+    assert(dashboard_update_view(dashboard, &renderer, &view) == 2);
+    assert(renderer_flush(&renderer) > 0);
+
+    renderer_free(&renderer);
+    free(dashboard);
+}
+
+int main(void) {
+    test_glyphs();
+    test_snapshot();
+    test_layout_and_redraw();
+    printf("test_dashboard: OK\n");
+    return 0;
+}
@@ -0,0 +1,77 @@
+/* Host test for the duplicate packet filter. */
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include "networking/dedup.h"
+
+// Sender addresses in network byte order
+#define NODE_A 0x0a01a8c0u
+#define NODE_B 0x0b01a8c0u
+
+static void test_repeats_in_window(void) {
+    dedup_filter_t filter;
+    dedup_init(&filter, 0);
+
+    const char *bcb = "bcb,1,5,20,2,....";
+    const char *bpa = "bpa,3,1,20,....";
+    assert(!dedup_seen(&filter, NODE_A, bcb, strlen(bcb), 0));
+    assert(!dedup_seen(&filter, NODE_A, bpa, strlen(bpa), 1));
+    assert(dedup_seen(&filter, NODE_A, bcb, strlen(bcb), 2));
+    assert(dedup_seen(&filter, NODE_A, bpa, strlen(bpa), DEDUP_WINDOW_MS - 1));
+    assert(filter.duplicates == 2);
+
+    // Packets that differ in one byte or in length are not copies
+    assert(!dedup_seen(&filter, NODE_A, "bpa,3,2,20,....", 15, 3));
+    assert(!dedup_seen(&filter, NODE_A, bcb, strlen(bcb) - 1, 3));
+
+    // The same bytes from another node are its own packet
+    assert(!dedup_seen(&filter, NODE_B, bpa, strlen(bpa), 4));
+    assert(dedup_seen(&filter, NODE_B, bpa, strlen(bpa), 5));
+}
+
+static void test_window(void) {
+    dedup_filter_t filter;
+    dedup_init(&filter, 0);
+    const char *bca = "bca,4,12,abcdefgh";
+
+    // Still remembered one window later, after it moved to the older generation
+    assert(!dedup_seen(&filter, NODE_A, bca, strlen(bca), 0));
+    assert(dedup_seen(&filter, NODE_A, bca, strlen(bca), DEDUP_WINDOW_MS + 10));
+
+    // Forgotten once that generation is emptied again
+    assert(!dedup_seen(&filter, NODE_A, bca, strlen(bca), 2 * DEDUP_WINDOW_MS + 10));
+
+    // A long pause empties both generations at once
+    assert(!dedup_seen(&filter, NODE_A, "rpk,1;", 6, 2 * DEDUP_WINDOW_MS + 20));
+    assert(!dedup_seen(&filter, NODE_A, "rpk,1;", 6, 10 * DEDUP_WINDOW_MS));
+}
+
+static void test_full_generation(void) {
+    dedup_filter_t filter;
+    dedup_init(&filter, 0);
+    char packet[32];
+
+    // More unique packets than one generation holds in a single window
+    for (int i = 0; i < DEDUP_SLOTS * 2; i++) {
+        int length = snprintf(packet, sizeof(packet), "bpa,%d,1,20,x", i);
+        assert(!dedup_seen(&filter, NODE_A, packet, length, 5));
+        assert(filter.fill[filter.current] <= DEDUP_MAX_FILL);
+    }
+
+    // The newest ones are still remembered
+    int length = snprintf(packet, sizeof(packet), "bpa,%d,1,20,x", DEDUP_SLOTS * 2 - 1);
+    assert(dedup_seen(&filter, NODE_A, packet, length, 6));
+}
+
+int main(void) {
+    assert(dedup_digest(0, "", 0) != 0);
+    assert(dedup_digest(NODE_A, "abc", 3) != dedup_digest(NODE_A, "abd", 3));
+    assert(dedup_digest(NODE_A, "abc", 3) != dedup_digest(NODE_B, "abc", 3));
+
+    test_repeats_in_window();
+    test_window();
+    test_full_generation();
+    printf("test_dedup: OK\n");
+    return 0;
+}
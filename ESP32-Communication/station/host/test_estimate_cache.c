@@ -0,0 +1,79 @@
+/* Host test for the grid estimate cache. */
+#include <stdio.h>
+#include <assert.h>
+
+#include "grid/estimate_cache.h"
+
+static void test_hit_and_miss(void) {
+    estimate_cache_t cache;
+    estimate_cache_key_t key;
+    fixed_t load[GRID_MAX_NODES] = {0};
+    fixed_t estimate = -1;
+
+    estimate_cache_init(&cache);
+    load[3] = FIXED_FROM_INT(10);
+    load[5] = FIXED_FROM_INT(-5);
+
+    estimate_cache_make_key(&key, load, 3, 5, FIXED_FROM_INT(-5));
+    assert(!estimate_cache_lookup(&cache, &key, &estimate));
+    estimate_cache_insert(&cache, &key, 12500);
+
+    // A slightly different reading (10.02 A, -5.01 A) quantizes to the same key
+    load[3] = 100200;
+    estimate_cache_make_key(&key, load, 3, 5, -50100);
+    assert(estimate_cache_lookup(&cache, &key, &estimate));
+    assert(estimate == 12500);
+
+    // Another buyer is another key
+    estimate_cache_make_key(&key, load, 6, 5, FIXED_FROM_INT(-5));
+    assert(!estimate_cache_lookup(&cache, &key, &estimate));
+
+    assert(cache.metrics.hits == 1);
+    assert(cache.metrics.misses == 2);
+}
+
+static void test_lru_eviction(void) {
+    estimate_cache_t cache;
+    estimate_cache_key_t key;
+    fixed_t load[GRID_MAX_NODES] = {0};
+    fixed_t estimate;
+
+    estimate_cache_init(&cache);
+
+    // Fill the cache, load[3] = 0 is the oldest entry
+    for (int i = 0; i < ESTIMATE_CACHE_CAPACITY; i++) {
+        load[3] = FIXED_FROM_INT(i);
+        estimate_cache_make_key(&key, load, 3, 5, FIXED_FROM_INT(-5));
+        estimate_cache_insert(&cache, &key, i);
+    }
+
+    // Touch the oldest entry, so load[3] = 1 becomes the least recently used
+    load[3] = FIXED_FROM_INT(0);
+    estimate_cache_make_key(&key, load, 3, 5, FIXED_FROM_INT(-5));
+    assert(estimate_cache_lookup(&cache, &key, &estimate));
+
+    load[3] = FIXED_FROM_INT(1000);
+    estimate_cache_make_key(&key, load, 3, 5, FIXED_FROM_INT(-5));
+    estimate_cache_insert(&cache, &key, 1000);
+    assert(cache.metrics.evictions == 1);
+
+    load[3] = FIXED_FROM_INT(1);
+    estimate_cache_make_key(&key, load, 3, 5, FIXED_FROM_INT(-5));
+    assert(!estimate_cache_lookup(&cache, &key, &estimate));
+
+    for (int i = 0; i < ESTIMATE_CACHE_CAPACITY; i++) {
+        if (i == 1) continue;
+        load[3] = FIXED_FROM_INT(i);
+        estimate_cache_make_key(&key, load, 3, 5, FIXED_FROM_INT(-5));
+        assert(estimate_cache_lookup(&cache, &key, &estimate));
+        assert(estimate == i);
+    }
+}
+
+int main(void) {
+    test_hit_and_miss();
+    test_lru_eviction();
+
+    printf("test_estimate_cache: OK\n");
+    return 0;
+}
@@ -0,0 +1,124 @@
+/* Host test for the fixed point numbers, checked against strtod and snprintf. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include "grid/fixed_point.h"
+
+static fixed_t parsed(const char *text) {
+    fixed_t value = 12345;
+    assert(fixed_parse(text, &value) == 0);
+    return value;
+}
+
+static void test_parse(void) {
+    assert(parsed("25") == FIXED_FROM_INT(25));
+    assert(parsed("-5") == FIXED_FROM_INT(-5));
+    assert(parsed("+3.5") == 35000);
+    assert(parsed("10.000000") == FIXED_FROM_INT(10));     // rlc as sent with %f
+    assert(parsed("0.0001") == 1);
+    assert(parsed(".5") == 5000);
+    assert(parsed("7.") == FIXED_FROM_INT(7));
+    assert(parsed("-0.0") == 0);
+    assert(parsed("1e-05") == 0);                           // Python prints small floats like this
+    assert(parsed("5e-05") == 1);
+    assert(parsed("-2.5E2") == FIXED_FROM_INT(-250));
+    assert(parsed("0.000000000000000000000000001") == 0);
+    assert(parsed("00000000000000000000000012.5") == 125000);
+
+    // Past the 4th decimal is rounded half away from zero
+    assert(parsed("1.23445") == 12345);
+    assert(parsed("1.23455") == 12346);
+    assert(parsed("-1.23455") == -12346);
+    assert(parsed("1.234549999") == 12345);
+
+    // Ends at a separator, like the fields of a message
+    assert(parsed("25.5,3") == 255000);
+    assert(parsed("-1.25;") == -12500);
+
+    // Range
+    assert(parsed("214748.3647") == FIXED_MAX);
+    assert(parsed("-214748.3647") == FIXED_MIN);
+    assert(parsed("214748.36474") == FIXED_MAX);
+
+    const char *invalid[] = {"", "-", ".", "+.", "1.2.3", "12a", "1e", "1e+", "e5", " 1", "214748.3648", "-214748.36475", "1e10", "99999999999999999999"};
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        fixed_t value = 12345;
+        assert(fixed_parse(invalid[i], &value) == -1);
+        assert(value == 12345);
+    }
+}
+
+static void test_format(void) {
+    char text[FIXED_TEXT_SIZE];
+
+    assert(fixed_format(FIXED_MIN, FIXED_DECIMALS, text, sizeof(text)) == FIXED_TEXT_SIZE - 1);
+    assert(strcmp(text, "-214748.3647") == 0);
+    assert(fixed_format(-500, 4, text, sizeof(text)) == 7);
+    assert(strcmp(text, "-0.0500") == 0);
+    assert(fixed_format(-500, 1, text, sizeof(text)) > 0);
+    assert(strcmp(text, "-0.1") == 0);
+    assert(fixed_format(-499, 1, text, sizeof(text)) > 0);
+    assert(strcmp(text, "0.0") == 0);
+    assert(fixed_format(FIXED_FROM_INT(25) + 5000, 0, text, sizeof(text)) > 0);
+    assert(strcmp(text, "26") == 0);
+
+    assert(fixed_format(FIXED_MAX, 4, text, 11) == -1);      // 11 characters and the 0
+    assert(fixed_format(1, 5, text, sizeof(text)) == -1);
+
+    // Everything formatted reads back the same, and as the same number for strtod
+    srand(6666);
+    for (int i = 0; i < 100000; i++) {
+        fixed_t value = (fixed_t)(((uint32_t)rand() << 16) ^ (uint32_t)rand());
+        if (value == INT32_MIN) continue;
+        assert(fixed_format(value, FIXED_DECIMALS, text, sizeof(text)) > 0);
+        assert(parsed(text) == value);
+        assert(llround(strtod(text, NULL) * FIXED_ONE) == value);
+
+        char expected[32];
+        snprintf(expected, sizeof(expected), "%.4f", (double)value / FIXED_ONE);
+        assert(strcmp(text, expected) == 0);
+    }
+}
+
+static void test_arithmetic(void) {
+    assert(fixed_mul(FIXED_FROM_INT(3), 25000) == 75000);
+    assert(fixed_mul(-15000, 15000) == -22500);
+    assert(fixed_mul(1, 5000) == 1);                    // 0.00005 rounds away from zero
+    assert(fixed_mul(-1, 5000) == -1);
+    assert(fixed_mul(FIXED_FROM_INT(1000), FIXED_FROM_INT(1000)) == FIXED_MAX);
+
+    assert(fixed_add(FIXED_MAX, 1) == FIXED_MAX);
+    assert(fixed_add(FIXED_MIN, -1) == FIXED_MIN);
+    assert(fixed_abs(-12345) == 12345);
+    assert(fixed_abs(INT32_MIN) == FIXED_MAX);
+
+    assert(fixed_steps(FIXED_FROM_INT(10) + 200, FIXED_ONE / 10) == 100);
+    assert(fixed_steps(-50100, FIXED_ONE / 10) == -50);
+    assert(fixed_steps(-55000, FIXED_ONE / 10) == -55);
+    assert(fixed_steps(-5000, FIXED_ONE) == -1);
+    assert(fixed_steps(1, 0) == 0);
+
+    // Sums saturate once at the end, so an intermediate overflow does not matter
+    fixed_t load[10] = {FIXED_MAX, FIXED_MAX, FIXED_MIN, FIXED_MIN, 3};
+    assert(fixed_sum(load, 10) == 3);
+    assert(fixed_sum(load, 2) == FIXED_MAX);
+    assert(fixed_sum(load, 0) == 0);
+
+    assert(fixed_from_double(1.23456) == 12346);
+    assert(fixed_from_double(-0.00006) == -1);
+    assert(fixed_from_double(1e12) == FIXED_MAX);
+    assert(fixed_from_double(-INFINITY) == FIXED_MIN);
+    assert(fixed_from_double(NAN) == FIXED_MAX);
+    assert(fixed_to_double(-12500) == -1.25);
+}
+
+int main(void) {
+    test_parse();
+    test_format();
+    test_arithmetic();
+    printf("test_fixed_point: OK\n");
+    return 0;
+}
@@ -0,0 +1,81 @@
+/* Host test for the hex codec, checked against snprintf and sscanf. */
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include "networking/hex.h"
+
+static void test_round_trip(void) {
+    uint8_t data[80];
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)(i * 37 + 11);
+    }
+
+    // Lengths around the 16 byte blocks, so both the block and the tail code run
+    const size_t lengths[] = {0, 1, 15, 16, 17, 31, 32, 33, 64, 80};
+    for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+        size_t length = lengths[l];
+        char hex[HEX_ENCODED_SIZE(80)];
+        char expected[HEX_ENCODED_SIZE(80)] = {0};
+        for (size_t i = 0; i < length; i++) {
+            snprintf(expected + 2 * i, 3, "%02x", data[i]);
+        }
+
+        assert(hex_encode(data, length, hex, HEX_ENCODED_SIZE(length)) == (int)(2 * length));
+        assert(strcmp(hex, expected) == 0);
+
+        uint8_t decoded[80];
+        assert(hex_decode(hex, 2 * length, decoded, length) == (int)length);
+        assert(memcmp(decoded, data, length) == 0);
+    }
+}
+
+static void test_decode_input(void) {
+    uint8_t data[20];
+    const char *upper = "00FFa5A57Fb3C0DE9e10";
+    assert(hex_decode(upper, strlen(upper), data, 10) == 10);
+    for (int i = 0; i < 10; i++) {
+        unsigned int value;
+        sscanf(upper + 2 * i, "%2x", &value);
+        assert(data[i] == value);
+    }
+
+    // An invalid character in the 16 byte blocks and in the tail
+    char hex[41];
+    memset(hex, 'a', 40);
+    hex[40] = '\0';
+    assert(hex_decode(hex, 40, data, 20) == 20);
+    hex[7] = 'g';
+    assert(hex_decode(hex, 40, data, 20) == -1);
+    hex[7] = 'a';
+    hex[37] = ':';
+    assert(hex_decode(hex, 40, data, 20) == -1);
+    hex[37] = '/';
+    assert(hex_decode(hex, 40, data, 20) == -1);
+
+    // Too few characters
+    hex[37] = 'a';
+    assert(hex_decode(hex, 39, data, 20) == -1);
+}
+
+static void test_sizes(void) {
+    const uint8_t data[4] = {0xde, 0xad, 0xbe, 0xef};
+    char hex[9];
+    memset(hex, 'x', sizeof(hex));
+    assert(hex_encode(data, 4, hex, 8) == -1);
+    assert(hex[0] == 'x');
+
+    char message[16] = "atd,3,";
+    assert(hex_append(message, sizeof(message), data, 4) == 14);
+    assert(strcmp(message, "atd,3,deadbeef") == 0);
+    assert(hex_append(message, sizeof(message), data, 1) == -1);
+    assert(strcmp(message, "atd,3,deadbeef") == 0);
+}
+
+int main(void) {
+    test_round_trip();
+    test_decode_input();
+    test_sizes();
+    printf("test_hex: OK\n");
+    return 0;
+}
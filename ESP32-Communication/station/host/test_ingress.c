@@ -0,0 +1,97 @@
+/* Host test for the ingress classification and per source rate limiting. */
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include "networking/ingress.h"
+
+static void test_classify(void) {
+    assert(ingress_classify("bcb;1;2;", 8) == INGRESS_PRIORITY_HIGH);
+    assert(ingress_classify("atd;", 4) == INGRESS_PRIORITY_HIGH);
+    assert(ingress_classify("rpk;", 4) == INGRESS_PRIORITY_NORMAL);
+    assert(ingress_classify("rcs,2,40;", 9) == INGRESS_PRIORITY_NORMAL);
+    assert(ingress_classify("cbk,1,5,20,2,", 13) == INGRESS_PRIORITY_NORMAL);
+    assert(ingress_classify("psn,2,300,", 10) == INGRESS_PRIORITY_NORMAL);
+    assert(ingress_classify("bca;12;3;", 9) == INGRESS_PRIORITY_LOW);
+    assert(ingress_classify("dpr;", 4) == INGRESS_PRIORITY_LOW);
+    assert(ingress_classify("dtr;", 4) == INGRESS_PRIORITY_LOW);
+
+    assert(ingress_classify("xyz;", 4) == INGRESS_UNKNOWN);
+    assert(ingress_classify("bcb", 3) == INGRESS_UNKNOWN);
+    assert(ingress_classify("", 0) == INGRESS_UNKNOWN);
+}
+
+static void test_burst_and_refill(void) {
+    ingress_limiter_t limiter;
+    ingress_limiter_init(&limiter);
+
+    // A new source may send a full burst at once
+    for (int i = 0; i < INGRESS_BURST; i++) {
+        assert(ingress_admit(&limiter, 1, 1000));
+    }
+    assert(!ingress_admit(&limiter, 1, 1000));
+    assert(limiter.rate_limited == 1);
+
+    // One token comes back every 1000 / INGRESS_RATE_PER_S ms
+    int64_t refill_ms = 1000 / INGRESS_RATE_PER_S;
+    assert(!ingress_admit(&limiter, 1, 1000 + refill_ms - 1));
+    assert(ingress_admit(&limiter, 1, 1000 + refill_ms));
+    assert(!ingress_admit(&limiter, 1, 1000 + refill_ms));
+
+    // A long pause refills the bucket, but never past the burst
+    int64_t later = 100000;
+    for (int i = 0; i < INGRESS_BURST; i++) {
+        assert(ingress_admit(&limiter, 1, later));
+    }
+    assert(!ingress_admit(&limiter, 1, later));
+}
+
+static void test_flooding_source(void) {
+    ingress_limiter_t limiter;
+    ingress_limiter_init(&limiter);
+    int flood_admitted = 0;
+    int other_admitted = 0;
+
+    // One source sends a packet every millisecond for 10 seconds, another one every 100 ms
+    for (int64_t now_ms = 0; now_ms < 10000; now_ms++) {
+        flood_admitted += ingress_admit(&limiter, 0xBAD, now_ms);
+        if (now_ms % 100 == 0) {
+            other_admitted += ingress_admit(&limiter, 0x600D, now_ms);
+        }
+    }
+
+    assert(flood_admitted <= INGRESS_BURST + 10 * INGRESS_RATE_PER_S + 1);
+    assert(other_admitted == 100);
+}
+
+static void test_source_eviction(void) {
+    ingress_limiter_t limiter;
+    ingress_limiter_init(&limiter);
+
+    // Empty the bucket of source 1, then fill the table with sources seen later
+    while (ingress_admit(&limiter, 1, 0)) {
+    }
+    for (uint32_t ip = 2; ip <= INGRESS_MAX_SOURCES; ip++) {
+        assert(ingress_admit(&limiter, ip, 1));
+    }
+    assert(limiter.source_amount == INGRESS_MAX_SOURCES);
+
+    // A new source replaces the one seen longest ago
+    assert(ingress_admit(&limiter, 100, 2));
+    assert(limiter.source_amount == INGRESS_MAX_SOURCES);
+    for (int i = 0; i < limiter.source_amount; i++) {
+        assert(limiter.sources[i].ip != 1);
+    }
+
+    // A forgotten source starts over with a full bucket
+    assert(ingress_admit(&limiter, 1, 3));
+}
+
+int main(void) {
+    test_classify();
+    test_burst_and_refill();
+    test_flooding_source();
+    test_source_eviction();
+    printf("test_ingress: OK\n");
+    return 0;
+}
@@ -0,0 +1,258 @@
+/* Host test for the settlement ledger, checked against summing over the whole chain. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "blockchain/ledger.h"
+
+#define BLOCKS 200
+
+typedef struct {
+    int seller;
+    int buyer;
+    int price;
+    int duration;
+    char hash[LEDGER_HASH_SIZE];
+} test_block_t;
+
+static test_block_t chain[BLOCKS];
+
+// What the ledger replaces: a walk over every block up to the height
+static void chain_scan(int height, int node_id, int64_t *balance, uint32_t *seconds_sold) {
+    *balance = 0;
+    *seconds_sold = 0;
+    for (int i = 0; i < height; i++) {
+        int64_t amount = (int64_t)chain[i].price * chain[i].duration;
+        if (chain[i].seller == node_id) {
+            *balance += amount;
+            *seconds_sold += chain[i].duration;
+        }
+        if (chain[i].buyer == node_id) {
+            *balance -= amount;
+        }
+    }
+}
+
+static void test_against_chain_scan(void) {
+    static ledger_t ledger;
+    ledger_init(&ledger);
+    assert(ledger_latest_snapshot(&ledger) == NULL);
+
+    srand(6666);
+    for (int i = 0; i < BLOCKS; i++) {
+        test_block_t *block = &chain[i];
+        block->seller = 1 + rand() % 9;
+        block->buyer = 1 + (block->seller + rand() % 8) % 9;
+        block->price = 1 + rand() % 20;
+        block->duration = 5 * (rand() % 13);   // 0 when no phase was validated
+        memset(block->hash, i, LEDGER_HASH_SIZE);
+        assert(ledger_apply(&ledger, block->seller, block->buyer, block->price, block->duration, block->hash) == 0);
+
+        for (int node = 0; node < LEDGER_MAX_NODES; node++) {
+            int64_t balance;
+            uint32_t seconds_sold;
+            chain_scan(i + 1, node, &balance, &seconds_sold);
+            assert(ledger_balance(&ledger, node) == balance);
+            assert(ledger_account(&ledger, node)->seconds_sold == seconds_sold);
+        }
+        assert(ledger.state.digest == ledger_compute_digest(&ledger.state));
+    }
+    assert(ledger.state.height == BLOCKS);
+    assert(memcmp(ledger.state.tip_hash, chain[BLOCKS - 1].hash, LEDGER_HASH_SIZE) == 0);
+
+    // Balances net out, and what is owed adds up to what was spent
+    int64_t total = 0;
+    for (int buyer = 0; buyer < LEDGER_MAX_NODES; buyer++) {
+        int64_t owed = 0;
+        for (int seller = 0; seller < LEDGER_MAX_NODES; seller++) {
+            owed += ledger_owed(&ledger, buyer, seller);
+        }
+        assert(owed == ledger_account(&ledger, buyer)->spent);
+        total += ledger_balance(&ledger, buyer);
+    }
+    assert(total == 0);
+
+    // Only the newest snapshots are kept, each one matching the chain at its height
+    uint32_t latest = (BLOCKS / LEDGER_SNAPSHOT_INTERVAL) * LEDGER_SNAPSHOT_INTERVAL;
+    assert(ledger_latest_snapshot(&ledger)->height == latest);
+    assert(ledger_snapshot_at(&ledger, latest - LEDGER_SNAPSHOT_INTERVAL * LEDGER_SNAPSHOTS) == NULL);
+    for (int i = 0; i < LEDGER_SNAPSHOTS; i++) {
+        uint32_t height = latest - i * LEDGER_SNAPSHOT_INTERVAL;
+        const ledger_state_t *snapshot = ledger_snapshot_at(&ledger, height);
+        assert(snapshot != NULL && snapshot->height == height);
+        assert(memcmp(snapshot->tip_hash, chain[height - 1].hash, LEDGER_HASH_SIZE) == 0);
+
+        int64_t balance;
+        uint32_t seconds_sold;
+        chain_scan(height, 4, &balance, &seconds_sold);
+        assert(snapshot->accounts[4].earned - snapshot->accounts[4].spent == balance);
+        assert(snapshot->accounts[4].seconds_sold == seconds_sold);
+    }
+}
+
+static void test_invalid_blocks(void) {
+    static ledger_t ledger;
+    char hash[LEDGER_HASH_SIZE] = {0};
+    ledger_init(&ledger);
+
+    assert(ledger_apply(&ledger, 3, 3, 10, 30, hash) == -1);
+    assert(ledger_apply(&ledger, -1, 3, 10, 30, hash) == -1);
+    assert(ledger_apply(&ledger, 3, LEDGER_MAX_NODES, 10, 30, hash) == -1);
+    assert(ledger.state.height == 0);
+
+    assert(ledger_account(&ledger, LEDGER_MAX_NODES) == NULL);
+    assert(ledger_balance(&ledger, -1) == 0);
+    assert(ledger_owed(&ledger, 3, 99) == 0);
+
+    // A block without validated phases moves the height but no energy
+    assert(ledger_apply(&ledger, 5, 3, 10, 0, hash) == 0);
+    assert(ledger.state.height == 1);
+    assert(ledger_account(&ledger, 5)->trades_sold == 0);
+    assert(ledger_balance(&ledger, 5) == 0);
+}
+
+static void test_digest(void) {
+    static ledger_t ledger;
+    static ledger_t other;
+    char hash[LEDGER_HASH_SIZE] = {0};
+    ledger_init(&ledger);
+    ledger_init(&other);
+    assert(ledger.state.digest == 0);
+
+    // The same trades give the same digest, a different price or pair does not
+    assert(ledger_apply(&ledger, 2, 3, 10, 30, hash) == 0);
+    assert(ledger_apply(&other, 2, 3, 10, 30, hash) == 0);
+    assert(ledger.state.digest == other.state.digest && ledger.state.digest != 0);
+    assert(ledger_apply(&ledger, 4, 5, 10, 30, hash) == 0);
+    assert(ledger_apply(&other, 4, 5, 11, 30, hash) == 0);
+    assert(ledger.state.digest != other.state.digest);
+    ledger_init(&other);
+    assert(ledger_apply(&other, 2, 3, 10, 30, hash) == 0);
+    assert(ledger_apply(&other, 5, 4, 10, 30, hash) == 0);
+    assert(ledger.state.digest != other.state.digest);
+
+    // The digest only depends on the entries, not on how they got there
+    uint64_t before = ledger.state.digest;
+    ledger_state_t state = ledger.state;
+    state.accounts[6].earned = 1;
+    assert(ledger_compute_digest(&state) != before);
+    state.accounts[6].earned = 0;
+    assert(ledger_compute_digest(&state) == before);
+}
+
+static void test_snapshot_encoding(void) {
+    static ledger_t ledger;
+    static ledger_t restored;
+    static ledger_state_t decoded;
+    static uint8_t buffer[LEDGER_SNAPSHOT_MAX_SIZE];
+    char hash[LEDGER_HASH_SIZE];
+    ledger_init(&ledger);
+
+    // Only the pairs that traded are written
+    srand(45);
+    for (int i = 0; i < LEDGER_SNAPSHOT_INTERVAL * 3; i++) {
+        memset(hash, 'a' + i % 26, LEDGER_HASH_SIZE);
+        int seller = 1 + rand() % 3;
+        assert(ledger_apply(&ledger, seller, 1 + seller % 3, 1 + rand() % 20, 5 * (rand() % 13), hash) == 0);
+    }
+    const ledger_state_t *snapshot = ledger_latest_snapshot(&ledger);
+    int length = ledger_snapshot_encode(snapshot, buffer, sizeof(buffer));
+    assert(length > 0 && length < LEDGER_SNAPSHOT_MAX_SIZE / 2);
+    assert(ledger_snapshot_encode(snapshot, buffer, length - 1) == -1);
+    assert(ledger_snapshot_encode(snapshot, buffer, length) == length);
+
+    assert(ledger_snapshot_decode(buffer, length, &decoded) == 0);
+    assert(memcmp(&decoded, snapshot, sizeof(ledger_state_t)) == 0);
+
+    // A station restored from the snapshot ends up where the original does after the same blocks
+    ledger_restore(&restored, &decoded);
+    assert(ledger_latest_snapshot(&restored)->height == decoded.height);
+    for (int i = 0; i < 10; i++) {
+        memset(hash, 'A' + i, LEDGER_HASH_SIZE);
+        assert(ledger_apply(&ledger, 7, 8, 10, 30, hash) == 0);
+        assert(ledger_apply(&restored, 7, 8, 10, 30, hash) == 0);
+    }
+    assert(memcmp(&restored.state, &ledger.state, sizeof(ledger_state_t)) == 0);
+
+    // A full snapshot, every pair owing something, still fits
+    for (int buyer = 0; buyer < LEDGER_MAX_NODES; buyer++) {
+        for (int seller = 0; seller < LEDGER_MAX_NODES; seller++) {
+            if (buyer == seller) continue;
+            assert(ledger_apply(&ledger, seller, buyer, 1, -5, hash) == 0);
+        }
+    }
+    assert(ledger_snapshot_encode(&ledger.state, buffer, sizeof(buffer)) == LEDGER_SNAPSHOT_MAX_SIZE);
+    assert(ledger_snapshot_decode(buffer, LEDGER_SNAPSHOT_MAX_SIZE, &decoded) == 0);
+    assert(memcmp(&decoded, &ledger.state, sizeof(ledger_state_t)) == 0);
+
+    // Damaged buffers are refused and leave the snapshot as it was
+    memcpy(&decoded, snapshot, sizeof(ledger_state_t));
+    length = ledger_snapshot_encode(snapshot, buffer, sizeof(buffer));
+    for (int cut = 0; cut < length; cut += 7) {
+        assert(ledger_snapshot_decode(buffer, cut, &decoded) == -1);
+    }
+    for (int i = 0; i < length; i += 5) {
+        buffer[i] ^= 0x10;
+        assert(ledger_snapshot_decode(buffer, length, &decoded) == -1);
+        buffer[i] ^= 0x10;
+    }
+    buffer[4] = LEDGER_SNAPSHOT_VERSION + 1;
+    assert(ledger_snapshot_decode(buffer, length, &decoded) == -1);
+    assert(memcmp(&decoded, snapshot, sizeof(ledger_state_t)) == 0);
+}
+
+static ledger_state_t make_candidate(uint32_t height, uint8_t tip) {
+    ledger_state_t state;
+    memset(&state, 0, sizeof(state));
+    state.height = height;
+    memset(state.tip_hash, tip, LEDGER_HASH_SIZE);
+    state.digest = 1000 + tip;
+    return state;
+}
+
+static void test_snapshot_candidates(void) {
+    static ledger_candidates_t candidates;
+    ledger_candidates_init(&candidates);
+    ledger_state_t low = make_candidate(32, 'a');
+    ledger_state_t high = make_candidate(48, 'b');
+    ledger_state_t forged = make_candidate(48, 'c');
+
+    // Members at different heights do not reset each other's count
+    assert(ledger_candidates_add(&candidates, &low, 1, 10) == 1);
+    assert(ledger_candidates_add(&candidates, &high, 2, 10) == 1);
+    assert(ledger_candidates_add(&candidates, &forged, 3, 10) == 1);
+    assert(ledger_candidates_agreed(&candidates, 2) == NULL);
+    assert(ledger_candidates_add(&candidates, &low, 4, 10) == 2);
+    assert(ledger_candidates_agreed(&candidates, 2)->height == 32);
+    assert(ledger_candidates_add(&candidates, &low, 4, 10) == 2);
+
+    // The highest agreed snapshot is taken
+    assert(ledger_candidates_add(&candidates, &high, 5, 10) == 2);
+    const ledger_state_t *agreed = ledger_candidates_agreed(&candidates, 2);
+    assert(agreed->height == 48 && agreed->tip_hash[0] == 'b');
+
+    // A full table replaces the candidate with the fewest senders, the forged one, not the agreed ones
+    ledger_state_t other = make_candidate(64, 'd');
+    ledger_state_t another = make_candidate(80, 'e');
+    assert(ledger_candidates_add(&candidates, &other, 6, 10) == 1);
+    assert(ledger_candidates_add(&candidates, &another, 7, 10) == 1);
+    assert(ledger_candidates_add(&candidates, &low, 8, 10) == 3);
+    assert(ledger_candidates_add(&candidates, &high, 8, 10) == 3);
+
+    // Candidates the station got past are dropped
+    assert(ledger_candidates_add(&candidates, &low, 9, 32) == -1);
+    assert(ledger_candidates_add(&candidates, &high, 9, 32) == 4);
+    assert(ledger_candidates_agreed(&candidates, 5) == NULL);
+    assert(ledger_candidates_add(&candidates, &high, LEDGER_MAX_NODES, 32) == -1);
+}
+
+int main(void) {
+    test_against_chain_scan();
+    test_invalid_blocks();
+    test_digest();
+    test_snapshot_encoding();
+    test_snapshot_candidates();
+    printf("test_ledger: OK\n");
+    return 0;
+}
@@ -0,0 +1,131 @@
+/* Host test for the native load flow.
+ * Without arguments it runs the checks below. With --cases it reads
+ * "load2 load3 load4 load5 load6 buyer seller offer" lines from stdin and prints one estimate per line,
+ * which Testing/test_loadflow.py compares against an independent nodal Newton-Raphson solve. */
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include "grid/loadflow.h"
+
+static void test_no_load(const grid_system_t *system) {
+    double load[GRID_MAX_NODES] = {0};
+    loadflow_result_t result;
+
+    assert(loadflow_solve(system, load, &result) == 0);
+    assert(result.converged);
+    for (int node = 1; node <= 6; node++) {
+        assert(fabs(result.voltage[node] - GRID_BASE_VOLTAGE) < 1e-9);
+    }
+}
+
+static void test_voltage_drop(const grid_system_t *system) {
+    double load[GRID_MAX_NODES] = {0};
+    load[3] = 10;
+    load[5] = 25;
+    load[6] = -5;
+    loadflow_result_t result;
+
+    assert(loadflow_solve(system, load, &result) == 0);
+
+    // The cable into the transformer carries the sum of all (constant power) load currents
+    double total_current = 0;
+    for (int node = 2; node <= 6; node++) {
+        total_current += load[node] * GRID_BASE_VOLTAGE / result.voltage[node];
+    }
+    assert(fabs(result.line_current[2] - total_current) < 1e-6);
+
+    // Consuming nodes sit below their parent
+    assert(result.voltage[2] < GRID_BASE_VOLTAGE);
+    assert(result.voltage[3] < result.voltage[2]);
+    assert(result.voltage[5] < result.voltage[4]);
+}
+
+// One cable with a constant power load at its end has a closed form: V = (V0 + sqrt(V0^2 - 4 R P)) / 2
+static void test_closed_form(void) {
+    grid_system_t system = { .base_voltage = GRID_BASE_VOLTAGE, .line_amount = 1, .lines = {{1, 2, .4}} };
+    double load[GRID_MAX_NODES] = {0};
+    loadflow_result_t result;
+
+    for (int amperage = -60; amperage <= 100; amperage += 20) {
+        load[2] = amperage;
+        double power = amperage * GRID_BASE_VOLTAGE;
+        double expected = (GRID_BASE_VOLTAGE + sqrt(GRID_BASE_VOLTAGE * GRID_BASE_VOLTAGE - 4 * .4 * power)) / 2;
+        assert(loadflow_solve(&system, load, &result) == 0);
+        assert(fabs(result.voltage[2] - expected) < 1e-6);
+    }
+
+    // Past V0^2 / 4R there is no solution (voltage collapse), so the sweep must not report one
+    load[2] = GRID_BASE_VOLTAGE / (4 * .4) + 1;
+    assert(loadflow_solve(&system, load, &result) == -1);
+}
+
+static void test_not_radial(void) {
+    grid_system_t system;
+    loadflow_default_system(&system);
+    // Close a loop between node 3 and node 5
+    system.lines[system.line_amount++] = (grid_line_t){3, 5, .1};
+
+    double load[GRID_MAX_NODES] = {0};
+    loadflow_result_t result;
+    assert(loadflow_solve(&system, load, &result) == -1);
+}
+
+static void test_grid_estimate(const grid_system_t *system) {
+    fixed_t load[GRID_MAX_NODES] = {0};
+    load[3] = FIXED_FROM_INT(10);
+    load[5] = FIXED_FROM_INT(-5);
+
+    // A small trade keeps every node inside the band
+    assert(loadflow_grid_estimate(system, load, 3, 5, FIXED_FROM_INT(-5)) <= 0);
+
+    // Drawing 60 A over the 0.5 ohm cable to node 3 pulls it more than 23 V down
+    assert(loadflow_grid_estimate(system, load, 3, 5, FIXED_FROM_INT(-60)) > 0);
+
+    assert(loadflow_grid_estimate(system, load, 0, 5, FIXED_FROM_INT(-5)) == FIXED_MAX);
+}
+
+// Reads and prints the numbers with the fixed point parser and formatter, like the station does with rlc and plc
+static int run_cases(const grid_system_t *system) {
+    fixed_t load[GRID_MAX_NODES];
+    int buyer;
+    int seller;
+    fixed_t offer;
+    char text[6][32];
+
+    memset(load, 0, sizeof(load));
+    while (scanf("%31s %31s %31s %31s %31s %d %d %31s", text[0], text[1], text[2], text[3], text[4], &buyer, &seller, text[5]) == 8) {
+        for (int node = 2; node <= 6; node++) {
+            if (fixed_parse(text[node - 2], &load[node]) != 0) return 1;
+        }
+        if (fixed_parse(text[5], &offer) != 0) return 1;
+
+        // A failed load flow is FIXED_MAX here and inf in Python
+        char estimate[FIXED_TEXT_SIZE] = "inf";
+        fixed_t result = loadflow_grid_estimate(system, load, buyer, seller, offer);
+        if (result != FIXED_MAX) {
+            fixed_format(result, FIXED_DECIMALS, estimate, sizeof(estimate));
+        }
+        printf("%s\n", estimate);
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    grid_system_t system;
+    loadflow_default_system(&system);
+
+    if (argc > 1 && strcmp(argv[1], "--cases") == 0) {
+        return run_cases(&system);
+    }
+
+    test_no_load(&system);
+    test_voltage_drop(&system);
+    test_closed_form();
+    test_not_radial();
+    test_grid_estimate(&system);
+
+    printf("test_loadflow: OK\n");
+    return 0;
+}
@@ -0,0 +1,96 @@
+/* Host test for the metrics registry. */
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include "diagnostics/metrics.h"
+
+static void test_register(void) {
+    metrics_reset();
+
+    int packets_7777 = metrics_register("laset_udp_packets_received", "port=\"7777\"", METRIC_COUNTER);
+    int packets_8888 = metrics_register("laset_udp_packets_received", "port=\"8888\"", METRIC_COUNTER);
+    assert(packets_7777 != METRIC_NONE && packets_8888 != METRIC_NONE && packets_7777 != packets_8888);
+
+    // Same name and labels gives the same metric, a different type is refused
+    assert(metrics_register("laset_udp_packets_received", "port=\"7777\"", METRIC_COUNTER) == packets_7777);
+    assert(metrics_register("laset_udp_packets_received", "port=\"7777\"", METRIC_GAUGE) == METRIC_NONE);
+
+    // Updating METRIC_NONE or a metric of another type is ignored
+    metrics_counter_add(METRIC_NONE, 1);
+    metrics_gauge_set(packets_7777, 5);
+    assert(metrics_get(packets_7777) == 0);
+
+    char name[METRICS_NAME_SIZE];
+    for (int i = 2; i < METRICS_MAX; i++) {
+        sprintf(name, "filler_%d", i);
+        assert(metrics_register(name, NULL, METRIC_GAUGE) != METRIC_NONE);
+    }
+    assert(metrics_register("one_too_many", NULL, METRIC_GAUGE) == METRIC_NONE);
+}
+
+static void test_render(void) {
+    char text[2048];
+    metrics_reset();
+
+    int packets_7777 = metrics_register("laset_udp_packets_received", "port=\"7777\"", METRIC_COUNTER);
+    int packets_8888 = metrics_register("laset_udp_packets_received", "port=\"8888\"", METRIC_COUNTER);
+    int heap = metrics_register("laset_heap_free_bytes", NULL, METRIC_GAUGE);
+    int verify = metrics_register("laset_signature_verify_us", NULL, METRIC_HISTOGRAM);
+
+    metrics_counter_add(packets_7777, 3);
+    metrics_counter_add(packets_8888, 1);
+    metrics_gauge_set(heap, -12);
+    metrics_histogram_observe(verify, 1);
+    metrics_histogram_observe(verify, 3);
+    metrics_histogram_observe(verify, 1500);
+    metrics_histogram_observe(verify, 4000000000u);
+
+    int length = metrics_render(text, sizeof(text));
+    assert(length > 0 && length == (int)strlen(text));
+    printf("%s", text);
+
+    assert(strstr(text, "# TYPE laset_udp_packets_received counter\n"
+                        "laset_udp_packets_received{port=\"7777\"} 3\n"
+                        "laset_udp_packets_received{port=\"8888\"} 1\n") != NULL);
+    assert(strstr(text, "laset_heap_free_bytes -12\n") != NULL);
+    assert(strstr(text, "laset_signature_verify_us_bucket{le=\"1\"} 1\n") != NULL);
+    assert(strstr(text, "laset_signature_verify_us_bucket{le=\"4\"} 2\n") != NULL);
+    assert(strstr(text, "laset_signature_verify_us_bucket{le=\"1024\"} 2\n") != NULL);
+    assert(strstr(text, "laset_signature_verify_us_bucket{le=\"4096\"} 3\n") != NULL);
+    assert(strstr(text, "laset_signature_verify_us_bucket{le=\"+Inf\"} 4\n") != NULL);
+    assert(strstr(text, "laset_signature_verify_us_sum 4000001504\n") != NULL);
+    assert(strstr(text, "laset_signature_verify_us_count 4\n") != NULL);
+
+    // Too small buffers are refused instead of truncated
+    assert(metrics_render(text, 40) == -1);
+}
+
+static int contended_counter;
+
+static void *add_many(void *arg) {
+    (void)arg;
+    for (int i = 0; i < 100000; i++) {
+        metrics_counter_add(contended_counter, 1);
+    }
+    return NULL;
+}
+
+static void test_concurrent_updates(void) {
+    pthread_t threads[4];
+    metrics_reset();
+    contended_counter = metrics_register("contended", NULL, METRIC_COUNTER);
+
+    for (int i = 0; i < 4; i++) pthread_create(&threads[i], NULL, add_many, NULL);
+    for (int i = 0; i < 4; i++) pthread_join(threads[i], NULL);
+    assert(metrics_get(contended_counter) == 400000);
+}
+
+int main(void) {
+    test_register();
+    test_render();
+    test_concurrent_updates();
+    printf("test_metrics: OK\n");
+    return 0;
+}
@@ -0,0 +1,127 @@
+/* Host test for the packet buffer pool. */
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "networking/packet_pool.h"
+
+// Counts the free buffers by taking all of them, and puts them back
+static int free_buffers(void) {
+    packet_t *taken[PACKET_POOL_SIZE];
+    int amount = 0;
+    while (amount < PACKET_POOL_SIZE && (taken[amount] = packet_acquire()) != NULL) {
+        amount++;
+    }
+    for (int i = 0; i < amount; i++) {
+        packet_release(taken[i]);
+    }
+    return amount;
+}
+
+static void test_acquire_release(void) {
+    packet_t *packets[PACKET_POOL_SIZE];
+    packet_pool_init();
+
+    for (int i = 0; i < PACKET_POOL_SIZE; i++) {
+        packets[i] = packet_acquire();
+        assert(packets[i] != NULL);
+        assert(packets[i]->in_use == 1);
+    }
+    assert(packet_acquire() == NULL);
+
+    packet_release(packets[0]);
+    assert(free_buffers() == 1);
+
+    // Releasing again is refused and does not free the buffer twice
+    packet_release(packets[0]);
+    assert(free_buffers() == 1);
+
+    // The freed buffer is handed out again
+    assert(packet_acquire() == packets[0]);
+
+    for (int i = 0; i < PACKET_POOL_SIZE; i++) {
+        packet_release(packets[i]);
+    }
+    assert(free_buffers() == PACKET_POOL_SIZE);
+}
+
+static void test_set_length(void) {
+    packet_pool_init();
+    packet_t *packet = packet_acquire();
+
+    memcpy(packet->data, "pni,3;garbage", 13);
+    assert(packet_set_length(packet, 6) == 0);
+    assert(strcmp(packet->data, "pni,3;") == 0);
+
+    assert(packet_set_length(packet, PACKET_BUFFER_SIZE) == -1);
+    assert(packet->length == 0);
+    assert(packet_set_length(packet, -1) == -1);
+    packet_release(packet);
+}
+
+// Producers hand packets to a consumer through a small ring, like a receiver and its handler
+#define HANDOFFS 100000
+static packet_t *handoff[4];
+static int handoff_head = 0, handoff_tail = 0;
+static pthread_mutex_t handoff_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void *produce(void *arg) {
+    (void)arg;
+    for (int sent = 0; sent < HANDOFFS;) {
+        packet_t *packet = packet_acquire();
+        if (packet == NULL) {
+            sched_yield();
+            continue;
+        }
+        packet_set_length(packet, sprintf(packet->data, "%d", sent));
+
+        pthread_mutex_lock(&handoff_lock);
+        if (handoff_head - handoff_tail < 4) {
+            handoff[handoff_head++ % 4] = packet;
+            sent++;
+            packet = NULL;
+        }
+        pthread_mutex_unlock(&handoff_lock);
+        if (packet != NULL) {
+            packet_release(packet);
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void test_handoff(void) {
+    pthread_t producer;
+    packet_pool_init();
+    pthread_create(&producer, NULL, produce, NULL);
+
+    for (int received = 0; received < HANDOFFS;) {
+        packet_t *packet = NULL;
+        pthread_mutex_lock(&handoff_lock);
+        if (handoff_tail < handoff_head) packet = handoff[handoff_tail++ % 4];
+        pthread_mutex_unlock(&handoff_lock);
+        if (packet == NULL) {
+            sched_yield();
+            continue;
+        }
+
+        // The consumer sees what the producer wrote, in order
+        int value;
+        sscanf(packet->data, "%d", &value);
+        assert(value == received);
+        received++;
+        packet_release(packet);
+    }
+    pthread_join(producer, NULL);
+    assert(free_buffers() == PACKET_POOL_SIZE);
+}
+
+int main(void) {
+    test_acquire_release();
+    test_set_length();
+    test_handoff();
+    printf("test_packet_pool: OK\n");
+    return 0;
+}
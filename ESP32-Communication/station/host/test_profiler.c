@@ -0,0 +1,64 @@
+/* Host test for the cycle profiler. */
+#include <stdio.h>
+#include <assert.h>
+
+#include "diagnostics/profiler.h"
+
+static volatile uint32_t sink;
+
+static void busy_work(int iterations) {
+    for (int i = 0; i < iterations; i++) {
+        sink += i;
+    }
+}
+
+static void test_record(void) {
+    profile_stats_t stats;
+    profiler_reset();
+
+    profiler_record(PROFILE_SIGN_MESSAGE, 100);
+    profiler_record(PROFILE_SIGN_MESSAGE, 300);
+    profiler_record(PROFILE_SITE_AMOUNT, 5);    // Unknown sites are ignored
+
+    profiler_get_stats(PROFILE_SIGN_MESSAGE, &stats);
+    assert(stats.count == 2);
+    assert(stats.total_cycles == 400);
+    assert(stats.max_cycles == 300);
+
+    profiler_get_stats(PROFILE_VERIFY_MESSAGE, &stats);
+    assert(stats.count == 0);
+}
+
+static void test_macros(void) {
+    profile_stats_t short_stats, long_stats;
+    profiler_reset();
+
+    for (int i = 0; i < 10; i++) {
+        PROFILE_BEGIN(PROFILE_PAYLOAD_DECODER);
+        busy_work(100);
+        PROFILE_END(PROFILE_PAYLOAD_DECODER);
+
+        PROFILE_BEGIN(PROFILE_VERIFY_BLOCK_SIGNATURES);
+        busy_work(100000);
+        PROFILE_END(PROFILE_VERIFY_BLOCK_SIGNATURES);
+    }
+
+    profiler_get_stats(PROFILE_PAYLOAD_DECODER, &short_stats);
+    profiler_get_stats(PROFILE_VERIFY_BLOCK_SIGNATURES, &long_stats);
+#if PROFILER_ENABLED
+    assert(short_stats.count == 10 && long_stats.count == 10);
+    assert(long_stats.total_cycles > short_stats.total_cycles);
+    assert(long_stats.max_cycles > 0);
+#else
+    assert(short_stats.count == 0 && long_stats.count == 0);
+#endif
+
+    profiler_dump();
+}
+
+int main(void) {
+    test_record();
+    test_macros();
+    printf("test_profiler: OK\n");
+    return 0;
+}
@@ -0,0 +1,161 @@
+/* Host test for quorum certificates: cumulative votes, the duration they validate, verification against a stand-in
+ * signature, and the encoding round trip. */
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include "blockchain/quorum.h"
+
+static const char block_hash[QUORUM_HASH_SIZE] = "block voted for in this test....";
+
+#define ALL_MEMBERS ((1 << QUORUM_SIGNERS) - 1)
+
+// Stand-in for RSA: a checksum of the signed message, keyed by the node id
+static void sign(int node_id, const uint8_t *msg, size_t msg_size, uint8_t signature[QUORUM_SIGNATURE_SIZE]) {
+    uint32_t state = 2166136261u ^ (uint32_t)node_id;
+    for (size_t i = 0; i < msg_size; i++) {
+        state = (state ^ msg[i]) * 16777619u;
+    }
+    for (int i = 0; i < QUORUM_SIGNATURE_SIZE; i++) {
+        state = state * 1103515245u + 12345u;
+        signature[i] = (uint8_t)(state >> 24);
+    }
+}
+
+static int verified_signatures = 0;
+
+static int verify(int node_id, uint8_t *message, size_t message_size, uint8_t *signature) {
+    uint8_t expected[QUORUM_SIGNATURE_SIZE];
+    sign(node_id, message, message_size, expected);
+    verified_signatures++;
+    return memcmp(expected, signature, QUORUM_SIGNATURE_SIZE) == 0 ? 0 : -1;
+}
+
+// Signs a vote like a station does before broadcasting it, and adds it
+static int vote(quorum_certificate_t *certificate, int node_id, uint16_t phases) {
+    uint8_t msg[256];
+    uint8_t signature[QUORUM_SIGNATURE_SIZE];
+    quorum_vote_message(msg, sizeof(msg), node_id, phases, block_hash);
+    sign(node_id, msg, sizeof(msg), signature);
+    return quorum_add_vote(certificate, node_id, phases, signature);
+}
+
+static void test_votes(void) {
+    quorum_certificate_t certificate;
+    quorum_init(&certificate, block_hash, 20, ALL_MEMBERS);      // 4 phases
+    assert(quorum_duration(&certificate, 1) == 0);
+
+    // Votes grow with every phase a node accepts, only the newest is kept
+    assert(vote(&certificate, 1, 0x1) == 0);
+    assert(vote(&certificate, 1, 0x3) == 0);
+    assert(vote(&certificate, 1, 0x1) == -1);       // Older than the kept one
+    assert(vote(&certificate, 2, 0x3) == 0);
+    assert(vote(&certificate, 3, 0x6) == 0);
+    assert(vote(&certificate, 3, 0x9) == -1);       // Drops phases it accepted before
+    assert(certificate.signers == 0xE && certificate.phases[1] == 0x3);
+
+    // Out of range node ids and phases are not taken
+    assert(vote(&certificate, QUORUM_SIGNERS, 0x1) == -1);
+    assert(vote(&certificate, 4, 0) == -1);
+    assert(vote(&certificate, 4, 1 << QUORUM_PHASES) == -1);
+
+    // Phase 1: nodes 1, 2. Phase 2: nodes 1, 2, 3. Phase 3: node 3. Phase 4: none
+    assert(quorum_duration(&certificate, 1) == 15);
+    assert(quorum_duration(&certificate, 2) == 10);
+    assert(quorum_duration(&certificate, 3) == 5);
+    assert(quorum_duration(&certificate, 4) == 0);
+
+    // Phases past the voted duration never count
+    assert(vote(&certificate, 4, 0x7FF) == 0);
+    assert(quorum_duration(&certificate, 1) == 20);
+    assert(quorum_duration(&certificate, 0) == 20);
+}
+
+static void test_verify(void) {
+    quorum_certificate_t certificate;
+    quorum_init(&certificate, block_hash, 30, ALL_MEMBERS);
+    for (int node_id = 0; node_id < 5; node_id++) {
+        assert(vote(&certificate, node_id, (node_id < 3) ? 0x3F : 0x0F) == 0);
+    }
+    assert(quorum_verify(&certificate, 3, 30, verify) == 0);
+    assert(verified_signatures == 5);
+    assert(quorum_verify(&certificate, 4, 30, verify) == -1);        // Only 3 signers accepted the last two phases
+    assert(quorum_verify(&certificate, 4, 20, verify) == 0);
+
+    // A committer can not claim phases or a block the signers did not sign
+    quorum_certificate_t tampered = certificate;
+    tampered.phases[3] = 0x3F;
+    assert(quorum_verify(&tampered, 4, 30, verify) == -1);
+    tampered = certificate;
+    tampered.hash[0] ^= 1;
+    assert(quorum_verify(&tampered, 3, 30, verify) == -1);
+    tampered = certificate;
+    tampered.signatures[4][10] ^= 1;
+    assert(quorum_verify(&tampered, 3, 30, verify) == -1);
+}
+
+static void test_encoding(void) {
+    quorum_certificate_t certificate;
+    quorum_init(&certificate, block_hash, 60, ALL_MEMBERS);
+    assert(vote(&certificate, 0, 0x00F) == 0);
+    assert(vote(&certificate, 7, 0xFFF) == 0);
+    assert(vote(&certificate, 9, 0x800) == 0);
+
+    // Only the signers that voted take room
+    uint8_t buffer[QUORUM_MAX_ENCODED_SIZE];
+    int length = quorum_encode(&certificate, buffer, sizeof(buffer));
+    assert(length == QUORUM_HEADER_ENCODED_SIZE + 3 * QUORUM_SIGNER_ENCODED_SIZE);
+    assert(quorum_encode(&certificate, buffer, length - 1) == -1);
+
+    quorum_certificate_t decoded;
+    assert(quorum_decode(buffer, length, &decoded) == 0);
+    assert(memcmp(&decoded, &certificate, sizeof(quorum_certificate_t)) == 0);
+    assert(quorum_verify(&decoded, 2, 25, verify) == 0);        // Phases 1 to 4 and 12
+
+    // Cut off or naming a node id out of range, the certificate stays as it was
+    quorum_certificate_t unchanged = decoded;
+    assert(quorum_decode(buffer, length - 1, &decoded) == -1);
+    assert(quorum_decode(buffer, QUORUM_HEADER_ENCODED_SIZE - 1, &decoded) == -1);
+    buffer[QUORUM_HASH_SIZE + 3] |= 0x80;
+    assert(quorum_decode(buffer, length, &decoded) == -1);
+    buffer[QUORUM_HASH_SIZE + 3] &= 0x7F;
+    buffer[QUORUM_HASH_SIZE + 5] |= 0x80;
+    assert(quorum_decode(buffer, length, &decoded) == -1);
+    assert(memcmp(&decoded, &unchanged, sizeof(quorum_certificate_t)) == 0);
+
+    quorum_certificate_t full;
+    quorum_init(&full, block_hash, 60, ALL_MEMBERS);
+    for (int node_id = 0; node_id < QUORUM_SIGNERS; node_id++) {
+        assert(vote(&full, node_id, 0xFFF) == 0);
+    }
+    assert(quorum_encode(&full, buffer, sizeof(buffer)) == QUORUM_MAX_ENCODED_SIZE);
+}
+
+static void test_members(void) {
+    // The threshold comes from the modules recorded with the votes
+    quorum_certificate_t certificate;
+    quorum_init(&certificate, block_hash, 10, 0x1F);
+    assert(quorum_member_amount(&certificate) == 5 && quorum_needed(&certificate) == 3);
+    quorum_init(&certificate, block_hash, 10, 0x7);
+    assert(quorum_needed(&certificate) == 2);
+
+    // Only members can vote, and a certificate with a signer outside them does not verify
+    assert(vote(&certificate, 5, 0x3) == -1);
+    assert(vote(&certificate, 0, 0x3) == 0);
+    assert(vote(&certificate, 1, 0x3) == 0);
+    assert(quorum_verify(&certificate, quorum_needed(&certificate), 10, verify) == 0);
+    quorum_certificate_t tampered = certificate;
+    tampered.members = 0x3;
+    assert(quorum_verify(&tampered, quorum_needed(&tampered), 10, verify) == 0);
+    tampered.members = 0x1;
+    assert(quorum_verify(&tampered, quorum_needed(&tampered), 10, verify) == -1);
+}
+
+int main(void) {
+    test_votes();
+    test_verify();
+    test_members();
+    test_encoding();
+    printf("test_quorum: OK\n");
+    return 0;
+}
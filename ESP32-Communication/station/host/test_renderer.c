@@ -0,0 +1,139 @@
+/* Host test and frame cost benchmark for the dirty region renderer. */
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+
+#include "graphics/renderer.h"
+
+// Screen content: one color everywhere, except a box that can be moved
+typedef struct {
+    uint16_t background;
+    uint16_t box_color;
+    int box_x, box_y, box_size;
+    int painted_pixels;
+} scene_t;
+
+static void paint_scene(void *context, int x, int y, int width, int height, uint16_t *pixels) {
+    scene_t *scene = (scene_t *)context;
+    for (int row = 0; row < height; row++) {
+        for (int column = 0; column < width; column++) {
+            int px = x + column;
+            int py = y + row;
+            bool in_box = px >= scene->box_x && px < scene->box_x + scene->box_size && py >= scene->box_y && py < scene->box_y + scene->box_size;
+            pixels[row * width + column] = in_box ? scene->box_color : scene->background;
+        }
+    }
+    scene->painted_pixels += width * height;
+}
+
+static render_memory_t memory;
+
+static void check_screen(const scene_t *scene) {
+    uint16_t expected[PARALLEL_LINES * SCREEN_WIDTH];
+    for (int y = 0; y < SCREEN_HEIGHT; y += PARALLEL_LINES) {
+        scene_t copy = *scene;
+        paint_scene(&copy, 0, y, SCREEN_WIDTH, PARALLEL_LINES, expected);
+        assert(memcmp(&memory.pixels[y * SCREEN_WIDTH], expected, sizeof(expected)) == 0);
+    }
+}
+
+static void test_full_and_partial_flush(void) {
+    scene_t scene = { .background = 0x1234, .box_color = 0xF800, .box_x = 40, .box_y = 40, .box_size = 20 };
+    renderer_t renderer;
+    render_backend_t backend = render_memory_backend(&memory);
+    assert(renderer_init(&renderer, paint_scene, &scene, &backend) == 0);
+
+    // The first flush sends the whole screen, one run per band
+    assert(renderer_flush(&renderer) == RENDER_TILE_ROWS);
+    assert(renderer.stats.pixels == SCREEN_WIDTH * SCREEN_HEIGHT);
+    check_screen(&scene);
+
+    // Nothing changed, nothing is sent
+    assert(!renderer_is_dirty(&renderer));
+    assert(renderer_flush(&renderer) == 0);
+    assert(renderer.stats.frames == 1);
+
+    // Moving the box only repaints the tiles of the old and new position
+    renderer_invalidate(&renderer, scene.box_x, scene.box_y, scene.box_size, scene.box_size);
+    scene.box_x = 100;
+    renderer_invalidate(&renderer, scene.box_x, scene.box_y, scene.box_size, scene.box_size);
+    scene.painted_pixels = 0;
+    int transfers = renderer_flush(&renderer);
+    assert(transfers > 0 && transfers <= 4);
+    assert(scene.painted_pixels < SCREEN_WIDTH * SCREEN_HEIGHT / 10);
+    check_screen(&scene);
+
+    renderer_free(&renderer);
+}
+
+static void test_invalidate_and_merge(void) {
+    scene_t scene = { .background = 0 };
+    renderer_t renderer;
+    render_backend_t backend = render_memory_backend(&memory);
+    assert(renderer_init(&renderer, paint_scene, &scene, &backend) == 0);
+    renderer_flush(&renderer);
+
+    // Outside the screen is ignored, a rectangle on a tile corner marks four tiles
+    renderer_invalidate(&renderer, -50, -50, 10, 10);
+    renderer_invalidate(&renderer, SCREEN_WIDTH, 0, 10, 10);
+    assert(!renderer_is_dirty(&renderer));
+    renderer_invalidate(&renderer, RENDER_TILE_SIZE - 1, RENDER_TILE_SIZE - 1, 2, 2);
+    assert(renderer.dirty[0] == 0x3 && renderer.dirty[1] == 0x3);
+    assert(renderer_flush(&renderer) == 2);
+
+    // Tiles one apart are sent as one run, tiles further apart as two
+    renderer_invalidate(&renderer, 0, 0, 1, 1);
+    renderer_invalidate(&renderer, 2 * RENDER_TILE_SIZE, 0, 1, 1);
+    assert(renderer_flush(&renderer) == 1);
+    renderer_invalidate(&renderer, 0, 0, 1, 1);
+    renderer_invalidate(&renderer, 3 * RENDER_TILE_SIZE, 0, 1, 1);
+    renderer_invalidate(&renderer, (RENDER_TILE_COLUMNS - 1) * RENDER_TILE_SIZE, 0, 1, 1);
+    assert(renderer_flush(&renderer) == 3);
+    assert(!renderer_is_dirty(&renderer));
+
+    renderer_free(&renderer);
+}
+
+static double elapsed_us(struct timespec start, struct timespec end) {
+    return (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3;
+}
+
+// Prints what a full redraw costs compared to redrawing a small changed area
+static void benchmark(void) {
+    const int frames = 200;
+    scene_t scene = { .background = 0x1234, .box_color = 0xF800, .box_x = 0, .box_y = 100, .box_size = 24 };
+    renderer_t renderer;
+    render_backend_t backend = render_memory_backend(&memory);
+    struct timespec start, end;
+    assert(renderer_init(&renderer, paint_scene, &scene, &backend) == 0);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < frames; i++) {
+        renderer_invalidate_all(&renderer);
+        renderer_flush(&renderer);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double full_us = elapsed_us(start, end) / frames;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < frames; i++) {
+        renderer_invalidate(&renderer, scene.box_x, scene.box_y, scene.box_size, scene.box_size);
+        scene.box_x = (scene.box_x + 1) % (SCREEN_WIDTH - scene.box_size);
+        renderer_invalidate(&renderer, scene.box_x, scene.box_y, scene.box_size, scene.box_size);
+        renderer_flush(&renderer);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double dirty_us = elapsed_us(start, end) / frames;
+
+    printf("test_renderer: full frame %.1f us, moving box %.1f us per frame\n", full_us, dirty_us);
+    renderer_free(&renderer);
+}
+
+int main(void) {
+    test_full_and_partial_flush();
+    test_invalidate_and_merge();
+    benchmark();
+    printf("test_renderer: OK\n");
+    return 0;
+}
@@ -0,0 +1,47 @@
+/* Host test for the task plan, where roles map to thread affinity. */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <assert.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "scheduling/task_plan.h"
+
+static int ran_on_core[TASK_ROLE_AMOUNT];
+
+static void record_core(void *param) {
+    task_role_t role = (task_role_t)(long)param;
+    ran_on_core[role] = sched_getcpu();
+}
+
+static void test_roles(void) {
+    // The network and background roles share a core, crypto gets the other one when there are two
+    assert(task_plan_core(TASK_ROLE_NETWORK) == task_plan_core(TASK_ROLE_BACKGROUND));
+    assert(task_plan_priority(TASK_ROLE_NETWORK) > task_plan_priority(TASK_ROLE_BACKGROUND));
+    assert(task_plan_priority(TASK_ROLE_CRYPTO) > task_plan_priority(TASK_ROLE_BACKGROUND));
+    assert(task_plan_core(TASK_ROLE_AMOUNT) == 0);
+}
+
+static void test_affinity(void) {
+    task_plan_handle_t handles[TASK_ROLE_AMOUNT];
+
+    for (int role = 0; role < TASK_ROLE_AMOUNT; role++) {
+        ran_on_core[role] = -1;
+        assert(task_plan_create(record_core, "test", 4096, (void *)(long)role, role, &handles[role]) == 0);
+    }
+    for (int role = 0; role < TASK_ROLE_AMOUNT; role++) {
+        pthread_join(handles[role], NULL);
+        printf("%-10s ran on core %d\n", task_plan_role_name(role), ran_on_core[role]);
+        assert(ran_on_core[role] == task_plan_core(role));
+    }
+
+    assert(task_plan_apply_to_self(TASK_ROLE_CRYPTO) == 0);
+    assert(sched_getcpu() == task_plan_core(TASK_ROLE_CRYPTO));
+}
+
+int main(void) {
+    test_roles();
+    test_affinity();
+    printf("test_task_plan: OK\n");
+    return 0;
+}
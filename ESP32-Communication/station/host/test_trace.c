@@ -0,0 +1,85 @@
+/* Host test for trade lifecycle tracing. */
+#include <stdio.h>
+#include <assert.h>
+
+#include "diagnostics/trace.h"
+
+static void test_stage_latencies(void) {
+    trace_stats_t stats;
+    trace_reset();
+
+    // 100 trades: atd after 1 ms, bcb after 2 ms and commit 30 s later
+    for (int i = 0; i < 100; i++) {
+        uint32_t trade_id = trace_trade_id(3, i, 30);
+        int64_t start = (int64_t)i * 100000000;
+        trace_mark_at(trade_id, TRACE_BCD_BROADCAST, start);
+        trace_mark_at(trade_id, TRACE_ATD_VERIFIED, start + 1000);
+        trace_mark_at(trade_id, TRACE_BCB_BROADCAST, start + 3000);
+        trace_mark_at(trade_id, TRACE_COMMIT, start + 30003000);
+    }
+
+    // Starting a trace is not a latency
+    trace_get_stats(TRACE_BCD_BROADCAST, &stats);
+    assert(stats.count == 0);
+
+    trace_get_stats(TRACE_ATD_VERIFIED, &stats);
+    assert(stats.count == 100);
+    assert(stats.max_us == 1000);
+    assert(stats.p50_us == 1000);   // Bucket upper bound 1023 is capped at the max
+
+    trace_get_stats(TRACE_BCB_BROADCAST, &stats);
+    assert(stats.p99_us == 2000);
+
+    trace_get_stats(TRACE_END_TO_END, &stats);
+    assert(stats.count == 100);
+    assert(stats.total_us == 100ULL * 30003000);
+}
+
+static void test_percentiles(void) {
+    trace_stats_t stats;
+    trace_reset();
+
+    // 99 fast phase votes (about 100 us) and one slow (about 1 s)
+    uint32_t trade_id = trace_trade_id(5, 4, 60);
+    int64_t now = 0;
+    trace_mark_at(trade_id, TRACE_BCB_RECEIVED, now);
+    for (int i = 0; i < 99; i++) {
+        now += 100;
+        trace_mark_at(trade_id, TRACE_PHASE_VOTE, now);
+    }
+    now += 1000000;
+    trace_mark_at(trade_id, TRACE_PHASE_VOTE, now);
+
+    trace_get_stats(TRACE_PHASE_VOTE, &stats);
+    assert(stats.count == 100);
+    assert(stats.p50_us < 128);
+    assert(stats.p99_us < 128);
+    assert(stats.max_us == 1000000);
+}
+
+static void test_oldest_trade_is_dropped(void) {
+    trace_stats_t stats;
+    trace_reset();
+
+    // Start one more trade than can be traced, so the first one is dropped
+    for (int i = 0; i <= TRACE_MAX_TRADES; i++) {
+        trace_mark_at(trace_trade_id(3, i, 5), TRACE_BCB_RECEIVED, i);
+    }
+    trace_mark_at(trace_trade_id(3, 0, 5), TRACE_COMMIT, 1000);
+    trace_mark_at(trace_trade_id(3, 1, 5), TRACE_COMMIT, 1000);
+
+    // Trade 0 is no longer traced so its commit is ignored, trade 1 was still traced
+    trace_get_stats(TRACE_COMMIT, &stats);
+    assert(stats.count == 1);
+    assert(stats.max_us == 999);
+}
+
+int main(void) {
+    test_stage_latencies();
+    test_percentiles();
+    test_oldest_trade_is_dropped();
+    trace_print_report();
+
+    printf("test_trace: OK\n");
+    return 0;
+}
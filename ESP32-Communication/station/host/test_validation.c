@@ -0,0 +1,81 @@
+/* Host test for the validation stage checks and their counters. */
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include "blockchain/validation.h"
+#include "diagnostics/metrics.h"
+
+static void test_header(void) {
+    assert(validation_check_node_id(0) == 0);
+    assert(validation_check_node_id(PK_KEY_ARRAY_SIZE - 1) == 0);
+    assert(validation_check_node_id(-1) == -1);
+    assert(validation_check_node_id(PK_KEY_ARRAY_SIZE) == -1);
+
+    assert(validation_check_block_header(1, 2, 5, 20) == 0);
+    assert(validation_check_block_header(1, 1, 5, 20) == -1);     // Trading with itself
+    assert(validation_check_block_header(1, 12, 5, 20) == -1);    // Unknown buyer slot
+    assert(validation_check_block_header(1, 2, 0, 20) == -1);
+    assert(validation_check_block_header(1, 2, 5, 0) == -1);
+    assert(validation_check_block_header(1, 2, 5, VALIDATION_MAX_DURATION + 5) == -1);
+
+    // A 20 second block has the phases 1 to 4
+    assert(validation_check_phase(1, 20) == 0);
+    assert(validation_check_phase(4, 20) == 0);
+    assert(validation_check_phase(0, 20) == -1);
+    assert(validation_check_phase(5, 20) == -1);
+    assert(validation_check_phase(13, 1000) == -1);
+}
+
+static void test_membership(void) {
+    char key_array[PK_KEY_ARRAY_SIZE][PUBLIC_KEY_SIZE];
+    memset(key_array, 0, sizeof(key_array));
+    key_array[3][PUBLIC_KEY_SIZE - 1] = 0x42;
+
+    assert(validation_check_member(key_array, 3) == 0);
+    assert(validation_check_member(key_array, 4) == -1);
+    assert(validation_check_member(key_array, -1) == -1);
+    assert(validation_check_member(key_array, PK_KEY_ARRAY_SIZE) == -1);
+}
+
+static void test_hash(void) {
+    char head_hash[SHA256_HASH_SIZE];
+    for (int i = 0; i < SHA256_HASH_SIZE; i++) {
+        head_hash[i] = (char)(i * 7);
+    }
+
+    char other_hash[SHA256_HASH_SIZE];
+    memcpy(other_hash, head_hash, sizeof(other_hash));
+    assert(validation_check_hash(head_hash, other_hash) == 0);
+    other_hash[SHA256_HASH_SIZE - 1] ^= 1;
+    assert(validation_check_hash(head_hash, other_hash) == -1);
+}
+
+static void test_counters(void) {
+    metrics_reset();
+    validation_register_metrics();
+
+    assert(validation_record(VALIDATION_HEADER, 0) == 0);
+    assert(validation_record(VALIDATION_HEADER, -1) == -1);
+    assert(validation_record_bool(VALIDATION_SIGNATURE, false) == -1);
+    assert(validation_record_bool(VALIDATION_SIGNATURE, true) == 0);
+    assert(validation_record_bool(VALIDATION_SIGNATURE, true) == 0);
+
+    char text[4096];
+    assert(metrics_render(text, sizeof(text)) > 0);
+    assert(strstr(text, "laset_validation_checks{stage=\"header\",result=\"passed\"} 1") != NULL);
+    assert(strstr(text, "laset_validation_checks{stage=\"header\",result=\"rejected\"} 1") != NULL);
+    assert(strstr(text, "laset_validation_checks{stage=\"signature\",result=\"passed\"} 2") != NULL);
+    assert(strstr(text, "laset_validation_checks{stage=\"membership\",result=\"rejected\"} 0") != NULL);
+
+    assert(strcmp(validation_stage_name(VALIDATION_LINKAGE), "linkage") == 0);
+}
+
+int main(void) {
+    test_header();
+    test_membership();
+    test_hash();
+    test_counters();
+    printf("test_validation: OK\n");
+    return 0;
+}
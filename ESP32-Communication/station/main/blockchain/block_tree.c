@@ -0,0 +1,269 @@
+#include "block_tree.h"
+
+#include <string.h>
+
+void block_tree_init(block_tree_t *tree, const char root_hash[BLOCK_TREE_HASH_SIZE], uint32_t root_height, block_tree_link_t link, block_tree_release_t release) {
+    memset(tree, 0, sizeof(block_tree_t));
+    memcpy(tree->root_hash, root_hash, BLOCK_TREE_HASH_SIZE);
+    tree->root_height = root_height;
+    tree->best = -1;
+    tree->final = -1;
+    tree->final_height = root_height;
+    tree->link = link;
+    tree->release = release;
+}
+
+void block_tree_reset(block_tree_t *tree, const char root_hash[BLOCK_TREE_HASH_SIZE], uint32_t root_height) {
+    for (int i = 0; i < BLOCK_TREE_CAPACITY; i++) {
+        if (tree->nodes[i].used) {
+            tree->release(tree->nodes[i].block);
+        }
+    }
+    for (int i = 0; i < BLOCK_TREE_ORPHANS; i++) {
+        if (tree->orphans[i].used) {
+            tree->release(tree->orphans[i].block);
+        }
+    }
+    block_tree_init(tree, root_hash, root_height, tree->link, tree->release);
+}
+
+static int find_node(const block_tree_t *tree, const char hash[BLOCK_TREE_HASH_SIZE]) {
+    for (int i = 0; i < BLOCK_TREE_CAPACITY; i++) {
+        if (tree->nodes[i].used && memcmp(tree->nodes[i].hash, hash, BLOCK_TREE_HASH_SIZE) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int find_orphan(const block_tree_t *tree, const char hash[BLOCK_TREE_HASH_SIZE]) {
+    for (int i = 0; i < BLOCK_TREE_ORPHANS; i++) {
+        if (tree->orphans[i].used && memcmp(tree->orphans[i].hash, hash, BLOCK_TREE_HASH_SIZE) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// The fork choice: the higher block, and of equal heights the lower hash
+static bool is_better(const block_tree_node_t *node, const block_tree_node_t *best) {
+    if (node->height != best->height) {
+        return node->height > best->height;
+    }
+    return memcmp(node->hash, best->hash, BLOCK_TREE_HASH_SIZE) < 0;
+}
+
+// The ancestor of a node at a height (the node itself at its own height), -1 when that is the root
+static int ancestor_at(const block_tree_t *tree, int index, uint32_t height) {
+    while (index != -1 && tree->nodes[index].height > height) {
+        index = tree->nodes[index].parent;
+    }
+    return index;
+}
+
+// Frees the slot of the oldest final block, its child then links to the root. Returns false if no block is final
+static bool evict_oldest_final(block_tree_t *tree) {
+    int oldest = -1;
+    for (int i = 0; i < BLOCK_TREE_CAPACITY; i++) {
+        if (tree->nodes[i].used && tree->nodes[i].final && tree->nodes[i].parent == -1) {
+            oldest = i;
+            break;
+        }
+    }
+    if (oldest == -1) {
+        return false;
+    }
+
+    block_tree_node_t *node = &tree->nodes[oldest];
+    for (int i = 0; i < BLOCK_TREE_CAPACITY; i++) {
+        if (tree->nodes[i].used && tree->nodes[i].parent == oldest) {
+            tree->nodes[i].parent = -1;
+            tree->link(tree->nodes[i].block, NULL);
+        }
+    }
+    memcpy(tree->root_hash, node->hash, BLOCK_TREE_HASH_SIZE);
+    tree->root_height = node->height;
+    if (tree->final == oldest) {
+        tree->final = -1;
+    }
+    node->used = false;
+    tree->release(node->block);
+    return true;
+}
+
+// Where a block with this previous hash connects: 0 with the parent index (-1 for the root), 1 if the parent is
+// not known, -1 if the parent is behind the final block so the block could never become final
+static int find_parent(const block_tree_t *tree, const char previous_hash[BLOCK_TREE_HASH_SIZE], int *parent) {
+    if (memcmp(previous_hash, tree->root_hash, BLOCK_TREE_HASH_SIZE) == 0) {
+        *parent = -1;
+        return (tree->final == -1) ? 0 : -1;
+    }
+    *parent = find_node(tree, previous_hash);
+    if (*parent == -1) {
+        return 1;
+    }
+    const block_tree_node_t *node = &tree->nodes[*parent];
+    return (*parent == tree->final || node->height > tree->final_height) ? 0 : -1;
+}
+
+static void connect_orphans(block_tree_t *tree, const char hash[BLOCK_TREE_HASH_SIZE]);
+
+// Adds a block whose parent is kept. Returns the node index, or -1 if there is no room
+static int connect_block(block_tree_t *tree, const char hash[BLOCK_TREE_HASH_SIZE], const char previous_hash[BLOCK_TREE_HASH_SIZE], void *block) {
+    int index = -1;
+    while (index == -1) {
+        for (int i = 0; i < BLOCK_TREE_CAPACITY; i++) {
+            if (!tree->nodes[i].used) {
+                index = i;
+                break;
+            }
+        }
+        if (index == -1 && !evict_oldest_final(tree)) {
+            return -1;
+        }
+    }
+    // Looked up after the eviction, which may have turned the parent into the root
+    int parent;
+    if (find_parent(tree, previous_hash, &parent) != 0) {
+        return -1;
+    }
+
+    block_tree_node_t *node = &tree->nodes[index];
+    memcpy(node->hash, hash, BLOCK_TREE_HASH_SIZE);
+    memcpy(node->previous_hash, previous_hash, BLOCK_TREE_HASH_SIZE);
+    node->block = block;
+    node->parent = parent;
+    node->height = ((parent == -1) ? tree->root_height : tree->nodes[parent].height) + 1;
+    node->final = false;
+    node->used = true;
+    tree->link(block, (parent == -1) ? NULL : tree->nodes[parent].block);
+
+    if (tree->best == -1 || is_better(node, &tree->nodes[tree->best])) {
+        tree->best = index;
+    }
+    connect_orphans(tree, hash);
+    return index;
+}
+
+static void connect_orphans(block_tree_t *tree, const char hash[BLOCK_TREE_HASH_SIZE]) {
+    for (int i = 0; i < BLOCK_TREE_ORPHANS; i++) {
+        block_tree_orphan_t *orphan = &tree->orphans[i];
+        if (!orphan->used || memcmp(orphan->previous_hash, hash, BLOCK_TREE_HASH_SIZE) != 0) {
+            continue;
+        }
+        orphan->used = false;
+        if (connect_block(tree, orphan->hash, orphan->previous_hash, orphan->block) == -1) {
+            tree->release(orphan->block);
+        }
+    }
+}
+
+static void expire_orphans(block_tree_t *tree, int64_t now_ms) {
+    for (int i = 0; i < BLOCK_TREE_ORPHANS; i++) {
+        block_tree_orphan_t *orphan = &tree->orphans[i];
+        if (orphan->used && now_ms - orphan->received_ms > BLOCK_TREE_ORPHAN_TIMEOUT_MS) {
+            orphan->used = false;
+            tree->release(orphan->block);
+        }
+    }
+}
+
+// Buffers a block until its parent arrives, replacing the oldest orphan when the buffer is full
+static void add_orphan(block_tree_t *tree, const char hash[BLOCK_TREE_HASH_SIZE], const char previous_hash[BLOCK_TREE_HASH_SIZE], void *block, int64_t now_ms) {
+    int slot = 0;
+    for (int i = 0; i < BLOCK_TREE_ORPHANS; i++) {
+        if (!tree->orphans[i].used) {
+            slot = i;
+            break;
+        }
+        if (tree->orphans[i].received_ms < tree->orphans[slot].received_ms) {
+            slot = i;
+        }
+    }
+    block_tree_orphan_t *orphan = &tree->orphans[slot];
+    if (orphan->used) {
+        tree->release(orphan->block);
+    }
+    memcpy(orphan->hash, hash, BLOCK_TREE_HASH_SIZE);
+    memcpy(orphan->previous_hash, previous_hash, BLOCK_TREE_HASH_SIZE);
+    orphan->block = block;
+    orphan->received_ms = now_ms;
+    orphan->used = true;
+    tree->link(block, NULL);
+}
+
+block_tree_result_t block_tree_add(block_tree_t *tree, const char hash[BLOCK_TREE_HASH_SIZE], const char previous_hash[BLOCK_TREE_HASH_SIZE], void *block, int64_t now_ms) {
+    expire_orphans(tree, now_ms);
+    if (block_tree_contains(tree, hash)) {
+        return BLOCK_TREE_REJECTED;
+    }
+
+    int parent;
+    int found = find_parent(tree, previous_hash, &parent);
+    if (found == 1) {
+        add_orphan(tree, hash, previous_hash, block, now_ms);
+        return BLOCK_TREE_ORPHANED;
+    }
+    if (found != 0 || connect_block(tree, hash, previous_hash, block) == -1) {
+        return BLOCK_TREE_REJECTED;
+    }
+    return BLOCK_TREE_CONNECTED;
+}
+
+void *block_tree_head(const block_tree_t *tree) {
+    return (tree->best == -1) ? NULL : tree->nodes[tree->best].block;
+}
+
+uint32_t block_tree_height(const block_tree_t *tree) {
+    return (tree->best == -1) ? tree->root_height : tree->nodes[tree->best].height;
+}
+
+uint32_t block_tree_root_height(const block_tree_t *tree) {
+    return tree->root_height;
+}
+
+void block_tree_head_hash(const block_tree_t *tree, char hash[BLOCK_TREE_HASH_SIZE]) {
+    memcpy(hash, (tree->best == -1) ? tree->root_hash : tree->nodes[tree->best].hash, BLOCK_TREE_HASH_SIZE);
+}
+
+bool block_tree_contains(const block_tree_t *tree, const char hash[BLOCK_TREE_HASH_SIZE]) {
+    return memcmp(hash, tree->root_hash, BLOCK_TREE_HASH_SIZE) == 0 || find_node(tree, hash) != -1 || find_orphan(tree, hash) != -1;
+}
+
+void *block_tree_take_final(block_tree_t *tree) {
+    if (tree->best == -1 || tree->nodes[tree->best].height < tree->final_height + 1 + BLOCK_TREE_CONFIRMATIONS) {
+        return NULL;
+    }
+    int final = ancestor_at(tree, tree->best, tree->final_height + 1);
+    tree->nodes[final].final = true;
+    tree->final = final;
+    tree->final_height++;
+
+    // Everything not built on the new final block can not win anymore. Marked first, so the walks still find
+    // the parents of the blocks that are dropped
+    bool dropped[BLOCK_TREE_CAPACITY];
+    for (int i = 0; i < BLOCK_TREE_CAPACITY; i++) {
+        const block_tree_node_t *node = &tree->nodes[i];
+        dropped[i] = node->used && node->height >= tree->final_height && ancestor_at(tree, i, tree->final_height) != final;
+    }
+    for (int i = 0; i < BLOCK_TREE_CAPACITY; i++) {
+        if (dropped[i]) {
+            tree->nodes[i].used = false;
+            tree->release(tree->nodes[i].block);
+        }
+    }
+
+    // Only the newest final blocks are kept
+    while (tree->final_height - tree->root_height > BLOCK_TREE_RETAINED) {
+        if (!evict_oldest_final(tree)) break;
+    }
+    return tree->nodes[final].block;
+}
+
+int block_tree_orphan_amount(const block_tree_t *tree) {
+    int amount = 0;
+    for (int i = 0; i < BLOCK_TREE_ORPHANS; i++) {
+        if (tree->orphans[i].used) amount++;
+    }
+    return amount;
+}
@@ -0,0 +1,105 @@
+#ifndef BLOCK_TREE_H
+#define BLOCK_TREE_H
+
+/* Block tree: committed blocks are added by their hash and the hash they link to, so two trades built on the same
+ * parent become two branches instead of one overwriting the other. The head is the tip every station picks the
+ * same way: the highest block, and of blocks at the same height the one with the lowest hash.
+ * A block whose parent has not arrived yet waits in a small orphan buffer and is connected when the parent comes.
+ * A block is final once the head is BLOCK_TREE_CONFIRMATIONS blocks above it. Branches off a final block are
+ * dropped, and only the newest BLOCK_TREE_RETAINED final blocks are kept.
+ * The blocks belong to the caller. The tree keeps a pointer, tells the caller what each block links to through
+ * the link callback, and hands dropped blocks to the release callback. Only depends on the C standard library.
+ * Not thread safe, the caller must serialize access. */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TAG_BLOCK_TREE "LASET_TREE"
+
+#define BLOCK_TREE_HASH_SIZE 32
+
+// Blocks the head must be above a block before it is final, and handed to the ledger
+#define BLOCK_TREE_CONFIRMATIONS 3
+// Final blocks kept, the older ones are covered by the ledger snapshots
+#define BLOCK_TREE_RETAINED 32
+// Connected blocks: the retained final ones, and room for the branches that are not final yet
+#define BLOCK_TREE_CAPACITY (BLOCK_TREE_RETAINED + 16)
+
+#define BLOCK_TREE_ORPHANS 8
+#define BLOCK_TREE_ORPHAN_TIMEOUT_MS (2 * 60 * 1000)
+
+typedef enum {
+    BLOCK_TREE_REJECTED = -1,   // Already known, builds on a block behind the final one, or no room. The caller keeps the block
+    BLOCK_TREE_CONNECTED = 0,
+    BLOCK_TREE_ORPHANED,        // Waits for its parent
+} block_tree_result_t;
+
+// Tells the caller the block now links to parent, NULL when it links to the root or waits as an orphan
+typedef void (*block_tree_link_t)(void *block, void *parent);
+// Hands back a block the tree dropped
+typedef void (*block_tree_release_t)(void *block);
+
+typedef struct {
+    char hash[BLOCK_TREE_HASH_SIZE];
+    char previous_hash[BLOCK_TREE_HASH_SIZE];
+    void *block;
+    int parent;         // Index in nodes, -1 when the block links to the root
+    uint32_t height;
+    bool final;
+    bool used;
+} block_tree_node_t;
+
+typedef struct {
+    char hash[BLOCK_TREE_HASH_SIZE];
+    char previous_hash[BLOCK_TREE_HASH_SIZE];
+    void *block;
+    int64_t received_ms;
+    bool used;
+} block_tree_orphan_t;
+
+typedef struct {
+    block_tree_node_t nodes[BLOCK_TREE_CAPACITY];
+    block_tree_orphan_t orphans[BLOCK_TREE_ORPHANS];
+    char root_hash[BLOCK_TREE_HASH_SIZE];   // What the oldest kept block links to
+    uint32_t root_height;                   // Height of the root, the blocks before the oldest kept one
+    int best;                               // Index of the head, -1 while there are no blocks
+    int final;                              // Index of the newest final block, -1 when that is the root
+    uint32_t final_height;
+    block_tree_link_t link;
+    block_tree_release_t release;
+} block_tree_t;
+
+// Starts a tree on a root: the base hash at height 0, or the tip of the snapshot the station continues from.
+// The root is final.
+void block_tree_init(block_tree_t *tree, const char root_hash[BLOCK_TREE_HASH_SIZE], uint32_t root_height, block_tree_link_t link, block_tree_release_t release);
+
+// Drops every block and orphan, handing them to the release callback, and starts again on a new root. For a
+// station that continues from a snapshot of a peer, because the blocks it has do not connect to the peer's chain.
+void block_tree_reset(block_tree_t *tree, const char root_hash[BLOCK_TREE_HASH_SIZE], uint32_t root_height);
+
+// Adds a block, connects the orphans waiting for it and moves the head if the block (or an orphan) beats it.
+// Orphans older than BLOCK_TREE_ORPHAN_TIMEOUT_MS are released first.
+block_tree_result_t block_tree_add(block_tree_t *tree, const char hash[BLOCK_TREE_HASH_SIZE], const char previous_hash[BLOCK_TREE_HASH_SIZE], void *block, int64_t now_ms);
+
+// The head, or NULL while there are no blocks.
+void *block_tree_head(const block_tree_t *tree);
+
+// Height of the head, the root height while there are no blocks.
+uint32_t block_tree_height(const block_tree_t *tree);
+
+// Height of the root. The blocks up to it are not kept, only a snapshot covers them.
+uint32_t block_tree_root_height(const block_tree_t *tree);
+
+// The hash a new block links to: the hash of the head, or the root hash while there are no blocks.
+void block_tree_head_hash(const block_tree_t *tree, char hash[BLOCK_TREE_HASH_SIZE]);
+
+// Returns true if the hash is the root, a kept block or an orphan.
+bool block_tree_contains(const block_tree_t *tree, const char hash[BLOCK_TREE_HASH_SIZE]);
+
+// The next block that became final, oldest first, or NULL. Called until NULL after adding blocks, each block is
+// returned once. The block stays in the tree, so it is only valid until the next call into the tree.
+void *block_tree_take_final(block_tree_t *tree);
+
+int block_tree_orphan_amount(const block_tree_t *tree);
+
+#endif
@@ -1,5 +1,7 @@
 #include "chain.h"
 
+#include "diagnostics/profiler.h"
+
 int get_chain_length(struct block_t *head) {
     struct block_t *current = head;
     int length = 0;
@@ -10,6 +12,24 @@ int get_chain_length(struct block_t *head) {
     return length;
 }
 
+static char anchor_hash[SHA256_HASH_SIZE];
+static bool anchored = false;
+
+void chain_set_anchor(const char hash[SHA256_HASH_SIZE]) {
+    memcpy(anchor_hash, hash, SHA256_HASH_SIZE);
+    anchored = true;
+}
+
+void chain_previous_hash(struct block_t *head, char previous_hash[SHA256_HASH_SIZE]) {
+    if (head != -1) {
+        memcpy(previous_hash, head->hash, SHA256_HASH_SIZE);
+    } else if (anchored) {
+        memcpy(previous_hash, anchor_hash, SHA256_HASH_SIZE);
+    } else {
+        memset(previous_hash, 48, SHA256_HASH_SIZE); // 48 is as 0x30, which is interpreted as 0 in ascii
+    }
+}
+
 void print_blocks(struct block_t *head) {
     struct block_t *current = head;
     int id = get_chain_length(head);
@@ -50,6 +70,7 @@ struct block_t *create_block(char previous_hash[SHA256_HASH_SIZE], int seller_no
     new_block->buyer_node_id = buyer_node_id;
     memcpy(new_block->buyer_signature, buyer_signature, SIGNATURE_SIZE/2);
     new_block->previous_block = previous_block;
+    new_block->certificate = NULL;
 
     create_block_hash(new_block);
 
@@ -61,13 +82,17 @@ struct block_t *get_prev_block(struct block_t *head) {
     return head->previous_block;
 }
 
-// Function for constructing a udp message containing a block.
-void construct_block_message(struct block_t *block, char *pBlockMsg) {   
-    size_t new_block_size = sizeof(char)*3 + sizeof(int)*4 + sizeof(char)*5 + SIGNATURE_SIZE + SHA256_HASH_SIZE*2; // 2x signatures, since signature/2 = binary signature.
-    
+void free_block(void *block) {
+    free(((struct block_t *)block)->certificate);
+    free(block);
+}
+
+// Puts a header and the content of a block into pBlockMsg. Returns the length, or -1 if it does not fit in size
+static int put_block_message(struct block_t *block, const char *header, char *pBlockMsg, size_t size) {
     // Put header onto message
-    snprintf(pBlockMsg, new_block_size,
-        "bcb,%i,%i,%i,%i,",
+    snprintf(pBlockMsg, size,
+        "%s,%i,%i,%i,%i,",
+        header,
         block->seller_node_id,
         block->price,
         block->duration,
@@ -75,6 +100,9 @@ void construct_block_message(struct block_t *block, char *pBlockMsg) {
     );
 
     int basicBlockBodySize = strlen(pBlockMsg);
+    if ((size_t)(basicBlockBodySize + SHA256_HASH_SIZE*2 + SIGNATURE_SIZE) > size) {
+        return -1;
+    }
 
     // Add the previous hash.
     memcpy(pBlockMsg + basicBlockBodySize, block->previous_hash, SHA256_HASH_SIZE);
@@ -87,48 +115,29 @@ void construct_block_message(struct block_t *block, char *pBlockMsg) {
 
     // Add the hash of the block.
     memcpy(pBlockMsg + basicBlockBodySize + SHA256_HASH_SIZE + SIGNATURE_SIZE, block->hash, SHA256_HASH_SIZE);
+    return basicBlockBodySize + SHA256_HASH_SIZE*2 + SIGNATURE_SIZE;
 }
 
-// returns 0 if the block was verified, returns -1 if it did not.
-int verify_block_hash(struct block_t *block, char key_array[10][PUBLIC_KEY_SIZE]) {
-    mbedtls_sha256_context block_SHA256_context;
-
-    size_t data_size = SHA256_HASH_SIZE + sizeof(int)*4 - sizeof(char)*6 + SIGNATURE_SIZE;
-    char *data = malloc(data_size);
-    memset(data, 0, data_size);
-
-    memcpy(data, block->previous_hash, SHA256_HASH_SIZE);
-
-    snprintf(data+SHA256_HASH_SIZE, data_size,
-        ",%i,%i,%i,%i,",
-        block->seller_node_id,
-        block->price,
-        block->duration,
-        block->buyer_node_id
-    );
-
-    memcpy(data + SHA256_HASH_SIZE + sizeof(int)*4 - sizeof(char)*6, block->seller_signature, SIGNATURE_SIZE/2);
-    memcpy(data + SHA256_HASH_SIZE + sizeof(int)*4 - sizeof(char)*6 + SIGNATURE_SIZE/2, block->buyer_signature, SIGNATURE_SIZE/2);
-
-    // Hash the message
-    unsigned char block_hash[SHA256_HASH_SIZE];
-
-    // Initialize and start the SHA256 hashing function
-    mbedtls_sha256_init(&block_SHA256_context);
-    mbedtls_sha256_starts(&block_SHA256_context, 0);
-
-    // Input the string to be hashed.
-    mbedtls_sha256_update(&block_SHA256_context, (const unsigned char *)data, data_size);
-
-    // Finalize the SHA256 hash
-    mbedtls_sha256_finish(&block_SHA256_context, block_hash);
+// Function for constructing a udp message containing a block.
+void construct_block_message(struct block_t *block, char *pBlockMsg) {   
+    size_t new_block_size = sizeof(char)*3 + sizeof(int)*4 + sizeof(char)*5 + SIGNATURE_SIZE + SHA256_HASH_SIZE*2; // 2x signatures, since signature/2 = binary signature.
+    put_block_message(block, "bcb", pBlockMsg, new_block_size);
+}
 
-    if(memcmp(block_hash, block->hash, SHA256_HASH_SIZE) != 0) {
-        ESP_LOGE(TAG_BLOCK, "Hash of block does not match hash of block message.");
+int construct_committed_block_message(struct block_t *block, char *pBlockMsg, size_t size) {
+    if (block->certificate == NULL) {
+        return -1;
+    }
+    int length = put_block_message(block, "cbk", pBlockMsg, size);
+    if (length < 0) {
         return -1;
     }
-    ESP_LOGI(TAG_BLOCK, "Hash of block verified.");
+    int certificate_length = quorum_encode(block->certificate, (uint8_t *)pBlockMsg + length, size - length);
+    return (certificate_length < 0) ? -1 : length + certificate_length;
+}
 
+// returns 0 if both signatures of the block were verified, returns -1 if one did not.
+int verify_block_signatures(struct block_t *block, char key_array[10][PUBLIC_KEY_SIZE]) {
     // Check buyer signature
     // Setup key
     node_public_key_t buyer_npk;
@@ -180,16 +189,13 @@ int verify_block_hash(struct block_t *block, char key_array[10][PUBLIC_KEY_SIZE]
         return -1;
     }
 
-    // Free memory
-    free(data);
-    mbedtls_sha256_free(&block_SHA256_context);
-
     // Return success
     return 0;
 }
 
 // Takes in a block and generates a hash for that block based on the previous block.
 void create_block_hash(struct block_t *block) {
+    PROFILE_BEGIN(PROFILE_CREATE_BLOCK_HASH);
     mbedtls_sha256_context block_SHA256_context;
 
     size_t data_size = SHA256_HASH_SIZE + sizeof(int)*4 - sizeof(char)*6 + SIGNATURE_SIZE; // Signaturesize (128) / 2 * 2
@@ -230,6 +236,7 @@ void create_block_hash(struct block_t *block) {
     // Free data, to not cause a memory leak.
     free(data);
     mbedtls_sha256_free(&block_SHA256_context);
+    PROFILE_END(PROFILE_CREATE_BLOCK_HASH);
 }
 
 int get_laset_module_amount(char key_array[PK_KEY_ARRAY_SIZE][PUBLIC_KEY_SIZE]) {
@@ -247,12 +254,24 @@ int get_laset_module_amount(char key_array[PK_KEY_ARRAY_SIZE][PUBLIC_KEY_SIZE])
     return (PK_KEY_ARRAY_SIZE - empty_module_amount);
 }
 
+uint16_t get_laset_module_members(char key_array[PK_KEY_ARRAY_SIZE][PUBLIC_KEY_SIZE]) {
+    uint16_t members = 0;
+    char null_key[PUBLIC_KEY_SIZE] = {0};
+
+    for (int i = 0; i < PK_KEY_ARRAY_SIZE; i++) {
+        if (memcmp(key_array[i], null_key, PUBLIC_KEY_SIZE) != 0) {
+            members |= (uint16_t)(1 << i);
+        }
+    }
+    return members;
+}
+
 // erase_block is not in use at the moment
 struct block_t *erase_block(struct block_t *head) {
     struct block_t *previous_block = head->previous_block;
 
     // free the current head of the linked list
-    free(head);
+    free_block(head);
 
     return previous_block;
 }
\ No newline at end of file
@@ -17,9 +17,11 @@
 #include "mbedtls/sha256.h"
 
 #include <stddef.h>
+#include <stdbool.h>
 
 #include "../models/models.h"
 #include "../cryptography/crypto.h"
+#include "quorum.h"
 
 typedef struct block_t {
     char previous_hash[SHA256_HASH_SIZE];
@@ -31,6 +33,7 @@ typedef struct block_t {
     uint8_t buyer_signature[SIGNATURE_SIZE/2];
     char hash[SHA256_HASH_SIZE];
     struct block_t *previous_block;
+    quorum_certificate_t *certificate;  // Phase votes the block was committed with, NULL for auction blocks
 };
 
 #define TAG_BLOCK "LASET_BLCK"
@@ -41,20 +44,38 @@ void print_blocks(struct block_t *head);
 struct block_t *create_block(char previous_hash[SHA256_HASH_SIZE], int seller_node_id, int price, int duration, uint8_t seller_signature[SIGNATURE_SIZE/2], int buyer_node_id, uint8_t buyer_signature[SIGNATURE_SIZE/2], struct block_t *previous_block);
 struct block_t *get_prev_block(struct block_t *head);
 
+// Frees a block and its quorum certificate
+void free_block(void *block);
+
+// Blocks linked behind head. The block tree only keeps the newest ones, its height is the length of the whole chain
 int get_chain_length(struct block_t *head);
 
+// Sets the hash a chain without blocks links to, the tip hash of the snapshot the station started from.
+// Without an anchor it is the base hash (all '0').
+void chain_set_anchor(const char hash[SHA256_HASH_SIZE]);
+
+// The hash the next block links to: the hash of head, or the anchor if there are no blocks.
+void chain_previous_hash(struct block_t *head, char previous_hash[SHA256_HASH_SIZE]);
+
 // Computes the hash of a block depending on its variables
 void create_block_hash(struct block_t *head_with_block_hash);
 
 // Puts the content of a block into a char buffer, so it can be send.
 void construct_block_message(struct block_t *block, char *pBlockMsg);
 
-// Verifies the hash and both seller/buyer signatures
-int verify_block_hash(struct block_t *block, char key_array[10][PUBLIC_KEY_SIZE]);
+// Puts a committed block and its quorum certificate into a cbk message, for a station catching up.
+// Returns the length, or -1 if the block has no certificate or it does not fit in size.
+int construct_committed_block_message(struct block_t *block, char *pBlockMsg, size_t size);
+
+// Verifies the seller/buyer signatures, the hash is checked against the block message by validation_check_hash
+int verify_block_signatures(struct block_t *block, char key_array[10][PUBLIC_KEY_SIZE]);
 
 // Gets the amount of modules assumed to be in the network currently (looks of the invandrer keys)
 int get_laset_module_amount(char key_array[PK_KEY_ARRAY_SIZE][PUBLIC_KEY_SIZE]);
 
+// The same modules as a bitmap, bit per node id with a key
+uint16_t get_laset_module_members(char key_array[PK_KEY_ARRAY_SIZE][PUBLIC_KEY_SIZE]);
+
 // Not in use
 struct block_t *erase_block(struct block_t *head);
 
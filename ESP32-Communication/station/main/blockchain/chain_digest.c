@@ -0,0 +1,113 @@
+#include "chain_digest.h"
+
+#include <string.h>
+
+// FNV-1a over size bytes of value, little endian
+static uint64_t digest_add(uint64_t hash, uint64_t value, int size) {
+    for (int i = 0; i < size; i++) {
+        hash ^= (uint8_t)(value >> (8 * i));
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+void chain_digest_make(chain_digest_t *digest, uint32_t height, const char tip_hash[CHAIN_DIGEST_HASH_SIZE], uint64_t ledger_digest) {
+    uint64_t hash = digest_add(14695981039346656037ull, height, 4);
+    for (int i = 0; i < CHAIN_DIGEST_HASH_SIZE; i++) {
+        hash = digest_add(hash, (uint8_t)tip_hash[i], 1);
+    }
+    hash = digest_add(hash, ledger_digest, 8);
+
+    digest->height = height;
+    digest->digest = hash;
+}
+
+void chain_digest_encode(const chain_digest_t *digest, uint8_t buffer[CHAIN_DIGEST_ENCODED_SIZE]) {
+    for (int i = 0; i < 4; i++) {
+        buffer[i] = (uint8_t)(digest->height >> (8 * i));
+    }
+    for (int i = 0; i < 8; i++) {
+        buffer[4 + i] = (uint8_t)(digest->digest >> (8 * i));
+    }
+}
+
+void chain_digest_decode(const uint8_t buffer[CHAIN_DIGEST_ENCODED_SIZE], chain_digest_t *digest) {
+    digest->height = 0;
+    digest->digest = 0;
+    for (int i = 0; i < 4; i++) {
+        digest->height |= (uint32_t)buffer[i] << (8 * i);
+    }
+    for (int i = 0; i < 8; i++) {
+        digest->digest |= (uint64_t)buffer[4 + i] << (8 * i);
+    }
+}
+
+void chain_digest_peers_init(chain_digest_peers_t *peers) {
+    memset(peers, 0, sizeof(chain_digest_peers_t));
+    for (int i = 0; i < CHAIN_DIGEST_PEERS; i++) {
+        peers->requested_ms[i] = -CHAIN_DIGEST_RETRY_MS;
+    }
+}
+
+chain_digest_sync_t chain_digest_observe(chain_digest_peers_t *peers, int node_id, const chain_digest_t *own, const chain_digest_t *announced, int64_t now_ms) {
+    if (node_id < 0 || node_id >= CHAIN_DIGEST_PEERS) {
+        return CHAIN_DIGEST_SYNC_NONE;
+    }
+    peers->announced[node_id] = *announced;
+
+    bool same = (announced->height == own->height && announced->digest == own->digest);
+    if (same || announced->height < own->height) {
+        peers->mismatches[node_id] = 0;
+        peers->attempts[node_id] = 0;
+        return CHAIN_DIGEST_SYNC_NONE;
+    }
+    if (peers->mismatches[node_id] < CHAIN_DIGEST_MISMATCHES) {
+        peers->mismatches[node_id]++;
+    }
+    if (peers->mismatches[node_id] < CHAIN_DIGEST_MISMATCHES || now_ms - peers->requested_ms[node_id] < CHAIN_DIGEST_RETRY_MS) {
+        return CHAIN_DIGEST_SYNC_NONE;
+    }
+
+    // The last request moved the own chain, so asking for blocks works
+    if (own->digest != peers->requested_own[node_id]) {
+        peers->attempts[node_id] = 0;
+    }
+    if (peers->attempts[node_id] > CHAIN_DIGEST_SYNC_ATTEMPTS) {
+        return CHAIN_DIGEST_SYNC_NONE;
+    }
+    peers->attempts[node_id]++;
+    peers->requested_ms[node_id] = now_ms;
+    peers->requested_own[node_id] = own->digest;
+    return (peers->attempts[node_id] > CHAIN_DIGEST_SYNC_ATTEMPTS) ? CHAIN_DIGEST_SYNC_SNAPSHOT : CHAIN_DIGEST_SYNC_BLOCKS;
+}
+
+void chain_digest_replies_init(chain_digest_replies_t *replies) {
+    memset(replies, 0, sizeof(chain_digest_replies_t));
+}
+
+bool chain_digest_may_reply(chain_digest_replies_t *replies, uint32_t source_ip, int64_t now_ms) {
+    int entry = -1;
+    int oldest = 0;
+    for (int i = 0; i < CHAIN_DIGEST_REPLY_SOURCES; i++) {
+        if (replies->used[i] && replies->ip[i] == source_ip) {
+            entry = i;
+            break;
+        }
+        if (!replies->used[oldest]) {
+            continue;
+        }
+        if (!replies->used[i] || replies->replied_ms[i] < replies->replied_ms[oldest]) {
+            oldest = i;
+        }
+    }
+    if (entry >= 0 && now_ms - replies->replied_ms[entry] < CHAIN_DIGEST_REPLY_MS) {
+        return false;
+    }
+    if (entry < 0) {
+        entry = oldest;
+        replies->ip[entry] = source_ip;
+        replies->used[entry] = true;
+    }
+    replies->replied_ms[entry] = now_ms;
+    return true;
+}
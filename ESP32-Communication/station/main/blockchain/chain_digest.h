@@ -0,0 +1,81 @@
+#ifndef CHAIN_DIGEST_H
+#define CHAIN_DIGEST_H
+
+/* Chain state digest, gossiped with every bca so stations notice when their chains differ, in a few bytes instead
+ * of the blocks. It stands for the height and tip hash of the head and the digest of the ledger (see ledger.h),
+ * which is kept up to date per block, so making it again on a commit only mixes the three values.
+ * A peer whose digest keeps differing from the own one, and that is not behind, is asked for its newest blocks.
+ * When that does not change the own chain, the chains split below the final block: the peer is asked for its
+ * snapshot once, and then left alone until the own chain moves.
+ * Only depends on the C standard library. Not thread safe, the caller must serialize access. */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TAG_CHAIN_DIGEST "LASET_DGST"
+
+#define CHAIN_DIGEST_HASH_SIZE 32
+
+// Node ids a digest is kept for, same as PK_KEY_ARRAY_SIZE
+#define CHAIN_DIGEST_PEERS 10
+
+// Encoded digest: height and digest, little endian. Same as CHAIN_DIGEST_SIZE in models.h
+#define CHAIN_DIGEST_ENCODED_SIZE 12
+
+// Heartbeats in a row with a different digest before a peer is asked, so a block one station committed a moment
+// before the other does not start a reconciliation
+#define CHAIN_DIGEST_MISMATCHES 2
+// A peer is asked again at most this often
+#define CHAIN_DIGEST_RETRY_MS 10000
+// Requests for blocks in a row after which the own chain did not change, before the snapshot is asked for
+#define CHAIN_DIGEST_SYNC_ATTEMPTS 3
+
+// Chain sync requests (rcs) answered per source address at most this often, each answer is up to 8 blocks
+#define CHAIN_DIGEST_REPLY_MS 5000
+#define CHAIN_DIGEST_REPLY_SOURCES 8
+
+typedef enum {
+    CHAIN_DIGEST_SYNC_NONE = 0,
+    CHAIN_DIGEST_SYNC_BLOCKS,       // Ask the peer for its blocks above the own final one
+    CHAIN_DIGEST_SYNC_SNAPSHOT,     // Its blocks did not connect, ask for its snapshot
+} chain_digest_sync_t;
+
+typedef struct {
+    uint32_t height;
+    uint64_t digest;        // Height, tip hash and ledger digest mixed
+} chain_digest_t;
+
+typedef struct {
+    chain_digest_t announced[CHAIN_DIGEST_PEERS];   // The newest digest of every peer
+    uint8_t mismatches[CHAIN_DIGEST_PEERS];         // Heartbeats in a row that differed
+    int64_t requested_ms[CHAIN_DIGEST_PEERS];       // When the peer was asked last
+    uint64_t requested_own[CHAIN_DIGEST_PEERS];     // The own digest when the peer was asked last
+    uint8_t attempts[CHAIN_DIGEST_PEERS];           // Requests in a row that did not change the own chain
+} chain_digest_peers_t;
+
+typedef struct {
+    uint32_t ip[CHAIN_DIGEST_REPLY_SOURCES];
+    int64_t replied_ms[CHAIN_DIGEST_REPLY_SOURCES];
+    bool used[CHAIN_DIGEST_REPLY_SOURCES];
+} chain_digest_replies_t;
+
+void chain_digest_make(chain_digest_t *digest, uint32_t height, const char tip_hash[CHAIN_DIGEST_HASH_SIZE], uint64_t ledger_digest);
+
+void chain_digest_encode(const chain_digest_t *digest, uint8_t buffer[CHAIN_DIGEST_ENCODED_SIZE]);
+void chain_digest_decode(const uint8_t buffer[CHAIN_DIGEST_ENCODED_SIZE], chain_digest_t *digest);
+
+void chain_digest_peers_init(chain_digest_peers_t *peers);
+
+// Records the digest a peer announced. Returns what to ask the peer for now, if its digest differed from own
+// CHAIN_DIGEST_MISMATCHES times in a row, it is not behind, and it was not asked in the last CHAIN_DIGEST_RETRY_MS.
+// Blocks for the first CHAIN_DIGEST_SYNC_ATTEMPTS requests that leave own unchanged, then the snapshot once, then
+// nothing until own changes. A peer that is behind is left to ask this station.
+chain_digest_sync_t chain_digest_observe(chain_digest_peers_t *peers, int node_id, const chain_digest_t *own, const chain_digest_t *announced, int64_t now_ms);
+
+void chain_digest_replies_init(chain_digest_replies_t *replies);
+
+// Returns true if a chain sync from source_ip may be answered now, at most once per CHAIN_DIGEST_REPLY_MS. When
+// every entry is taken the source answered longest ago is forgotten.
+bool chain_digest_may_reply(chain_digest_replies_t *replies, uint32_t source_ip, int64_t now_ms);
+
+#endif
@@ -0,0 +1,205 @@
+#include "chain_tip.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static portMUX_TYPE chain_tip_lock = portMUX_INITIALIZER_UNLOCKED;
+#define CHAIN_TIP_LOCK() portENTER_CRITICAL(&chain_tip_lock)
+#define CHAIN_TIP_UNLOCK() portEXIT_CRITICAL(&chain_tip_lock)
+#else
+#include <pthread.h>
+
+static pthread_mutex_t chain_tip_lock = PTHREAD_MUTEX_INITIALIZER;
+#define CHAIN_TIP_LOCK() pthread_mutex_lock(&chain_tip_lock)
+#define CHAIN_TIP_UNLOCK() pthread_mutex_unlock(&chain_tip_lock)
+#endif
+
+// A published tip. Replaced records are kept on a list until they are reclaimed, so publishing never waits
+typedef struct tip_record_t {
+    chain_tip_t tip;                // First, so a chain_tip_t pointer is the record pointer
+    struct tip_record_t *next;
+    uint32_t retired_epoch;
+} tip_record_t;
+
+typedef struct {
+    void *pointer;
+    void (*reclaim)(void *pointer);
+    uint32_t retired_epoch;
+} retired_t;
+
+// A retired pointer that did not fit in the array
+typedef struct retired_node_t {
+    retired_t entry;
+    struct retired_node_t *next;
+} retired_node_t;
+
+static tip_record_t *current = NULL;
+
+// Epoch 0 marks a reader slot that is not in a read-side section
+static uint32_t global_epoch = 1;
+static uint32_t reader_epochs[CHAIN_TIP_READERS];
+
+// Guarded by chain_tip_lock. Readers never take it
+static retired_t retired[CHAIN_TIP_RETIRED_CAPACITY];
+static int retired_amount = 0;
+static retired_node_t *retired_overflow = NULL;
+static int overflow_amount = 0;
+static tip_record_t *retired_records = NULL;
+
+int chain_tip_init(const chain_tip_t *tip) {
+    tip_record_t *record = malloc(sizeof(tip_record_t));
+    if (record == NULL) {
+        return -1;
+    }
+    memcpy(&record->tip, tip, sizeof(chain_tip_t));
+    record->next = NULL;
+    __atomic_store_n(&current, record, __ATOMIC_SEQ_CST);
+    return 0;
+}
+
+const chain_tip_t *chain_tip_read_begin(int *reader) {
+    uint32_t epoch = __atomic_load_n(&global_epoch, __ATOMIC_SEQ_CST);
+
+    // Takes a free slot. An epoch that moved on meanwhile is older than needed, which only delays reclaiming
+    for (int i = 0; i < CHAIN_TIP_READERS; i++) {
+        uint32_t free_slot = 0;
+        if (__atomic_compare_exchange_n(&reader_epochs[i], &free_slot, epoch, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+            *reader = i;
+            return &__atomic_load_n(&current, __ATOMIC_SEQ_CST)->tip;
+        }
+    }
+    return NULL;
+}
+
+void chain_tip_read_end(int reader) {
+    __atomic_store_n(&reader_epochs[reader], 0, __ATOMIC_RELEASE);
+}
+
+int chain_tip_publish(const chain_tip_t *expected, const chain_tip_t *tip) {
+    tip_record_t *record = malloc(sizeof(tip_record_t));
+    if (record == NULL) {
+        return -1;
+    }
+    memcpy(&record->tip, tip, sizeof(chain_tip_t));
+    record->next = NULL;
+
+    // Safe from a record being freed and allocated again at the same address, the caller's section holds expected
+    tip_record_t *replaced = (tip_record_t *)expected;
+    if (!__atomic_compare_exchange_n(&current, &replaced, record, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+        free(record);
+        return -1;
+    }
+
+    CHAIN_TIP_LOCK();
+    ((tip_record_t *)expected)->retired_epoch = __atomic_load_n(&global_epoch, __ATOMIC_SEQ_CST);
+    ((tip_record_t *)expected)->next = retired_records;
+    retired_records = (tip_record_t *)expected;
+    CHAIN_TIP_UNLOCK();
+    return 0;
+}
+
+// Moves the epoch on if every reader in a section entered in the current one
+static void try_advance_epoch(void) {
+    uint32_t epoch = __atomic_load_n(&global_epoch, __ATOMIC_SEQ_CST);
+    for (int i = 0; i < CHAIN_TIP_READERS; i++) {
+        uint32_t reader_epoch = __atomic_load_n(&reader_epochs[i], __ATOMIC_SEQ_CST);
+        if (reader_epoch != 0 && reader_epoch != epoch) {
+            return;
+        }
+    }
+    __atomic_compare_exchange_n(&global_epoch, &epoch, epoch + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+// A reader that could hold something retired in this epoch entered in it or the one after, so two epochs later it is gone
+static bool grace_period_over(uint32_t retired_epoch) {
+    return __atomic_load_n(&global_epoch, __ATOMIC_SEQ_CST) - retired_epoch >= 2;
+}
+
+int chain_tip_reclaim(void) {
+    try_advance_epoch();
+
+    // One at a time, so reclaim is not called with the lock taken
+    while (1) {
+        retired_t ready = { .pointer = NULL };
+        retired_node_t *ready_node = NULL;
+        CHAIN_TIP_LOCK();
+        for (int i = 0; i < retired_amount; i++) {
+            if (grace_period_over(retired[i].retired_epoch)) {
+                ready = retired[i];
+                retired[i] = retired[--retired_amount];
+                break;
+            }
+        }
+        if (ready.pointer == NULL) {
+            for (retired_node_t **link = &retired_overflow; *link != NULL; link = &(*link)->next) {
+                if (grace_period_over((*link)->entry.retired_epoch)) {
+                    ready_node = *link;
+                    *link = ready_node->next;
+                    overflow_amount--;
+                    ready = ready_node->entry;
+                    break;
+                }
+            }
+        }
+        CHAIN_TIP_UNLOCK();
+        if (ready.pointer == NULL) {
+            break;
+        }
+        free(ready_node);
+        ready.reclaim(ready.pointer);
+    }
+
+    // Records are pushed newest first, so once one is ready everything behind it is too
+    tip_record_t *ready_records = NULL;
+    int waiting = 0;
+    CHAIN_TIP_LOCK();
+    tip_record_t **link = &retired_records;
+    while (*link != NULL && !grace_period_over((*link)->retired_epoch)) {
+        link = &(*link)->next;
+        waiting++;
+    }
+    ready_records = *link;
+    *link = NULL;
+    waiting += retired_amount + overflow_amount;
+    CHAIN_TIP_UNLOCK();
+
+    while (ready_records != NULL) {
+        tip_record_t *next = ready_records->next;
+        free(ready_records);
+        ready_records = next;
+    }
+    return waiting;
+}
+
+int chain_tip_retire(void *pointer, void (*reclaim)(void *pointer)) {
+    chain_tip_reclaim();
+
+    bool added = false;
+    CHAIN_TIP_LOCK();
+    if (retired_amount < CHAIN_TIP_RETIRED_CAPACITY) {
+        retired[retired_amount++] = (retired_t){ pointer, reclaim, __atomic_load_n(&global_epoch, __ATOMIC_SEQ_CST) };
+        added = true;
+    }
+    CHAIN_TIP_UNLOCK();
+    if (added) {
+        return 0;
+    }
+
+    // Full while a reader holds the epoch back. Allocated outside the lock, which is a critical section on the
+    // station. The epoch is read after the pointer was unlinked either way, a later one only waits longer
+    retired_node_t *node = malloc(sizeof(retired_node_t));
+    if (node == NULL) {
+        return -1;
+    }
+    CHAIN_TIP_LOCK();
+    node->entry = (retired_t){ pointer, reclaim, __atomic_load_n(&global_epoch, __ATOMIC_SEQ_CST) };
+    node->next = retired_overflow;
+    retired_overflow = node;
+    overflow_amount++;
+    CHAIN_TIP_UNLOCK();
+    return 0;
+}
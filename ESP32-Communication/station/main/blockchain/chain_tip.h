@@ -0,0 +1,54 @@
+#ifndef CHAIN_TIP_H
+#define CHAIN_TIP_H
+
+/* The chain tip (head block, height and hash), published for readers that never lock, RCU style.
+ * The tip is an immutable record behind one pointer. A writer copies it into a new record and swaps the pointer
+ * with a compare-and-swap, so a reader always sees one whole tip and two writers can not both replace the same
+ * one. A reader announces the epoch it entered in, and a record (or a block) that is replaced is only reclaimed
+ * two epochs after it was retired. The epoch only moves on when no reader is still in an older one, so nothing
+ * a reader may hold is freed under it. Neither readers nor writers wait: a reader that finds every slot taken gets
+ * NULL, and writers call in with block_tree_mutex taken, so pointers retired beyond CHAIN_TIP_RETIRED_CAPACITY go
+ * on an allocated overflow list instead. */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TAG_CHAIN_TIP "LASET_TIP"
+
+#define CHAIN_TIP_HASH_SIZE 32
+
+// Read-side sections open at the same time, more than there are tasks
+#define CHAIN_TIP_READERS 16
+// Retired pointers waiting for a grace period
+#define CHAIN_TIP_RETIRED_CAPACITY 64
+
+typedef struct {
+    void *block;                        // Head block, NULL while there are no blocks
+    uint32_t height;
+    char hash[CHAIN_TIP_HASH_SIZE];     // The hash a new block links to
+} chain_tip_t;
+
+// Publishes the first tip. Must be called before any other chain_tip function.
+// Returns 0, or -1 if there is no memory for the tip.
+int chain_tip_init(const chain_tip_t *tip);
+
+// Enters a read-side section and returns the tip. The tip, and the block in it, stay valid until
+// chain_tip_read_end with the returned reader. Tries every slot once and returns NULL if all of them are taken,
+// the caller may retry after the other readers had a chance to leave.
+const chain_tip_t *chain_tip_read_begin(int *reader);
+
+void chain_tip_read_end(int reader);
+
+// Replaces expected by a copy of tip. Called inside the read-side section expected was read in.
+// Returns 0, or -1 if another writer replaced expected first (nothing is published then).
+int chain_tip_publish(const chain_tip_t *expected, const chain_tip_t *tip);
+
+// Calls reclaim with the pointer once no reader can hold it anymore. Must not be called inside a read-side section.
+// Never waits for the readers. Returns 0, or -1 if the array was full and there was no memory to keep the pointer
+// on the overflow list: it is then never reclaimed, a leak rather than a free under a reader.
+int chain_tip_retire(void *pointer, void (*reclaim)(void *pointer));
+
+// Reclaims what no reader can hold anymore. Returns the amount of pointers still waiting.
+int chain_tip_reclaim(void);
+
+#endif
@@ -0,0 +1,339 @@
+#include "ledger.h"
+
+#include <string.h>
+
+void ledger_init(ledger_t *ledger) {
+    memset(ledger, 0, sizeof(ledger_t));
+    ledger->newest_snapshot = -1;
+}
+
+static bool valid_node_id(int node_id) {
+    return node_id >= 0 && node_id < LEDGER_MAX_NODES;
+}
+
+// FNV-1a over the 8 bytes of value
+static uint64_t digest_add(uint64_t hash, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        hash ^= (uint8_t)(value >> (8 * i));
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Spreads the bits, so the sum of entry hashes does not cancel out for entries that differ in a few bits
+static uint64_t digest_finish(uint64_t hash) {
+    hash ^= hash >> 30;
+    hash *= 0xBF58476D1CE4E5B9ull;
+    hash ^= hash >> 27;
+    hash *= 0x94D049BB133111EBull;
+    return hash ^ (hash >> 31);
+}
+
+static uint64_t account_digest(int node_id, const ledger_account_t *account) {
+    if (account->earned == 0 && account->spent == 0 && account->seconds_sold == 0 && account->seconds_bought == 0
+        && account->trades_sold == 0 && account->trades_bought == 0) {
+        return 0;
+    }
+    uint64_t hash = digest_add(14695981039346656037ull, ('a' << 8) | node_id);
+    hash = digest_add(hash, (uint64_t)account->earned);
+    hash = digest_add(hash, (uint64_t)account->spent);
+    hash = digest_add(hash, ((uint64_t)account->seconds_sold << 32) | account->seconds_bought);
+    hash = digest_add(hash, ((uint64_t)account->trades_sold << 32) | account->trades_bought);
+    return digest_finish(hash);
+}
+
+static uint64_t owed_digest(int buyer_node_id, int seller_node_id, int64_t owed) {
+    if (owed == 0) {
+        return 0;
+    }
+    uint64_t hash = digest_add(14695981039346656037ull, ('o' << 16) | (buyer_node_id << 8) | seller_node_id);
+    return digest_finish(digest_add(hash, (uint64_t)owed));
+}
+
+// The digest of the three entries a block changes
+static uint64_t block_entries_digest(const ledger_state_t *state, int seller_node_id, int buyer_node_id) {
+    return account_digest(seller_node_id, &state->accounts[seller_node_id]) + account_digest(buyer_node_id, &state->accounts[buyer_node_id])
+        + owed_digest(buyer_node_id, seller_node_id, state->owed[buyer_node_id][seller_node_id]);
+}
+
+uint64_t ledger_compute_digest(const ledger_state_t *state) {
+    uint64_t digest = 0;
+    for (int node = 0; node < LEDGER_MAX_NODES; node++) {
+        digest += account_digest(node, &state->accounts[node]);
+    }
+    for (int buyer = 0; buyer < LEDGER_MAX_NODES; buyer++) {
+        for (int seller = 0; seller < LEDGER_MAX_NODES; seller++) {
+            digest += owed_digest(buyer, seller, state->owed[buyer][seller]);
+        }
+    }
+    return digest;
+}
+
+// Keeps a copy of the state, replacing the oldest snapshot when all are in use
+static void take_snapshot(ledger_t *ledger) {
+    ledger->newest_snapshot = (ledger->newest_snapshot + 1) % LEDGER_SNAPSHOTS;
+    memcpy(&ledger->snapshots[ledger->newest_snapshot], &ledger->state, sizeof(ledger_state_t));
+    if (ledger->snapshot_amount < LEDGER_SNAPSHOTS) {
+        ledger->snapshot_amount++;
+    }
+}
+
+int ledger_apply(ledger_t *ledger, int seller_node_id, int buyer_node_id, int price, int duration, const char hash[LEDGER_HASH_SIZE]) {
+    if (!valid_node_id(seller_node_id) || !valid_node_id(buyer_node_id) || seller_node_id == buyer_node_id) {
+        return -1;
+    }
+
+    ledger_state_t *state = &ledger->state;
+    ledger_account_t *seller = &state->accounts[seller_node_id];
+    ledger_account_t *buyer = &state->accounts[buyer_node_id];
+    int64_t amount = (int64_t)price * duration;
+    state->digest -= block_entries_digest(state, seller_node_id, buyer_node_id);
+
+    seller->earned += amount;
+    buyer->spent += amount;
+    state->owed[buyer_node_id][seller_node_id] += amount;
+    if (duration > 0) {
+        seller->seconds_sold += duration;
+        buyer->seconds_bought += duration;
+        seller->trades_sold++;
+        buyer->trades_bought++;
+    }
+
+    state->digest += block_entries_digest(state, seller_node_id, buyer_node_id);
+    state->height++;
+    memcpy(state->tip_hash, hash, LEDGER_HASH_SIZE);
+
+    if (state->height % LEDGER_SNAPSHOT_INTERVAL == 0) {
+        take_snapshot(ledger);
+    }
+    return 0;
+}
+
+const ledger_account_t *ledger_account(const ledger_t *ledger, int node_id) {
+    if (!valid_node_id(node_id)) {
+        return NULL;
+    }
+    return &ledger->state.accounts[node_id];
+}
+
+int64_t ledger_balance(const ledger_t *ledger, int node_id) {
+    if (!valid_node_id(node_id)) {
+        return 0;
+    }
+    return ledger->state.accounts[node_id].earned - ledger->state.accounts[node_id].spent;
+}
+
+int64_t ledger_owed(const ledger_t *ledger, int buyer_node_id, int seller_node_id) {
+    if (!valid_node_id(buyer_node_id) || !valid_node_id(seller_node_id)) {
+        return 0;
+    }
+    return ledger->state.owed[buyer_node_id][seller_node_id];
+}
+
+const ledger_state_t *ledger_snapshot_at(const ledger_t *ledger, uint32_t height) {
+    for (int i = 0; i < ledger->snapshot_amount; i++) {
+        if (ledger->snapshots[i].height == height) {
+            return &ledger->snapshots[i];
+        }
+    }
+    return NULL;
+}
+
+const ledger_state_t *ledger_latest_snapshot(const ledger_t *ledger) {
+    if (ledger->snapshot_amount == 0) {
+        return NULL;
+    }
+    return &ledger->snapshots[ledger->newest_snapshot];
+}
+
+// FNV-1a over the encoded bytes before the checksum
+static uint32_t checksum(const uint8_t *buffer, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= buffer[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void put_uint(uint8_t **cursor, uint64_t value, int size) {
+    for (int i = 0; i < size; i++) {
+        (*cursor)[i] = (uint8_t)(value >> (8 * i));
+    }
+    *cursor += size;
+}
+
+static uint64_t get_uint(const uint8_t **cursor, int size) {
+    uint64_t value = 0;
+    for (int i = 0; i < size; i++) {
+        value |= (uint64_t)(*cursor)[i] << (8 * i);
+    }
+    *cursor += size;
+    return value;
+}
+
+int ledger_snapshot_encode(const ledger_state_t *snapshot, uint8_t *buffer, size_t size) {
+    int owed_amount = 0;
+    for (int buyer = 0; buyer < LEDGER_MAX_NODES; buyer++) {
+        for (int seller = 0; seller < LEDGER_MAX_NODES; seller++) {
+            if (snapshot->owed[buyer][seller] != 0) owed_amount++;
+        }
+    }
+    size_t length = 4 + 1 + 1 + 4 + LEDGER_HASH_SIZE + LEDGER_MAX_NODES * LEDGER_ACCOUNT_ENCODED_SIZE
+        + 1 + owed_amount * LEDGER_OWED_ENCODED_SIZE + 4;
+    if (length > size) {
+        return -1;
+    }
+
+    uint8_t *cursor = buffer;
+    put_uint(&cursor, LEDGER_SNAPSHOT_MAGIC, 4);
+    put_uint(&cursor, LEDGER_SNAPSHOT_VERSION, 1);
+    put_uint(&cursor, LEDGER_MAX_NODES, 1);
+    put_uint(&cursor, snapshot->height, 4);
+    memcpy(cursor, snapshot->tip_hash, LEDGER_HASH_SIZE);
+    cursor += LEDGER_HASH_SIZE;
+
+    for (int node = 0; node < LEDGER_MAX_NODES; node++) {
+        const ledger_account_t *account = &snapshot->accounts[node];
+        put_uint(&cursor, (uint64_t)account->earned, 8);
+        put_uint(&cursor, (uint64_t)account->spent, 8);
+        put_uint(&cursor, account->seconds_sold, 4);
+        put_uint(&cursor, account->seconds_bought, 4);
+        put_uint(&cursor, account->trades_sold, 4);
+        put_uint(&cursor, account->trades_bought, 4);
+    }
+
+    put_uint(&cursor, owed_amount, 1);
+    for (int buyer = 0; buyer < LEDGER_MAX_NODES; buyer++) {
+        for (int seller = 0; seller < LEDGER_MAX_NODES; seller++) {
+            if (snapshot->owed[buyer][seller] == 0) continue;
+            put_uint(&cursor, buyer, 1);
+            put_uint(&cursor, seller, 1);
+            put_uint(&cursor, (uint64_t)snapshot->owed[buyer][seller], 8);
+        }
+    }
+
+    put_uint(&cursor, checksum(buffer, cursor - buffer), 4);
+    return (int)(cursor - buffer);
+}
+
+int ledger_snapshot_decode(const uint8_t *buffer, size_t length, ledger_state_t *snapshot) {
+    size_t fixed_length = 4 + 1 + 1 + 4 + LEDGER_HASH_SIZE + LEDGER_MAX_NODES * LEDGER_ACCOUNT_ENCODED_SIZE + 1;
+    if (length < fixed_length + 4) {
+        return -1;
+    }
+    const uint8_t *cursor = buffer;
+    if (get_uint(&cursor, 4) != LEDGER_SNAPSHOT_MAGIC || get_uint(&cursor, 1) != LEDGER_SNAPSHOT_VERSION || get_uint(&cursor, 1) != LEDGER_MAX_NODES) {
+        return -1;
+    }
+    size_t owed_amount = buffer[fixed_length - 1];
+    size_t encoded_length = fixed_length + owed_amount * LEDGER_OWED_ENCODED_SIZE + 4;
+    if (length < encoded_length) {
+        return -1;
+    }
+    const uint8_t *checksum_cursor = buffer + encoded_length - 4;
+    if (get_uint(&checksum_cursor, 4) != checksum(buffer, encoded_length - 4)) {
+        return -1;
+    }
+
+    // Decoded into a copy, so a bad pair leaves the snapshot as it was
+    ledger_state_t decoded;
+    memset(&decoded, 0, sizeof(ledger_state_t));
+    decoded.height = (uint32_t)get_uint(&cursor, 4);
+    memcpy(decoded.tip_hash, cursor, LEDGER_HASH_SIZE);
+    cursor += LEDGER_HASH_SIZE;
+
+    for (int node = 0; node < LEDGER_MAX_NODES; node++) {
+        ledger_account_t *account = &decoded.accounts[node];
+        account->earned = (int64_t)get_uint(&cursor, 8);
+        account->spent = (int64_t)get_uint(&cursor, 8);
+        account->seconds_sold = (uint32_t)get_uint(&cursor, 4);
+        account->seconds_bought = (uint32_t)get_uint(&cursor, 4);
+        account->trades_sold = (uint32_t)get_uint(&cursor, 4);
+        account->trades_bought = (uint32_t)get_uint(&cursor, 4);
+    }
+
+    cursor++;   // Amount of pairs, read above
+    for (size_t i = 0; i < owed_amount; i++) {
+        int buyer = (int)get_uint(&cursor, 1);
+        int seller = (int)get_uint(&cursor, 1);
+        if (!valid_node_id(buyer) || !valid_node_id(seller)) {
+            return -1;
+        }
+        decoded.owed[buyer][seller] = (int64_t)get_uint(&cursor, 8);
+    }
+
+    decoded.digest = ledger_compute_digest(&decoded);
+    memcpy(snapshot, &decoded, sizeof(ledger_state_t));
+    return 0;
+}
+
+void ledger_restore(ledger_t *ledger, const ledger_state_t *snapshot) {
+    ledger_init(ledger);
+    memcpy(&ledger->state, snapshot, sizeof(ledger_state_t));
+    ledger->newest_snapshot = 0;
+    ledger->snapshot_amount = 1;
+    memcpy(&ledger->snapshots[0], snapshot, sizeof(ledger_state_t));
+}
+
+void ledger_candidates_init(ledger_candidates_t *candidates) {
+    memset(candidates, 0, sizeof(ledger_candidates_t));
+}
+
+static bool same_snapshot(const ledger_state_t *a, const ledger_state_t *b) {
+    return a->height == b->height && a->digest == b->digest && memcmp(a->tip_hash, b->tip_hash, LEDGER_HASH_SIZE) == 0;
+}
+
+// A free entry goes first, then the one with the fewest senders, then the lowest
+static bool replaced_before(const ledger_candidate_t *a, const ledger_candidate_t *b) {
+    if (a->senders == 0 || b->senders == 0) {
+        return a->senders == 0 && b->senders != 0;
+    }
+    int a_senders = __builtin_popcount(a->senders);
+    int b_senders = __builtin_popcount(b->senders);
+    if (a_senders != b_senders) {
+        return a_senders < b_senders;
+    }
+    return a->state.height < b->state.height;
+}
+
+int ledger_candidates_add(ledger_candidates_t *candidates, const ledger_state_t *snapshot, int sender, uint32_t final_height) {
+    if (!valid_node_id(sender) || snapshot->height <= final_height) {
+        return -1;
+    }
+
+    ledger_candidate_t *entry = NULL;
+    ledger_candidate_t *replaced = NULL;
+    for (int i = 0; i < LEDGER_SNAPSHOT_CANDIDATES; i++) {
+        ledger_candidate_t *candidate = &candidates->candidates[i];
+        if (candidate->senders != 0 && candidate->state.height <= final_height) {
+            candidate->senders = 0;
+        }
+        if (candidate->senders != 0 && same_snapshot(&candidate->state, snapshot)) {
+            entry = candidate;
+        }
+        if (replaced == NULL || replaced_before(candidate, replaced)) {
+            replaced = candidate;
+        }
+    }
+
+    if (entry == NULL) {
+        entry = replaced;
+        memcpy(&entry->state, snapshot, sizeof(ledger_state_t));
+        entry->senders = 0;
+    }
+    entry->senders |= (uint16_t)(1 << sender);
+    return __builtin_popcount(entry->senders);
+}
+
+const ledger_state_t *ledger_candidates_agreed(const ledger_candidates_t *candidates, int needed) {
+    const ledger_state_t *agreed = NULL;
+    for (int i = 0; i < LEDGER_SNAPSHOT_CANDIDATES; i++) {
+        const ledger_candidate_t *candidate = &candidates->candidates[i];
+        if (candidate->senders != 0 && __builtin_popcount(candidate->senders) >= needed
+            && (agreed == NULL || candidate->state.height > agreed->height)) {
+            agreed = &candidate->state;
+        }
+    }
+    return agreed;
+}
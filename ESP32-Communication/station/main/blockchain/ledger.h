@@ -0,0 +1,119 @@
+#ifndef LEDGER_H
+#define LEDGER_H
+
+/* Settlement ledger: what every node bought, sold, earned and spent, derived from the committed blocks.
+ * It is updated once per committed block, so balances are read without walking the chain from chain_head.
+ * Every LEDGER_SNAPSHOT_INTERVAL blocks a copy of the state is kept, tied to the height and hash of the block it
+ * ends at. A snapshot can be encoded into a compact buffer and restored from it, so the blocks it covers do not
+ * have to be kept. The state carries a digest of all accounts and pairs, a sum of one hash per entry, so a block
+ * only rehashes the three entries it changes. Only depends on the C standard library. Not thread safe, the caller
+ * must serialize access. */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define TAG_LEDGER "LASET_LDGR"
+
+// Node ids the ledger has accounts for, same as PK_KEY_ARRAY_SIZE
+#define LEDGER_MAX_NODES 10
+
+#define LEDGER_HASH_SIZE 32
+
+// A snapshot is taken every this many blocks, and the newest LEDGER_SNAPSHOTS are kept
+#define LEDGER_SNAPSHOT_INTERVAL 16
+#define LEDGER_SNAPSHOTS 2
+
+// Encoded snapshot: header, height and tip hash, the accounts, the pairs that owe something, and a checksum
+#define LEDGER_SNAPSHOT_MAGIC 0x4C534E50  // "LSNP"
+#define LEDGER_SNAPSHOT_VERSION 1
+#define LEDGER_ACCOUNT_ENCODED_SIZE 32
+#define LEDGER_OWED_ENCODED_SIZE 10
+#define LEDGER_SNAPSHOT_MAX_SIZE (4 + 1 + 1 + 4 + LEDGER_HASH_SIZE + LEDGER_MAX_NODES * LEDGER_ACCOUNT_ENCODED_SIZE \
+    + 1 + LEDGER_MAX_NODES * (LEDGER_MAX_NODES - 1) * LEDGER_OWED_ENCODED_SIZE + 4)
+
+// Different snapshots of the peers a station that is behind keeps counting senders for
+#define LEDGER_SNAPSHOT_CANDIDATES 4
+
+typedef struct {
+    int64_t earned;             // Price times duration of the blocks the node sold in
+    int64_t spent;              // Price times duration of the blocks the node bought in
+    uint32_t seconds_sold;      // Validated durations, blocks with no validated phase count as 0
+    uint32_t seconds_bought;
+    uint32_t trades_sold;       // Blocks with a duration above 0
+    uint32_t trades_bought;
+} ledger_account_t;
+
+typedef struct {
+    uint32_t height;                            // Blocks applied, the chain length
+    uint8_t tip_hash[LEDGER_HASH_SIZE];         // Hash of the last block applied, all 0 when there is none
+    ledger_account_t accounts[LEDGER_MAX_NODES];
+    int64_t owed[LEDGER_MAX_NODES][LEDGER_MAX_NODES];  // owed[buyer][seller], what the buyer owes the seller
+    uint64_t digest;                            // ledger_compute_digest of the accounts and owed, kept up to date
+} ledger_state_t;
+
+typedef struct {
+    ledger_state_t state;
+    ledger_state_t snapshots[LEDGER_SNAPSHOTS];
+    int snapshot_amount;
+    int newest_snapshot;
+} ledger_t;
+
+// A snapshot received from the peers, and a bit per node id that sent the same height, digest and tip hash
+typedef struct {
+    ledger_state_t state;
+    uint16_t senders;           // 0 for a free entry
+} ledger_candidate_t;
+
+typedef struct {
+    ledger_candidate_t candidates[LEDGER_SNAPSHOT_CANDIDATES];
+} ledger_candidates_t;
+
+void ledger_init(ledger_t *ledger);
+
+// Applies a committed block with its final duration. Returns 0, or -1 if a node id is out of range or the
+// seller is the buyer (the block is not applied, and the height does not change).
+int ledger_apply(ledger_t *ledger, int seller_node_id, int buyer_node_id, int price, int duration, const char hash[LEDGER_HASH_SIZE]);
+
+// Digest of the accounts and owed of a state, computed over every entry. Entries that are all 0 add nothing, so an
+// empty ledger has digest 0. The state's digest field always equals it, this is for checking and decoding.
+uint64_t ledger_compute_digest(const ledger_state_t *state);
+
+// Account of a node, or NULL if the id is out of range.
+const ledger_account_t *ledger_account(const ledger_t *ledger, int node_id);
+
+// Earned minus spent. 0 for ids out of range.
+int64_t ledger_balance(const ledger_t *ledger, int node_id);
+
+// What the buyer owes the seller over all blocks. 0 for ids out of range.
+int64_t ledger_owed(const ledger_t *ledger, int buyer_node_id, int seller_node_id);
+
+// The snapshot taken at exactly this height, or NULL if it is not kept.
+const ledger_state_t *ledger_snapshot_at(const ledger_t *ledger, uint32_t height);
+
+// The newest snapshot, or NULL if none was taken yet.
+const ledger_state_t *ledger_latest_snapshot(const ledger_t *ledger);
+
+// Writes a snapshot into buffer, little endian. Only pairs that owe something are written, so a young network
+// takes a few hundred bytes. Returns the encoded length, or -1 if it does not fit in size.
+int ledger_snapshot_encode(const ledger_state_t *snapshot, uint8_t *buffer, size_t size);
+
+// Reads a snapshot written by ledger_snapshot_encode. Returns 0, or -1 if the buffer is cut off, of another
+// version or fails the checksum (snapshot is then left unchanged).
+int ledger_snapshot_decode(const uint8_t *buffer, size_t length, ledger_state_t *snapshot);
+
+// Continues the ledger from a snapshot, for a station that starts without the blocks it covers. The snapshot
+// becomes the only one kept.
+void ledger_restore(ledger_t *ledger, const ledger_state_t *snapshot);
+
+void ledger_candidates_init(ledger_candidates_t *candidates);
+
+// Counts the sender for its snapshot, after dropping every candidate at or below final_height. A new snapshot
+// takes a free entry, or replaces the one with the fewest senders (the lowest on a tie). Returns the amount of
+// senders of the snapshot, or -1 if the sender is out of range or the snapshot is not above final_height.
+int ledger_candidates_add(ledger_candidates_t *candidates, const ledger_state_t *snapshot, int sender, uint32_t final_height);
+
+// The highest candidate at least needed nodes sent, or NULL if none has.
+const ledger_state_t *ledger_candidates_agreed(const ledger_candidates_t *candidates, int needed);
+
+#endif
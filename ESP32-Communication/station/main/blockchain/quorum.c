@@ -0,0 +1,149 @@
+#include "quorum.h"
+
+#include <stdio.h>
+#include <string.h>
+
+void quorum_init(quorum_certificate_t *certificate, const char hash[QUORUM_HASH_SIZE], int duration, uint16_t members) {
+    memset(certificate, 0, sizeof(quorum_certificate_t));
+    memcpy(certificate->hash, hash, QUORUM_HASH_SIZE);
+    certificate->duration = (uint16_t)duration;
+    certificate->members = members & ((1 << QUORUM_SIGNERS) - 1);
+}
+
+static bool valid_node_id(int node_id) {
+    return node_id >= 0 && node_id < QUORUM_SIGNERS;
+}
+
+static int bit_amount(uint16_t bits) {
+    int amount = 0;
+    for (int node_id = 0; node_id < QUORUM_SIGNERS; node_id++) {
+        if (bits & (1 << node_id)) amount++;
+    }
+    return amount;
+}
+
+int quorum_member_amount(const quorum_certificate_t *certificate) {
+    return bit_amount(certificate->members);
+}
+
+int quorum_needed(const quorum_certificate_t *certificate) {
+    return (quorum_member_amount(certificate) * 2) / 3;
+}
+
+void quorum_vote_message(uint8_t *msg, size_t msg_size, int node_id, uint16_t phases, const char hash[QUORUM_HASH_SIZE]) {
+    memset(msg, 0, msg_size);
+    int length = snprintf((char *)msg, msg_size, "bpa,%i,%u,", node_id, phases);
+    if (length >= 0 && (size_t)length + QUORUM_HASH_SIZE <= msg_size) {
+        memcpy(msg + length, hash, QUORUM_HASH_SIZE);
+    }
+}
+
+int quorum_add_vote(quorum_certificate_t *certificate, int node_id, uint16_t phases, const uint8_t signature[QUORUM_SIGNATURE_SIZE]) {
+    if (!valid_node_id(node_id) || !(certificate->members & (1 << node_id)) || phases == 0 || (phases >> QUORUM_PHASES) != 0) {
+        return -1;
+    }
+    // Votes only grow, one missing a phase of the kept vote is older or from a node that changed its mind
+    uint16_t kept = certificate->phases[node_id];
+    if ((phases & kept) != kept) {
+        return -1;
+    }
+    certificate->signers |= (uint16_t)(1 << node_id);
+    certificate->phases[node_id] = phases;
+    memcpy(certificate->signatures[node_id], signature, QUORUM_SIGNATURE_SIZE);
+    return 0;
+}
+
+int quorum_duration(const quorum_certificate_t *certificate, int needed) {
+    int phase_amount = certificate->duration / QUORUM_PHASE_SECONDS;
+    if (phase_amount > QUORUM_PHASES) {
+        phase_amount = QUORUM_PHASES;
+    }
+
+    int duration = 0;
+    for (int phase = 0; phase < phase_amount; phase++) {
+        int votes = 0;
+        for (int node_id = 0; node_id < QUORUM_SIGNERS; node_id++) {
+            if ((certificate->signers & (1 << node_id)) && (certificate->phases[node_id] & (1 << phase))) votes++;
+        }
+        if (votes >= needed) {
+            duration += QUORUM_PHASE_SECONDS;
+        }
+    }
+    return duration;
+}
+
+int quorum_verify(const quorum_certificate_t *certificate, int needed, int duration, quorum_verify_t verify) {
+    // The duration first, it is cheap and a mismatch makes the signatures irrelevant
+    if ((certificate->signers & ~certificate->members) != 0 || quorum_duration(certificate, needed) != duration) {
+        return -1;
+    }
+    for (int node_id = 0; node_id < QUORUM_SIGNERS; node_id++) {
+        if (!(certificate->signers & (1 << node_id))) continue;
+
+        uint8_t msg[256];
+        uint8_t signature[QUORUM_SIGNATURE_SIZE];
+        quorum_vote_message(msg, sizeof(msg), node_id, certificate->phases[node_id], certificate->hash);
+        memcpy(signature, certificate->signatures[node_id], QUORUM_SIGNATURE_SIZE);
+        if (verify(node_id, msg, sizeof(msg), signature) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void put_uint16(uint8_t **cursor, uint16_t value) {
+    (*cursor)[0] = (uint8_t)value;
+    (*cursor)[1] = (uint8_t)(value >> 8);
+    *cursor += 2;
+}
+
+static uint16_t get_uint16(const uint8_t **cursor) {
+    uint16_t value = (uint16_t)((*cursor)[0] | ((*cursor)[1] << 8));
+    *cursor += 2;
+    return value;
+}
+
+int quorum_encode(const quorum_certificate_t *certificate, uint8_t *buffer, size_t size) {
+    size_t length = QUORUM_HEADER_ENCODED_SIZE + bit_amount(certificate->signers) * QUORUM_SIGNER_ENCODED_SIZE;
+    if (length > size) {
+        return -1;
+    }
+
+    uint8_t *cursor = buffer;
+    memcpy(cursor, certificate->hash, QUORUM_HASH_SIZE);
+    cursor += QUORUM_HASH_SIZE;
+    put_uint16(&cursor, certificate->duration);
+    put_uint16(&cursor, certificate->signers);
+    put_uint16(&cursor, certificate->members);
+    for (int node_id = 0; node_id < QUORUM_SIGNERS; node_id++) {
+        if (!(certificate->signers & (1 << node_id))) continue;
+        put_uint16(&cursor, certificate->phases[node_id]);
+        memcpy(cursor, certificate->signatures[node_id], QUORUM_SIGNATURE_SIZE);
+        cursor += QUORUM_SIGNATURE_SIZE;
+    }
+    return (int)length;
+}
+
+int quorum_decode(const uint8_t *buffer, size_t length, quorum_certificate_t *certificate) {
+    if (length < QUORUM_HEADER_ENCODED_SIZE) {
+        return -1;
+    }
+    const uint8_t *cursor = buffer + QUORUM_HASH_SIZE;
+    uint16_t duration = get_uint16(&cursor);
+    uint16_t signers = get_uint16(&cursor);
+    uint16_t members = get_uint16(&cursor);
+    if ((signers >> QUORUM_SIGNERS) != 0 || (members >> QUORUM_SIGNERS) != 0
+        || length < (size_t)(QUORUM_HEADER_ENCODED_SIZE + bit_amount(signers) * QUORUM_SIGNER_ENCODED_SIZE)) {
+        return -1;
+    }
+
+    quorum_init(certificate, (const char *)buffer, duration, members);
+    certificate->signers = signers;
+    for (int node_id = 0; node_id < QUORUM_SIGNERS; node_id++) {
+        if (!(signers & (1 << node_id))) continue;
+        certificate->phases[node_id] = get_uint16(&cursor);
+        memcpy(certificate->signatures[node_id], cursor, QUORUM_SIGNATURE_SIZE);
+        cursor += QUORUM_SIGNATURE_SIZE;
+    }
+    return 0;
+}
@@ -0,0 +1,79 @@
+#ifndef QUORUM_H
+#define QUORUM_H
+
+/* Quorum certificates: the signed phase votes (bpa) a block was committed with, kept with the block.
+ * A vote is cumulative, it names every phase the node accepted so far and is signed over them and the block hash,
+ * so only the newest vote of each node is kept: a signer bitmap plus one phase set and signature per signer.
+ * With the public keys of the signers, anyone can check the committed duration from the certificate alone,
+ * without having listened to the votes. The modules the validating station knew are recorded with the votes, so
+ * the certificate is checked against the threshold it was made with, not the one of a network that grew since.
+ * Only depends on the C standard library, signatures are checked through
+ * a callback. Not thread safe, the caller must serialize access. */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define TAG_QUORUM "LASET_QRM"
+
+// Node ids that can sign, same as PK_KEY_ARRAY_SIZE
+#define QUORUM_SIGNERS 10
+
+#define QUORUM_HASH_SIZE 32
+#define QUORUM_SIGNATURE_SIZE 64
+
+// A trade lasts at most QUORUM_PHASES phases of QUORUM_PHASE_SECONDS each
+#define QUORUM_PHASES 12
+#define QUORUM_PHASE_SECONDS 5
+
+// Encoded certificate: hash, duration, signer bitmap, member bitmap, then the phases and signature of every signer
+#define QUORUM_HEADER_ENCODED_SIZE (QUORUM_HASH_SIZE + 2 + 2 + 2)
+#define QUORUM_SIGNER_ENCODED_SIZE (2 + QUORUM_SIGNATURE_SIZE)
+#define QUORUM_MAX_ENCODED_SIZE (QUORUM_HEADER_ENCODED_SIZE + QUORUM_SIGNERS * QUORUM_SIGNER_ENCODED_SIZE)
+
+typedef struct {
+    char hash[QUORUM_HASH_SIZE];        // The block the votes were cast for, with its duration before it was adjusted
+    uint16_t duration;                  // That duration
+    uint16_t signers;                   // Bit per node id that voted
+    uint16_t members;                   // Bit per node id the validating station had a key for, signers are among them
+    uint16_t phases[QUORUM_SIGNERS];    // Phases each signer accepted, bit 0 is phase 1
+    uint8_t signatures[QUORUM_SIGNERS][QUORUM_SIGNATURE_SIZE];
+} quorum_certificate_t;
+
+// Verifies the signature of node_id over message. Returns 0 if it is valid
+typedef int (*quorum_verify_t)(int node_id, uint8_t *message, size_t message_size, uint8_t *signature);
+
+// Starts an empty certificate for the block with this hash and duration, validated by the modules in members
+void quorum_init(quorum_certificate_t *certificate, const char hash[QUORUM_HASH_SIZE], int duration, uint16_t members);
+
+// Amount of modules in members.
+int quorum_member_amount(const quorum_certificate_t *certificate);
+
+// Votes a phase needs: 2/3 of the members, rounded down. E.g. 5 modules require 3 acknowledgements
+int quorum_needed(const quorum_certificate_t *certificate);
+
+// Constructs the message a vote is signed with, "bpa,<node id>,<phases>," and the raw block hash, into msg.
+void quorum_vote_message(uint8_t *msg, size_t msg_size, int node_id, uint16_t phases, const char hash[QUORUM_HASH_SIZE]);
+
+// Adds a vote whose signature the caller verified, replacing an older vote of the same node.
+// Returns 0, or -1 if the node is not a member, the phases are out of range, or the vote has fewer phases than the
+// kept one.
+int quorum_add_vote(quorum_certificate_t *certificate, int node_id, uint16_t phases, const uint8_t signature[QUORUM_SIGNATURE_SIZE]);
+
+// The duration the votes validate: QUORUM_PHASE_SECONDS for every phase of the voted duration that at least
+// needed signers accepted.
+int quorum_duration(const quorum_certificate_t *certificate, int needed);
+
+// Verifies every signature in the certificate and that the votes add up to duration with needed signers per phase.
+// Returns 0, or -1 if a signature is invalid, a signer is not a member or the duration differs.
+int quorum_verify(const quorum_certificate_t *certificate, int needed, int duration, quorum_verify_t verify);
+
+// Writes a certificate into buffer, little endian, with only the signers that voted.
+// Returns the encoded length, or -1 if it does not fit in size.
+int quorum_encode(const quorum_certificate_t *certificate, uint8_t *buffer, size_t size);
+
+// Reads a certificate written by quorum_encode. Returns 0, or -1 if the buffer is cut off or names a node id out of
+// range (certificate is then left unchanged).
+int quorum_decode(const uint8_t *buffer, size_t length, quorum_certificate_t *certificate);
+
+#endif
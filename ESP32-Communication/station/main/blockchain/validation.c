@@ -0,0 +1,81 @@
+#include "validation.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "diagnostics/metrics.h"
+
+static const char *stage_names[VALIDATION_STAGE_AMOUNT] = {
+    "header",
+    "membership",
+    "replay",
+    "linkage",
+    "hash",
+    "signature",
+};
+
+static int passed_metrics[VALIDATION_STAGE_AMOUNT] = {METRIC_NONE, METRIC_NONE, METRIC_NONE, METRIC_NONE, METRIC_NONE, METRIC_NONE};
+static int rejected_metrics[VALIDATION_STAGE_AMOUNT] = {METRIC_NONE, METRIC_NONE, METRIC_NONE, METRIC_NONE, METRIC_NONE, METRIC_NONE};
+
+void validation_register_metrics(void) {
+    char labels[METRICS_LABELS_SIZE];
+    for (int stage = 0; stage < VALIDATION_STAGE_AMOUNT; stage++) {
+        snprintf(labels, sizeof(labels), "stage=\"%s\",result=\"passed\"", stage_names[stage]);
+        passed_metrics[stage] = metrics_register("laset_validation_checks", labels, METRIC_COUNTER);
+        snprintf(labels, sizeof(labels), "stage=\"%s\",result=\"rejected\"", stage_names[stage]);
+        rejected_metrics[stage] = metrics_register("laset_validation_checks", labels, METRIC_COUNTER);
+    }
+}
+
+int validation_record(validation_stage_t stage, int result) {
+    if (stage < VALIDATION_STAGE_AMOUNT) {
+        metrics_counter_add((result == 0) ? passed_metrics[stage] : rejected_metrics[stage], 1);
+    }
+    return result;
+}
+
+int validation_record_bool(validation_stage_t stage, bool passed) {
+    return validation_record(stage, passed ? 0 : -1);
+}
+
+const char *validation_stage_name(validation_stage_t stage) {
+    return (stage < VALIDATION_STAGE_AMOUNT) ? stage_names[stage] : "unknown";
+}
+
+int validation_check_node_id(int node_id) {
+    return (node_id >= 0 && node_id < PK_KEY_ARRAY_SIZE) ? 0 : -1;
+}
+
+int validation_check_block_header(int seller_node_id, int buyer_node_id, int price, int duration) {
+    if (validation_check_node_id(seller_node_id) != 0 || validation_check_node_id(buyer_node_id) != 0) {
+        return -1;
+    }
+    if (seller_node_id == buyer_node_id) {
+        return -1;
+    }
+    if (price <= 0 || duration <= 0 || duration > VALIDATION_MAX_DURATION) {
+        return -1;
+    }
+    return 0;
+}
+
+int validation_check_phase(int phase, int duration) {
+    return (phase >= 1 && phase <= duration / VALIDATION_PHASE_DURATION && phase <= VALIDATION_MAX_DURATION / VALIDATION_PHASE_DURATION) ? 0 : -1;
+}
+
+int validation_check_member(const char key_array[PK_KEY_ARRAY_SIZE][PUBLIC_KEY_SIZE], int node_id) {
+    if (validation_check_node_id(node_id) != 0) {
+        return -1;
+    }
+    // Unknown keys are all zero
+    for (int i = 0; i < PUBLIC_KEY_SIZE; i++) {
+        if (key_array[node_id][i] != 0) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int validation_check_hash(const char computed_hash[SHA256_HASH_SIZE], const char received_hash[SHA256_HASH_SIZE]) {
+    return (memcmp(computed_hash, received_hash, SHA256_HASH_SIZE) == 0) ? 0 : -1;
+}
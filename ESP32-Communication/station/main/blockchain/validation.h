@@ -0,0 +1,59 @@
+#ifndef VALIDATION_H
+#define VALIDATION_H
+
+/* Checks for received messages, split into stages ordered from cheapest to most expensive. A handler runs the
+ * stages of its message type in order and stops at the first one that fails, so invalid traffic is rejected
+ * before it costs a hash or a key import and signature verification. Every stage counts the messages it passed
+ * and rejected in the metrics. */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../models/models.h"
+
+#define TAG_VALIDATION "LASET_VALD"
+
+// Longest trade duration in a block, the phase acceptance arrays have one entry per 5 seconds of it
+#define VALIDATION_MAX_DURATION 60
+#define VALIDATION_PHASE_DURATION 5
+
+typedef enum {
+    VALIDATION_HEADER = 0,  // Fields are in range, needs nothing but the message
+    VALIDATION_MEMBERSHIP,  // The nodes in the message have a known public key
+    VALIDATION_REPLAY,      // Not handled before: open trade deal, current auction slot, block not in the chain
+    VALIDATION_LINKAGE,     // A block builds on a block in the block tree (or one still in phase validation)
+    VALIDATION_HASH,        // The recomputed block hash matches the received one
+    VALIDATION_SIGNATURE,   // Key imports and signature verifications
+    VALIDATION_STAGE_AMOUNT
+} validation_stage_t;
+
+// Registers the passed/rejected counters of every stage.
+void validation_register_metrics(void);
+
+// Counts the result of a stage and returns it, so a stage reads as:
+//   if (validation_record(VALIDATION_HEADER, validation_check_node_id(id)) != 0) continue;
+int validation_record(validation_stage_t stage, int result);
+
+// Same as validation_record for a check that returns a bool.
+int validation_record_bool(validation_stage_t stage, bool passed);
+
+const char *validation_stage_name(validation_stage_t stage);
+
+/* Stage checks. Each returns 0 if the message passes and -1 if it is rejected. */
+
+// Header: node id fits the key array.
+int validation_check_node_id(int node_id);
+
+// Header: the fields of a block (bcb) are in range, with different buyer and seller.
+int validation_check_block_header(int seller_node_id, int buyer_node_id, int price, int duration);
+
+// Header: a phase acceptance (bpa) names one of the phases of a block with this duration.
+int validation_check_phase(int phase, int duration);
+
+// Membership: a public key is cached for the node.
+int validation_check_member(const char key_array[PK_KEY_ARRAY_SIZE][PUBLIC_KEY_SIZE], int node_id);
+
+// Hash: the hash computed from the block content matches the hash in the message.
+int validation_check_hash(const char computed_hash[SHA256_HASH_SIZE], const char received_hash[SHA256_HASH_SIZE]);
+
+#endif
@@ -2,6 +2,11 @@
 #include "mbedtls/rsa.h"
 
 #include "psa_crypto_rsa.h"
+#include "esp_timer.h"
+
+#include "diagnostics/metrics.h"
+#include "diagnostics/binlog.h"
+#include "diagnostics/profiler.h"
 
 /* THIS CODE IS VERY SENSITIVE. PLEASE DO NOT TOUCH  */
 
@@ -83,7 +88,9 @@ int import_public_key(node_public_key_t npk, node_key_credentials_t *pk_nkc) {
     psa_set_key_bits(&pk_attributes, key_bits);
 
     /* Import the key */
+    PROFILE_BEGIN(PROFILE_IMPORT_PUBLIC_KEY);
     psa_status = psa_import_key(&pk_attributes, npk.public_key_buffer, npk.public_key_length, &pk_key_id);
+    PROFILE_END(PROFILE_IMPORT_PUBLIC_KEY);
     if (psa_status != PSA_SUCCESS)
     {
         ESP_LOGE(TAG_CRYPTO, "Failed to import key, error: %li", psa_status);
@@ -122,34 +129,48 @@ int sign_message(node_key_credentials_t nkc, const uint8_t *msg, size_t msg_leng
         return -1;
     }
 
+    PROFILE_BEGIN(PROFILE_SIGN_MESSAGE);
     psa_status = psa_sign_message(nkc.key_identifier, psa_get_key_algorithm(&nkc.key_attributes), msg, msg_length, &signature, sizeof(signature), &signature_length);
+    PROFILE_END(PROFILE_SIGN_MESSAGE);
     if (psa_status != PSA_SUCCESS) {
         ESP_LOGE(TAG_CRYPTO, "Failed to sign message, error: %li.", psa_status);
         return -1;
     }
 
-    for (size_t i = 0; i < signature_length; ++i) {
-        printf("\033[38;5;51m%02x%s", signature[i], (i < signature_length - 1) ? "" : "\n");
-    }
-
     // Use memcpy to put the signature into the variable.
     memcpy(msg_signature, signature, 64);
     *msg_signature_length = signature_length;
 
-    ESP_LOGI(TAG_CRYPTO, "\033[38;5;51mSigned message <%s> successfully.", msg);
+    BINLOG(BINLOG_MESSAGE_SIGNED, msg_length, signature_length);
     
     return 0;
 }
 
+// Metric ids, registered on the first verification
+static int verify_ok_metric = METRIC_NONE;
+static int verify_failed_metric = METRIC_NONE;
+static int verify_duration_metric = METRIC_NONE;
+
 int verify_message(node_key_credentials_t pk_nkc, const uint8_t *msg, size_t msg_length, uint8_t *msg_signature, size_t msg_signature_length) {
     psa_status_t psa_status;
+
+    if (verify_duration_metric == METRIC_NONE) {
+        verify_ok_metric = metrics_register("laset_signature_verifications", "result=\"ok\"", METRIC_COUNTER);
+        verify_failed_metric = metrics_register("laset_signature_verifications", "result=\"failed\"", METRIC_COUNTER);
+        verify_duration_metric = metrics_register("laset_signature_verify_us", NULL, METRIC_HISTOGRAM);
+    }
     
     if (PSA_ALG_IS_SIGN_MESSAGE(psa_get_key_algorithm(&pk_nkc.key_attributes)) != 1) {
         ESP_LOGE(TAG_CRYPTO, "Algorithm is not a signing one?");
         return -1;
     }
 
+    int64_t verify_start_time = esp_timer_get_time();
+    PROFILE_BEGIN(PROFILE_VERIFY_MESSAGE);
     psa_status = psa_verify_message(pk_nkc.key_identifier, psa_get_key_algorithm(&pk_nkc.key_attributes), msg, msg_length, msg_signature, msg_signature_length);
+    PROFILE_END(PROFILE_VERIFY_MESSAGE);
+    metrics_histogram_observe(verify_duration_metric, esp_timer_get_time() - verify_start_time);
+    metrics_counter_add((psa_status == PSA_SUCCESS) ? verify_ok_metric : verify_failed_metric, 1);
     if (psa_status != PSA_SUCCESS) {
         ESP_LOGE(TAG_CRYPTO, "Failed to verify message <%s>, error: %li.", msg, psa_status);
         return -9;
@@ -163,7 +184,7 @@ int verify_message(node_key_credentials_t pk_nkc, const uint8_t *msg, size_t msg
         return -10;
     }
 
-    ESP_LOGI(TAG_CRYPTO, "\033[38;5;210mVerified message <%s> successfully.", msg);
+    BINLOG(BINLOG_MESSAGE_VERIFIED, msg_length);
     
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,13 @@
+#include "key_fingerprint.h"
+
+#include <string.h>
+
+#include "mbedtls/sha256.h"
+
+void key_fingerprint(const uint8_t *public_key, size_t public_key_length, uint8_t fingerprint[KEY_FINGERPRINT_SIZE]) {
+    unsigned char key_hash[SHA256_HASH_SIZE];
+
+    // is224 = 0, so SHA-256 is used
+    mbedtls_sha256(public_key, public_key_length, key_hash, 0);
+    memcpy(fingerprint, key_hash, KEY_FINGERPRINT_SIZE);
+}
@@ -0,0 +1,12 @@
+#ifndef KEY_FINGERPRINT_H
+#define KEY_FINGERPRINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "../models/models.h"
+
+// Computes the fingerprint of a public key: the first KEY_FINGERPRINT_SIZE bytes of its SHA-256 hash.
+void key_fingerprint(const uint8_t *public_key, size_t public_key_length, uint8_t fingerprint[KEY_FINGERPRINT_SIZE]);
+
+#endif
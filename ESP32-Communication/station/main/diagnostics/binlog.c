@@ -0,0 +1,125 @@
+#include "binlog.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+#else
+#include <time.h>
+#endif
+
+// Bounded queue where every slot carries a sequence number. A slot is free for the writer at position pos when
+// its sequence is pos, and holds a record for the reader when it is pos + 1.
+// The slot stores its sequence minus its index, so the zero initialized ring starts out with every slot free.
+typedef struct {
+    uint32_t sequence;
+    binlog_record_t record;
+} binlog_slot_t;
+
+static binlog_slot_t slots[BINLOG_CAPACITY];
+static uint32_t write_position = 0;
+static uint32_t read_position = 0;
+static uint32_t dropped = 0;
+
+static const char *event_formats[BINLOG_EVENT_AMOUNT] = {
+    "Amperage broadcasted: %d",
+    "Received amperage reading %d from node %d",
+    "Signed message of %d bytes, signature %d bytes",
+    "Verified message of %d bytes",
+    "[BCD] Received trade deal from node %d for %d kW with a duration of %d minute(s)",
+    "[ATD] Received accept trade deal from node %d",
+    "[BCB] Broadcasted block, seller %d, price %d, duration %d, buyer %d",
+    "[BCB] Received block, seller %d, price %d, duration %d, buyer %d",
+    "[BCB] Verified block, seller %d, price %d, duration %d, buyer %d",
+    "Acknowledging phase %d, estimate %d/1000",
+    "[BPA] Phase acceptance from node %d for phase %d, matches our block: %d",
+    "Added block %d to the chain, seller %d, buyer %d, price %d, duration %d",
+};
+
+static int64_t binlog_now_us(void) {
+#ifdef ESP_PLATFORM
+    return esp_timer_get_time();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+#endif
+}
+
+static uint32_t load_sequence(uint32_t position) {
+    return __atomic_load_n(&slots[position & (BINLOG_CAPACITY - 1)].sequence, __ATOMIC_ACQUIRE) + (position & (BINLOG_CAPACITY - 1));
+}
+
+static void store_sequence(uint32_t position, uint32_t sequence) {
+    __atomic_store_n(&slots[position & (BINLOG_CAPACITY - 1)].sequence, sequence - (position & (BINLOG_CAPACITY - 1)), __ATOMIC_RELEASE);
+}
+
+int binlog_write(binlog_event_t event, const int32_t args[BINLOG_MAX_ARGS]) {
+    return binlog_write_at(event, args, binlog_now_us());
+}
+
+int binlog_write_at(binlog_event_t event, const int32_t args[BINLOG_MAX_ARGS], int64_t time_us) {
+    uint32_t position = __atomic_load_n(&write_position, __ATOMIC_RELAXED);
+    while (1) {
+        int32_t difference = (int32_t)(load_sequence(position) - position);
+
+        if (difference == 0) {
+            // Claim the slot, on failure position holds the new write position
+            if (__atomic_compare_exchange_n(&write_position, &position, position + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // The reader has not freed this slot yet
+            __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+            return -1;
+        } else {
+            position = __atomic_load_n(&write_position, __ATOMIC_RELAXED);
+        }
+    }
+
+    binlog_record_t *record = &slots[position & (BINLOG_CAPACITY - 1)].record;
+    record->time_us = time_us;
+    record->event = event;
+    memcpy(record->args, args, sizeof(record->args));
+    store_sequence(position, position + 1);
+    return 0;
+}
+
+int binlog_read(binlog_record_t *record) {
+    if (load_sequence(read_position) != read_position + 1) {
+        return -1;
+    }
+
+    *record = slots[read_position & (BINLOG_CAPACITY - 1)].record;
+    store_sequence(read_position, read_position + BINLOG_CAPACITY);
+    read_position++;
+    return 0;
+}
+
+int binlog_format(const binlog_record_t *record, char *buffer, size_t buffer_size) {
+    if (record->event >= BINLOG_EVENT_AMOUNT) {
+        return snprintf(buffer, buffer_size, "[%lld us] unknown event %lu", (long long)record->time_us, (unsigned long)record->event);
+    }
+
+    int length = snprintf(buffer, buffer_size, "[%lld us] ", (long long)record->time_us);
+    if (length < 0) {
+        return length;
+    }
+
+    size_t offset = ((size_t)length < buffer_size) ? (size_t)length : buffer_size;
+    int message_length = snprintf(buffer + offset, buffer_size - offset, event_formats[record->event],
+        (int)record->args[0], (int)record->args[1], (int)record->args[2], (int)record->args[3], (int)record->args[4]);
+    return (message_length < 0) ? message_length : length + message_length;
+}
+
+uint32_t binlog_dropped(void) {
+    return __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+}
+
+void binlog_reset(void) {
+    memset(slots, 0, sizeof(slots));
+    write_position = 0;
+    read_position = 0;
+    dropped = 0;
+}
@@ -0,0 +1,61 @@
+#ifndef BINLOG_H
+#define BINLOG_H
+
+/* Deferred binary log. Hot paths write fixed-size records (event id, timestamp and up to BINLOG_MAX_ARGS integer
+ * arguments) into a lock-free ring buffer instead of formatting text on the UART. A low-priority task drains the
+ * ring and formats the records with the format string of their event.
+ * Any task can write, only one task may read. When the ring is full, new records are dropped and counted. */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TAG_BINLOG "LASET_BLOG"
+
+// Amount of records in the ring, must be a power of two
+#define BINLOG_CAPACITY 128
+#define BINLOG_MAX_ARGS 5
+
+typedef enum {
+    BINLOG_AMPERAGE_BROADCAST = 0,  // amperage in ten thousandths (fixed_t)
+    BINLOG_AMPERAGE_RECEIVED,       // amperage in ten thousandths, node id
+    BINLOG_MESSAGE_SIGNED,          // message length, signature length
+    BINLOG_MESSAGE_VERIFIED,        // message length
+    BINLOG_TRADE_DEAL_RECEIVED,     // node id, price, duration
+    BINLOG_ACCEPT_RECEIVED,         // node id
+    BINLOG_BLOCK_BROADCAST,         // seller node id, price, duration, buyer node id
+    BINLOG_BLOCK_RECEIVED,          // seller node id, price, duration, buyer node id
+    BINLOG_BLOCK_VERIFIED,          // seller node id, price, duration, buyer node id
+    BINLOG_PHASE_ACKNOWLEDGED,      // phase, estimate in ten thousandths
+    BINLOG_PHASE_ACCEPTANCE,        // node id, phase, matches our block (0/1)
+    BINLOG_BLOCK_COMMITTED,         // chain height, seller node id, buyer node id, price, duration
+    BINLOG_EVENT_AMOUNT
+} binlog_event_t;
+
+typedef struct {
+    int64_t time_us;
+    uint32_t event;
+    int32_t args[BINLOG_MAX_ARGS];
+} binlog_record_t;  // 32 bytes
+
+// Writes a record with the current time. The arguments after the event are converted to int32_t.
+#define BINLOG(event, ...) binlog_write((event), (const int32_t[BINLOG_MAX_ARGS]){__VA_ARGS__})
+
+// Writes a record with the current time. Returns 0, or -1 if the ring is full and the record was dropped.
+int binlog_write(binlog_event_t event, const int32_t args[BINLOG_MAX_ARGS]);
+
+// Same as binlog_write, with the timestamp given in microseconds (used by host tests).
+int binlog_write_at(binlog_event_t event, const int32_t args[BINLOG_MAX_ARGS], int64_t time_us);
+
+// Takes the oldest record out of the ring. Returns 0, or -1 if the ring is empty. Only one task may read.
+int binlog_read(binlog_record_t *record);
+
+// Formats a record as text (without newline). Returns the length like snprintf.
+int binlog_format(const binlog_record_t *record, char *buffer, size_t buffer_size);
+
+// Amount of records dropped because the ring was full.
+uint32_t binlog_dropped(void);
+
+// Empties the ring. No task may write or read while it runs.
+void binlog_reset(void);
+
+#endif
@@ -0,0 +1,202 @@
+#include "metrics.h"
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+
+static portMUX_TYPE metrics_lock = portMUX_INITIALIZER_UNLOCKED;
+#define METRICS_LOCK() portENTER_CRITICAL(&metrics_lock)
+#define METRICS_UNLOCK() portEXIT_CRITICAL(&metrics_lock)
+#else
+#include <pthread.h>
+
+static pthread_mutex_t metrics_lock = PTHREAD_MUTEX_INITIALIZER;
+#define METRICS_LOCK() pthread_mutex_lock(&metrics_lock)
+#define METRICS_UNLOCK() pthread_mutex_unlock(&metrics_lock)
+#endif
+
+typedef struct {
+    char name[METRICS_NAME_SIZE];
+    char labels[METRICS_LABELS_SIZE];
+    metric_type_t type;
+    uint32_t value;     // Counter value, or the gauge value as unsigned
+    uint32_t count;     // Histogram observations
+    uint64_t sum;
+    uint32_t buckets[METRICS_HISTOGRAM_BUCKETS];
+} metric_t;
+
+static metric_t metrics[METRICS_MAX];
+static int metric_amount = 0;   // Only grows while registering, read with acquire so new entries are complete
+
+static const char *type_names[] = {"counter", "gauge", "histogram"};
+
+static metric_t *get_metric(int id) {
+    if (id < 0 || id >= __atomic_load_n(&metric_amount, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+    return &metrics[id];
+}
+
+int metrics_register(const char *name, const char *labels, metric_type_t type) {
+    if (labels == NULL) {
+        labels = "";
+    }
+    if (strlen(name) >= METRICS_NAME_SIZE || strlen(labels) >= METRICS_LABELS_SIZE) {
+        return METRIC_NONE;
+    }
+
+    METRICS_LOCK();
+    for (int id = 0; id < metric_amount; id++) {
+        if (strcmp(metrics[id].name, name) == 0 && strcmp(metrics[id].labels, labels) == 0) {
+            METRICS_UNLOCK();
+            return (metrics[id].type == type) ? id : METRIC_NONE;
+        }
+    }
+
+    if (metric_amount >= METRICS_MAX) {
+        METRICS_UNLOCK();
+        return METRIC_NONE;
+    }
+
+    int id = metric_amount;
+    memset(&metrics[id], 0, sizeof(metric_t));
+    strcpy(metrics[id].name, name);
+    strcpy(metrics[id].labels, labels);
+    metrics[id].type = type;
+    __atomic_store_n(&metric_amount, id + 1, __ATOMIC_RELEASE);
+    METRICS_UNLOCK();
+    return id;
+}
+
+void metrics_counter_add(int id, uint32_t value) {
+    metric_t *metric = get_metric(id);
+    if (metric == NULL || metric->type != METRIC_COUNTER) {
+        return;
+    }
+    __atomic_fetch_add(&metric->value, value, __ATOMIC_RELAXED);
+}
+
+void metrics_gauge_set(int id, int32_t value) {
+    metric_t *metric = get_metric(id);
+    if (metric == NULL || metric->type != METRIC_GAUGE) {
+        return;
+    }
+    __atomic_store_n(&metric->value, (uint32_t)value, __ATOMIC_RELAXED);
+}
+
+void metrics_histogram_observe(int id, uint32_t value) {
+    metric_t *metric = get_metric(id);
+    if (metric == NULL || metric->type != METRIC_HISTOGRAM) {
+        return;
+    }
+
+    int bucket = 0;
+    uint32_t bound = 1;
+    while (bucket < METRICS_HISTOGRAM_BUCKETS - 1 && value > bound) {
+        bucket++;
+        bound <<= 2;
+    }
+    __atomic_fetch_add(&metric->buckets[bucket], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&metric->sum, value, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&metric->count, 1, __ATOMIC_RELAXED);
+}
+
+int64_t metrics_get(int id) {
+    metric_t *metric = get_metric(id);
+    if (metric == NULL) {
+        return 0;
+    }
+
+    switch (metric->type) {
+        case METRIC_COUNTER:
+            return __atomic_load_n(&metric->value, __ATOMIC_RELAXED);
+        case METRIC_GAUGE:
+            return (int32_t)__atomic_load_n(&metric->value, __ATOMIC_RELAXED);
+        default:
+            return __atomic_load_n(&metric->count, __ATOMIC_RELAXED);
+    }
+}
+
+// Appends to the buffer. Sets overflow instead of writing past the end.
+static void append(char *buffer, size_t buffer_size, size_t *length, bool *overflow, const char *format, ...) {
+    if (*overflow) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(buffer + *length, buffer_size - *length, format, args);
+    va_end(args);
+
+    if (written < 0 || (size_t)written >= buffer_size - *length) {
+        *overflow = true;
+        return;
+    }
+    *length += written;
+}
+
+int metrics_render(char *buffer, size_t buffer_size) {
+    size_t length = 0;
+    bool overflow = (buffer_size == 0);
+    int amount = __atomic_load_n(&metric_amount, __ATOMIC_ACQUIRE);
+
+    for (int id = 0; id < amount; id++) {
+        const metric_t *metric = &metrics[id];
+        const char *separator = (metric->labels[0] != '\0') ? "," : "";
+
+        // One TYPE line per name, also when it is registered with several labels
+        bool first_of_name = true;
+        for (int previous = 0; previous < id; previous++) {
+            if (strcmp(metrics[previous].name, metric->name) == 0) {
+                first_of_name = false;
+                break;
+            }
+        }
+        if (first_of_name) {
+            append(buffer, buffer_size, &length, &overflow, "# TYPE %s %s\n", metric->name, type_names[metric->type]);
+        }
+
+        if (metric->type != METRIC_HISTOGRAM) {
+            if (metric->labels[0] != '\0') {
+                append(buffer, buffer_size, &length, &overflow, "%s{%s} %lld\n", metric->name, metric->labels, (long long)metrics_get(id));
+            } else {
+                append(buffer, buffer_size, &length, &overflow, "%s %lld\n", metric->name, (long long)metrics_get(id));
+            }
+            continue;
+        }
+
+        // Prometheus buckets are cumulative
+        uint32_t cumulative = 0;
+        uint32_t bound = 1;
+        for (int bucket = 0; bucket < METRICS_HISTOGRAM_BUCKETS; bucket++) {
+            cumulative += __atomic_load_n(&metric->buckets[bucket], __ATOMIC_RELAXED);
+            if (bucket < METRICS_HISTOGRAM_BUCKETS - 1) {
+                append(buffer, buffer_size, &length, &overflow, "%s_bucket{%s%sle=\"%lu\"} %lu\n",
+                    metric->name, metric->labels, separator, (unsigned long)bound, (unsigned long)cumulative);
+            } else {
+                append(buffer, buffer_size, &length, &overflow, "%s_bucket{%s%sle=\"+Inf\"} %lu\n",
+                    metric->name, metric->labels, separator, (unsigned long)cumulative);
+            }
+            bound <<= 2;
+        }
+        const char *open = (metric->labels[0] != '\0') ? "{" : "";
+        const char *close = (metric->labels[0] != '\0') ? "}" : "";
+        append(buffer, buffer_size, &length, &overflow, "%s_sum%s%s%s %llu\n", metric->name, open, metric->labels, close,
+            (unsigned long long)__atomic_load_n(&metric->sum, __ATOMIC_RELAXED));
+        append(buffer, buffer_size, &length, &overflow, "%s_count%s%s%s %lu\n", metric->name, open, metric->labels, close,
+            (unsigned long)__atomic_load_n(&metric->count, __ATOMIC_RELAXED));
+    }
+
+    return overflow ? -1 : (int)length;
+}
+
+void metrics_reset(void) {
+    METRICS_LOCK();
+    __atomic_store_n(&metric_amount, 0, __ATOMIC_RELEASE);
+    memset(metrics, 0, sizeof(metrics));
+    METRICS_UNLOCK();
+}
@@ -0,0 +1,56 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+/* Registry of runtime metrics (counters, gauges and histograms). Metrics are registered once and then updated
+ * through their id with atomic operations, so hot paths do not take a lock. metrics_render() writes all of them
+ * in the Prometheus text format, which is what the station serves on METRICS_PORT. */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TAG_METRICS "LASET_METR"
+
+// TCP port the station serves its metrics on
+#define METRICS_PORT 9100
+
+#define METRICS_MAX 48
+#define METRICS_NAME_SIZE 48
+#define METRICS_LABELS_SIZE 40
+
+// Histogram bucket b counts values up to 4^b, the last bucket counts everything above 4^(BUCKETS - 2).
+// With microseconds this goes from 1 us to about 1 s.
+#define METRICS_HISTOGRAM_BUCKETS 12
+
+// Id of a metric that could not be registered. Updates to it are ignored.
+#define METRIC_NONE -1
+
+typedef enum {
+    METRIC_COUNTER = 0,     // Only goes up
+    METRIC_GAUGE,           // Set to the current value
+    METRIC_HISTOGRAM        // Distribution of observed values
+} metric_type_t;
+
+// Registers a metric and returns its id. Registering the same name and labels again returns the existing id.
+// labels can be NULL, otherwise it is inserted as is between the braces, like: port="7777".
+// Returns METRIC_NONE if the registry is full or the name does not fit.
+int metrics_register(const char *name, const char *labels, metric_type_t type);
+
+// Adds to a counter.
+void metrics_counter_add(int id, uint32_t value);
+
+// Sets a gauge.
+void metrics_gauge_set(int id, int32_t value);
+
+// Adds a value to a histogram.
+void metrics_histogram_observe(int id, uint32_t value);
+
+// Current value of a counter or gauge, or the amount of observations of a histogram.
+int64_t metrics_get(int id);
+
+// Writes all metrics into buffer as text. Returns the length written, or -1 if the buffer is too small.
+int metrics_render(char *buffer, size_t buffer_size);
+
+// Removes all metrics.
+void metrics_reset(void);
+
+#endif
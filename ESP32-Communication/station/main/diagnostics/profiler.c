@@ -0,0 +1,87 @@
+#include "profiler.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+
+static portMUX_TYPE profiler_lock = portMUX_INITIALIZER_UNLOCKED;
+#define PROFILER_LOCK() portENTER_CRITICAL(&profiler_lock)
+#define PROFILER_UNLOCK() portEXIT_CRITICAL(&profiler_lock)
+#define PROFILER_PRINT(...) ESP_LOGI(TAG_PROFILER, __VA_ARGS__)
+#else
+#include <pthread.h>
+
+static pthread_mutex_t profiler_lock = PTHREAD_MUTEX_INITIALIZER;
+#define PROFILER_LOCK() pthread_mutex_lock(&profiler_lock)
+#define PROFILER_UNLOCK() pthread_mutex_unlock(&profiler_lock)
+#define PROFILER_PRINT(...) do { printf(__VA_ARGS__); printf("\n"); } while (0)
+#endif
+
+static profile_stats_t sites[PROFILE_SITE_AMOUNT];
+
+static const char *site_names[PROFILE_SITE_AMOUNT] = {
+    "payload_decoder",
+    "create_block_hash",
+    "verify_block_signatures",
+    "import_public_key",
+    "sign_message",
+    "verify_message",
+    "udp send",
+    "tcp send",
+};
+
+void profiler_record(profile_site_t site, uint32_t cycles) {
+    if (site >= PROFILE_SITE_AMOUNT) {
+        return;
+    }
+
+    PROFILER_LOCK();
+    sites[site].count++;
+    sites[site].total_cycles += cycles;
+    if (cycles > sites[site].max_cycles) {
+        sites[site].max_cycles = cycles;
+    }
+    PROFILER_UNLOCK();
+}
+
+void profiler_get_stats(profile_site_t site, profile_stats_t *stats) {
+    if (site >= PROFILE_SITE_AMOUNT) {
+        memset(stats, 0, sizeof(profile_stats_t));
+        return;
+    }
+
+    PROFILER_LOCK();
+    *stats = sites[site];
+    PROFILER_UNLOCK();
+}
+
+const char *profiler_site_name(profile_site_t site) {
+    return (site < PROFILE_SITE_AMOUNT) ? site_names[site] : "unknown";
+}
+
+void profiler_dump(void) {
+    profile_stats_t stats;
+
+    if (!PROFILER_ENABLED) {
+        PROFILER_PRINT("profiler is disabled, enable LASET_PROFILER in menuconfig");
+        return;
+    }
+
+    PROFILER_PRINT("%-18s %8s %14s %12s %12s", "site", "count", "total cycles", "avg cycles", "max cycles");
+    for (int site = 0; site < PROFILE_SITE_AMOUNT; site++) {
+        profiler_get_stats(site, &stats);
+        PROFILER_PRINT("%-18s %8lu %14llu %12llu %12lu", site_names[site], (unsigned long)stats.count,
+            (unsigned long long)stats.total_cycles,
+            (unsigned long long)(stats.count ? stats.total_cycles / stats.count : 0),
+            (unsigned long)stats.max_cycles);
+    }
+}
+
+void profiler_reset(void) {
+    PROFILER_LOCK();
+    memset(sites, 0, sizeof(sites));
+    PROFILER_UNLOCK();
+}
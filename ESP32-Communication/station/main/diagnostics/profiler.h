@@ -0,0 +1,92 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+/* Cycle profiler for the functions stations spend their CPU in. PROFILE_BEGIN/PROFILE_END around a section read
+ * the cycle counter (esp_cpu_get_cycle_count on the station, rdtsc or the monotonic clock in nanoseconds on host
+ * builds) and add the cycles to the count, total and max of the site in a static table.
+ * On the station it is off unless LASET_PROFILER is set in menuconfig, with PROFILER_ENABLED 0 the macros compile
+ * to nothing and no site takes the lock. Host builds keep it on so test_profiler measures something. */
+
+#include <stdint.h>
+
+#define TAG_PROFILER "LASET_PROF"
+
+#ifndef PROFILER_ENABLED
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#ifdef CONFIG_LASET_PROFILER
+#define PROFILER_ENABLED 1
+#else
+#define PROFILER_ENABLED 0
+#endif
+#else
+#define PROFILER_ENABLED 1
+#endif
+#endif
+
+typedef enum {
+    PROFILE_PAYLOAD_DECODER = 0,
+    PROFILE_CREATE_BLOCK_HASH,
+    PROFILE_VERIFY_BLOCK_SIGNATURES,
+    PROFILE_IMPORT_PUBLIC_KEY,
+    PROFILE_SIGN_MESSAGE,
+    PROFILE_VERIFY_MESSAGE,
+    PROFILE_UDP_SEND,
+    PROFILE_TCP_SEND,
+    PROFILE_SITE_AMOUNT
+} profile_site_t;
+
+typedef struct {
+    uint32_t count;
+    uint64_t total_cycles;
+    uint32_t max_cycles;
+} profile_stats_t;
+
+// Current value of the cycle counter. Only differences are meaningful, they wrap at 32 bits.
+#ifdef ESP_PLATFORM
+#include "esp_cpu.h"
+
+static inline uint32_t profiler_cycles(void) {
+    return esp_cpu_get_cycle_count();
+}
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+
+static inline uint32_t profiler_cycles(void) {
+    return (uint32_t)__rdtsc();
+}
+#else
+#include <time.h>
+
+static inline uint32_t profiler_cycles(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000000u + now.tv_nsec);
+}
+#endif
+
+#if PROFILER_ENABLED
+// Starts timing a site. Declares a variable, so it has to be used as a statement in the scope of PROFILE_END.
+#define PROFILE_BEGIN(site) uint32_t profile_start_##site = profiler_cycles()
+#define PROFILE_END(site) profiler_record((site), profiler_cycles() - profile_start_##site)
+#else
+#define PROFILE_BEGIN(site) do { } while (0)
+#define PROFILE_END(site) do { } while (0)
+#endif
+
+// Adds a measurement to a site.
+void profiler_record(profile_site_t site, uint32_t cycles);
+
+// Gets the count, total and max of a site.
+void profiler_get_stats(profile_site_t site, profile_stats_t *stats);
+
+// Name of a site, for printing.
+const char *profiler_site_name(profile_site_t site);
+
+// Prints the table of all sites.
+void profiler_dump(void);
+
+// Clears the table.
+void profiler_reset(void);
+
+#endif
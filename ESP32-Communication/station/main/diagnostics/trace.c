@@ -0,0 +1,210 @@
+#include "trace.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static portMUX_TYPE trace_lock = portMUX_INITIALIZER_UNLOCKED;
+#define TRACE_LOCK() portENTER_CRITICAL(&trace_lock)
+#define TRACE_UNLOCK() portEXIT_CRITICAL(&trace_lock)
+#define TRACE_PRINT(...) ESP_LOGI(TAG_TRACE, __VA_ARGS__)
+#else
+#include <pthread.h>
+#include <time.h>
+
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+#define TRACE_LOCK() pthread_mutex_lock(&trace_lock)
+#define TRACE_UNLOCK() pthread_mutex_unlock(&trace_lock)
+#define TRACE_PRINT(...) do { printf(__VA_ARGS__); printf("\n"); } while (0)
+#endif
+
+typedef struct {
+    uint32_t trade_id;
+    bool in_use;
+    int64_t start_us;
+    int64_t last_us;
+} trace_trade_t;
+
+typedef struct {
+    uint32_t count;
+    uint64_t total_us;
+    uint64_t max_us;
+    uint32_t buckets[TRACE_HISTOGRAM_BUCKETS];
+} trace_histogram_t;
+
+static trace_trade_t trades[TRACE_MAX_TRADES];
+static trace_histogram_t histograms[TRACE_STAGE_AMOUNT];
+
+static const char *stage_names[TRACE_STAGE_AMOUNT] = {
+    "bcd broadcast",
+    "atd verified",
+    "bcb broadcast",
+    "bcb received",
+    "phase vote",
+    "commit",
+    "end to end",
+};
+
+static int64_t trace_now_us(void) {
+#ifdef ESP_PLATFORM
+    return esp_timer_get_time();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+#endif
+}
+
+uint32_t trace_trade_id(int seller_node_id, int price, int duration) {
+    // FNV-1a over the three terms
+    int terms[3] = {seller_node_id, price, duration};
+    const uint8_t *bytes = (const uint8_t *)terms;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(terms); i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void histogram_add(trace_histogram_t *histogram, uint64_t latency_us) {
+    int bucket = 0;
+    while (bucket < TRACE_HISTOGRAM_BUCKETS - 1 && (latency_us >> bucket) != 0) {
+        bucket++;
+    }
+    histogram->buckets[bucket]++;
+    histogram->count++;
+    histogram->total_us += latency_us;
+    if (latency_us > histogram->max_us) {
+        histogram->max_us = latency_us;
+    }
+}
+
+// Must be called with the lock taken. Sets started if the trade was not traced yet.
+// Returns NULL if the trade is not traced and can_start is false.
+static trace_trade_t *find_or_start_trade(uint32_t trade_id, int64_t time_us, bool can_start, bool *started) {
+    trace_trade_t *oldest = &trades[0];
+
+    for (int i = 0; i < TRACE_MAX_TRADES; i++) {
+        if (trades[i].in_use && trades[i].trade_id == trade_id) {
+            *started = false;
+            return &trades[i];
+        }
+    }
+
+    if (!can_start) {
+        return NULL;
+    }
+
+    for (int i = 0; i < TRACE_MAX_TRADES; i++) {
+        if (!trades[i].in_use) {
+            oldest = &trades[i];
+            break;
+        }
+        if (trades[i].last_us < oldest->last_us) {
+            oldest = &trades[i];
+        }
+    }
+
+    oldest->trade_id = trade_id;
+    oldest->in_use = true;
+    oldest->start_us = time_us;
+    oldest->last_us = time_us;
+    *started = true;
+    return oldest;
+}
+
+void trace_mark(uint32_t trade_id, trace_stage_t stage) {
+    trace_mark_at(trade_id, stage, trace_now_us());
+}
+
+void trace_mark_at(uint32_t trade_id, trace_stage_t stage, int64_t time_us) {
+    if (stage >= TRACE_END_TO_END) {
+        return;
+    }
+
+    bool started;
+    // Only the first stage on the seller or on the other stations can start a trace. Later stages of a trade
+    // that is not traced (or was dropped) are ignored.
+    bool can_start = (stage == TRACE_BCD_BROADCAST || stage == TRACE_BCB_RECEIVED);
+
+    TRACE_LOCK();
+    trace_trade_t *trade = find_or_start_trade(trade_id, time_us, can_start, &started);
+    if (trade == NULL) {
+        TRACE_UNLOCK();
+        return;
+    }
+
+    // The first stage of a trade only starts the trace, later ones record the time since the previous stage
+    if (!started && time_us >= trade->last_us) {
+        histogram_add(&histograms[stage], time_us - trade->last_us);
+        trade->last_us = time_us;
+    }
+
+    if (stage == TRACE_COMMIT) {
+        histogram_add(&histograms[TRACE_END_TO_END], trade->last_us - trade->start_us);
+        trade->in_use = false;
+    }
+    TRACE_UNLOCK();
+}
+
+// Upper bound of the bucket holding the given fraction of the samples
+static uint64_t histogram_percentile(const trace_histogram_t *histogram, uint32_t per_mille) {
+    if (histogram->count == 0) {
+        return 0;
+    }
+
+    uint32_t target = (histogram->count * per_mille + 999) / 1000;
+    uint32_t seen = 0;
+    for (int bucket = 0; bucket < TRACE_HISTOGRAM_BUCKETS; bucket++) {
+        seen += histogram->buckets[bucket];
+        if (seen >= target) {
+            uint64_t upper_bound = (bucket == 0) ? 0 : ((uint64_t)1 << bucket) - 1;
+            return (upper_bound < histogram->max_us) ? upper_bound : histogram->max_us;
+        }
+    }
+    return histogram->max_us;
+}
+
+void trace_get_stats(trace_stage_t stage, trace_stats_t *stats) {
+    memset(stats, 0, sizeof(trace_stats_t));
+    if (stage >= TRACE_STAGE_AMOUNT) {
+        return;
+    }
+
+    TRACE_LOCK();
+    const trace_histogram_t *histogram = &histograms[stage];
+    stats->count = histogram->count;
+    stats->total_us = histogram->total_us;
+    stats->max_us = histogram->max_us;
+    stats->p50_us = histogram_percentile(histogram, 500);
+    stats->p99_us = histogram_percentile(histogram, 990);
+    TRACE_UNLOCK();
+}
+
+const char *trace_stage_name(trace_stage_t stage) {
+    return (stage < TRACE_STAGE_AMOUNT) ? stage_names[stage] : "unknown";
+}
+
+void trace_print_report(void) {
+    trace_stats_t stats;
+
+    TRACE_PRINT("Trade latency per stage (since the previous stage of the same trade):");
+    for (int stage = 0; stage < TRACE_STAGE_AMOUNT; stage++) {
+        trace_get_stats(stage, &stats);
+        TRACE_PRINT("  %-14s count %5lu | p50 %8llu us | p99 %8llu us | max %8llu us",
+            trace_stage_name(stage), (unsigned long)stats.count,
+            (unsigned long long)stats.p50_us, (unsigned long long)stats.p99_us, (unsigned long long)stats.max_us);
+    }
+}
+
+void trace_reset(void) {
+    TRACE_LOCK();
+    memset(trades, 0, sizeof(trades));
+    memset(histograms, 0, sizeof(histograms));
+    TRACE_UNLOCK();
+}
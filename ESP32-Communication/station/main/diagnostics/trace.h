@@ -0,0 +1,59 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+/* Trade lifecycle tracing. Every stage a trade passes through is timestamped per trade id, and the time since
+ * the previous stage of the same trade is added to a latency histogram for that stage.
+ * Uses esp_timer_get_time() on the station and the monotonic clock on host builds. */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TAG_TRACE "LASET_TRCE"
+
+// Amount of trades that can be traced at the same time. The oldest trade is dropped when it is full.
+#define TRACE_MAX_TRADES 8
+
+// Histogram buckets. Bucket b holds latencies below 2^b microseconds, so 32 buckets cover more than an hour.
+#define TRACE_HISTOGRAM_BUCKETS 32
+
+typedef enum {
+    TRACE_BCD_BROADCAST = 0,    // Seller broadcasted its trade deal (a trace starts here on the seller)
+    TRACE_ATD_VERIFIED,         // Seller received and verified an accept from a buyer
+    TRACE_BCB_BROADCAST,        // Seller broadcasted the block
+    TRACE_BCB_RECEIVED,         // Block received and verified (a trace starts here on the other stations)
+    TRACE_PHASE_VOTE,           // A phase acceptance for the block was received
+    TRACE_COMMIT,               // Block added to the chain
+    TRACE_END_TO_END,           // From the first to the last stage of a trade (recorded on commit)
+    TRACE_STAGE_AMOUNT
+} trace_stage_t;
+
+typedef struct {
+    uint32_t count;
+    uint64_t total_us;
+    uint64_t max_us;
+    uint64_t p50_us;    // Upper bound of the bucket holding the percentile (capped at max_us)
+    uint64_t p99_us;
+} trace_stats_t;
+
+// Trade id from the terms every stage knows: seller node id, price and the duration that was agreed on.
+uint32_t trace_trade_id(int seller_node_id, int price, int duration);
+
+// Records that a trade reached a stage now.
+void trace_mark(uint32_t trade_id, trace_stage_t stage);
+
+// Same as trace_mark, with the timestamp given in microseconds (used by host tests).
+void trace_mark_at(uint32_t trade_id, trace_stage_t stage, int64_t time_us);
+
+// Gets the latency statistics of a stage.
+void trace_get_stats(trace_stage_t stage, trace_stats_t *stats);
+
+// Name of a stage, for printing.
+const char *trace_stage_name(trace_stage_t stage);
+
+// Prints count, p50, p99 and max of every stage.
+void trace_print_report(void);
+
+// Clears all traces and histograms.
+void trace_reset(void);
+
+#endif
@@ -0,0 +1,208 @@
+#include "dashboard.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static portMUX_TYPE dashboard_writer_lock = portMUX_INITIALIZER_UNLOCKED;
+#define DASHBOARD_WRITER_LOCK() portENTER_CRITICAL(&dashboard_writer_lock)
+#define DASHBOARD_WRITER_UNLOCK() portEXIT_CRITICAL(&dashboard_writer_lock)
+#define DASHBOARD_YIELD() taskYIELD()
+#else
+#include <pthread.h>
+#include <sched.h>
+
+static pthread_mutex_t dashboard_writer_lock = PTHREAD_MUTEX_INITIALIZER;
+#define DASHBOARD_WRITER_LOCK() pthread_mutex_lock(&dashboard_writer_lock)
+#define DASHBOARD_WRITER_UNLOCK() pthread_mutex_unlock(&dashboard_writer_lock)
+#define DASHBOARD_YIELD() sched_yield()
+#endif
+
+void dashboard_snapshot_init(dashboard_snapshot_t *snapshot) {
+    memset(snapshot, 0, sizeof(dashboard_snapshot_t));
+    snapshot->state.node_id = -1;
+    snapshot->state.trade_open = true;
+}
+
+dashboard_state_t *dashboard_begin_update(dashboard_snapshot_t *snapshot) {
+    DASHBOARD_WRITER_LOCK();
+    __atomic_store_n(&snapshot->sequence, snapshot->sequence + 1, __ATOMIC_RELAXED);
+    // The odd sequence has to be visible before any change of the state
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    return &snapshot->state;
+}
+
+void dashboard_end_update(dashboard_snapshot_t *snapshot) {
+    __atomic_store_n(&snapshot->sequence, snapshot->sequence + 1, __ATOMIC_RELEASE);
+    DASHBOARD_WRITER_UNLOCK();
+}
+
+uint32_t dashboard_read(dashboard_snapshot_t *snapshot, dashboard_state_t *state) {
+    while (1) {
+        uint32_t before = __atomic_load_n(&snapshot->sequence, __ATOMIC_ACQUIRE);
+        if (before & 1) {
+            DASHBOARD_YIELD();
+            continue;
+        }
+        memcpy(state, &snapshot->state, sizeof(dashboard_state_t));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&snapshot->sequence, __ATOMIC_RELAXED) == before) {
+            return before;
+        }
+    }
+}
+
+void dashboard_init(dashboard_t *dashboard) {
+    dashboard->background = COLOR_SWAP(DASHBOARD_BACKGROUND);
+    glyph_atlas_build(&dashboard->atlas, COLOR_SWAP(DASHBOARD_TEXT), dashboard->background);
+    memset(&dashboard->view, 0, sizeof(dashboard_view_t));
+}
+
+// Rows of the layout
+#define ROW_TITLE 0
+#define ROW_CHAIN 2
+#define ROW_TRADE 3
+#define ROW_AMPERAGE 4
+#define ROW_TRADE_DEAL 5
+#define ROW_GRID 7
+#define ROW_FIRST_NODE 8
+#define ROW_QUORUM 18
+#define ROW_VOTES 19
+
+// Formats the text of a row, cut off at the screen width
+static int set_row(dashboard_view_t *view, int row, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(view->text[row], sizeof(view->text[row]), format, args);
+    va_end(args);
+    return (length < DASHBOARD_COLUMNS) ? length : DASHBOARD_COLUMNS;
+}
+
+void dashboard_layout(const dashboard_state_t *state, dashboard_view_t *view) {
+    memset(view, 0, sizeof(dashboard_view_t));
+
+    set_row(view, ROW_TITLE, "LASET NODE %i", state->node_id);
+    set_row(view, ROW_CHAIN, "CHAIN HEIGHT %i", state->chain_height);
+    if (state->has_trade) {
+        set_row(view, ROW_TRADE, "LAST %i>%i %iKR %iS", state->trade_seller, state->trade_buyer, state->trade_price, state->trade_duration);
+    } else {
+        set_row(view, ROW_TRADE, "LAST TRADE NONE");
+    }
+    char amperage[FIXED_TEXT_SIZE];
+    fixed_format(state->amperage, 1, amperage, sizeof(amperage));
+    set_row(view, ROW_AMPERAGE, "AMPERAGE %s", amperage);
+    set_row(view, ROW_TRADE_DEAL, "TRADE DEAL %s", state->trade_open ? "OPEN" : "TAKEN");
+
+    char load_text[FIXED_TEXT_SIZE];
+    fixed_format(fixed_sum(state->grid_load, DASHBOARD_NODES), 1, load_text, sizeof(load_text));
+    set_row(view, ROW_GRID, "GRID LOAD %s", load_text);
+    for (int node = 0; node < DASHBOARD_NODES; node++) {
+        int row = ROW_FIRST_NODE + node;
+        fixed_t load = state->grid_load[node];
+        fixed_t magnitude = fixed_abs(load);
+        if (magnitude > FIXED_FROM_INT(DASHBOARD_BAR_FULL_SCALE)) {
+            magnitude = FIXED_FROM_INT(DASHBOARD_BAR_FULL_SCALE);
+        }
+        fixed_format(load, 1, load_text, sizeof(load_text));
+        set_row(view, row, "%c%i %6s", (node == state->node_id) ? '>' : ' ', node, load_text);
+        view->bar_width[row] = (uint8_t)((int64_t)magnitude * DASHBOARD_BAR_MAX_WIDTH / FIXED_FROM_INT(DASHBOARD_BAR_FULL_SCALE));
+        view->bar_color[row] = COLOR_SWAP((load < 0) ? DASHBOARD_PRODUCING : DASHBOARD_CONSUMING);
+    }
+
+    if (state->phase_amount == 0) {
+        set_row(view, ROW_QUORUM, "NO BLOCK IN VOTING");
+        return;
+    }
+    set_row(view, ROW_QUORUM, "NEEDS %i VOTES/PHASE", state->quorum);
+    // One character per phase, # when the phase has its quorum
+    char *votes = view->text[ROW_VOTES];
+    int length = set_row(view, ROW_VOTES, "VOTES ");
+    for (int phase = 0; phase < state->phase_amount && phase < DASHBOARD_PHASES && length < DASHBOARD_COLUMNS; phase++) {
+        uint8_t phase_votes = state->phase_votes[phase];
+        votes[length++] = (phase_votes >= state->quorum) ? '#' : (phase_votes > 9) ? '9' : '0' + phase_votes;
+    }
+    votes[length] = '\0';
+}
+
+int dashboard_update_view(dashboard_t *dashboard, renderer_t *renderer, const dashboard_view_t *view) {
+    int changed_rows = 0;
+
+    for (int row = 0; row < DASHBOARD_ROWS; row++) {
+        const char *old_text = dashboard->view.text[row];
+        const char *new_text = view->text[row];
+        bool changed = false;
+
+        // Columns from the first to the last one that differ, a shorter line differs in the cleared columns
+        int first = -1;
+        int last = -1;
+        for (int column = 0; column < DASHBOARD_COLUMNS; column++) {
+            char old_character = (column < (int)strlen(old_text)) ? old_text[column] : ' ';
+            char new_character = (column < (int)strlen(new_text)) ? new_text[column] : ' ';
+            if (old_character != new_character) {
+                if (first < 0) {
+                    first = column;
+                }
+                last = column;
+            }
+        }
+        if (first >= 0) {
+            renderer_invalidate(renderer, first * GLYPH_WIDTH, row * GLYPH_HEIGHT, (last - first + 1) * GLYPH_WIDTH, GLYPH_HEIGHT);
+            changed = true;
+        }
+
+        // The bar area between the old and new end, or all of it when the color changed
+        uint8_t old_width = dashboard->view.bar_width[row];
+        uint8_t new_width = view->bar_width[row];
+        if (dashboard->view.bar_color[row] != view->bar_color[row]) {
+            int width = (old_width > new_width) ? old_width : new_width;
+            renderer_invalidate(renderer, DASHBOARD_BAR_X, row * GLYPH_HEIGHT, width, GLYPH_HEIGHT);
+            changed = changed || width > 0;
+        } else if (old_width != new_width) {
+            int from = (old_width < new_width) ? old_width : new_width;
+            int to = (old_width > new_width) ? old_width : new_width;
+            renderer_invalidate(renderer, DASHBOARD_BAR_X + from, row * GLYPH_HEIGHT, to - from, GLYPH_HEIGHT);
+            changed = true;
+        }
+
+        changed_rows += changed;
+    }
+
+    dashboard->view = *view;
+    return changed_rows;
+}
+
+void dashboard_paint(void *context, int x, int y, int width, int height, uint16_t *pixels) {
+    dashboard_t *dashboard = (dashboard_t *)context;
+
+    for (int i = 0; i < width * height; i++) {
+        pixels[i] = dashboard->background;
+    }
+
+    int first_row = y / GLYPH_HEIGHT;
+    int last_row = (y + height - 1) / GLYPH_HEIGHT;
+    for (int row = first_row; row <= last_row && row < DASHBOARD_ROWS; row++) {
+        int row_y = row * GLYPH_HEIGHT;
+        glyph_draw_text(&dashboard->atlas, dashboard->view.text[row], 0, row_y, x, y, width, height, pixels);
+
+        // Bar, clipped to the rectangle
+        int bar_start = (x > DASHBOARD_BAR_X) ? x : DASHBOARD_BAR_X;
+        int bar_end = DASHBOARD_BAR_X + dashboard->view.bar_width[row];
+        if (bar_end > x + width) {
+            bar_end = x + width;
+        }
+        // Two pixels of space above and below, so bars of neighbouring rows do not touch
+        for (int screen_y = row_y + 2; screen_y < row_y + GLYPH_HEIGHT - 2 && bar_start < bar_end; screen_y++) {
+            if (screen_y < y || screen_y >= y + height) {
+                continue;
+            }
+            for (int screen_x = bar_start; screen_x < bar_end; screen_x++) {
+                pixels[(screen_y - y) * width + (screen_x - x)] = dashboard->view.bar_color[row];
+            }
+        }
+    }
+}
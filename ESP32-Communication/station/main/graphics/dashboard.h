@@ -0,0 +1,94 @@
+#ifndef DASHBOARD_H
+#define DASHBOARD_H
+
+/* Market dashboard for the station display. The network tasks publish what is shown into a dashboard snapshot,
+ * guarded by a sequence lock: a writer makes the sequence odd, changes the state and makes it even again, and the
+ * dashboard copies the state without any lock, retrying if the sequence was odd or changed during the copy. So
+ * drawing never blocks trade processing, and nothing is drawn while nothing changed.
+ * The state is laid out as rows of text (and load bars), and only the rows that changed are redrawn. */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../models/models.h"
+#include "../grid/fixed_point.h"
+#include "renderer.h"
+#include "glyphs.h"
+
+#define TAG_DASHBOARD "LASET_DASH"
+
+#define DASHBOARD_COLUMNS (SCREEN_WIDTH / GLYPH_WIDTH)
+#define DASHBOARD_ROWS (SCREEN_HEIGHT / GLYPH_HEIGHT)
+
+#define DASHBOARD_NODES PK_KEY_ARRAY_SIZE
+#define DASHBOARD_PHASES (60/5)
+
+// Load bars start after the text of a node row, and are full at this many amperes
+#define DASHBOARD_BAR_X (10 * GLYPH_WIDTH)
+#define DASHBOARD_BAR_MAX_WIDTH (SCREEN_WIDTH - DASHBOARD_BAR_X)
+#define DASHBOARD_BAR_FULL_SCALE 20
+
+// RGB565 colors, swapped for the panel when the dashboard is created
+#define DASHBOARD_BACKGROUND 0x0008
+#define DASHBOARD_TEXT 0xFFFF
+#define DASHBOARD_PRODUCING 0x07E0     // Negative load, the node has power to sell
+#define DASHBOARD_CONSUMING 0xFD20
+
+typedef struct {
+    int node_id;
+    int chain_height;
+    fixed_t amperage;                       // Own reading
+    fixed_t grid_load[DASHBOARD_NODES];
+    bool trade_open;                        // No buyer has accepted the own trade deal yet
+    bool has_trade;
+    short trade_seller;                     // Latest committed trade
+    short trade_buyer;
+    short trade_price;
+    short trade_duration;
+    uint8_t phase_amount;                   // Phases of the block being validated, 0 when there is none
+    uint8_t quorum;                         // Votes needed to accept a phase
+    uint8_t phase_votes[DASHBOARD_PHASES];
+} dashboard_state_t;
+
+typedef struct {
+    uint32_t sequence;                      // Odd while a writer changes the state
+    dashboard_state_t state;
+} dashboard_snapshot_t;
+
+// What is on the screen: a line of text per row, and a load bar on the node rows
+typedef struct {
+    char text[DASHBOARD_ROWS][DASHBOARD_COLUMNS + 1];
+    uint8_t bar_width[DASHBOARD_ROWS];
+    uint16_t bar_color[DASHBOARD_ROWS];
+} dashboard_view_t;
+
+typedef struct {
+    glyph_atlas_t atlas;
+    dashboard_view_t view;                  // Currently drawn
+    uint16_t background;
+} dashboard_t;
+
+void dashboard_snapshot_init(dashboard_snapshot_t *snapshot);
+
+// Starts a change of the snapshot. Writers are serialized by a short lock, the reader never takes it.
+// Every call must be followed by dashboard_end_update.
+dashboard_state_t *dashboard_begin_update(dashboard_snapshot_t *snapshot);
+void dashboard_end_update(dashboard_snapshot_t *snapshot);
+
+// Copies a consistent state without locking. Returns the sequence of the copy, which only changes with the state.
+uint32_t dashboard_read(dashboard_snapshot_t *snapshot, dashboard_state_t *state);
+
+// Builds the glyph atlas and an empty view.
+void dashboard_init(dashboard_t *dashboard);
+
+// Lays out a state as rows of text and bars.
+void dashboard_layout(const dashboard_state_t *state, dashboard_view_t *view);
+
+// Shows a new view: marks the parts that differ from the current one dirty and makes it current.
+// Returns the amount of rows that changed.
+int dashboard_update_view(dashboard_t *dashboard, renderer_t *renderer, const dashboard_view_t *view);
+
+// Paint callback for the renderer, with the dashboard as context.
+void dashboard_paint(void *context, int x, int y, int width, int height, uint16_t *pixels);
+
+#endif
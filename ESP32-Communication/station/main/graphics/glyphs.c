@@ -0,0 +1,121 @@
+#include "glyphs.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+// 5x7 font, one byte per column with the top row in bit 0
+static const uint8_t font[GLYPH_AMOUNT][5] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00},  // ' '
+    {0x00, 0x00, 0x5F, 0x00, 0x00},  // !
+    {0x00, 0x07, 0x00, 0x07, 0x00},  // "
+    {0x14, 0x7F, 0x14, 0x7F, 0x14},  // #
+    {0x24, 0x2A, 0x7F, 0x2A, 0x12},  // $
+    {0x23, 0x13, 0x08, 0x64, 0x62},  // %
+    {0x36, 0x49, 0x56, 0x20, 0x50},  // &
+    {0x00, 0x05, 0x03, 0x00, 0x00},  // '
+    {0x00, 0x1C, 0x22, 0x41, 0x00},  // (
+    {0x00, 0x41, 0x22, 0x1C, 0x00},  // )
+    {0x08, 0x2A, 0x1C, 0x2A, 0x08},  // *
+    {0x08, 0x08, 0x3E, 0x08, 0x08},  // +
+    {0x00, 0x50, 0x30, 0x00, 0x00},  // ,
+    {0x08, 0x08, 0x08, 0x08, 0x08},  // -
+    {0x00, 0x60, 0x60, 0x00, 0x00},  // .
+    {0x20, 0x10, 0x08, 0x04, 0x02},  // /
+    {0x3E, 0x51, 0x49, 0x45, 0x3E},  // 0
+    {0x00, 0x42, 0x7F, 0x40, 0x00},  // 1
+    {0x42, 0x61, 0x51, 0x49, 0x46},  // 2
+    {0x21, 0x41, 0x45, 0x4B, 0x31},  // 3
+    {0x18, 0x14, 0x12, 0x7F, 0x10},  // 4
+    {0x27, 0x45, 0x45, 0x45, 0x39},  // 5
+    {0x3C, 0x4A, 0x49, 0x49, 0x30},  // 6
+    {0x01, 0x71, 0x09, 0x05, 0x03},  // 7
+    {0x36, 0x49, 0x49, 0x49, 0x36},  // 8
+    {0x06, 0x49, 0x49, 0x29, 0x1E},  // 9
+    {0x00, 0x36, 0x36, 0x00, 0x00},  // :
+    {0x00, 0x56, 0x36, 0x00, 0x00},  // ;
+    {0x08, 0x14, 0x22, 0x41, 0x00},  // <
+    {0x14, 0x14, 0x14, 0x14, 0x14},  // =
+    {0x00, 0x41, 0x22, 0x14, 0x08},  // >
+    {0x02, 0x01, 0x51, 0x09, 0x06},  // ?
+    {0x32, 0x49, 0x79, 0x41, 0x3E},  // @
+    {0x7E, 0x11, 0x11, 0x11, 0x7E},  // A
+    {0x7F, 0x49, 0x49, 0x49, 0x36},  // B
+    {0x3E, 0x41, 0x41, 0x41, 0x22},  // C
+    {0x7F, 0x41, 0x41, 0x22, 0x1C},  // D
+    {0x7F, 0x49, 0x49, 0x49, 0x41},  // E
+    {0x7F, 0x09, 0x09, 0x09, 0x01},  // F
+    {0x3E, 0x41, 0x49, 0x49, 0x7A},  // G
+    {0x7F, 0x08, 0x08, 0x08, 0x7F},  // H
+    {0x00, 0x41, 0x7F, 0x41, 0x00},  // I
+    {0x20, 0x40, 0x41, 0x3F, 0x01},  // J
+    {0x7F, 0x08, 0x14, 0x22, 0x41},  // K
+    {0x7F, 0x40, 0x40, 0x40, 0x40},  // L
+    {0x7F, 0x02, 0x0C, 0x02, 0x7F},  // M
+    {0x7F, 0x04, 0x08, 0x10, 0x7F},  // N
+    {0x3E, 0x41, 0x41, 0x41, 0x3E},  // O
+    {0x7F, 0x09, 0x09, 0x09, 0x06},  // P
+    {0x3E, 0x41, 0x51, 0x21, 0x5E},  // Q
+    {0x7F, 0x09, 0x19, 0x29, 0x46},  // R
+    {0x46, 0x49, 0x49, 0x49, 0x31},  // S
+    {0x01, 0x01, 0x7F, 0x01, 0x01},  // T
+    {0x3F, 0x40, 0x40, 0x40, 0x3F},  // U
+    {0x1F, 0x20, 0x40, 0x20, 0x1F},  // V
+    {0x3F, 0x40, 0x38, 0x40, 0x3F},  // W
+    {0x63, 0x14, 0x08, 0x14, 0x63},  // X
+    {0x07, 0x08, 0x70, 0x08, 0x07},  // Y
+    {0x61, 0x51, 0x49, 0x45, 0x43},  // Z
+    {0x00, 0x7F, 0x41, 0x41, 0x00},  // [
+    {0x02, 0x04, 0x08, 0x10, 0x20},  // backslash
+    {0x00, 0x41, 0x41, 0x7F, 0x00},  // ]
+    {0x04, 0x02, 0x01, 0x02, 0x04},  // ^
+    {0x40, 0x40, 0x40, 0x40, 0x40},  // _
+};
+
+void glyph_atlas_build(glyph_atlas_t *atlas, uint16_t foreground, uint16_t background) {
+    atlas->foreground = foreground;
+    atlas->background = background;
+
+    for (int glyph = 0; glyph < GLYPH_AMOUNT; glyph++) {
+        for (int y = 0; y < GLYPH_HEIGHT; y++) {
+            int font_row = y / GLYPH_SCALE;
+            for (int x = 0; x < GLYPH_WIDTH; x++) {
+                int font_column = x / GLYPH_SCALE;
+                // The last column and row are the spacing to the next glyph
+                bool set = font_column < 5 && font_row < 7 && (font[glyph][font_column] & (1 << font_row));
+                atlas->pixels[glyph][y][x] = set ? foreground : background;
+            }
+        }
+    }
+}
+
+const uint16_t *glyph_row(const glyph_atlas_t *atlas, char character, int row) {
+    if (character >= 'a' && character <= 'z') {
+        character -= 'a' - 'A';
+    }
+    if (character < GLYPH_FIRST || character > GLYPH_LAST) {
+        character = '?';
+    }
+    return atlas->pixels[character - GLYPH_FIRST][row];
+}
+
+void glyph_draw_text(const glyph_atlas_t *atlas, const char *text, int text_x, int text_y,
+                     int x, int y, int width, int height, uint16_t *pixels) {
+    int row_start = (y > text_y) ? y : text_y;
+    int row_end = (y + height < text_y + GLYPH_HEIGHT) ? y + height : text_y + GLYPH_HEIGHT;
+
+    for (int screen_y = row_start; screen_y < row_end; screen_y++) {
+        uint16_t *destination = &pixels[(screen_y - y) * width];
+        int glyph_x = text_x;
+
+        for (const char *character = text; *character != '\0' && glyph_x < x + width; character++, glyph_x += GLYPH_WIDTH) {
+            if (glyph_x + GLYPH_WIDTH <= x) {
+                continue;
+            }
+            // Clip the glyph row to the rectangle and copy it
+            int from = (glyph_x < x) ? x - glyph_x : 0;
+            int to = (glyph_x + GLYPH_WIDTH > x + width) ? x + width - glyph_x : GLYPH_WIDTH;
+            const uint16_t *source = glyph_row(atlas, *character, screen_y - text_y);
+            memcpy(&destination[glyph_x + from - x], &source[from], (to - from) * sizeof(uint16_t));
+        }
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef GLYPHS_H
+#define GLYPHS_H
+
+/* Text drawing from a glyph atlas. The 5x7 font is expanded once into RGB565 pixels for a foreground and a
+ * background color at a fixed scale, so drawing text is copying rows of ready made pixels into a band buffer.
+ * The font covers ' ' to '_', lower case letters are drawn as upper case. */
+
+#include <stdint.h>
+
+#define TAG_GLYPHS "LASET_GLPH"
+
+#define GLYPH_FIRST ' '
+#define GLYPH_LAST '_'
+#define GLYPH_AMOUNT (GLYPH_LAST - GLYPH_FIRST + 1)
+
+// Font size, one column and one row of spacing included
+#define GLYPH_FONT_WIDTH 6
+#define GLYPH_FONT_HEIGHT 8
+
+// Scale of the atlas. At 2 a glyph is 12x16, so a text row is exactly one display band.
+#define GLYPH_SCALE 2
+#define GLYPH_WIDTH (GLYPH_FONT_WIDTH * GLYPH_SCALE)
+#define GLYPH_HEIGHT (GLYPH_FONT_HEIGHT * GLYPH_SCALE)
+
+typedef struct {
+    uint16_t foreground;
+    uint16_t background;
+    uint16_t pixels[GLYPH_AMOUNT][GLYPH_HEIGHT][GLYPH_WIDTH];
+} glyph_atlas_t;
+
+// Expands the font into the atlas. Colors are stored as given, so pass them swapped (COLOR_SWAP) for the panel.
+void glyph_atlas_build(glyph_atlas_t *atlas, uint16_t foreground, uint16_t background);
+
+// Pixel row of a glyph, characters outside the font are drawn as '?'.
+const uint16_t *glyph_row(const glyph_atlas_t *atlas, char character, int row);
+
+// Draws text with its top left corner at (text_x, text_y) into the rectangle (x, y, width, height) that pixels
+// holds, row by row. Only the part inside the rectangle is written.
+void glyph_draw_text(const glyph_atlas_t *atlas, const char *text, int text_x, int text_y,
+                     int x, int y, int width, int height, uint16_t *pixels);
+
+#endif
@@ -1,6 +1,36 @@
 #include "graphics.h"
 
-void setup_display()
+#include "freertos/semphr.h"
+
+// Given from the SPI interrupt when the panel finished reading a band buffer
+static SemaphoreHandle_t transfer_done;
+static int transfers_in_flight = 0;
+
+static bool notify_transfer_done(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *event_data, void *user_ctx) {
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    xSemaphoreGiveFromISR(transfer_done, &higher_priority_task_woken);
+    return higher_priority_task_woken == pdTRUE;
+}
+
+// The transfer is queued to the SPI driver and sent by DMA, the renderer paints the next band meanwhile
+static int panel_flush(void *context, int x, int y, int width, int height, const uint16_t *pixels) {
+    esp_lcd_panel_handle_t panel_handle = (esp_lcd_panel_handle_t)context;
+    if (esp_lcd_panel_draw_bitmap(panel_handle, x, y, x + width, y + height, pixels) != ESP_OK) {
+        ESP_LOGE(TAG_DISPLAY, "Could not draw %ix%i at (%i, %i)", width, height, x, y);
+        return -1;
+    }
+    transfers_in_flight++;
+    return 0;
+}
+
+static void panel_wait(void *context, int pending) {
+    while (transfers_in_flight > pending) {
+        xSemaphoreTake(transfer_done, portMAX_DELAY);
+        transfers_in_flight--;
+    }
+}
+
+void setup_display(renderer_t *renderer, render_paint_t paint, void *paint_context)
 {
     gpio_config_t bk_gpio_config = {
         .mode = GPIO_MODE_OUTPUT,
@@ -14,7 +44,7 @@ void setup_display()
     spi_bus_config_t bus_config = {
         .sclk_io_num = PIN_NUM_SCLK,
         .mosi_io_num = PIN_NUM_MOSI,
-        .max_transfer_sz = SCREEN_WIDTH * sizeof(uint16_t)
+        .max_transfer_sz = SCREEN_WIDTH * PARALLEL_LINES * sizeof(uint16_t)
     };
 
     // Initialize the SPI bus
@@ -29,8 +59,11 @@ void setup_display()
         .lcd_param_bits = LCD_PARAM_BITS,
         .spi_mode = 0,
         .trans_queue_depth = 10,
+        .on_color_trans_done = notify_transfer_done,
     };
 
+    transfer_done = xSemaphoreCreateCounting(RENDER_BAND_BUFFERS, 0);
+
     // Attach the LCD to the SPI bus
     ESP_ERROR_CHECK(esp_lcd_new_panel_io_spi((esp_lcd_spi_bus_handle_t)LCD_HOST, &io_config, &io_handle));
 
@@ -62,38 +95,8 @@ void setup_display()
     // Turn on backlight (Different LCD screens may need different levels)
     ESP_ERROR_CHECK(gpio_set_level(PIN_NUM_BK_LIGHT, LCD_BK_LIGHT_ON_LEVEL));
 
-    ESP_LOGI(TAG_DISPLAY, "It worked?");
+    render_backend_t backend = { .flush = panel_flush, .wait = panel_wait, .context = panel_handle };
+    ESP_ERROR_CHECK((renderer_init(renderer, paint, paint_context, &backend) == 0) ? ESP_OK : ESP_ERR_NO_MEM);
 
-    int x_start = 20;
-    int y_start = 30;
-
-    int x_end = 60;
-    int y_end = 80;
-
-    // FORMAT: COLOR_SWAP(RGB_565) -> BGR565.
-    uint16_t a_color = COLOR_SWAP(0x35f7); // Vi bruger macroen color swap, ellers bliver farverne forkerte, da farverne er af typen BGA.
-
-    uint16_t color_map[240];
-
-    for(int i = 0; i < 240; )
-    {
-        color_map[i] = a_color;
-        i++;
-    }
-
-    while(1) 
-    {
-        const int x = 0;
-        const int xend = SCREEN_WIDTH;
-        const int y = 0;
-        const int yend = SCREEN_HEIGHT;
-
-        for (int i = 0; i < yend - y; ++i) {
-            ESP_ERROR_CHECK(esp_lcd_panel_draw_bitmap(panel_handle, x, y + i, xend, y + i + 1, color_map));
-        }
-
-        vTaskDelay(10 / portTICK_PERIOD_MS);
-    }
+    ESP_LOGI(TAG_DISPLAY, "Display ready, %ix%i in bands of %i lines", SCREEN_WIDTH, SCREEN_HEIGHT, PARALLEL_LINES);
 }
-
-
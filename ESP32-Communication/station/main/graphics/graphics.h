@@ -21,12 +21,9 @@
 #include "driver/spi_master.h"
 #include "driver/gpio.h"
 
-#define LCD_HOST 1
+#include "renderer.h"
 
-// To speed up transfers, every SPI transfer sends a bunch of lines. This define specifies how many.
-// More means more memory use, but less overhead for setting up / finishing transfers. Make sure 240
-// is dividable by this.
-#define PARALLEL_LINES 16
+#define LCD_HOST 1
 
 // define pin headers, see pinouts on Lily TTGO t-display
 #define LCD_PIXEL_CLOCK_HZ (20 * 1000 * 1000)
@@ -40,10 +37,6 @@
 #define PIN_NUM_RST 23
 #define PIN_NUM_BK_LIGHT 4
 
-// Screen resolution
-#define SCREEN_WIDTH 240
-#define SCREEN_HEIGHT 320
-
 // bits
 #define LCD_CMD_BITS 8
 #define LCD_PARAM_BITS 8
@@ -51,12 +44,8 @@
 // Header tag
 #define TAG_DISPLAY "LASET_DISP"
 
-// Byte swap macro
-#define COLOR_SWAP(x) ((x >> 8) | (x << 8))
-
-
-void setup_display();
-
-void draw(esp_lcd_panel_handle_t screen_handle);
+// Initializes the panel and a renderer drawing to it with paint. Nothing is drawn until renderer_flush() is
+// called, which only sends the regions marked dirty (all of them after setup).
+void setup_display(renderer_t *renderer, render_paint_t paint, void *paint_context);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,155 @@
+#include "renderer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+
+#define RENDER_BUFFER_ALLOC(size) heap_caps_malloc(size, MALLOC_CAP_DMA)
+#define RENDER_BUFFER_FREE(buffer) heap_caps_free(buffer)
+#else
+#define RENDER_BUFFER_ALLOC(size) malloc(size)
+#define RENDER_BUFFER_FREE(buffer) free(buffer)
+#endif
+
+#define ALL_TILES ((uint16_t)((1u << RENDER_TILE_COLUMNS) - 1))
+
+int renderer_init(renderer_t *renderer, render_paint_t paint, void *paint_context, const render_backend_t *backend) {
+    memset(renderer, 0, sizeof(renderer_t));
+    renderer->paint = paint;
+    renderer->paint_context = paint_context;
+    renderer->backend = *backend;
+
+    for (int i = 0; i < RENDER_BAND_BUFFERS; i++) {
+        renderer->band_buffers[i] = RENDER_BUFFER_ALLOC(SCREEN_WIDTH * PARALLEL_LINES * sizeof(uint16_t));
+        if (renderer->band_buffers[i] == NULL) {
+            renderer_free(renderer);
+            return -1;
+        }
+    }
+
+    renderer_invalidate_all(renderer);
+    return 0;
+}
+
+void renderer_free(renderer_t *renderer) {
+    if (renderer->backend.wait != NULL) {
+        renderer->backend.wait(renderer->backend.context, 0);
+    }
+    for (int i = 0; i < RENDER_BAND_BUFFERS; i++) {
+        if (renderer->band_buffers[i] != NULL) {
+            RENDER_BUFFER_FREE(renderer->band_buffers[i]);
+            renderer->band_buffers[i] = NULL;
+        }
+    }
+}
+
+void renderer_invalidate(renderer_t *renderer, int x, int y, int width, int height) {
+    int x_end = x + width;
+    int y_end = y + height;
+    if (x < 0) x = 0;
+    if (y < 0) y = 0;
+    if (x_end > SCREEN_WIDTH) x_end = SCREEN_WIDTH;
+    if (y_end > SCREEN_HEIGHT) y_end = SCREEN_HEIGHT;
+    if (x >= x_end || y >= y_end) {
+        return;
+    }
+
+    int first_column = x / RENDER_TILE_SIZE;
+    int last_column = (x_end - 1) / RENDER_TILE_SIZE;
+    uint16_t columns = (uint16_t)(((1u << (last_column + 1)) - 1) & ~((1u << first_column) - 1));
+    for (int row = y / RENDER_TILE_SIZE; row <= (y_end - 1) / RENDER_TILE_SIZE; row++) {
+        renderer->dirty[row] |= columns;
+    }
+}
+
+void renderer_invalidate_all(renderer_t *renderer) {
+    for (int row = 0; row < RENDER_TILE_ROWS; row++) {
+        renderer->dirty[row] = ALL_TILES;
+    }
+}
+
+bool renderer_is_dirty(const renderer_t *renderer) {
+    for (int row = 0; row < RENDER_TILE_ROWS; row++) {
+        if (renderer->dirty[row] != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Paints one run of tiles in a band into the next band buffer and sends it
+static int flush_run(renderer_t *renderer, int row, int first_column, int last_column) {
+    int x = first_column * RENDER_TILE_SIZE;
+    int y = row * RENDER_TILE_SIZE;
+    int width = (last_column - first_column + 1) * RENDER_TILE_SIZE;
+    int height = RENDER_TILE_SIZE;
+
+    // The buffer painted now was sent two runs ago, that transfer has to be done first
+    if (renderer->backend.wait != NULL) {
+        renderer->backend.wait(renderer->backend.context, RENDER_BAND_BUFFERS - 1);
+    }
+    uint16_t *pixels = renderer->band_buffers[renderer->next_buffer];
+    renderer->next_buffer = (renderer->next_buffer + 1) % RENDER_BAND_BUFFERS;
+
+    renderer->paint(renderer->paint_context, x, y, width, height, pixels);
+    if (renderer->backend.flush(renderer->backend.context, x, y, width, height, pixels) != 0) {
+        return -1;
+    }
+    renderer->stats.transfers++;
+    renderer->stats.pixels += width * height;
+    return 0;
+}
+
+int renderer_flush(renderer_t *renderer) {
+    int transfers = 0;
+
+    for (int row = 0; row < RENDER_TILE_ROWS; row++) {
+        uint16_t dirty = renderer->dirty[row];
+        int column = 0;
+
+        while (dirty >> column) {
+            // Start of a run
+            while (!(dirty & (1u << column))) {
+                column++;
+            }
+            int first_column = column;
+            int last_column = column;
+
+            // Extend it over dirty tiles, and over clean gaps up to RENDER_MERGE_GAP wide
+            for (column++; column < RENDER_TILE_COLUMNS; column++) {
+                if (dirty & (1u << column)) {
+                    last_column = column;
+                } else if (column - last_column > RENDER_MERGE_GAP) {
+                    break;
+                }
+            }
+            column = last_column + 1;
+
+            if (flush_run(renderer, row, first_column, last_column) != 0) {
+                return -1;
+            }
+            renderer->dirty[row] &= (uint16_t)~(((1u << (last_column + 1)) - 1) & ~((1u << first_column) - 1));
+            transfers++;
+        }
+    }
+
+    if (transfers > 0) {
+        renderer->stats.frames++;
+    }
+    return transfers;
+}
+
+static int memory_flush(void *context, int x, int y, int width, int height, const uint16_t *pixels) {
+    render_memory_t *memory = (render_memory_t *)context;
+    for (int row = 0; row < height; row++) {
+        memcpy(&memory->pixels[(y + row) * SCREEN_WIDTH + x], &pixels[row * width], width * sizeof(uint16_t));
+    }
+    return 0;
+}
+
+render_backend_t render_memory_backend(render_memory_t *memory) {
+    render_backend_t backend = { .flush = memory_flush, .wait = NULL, .context = memory };
+    return backend;
+}
@@ -0,0 +1,89 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+/* Dirty region renderer. The screen is split into RENDER_TILE_SIZE tiles, and whatever changed marks its tiles
+ * dirty. A flush repaints only the dirty tiles: each band of PARALLEL_LINES rows is merged into horizontal runs,
+ * every run is painted into one of two band buffers and handed to the backend, which sends it to the panel
+ * while the next run is painted. Nothing is sent when nothing changed.
+ * The renderer keeps no framebuffer, the paint callback draws the requested rectangle from the current state. */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TAG_RENDERER "LASET_REND"
+
+// Screen resolution
+#define SCREEN_WIDTH 240
+#define SCREEN_HEIGHT 320
+
+// To speed up transfers, every SPI transfer sends a bunch of lines. This define specifies how many.
+// More means more memory use, but less overhead for setting up / finishing transfers. Make sure 320
+// is dividable by this.
+#define PARALLEL_LINES 16
+
+// Tiles are as high as a band, so a dirty tile row is flushed as one band
+#define RENDER_TILE_SIZE PARALLEL_LINES
+#define RENDER_TILE_COLUMNS (SCREEN_WIDTH / RENDER_TILE_SIZE)
+#define RENDER_TILE_ROWS (SCREEN_HEIGHT / RENDER_TILE_SIZE)
+
+// Dirty runs in a band closer than this many tiles are sent as one, a clean tile costs less than a transfer setup
+#define RENDER_MERGE_GAP 1
+
+#define RENDER_BAND_BUFFERS 2
+
+// Byte swap macro, the panel expects the RGB565 bytes swapped
+#define COLOR_SWAP(x) ((uint16_t)(((x) >> 8) | ((x) << 8)))
+
+// Draws the rectangle (x, y, width, height) of the screen into pixels, row by row with width pixels per row.
+typedef void (*render_paint_t)(void *context, int x, int y, int width, int height, uint16_t *pixels);
+
+typedef struct {
+    // Sends a rectangle to the screen. The backend may keep reading pixels after it returns, until wait allows it.
+    int (*flush)(void *context, int x, int y, int width, int height, const uint16_t *pixels);
+    // Returns once at most pending flushes are still reading their pixels. Can be NULL for a synchronous backend.
+    void (*wait)(void *context, int pending);
+    void *context;
+} render_backend_t;
+
+typedef struct {
+    uint32_t frames;        // Flushes that sent anything
+    uint32_t transfers;     // Rectangles sent to the backend
+    uint32_t pixels;        // Pixels sent to the backend
+} render_stats_t;
+
+typedef struct {
+    uint16_t dirty[RENDER_TILE_ROWS];   // One bit per tile column
+    render_paint_t paint;
+    void *paint_context;
+    render_backend_t backend;
+    uint16_t *band_buffers[RENDER_BAND_BUFFERS];
+    int next_buffer;
+    render_stats_t stats;
+} renderer_t;
+
+// Allocates the band buffers (DMA capable on the station) and marks the whole screen dirty. Returns 0, or -1 if
+// the buffers could not be allocated.
+int renderer_init(renderer_t *renderer, render_paint_t paint, void *paint_context, const render_backend_t *backend);
+
+void renderer_free(renderer_t *renderer);
+
+// Marks the tiles covering a rectangle dirty. Parts outside the screen are ignored.
+void renderer_invalidate(renderer_t *renderer, int x, int y, int width, int height);
+
+void renderer_invalidate_all(renderer_t *renderer);
+
+bool renderer_is_dirty(const renderer_t *renderer);
+
+// Paints and sends every dirty region, then marks the screen clean. Returns the amount of rectangles sent,
+// or -1 if the backend failed (the remaining regions stay dirty).
+int renderer_flush(renderer_t *renderer);
+
+/* Backend that draws into a framebuffer in memory, for host builds and tests. */
+
+typedef struct {
+    uint16_t pixels[SCREEN_WIDTH * SCREEN_HEIGHT];
+} render_memory_t;
+
+render_backend_t render_memory_backend(render_memory_t *memory);
+
+#endif
@@ -0,0 +1,121 @@
+#include "estimate_cache.h"
+
+#include <string.h>
+
+// FNV-1a over the key bytes
+static uint32_t hash_key(const estimate_cache_key_t *key) {
+    const uint8_t *bytes = (const uint8_t *)key;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(estimate_cache_key_t); i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Takes an entry out of the LRU list
+static void unlink_entry(estimate_cache_t *cache, short index) {
+    estimate_cache_entry_t *entry = &cache->entries[index];
+
+    if (entry->newer != ESTIMATE_CACHE_NONE) cache->entries[entry->newer].older = entry->older;
+    else cache->newest = entry->older;
+
+    if (entry->older != ESTIMATE_CACHE_NONE) cache->entries[entry->older].newer = entry->newer;
+    else cache->oldest = entry->newer;
+}
+
+// Puts an entry at the front of the LRU list
+static void push_newest(estimate_cache_t *cache, short index) {
+    estimate_cache_entry_t *entry = &cache->entries[index];
+
+    entry->newer = ESTIMATE_CACHE_NONE;
+    entry->older = cache->newest;
+    if (cache->newest != ESTIMATE_CACHE_NONE) cache->entries[cache->newest].newer = index;
+    cache->newest = index;
+    if (cache->oldest == ESTIMATE_CACHE_NONE) cache->oldest = index;
+}
+
+// Takes an entry out of its hash bucket
+static void remove_from_bucket(estimate_cache_t *cache, short index) {
+    short *link = &cache->buckets[cache->entries[index].hash & (ESTIMATE_CACHE_BUCKETS - 1)];
+    while (*link != ESTIMATE_CACHE_NONE) {
+        if (*link == index) {
+            *link = cache->entries[index].bucket_next;
+            return;
+        }
+        link = &cache->entries[*link].bucket_next;
+    }
+}
+
+void estimate_cache_init(estimate_cache_t *cache) {
+    memset(cache, 0, sizeof(estimate_cache_t));
+    for (int i = 0; i < ESTIMATE_CACHE_BUCKETS; i++) {
+        cache->buckets[i] = ESTIMATE_CACHE_NONE;
+    }
+    cache->newest = ESTIMATE_CACHE_NONE;
+    cache->oldest = ESTIMATE_CACHE_NONE;
+}
+
+void estimate_cache_make_key(estimate_cache_key_t *key, const fixed_t load[GRID_MAX_NODES], int buyer_node_id, int seller_node_id, fixed_t offer) {
+    // Zero everything (also the padding), since keys are hashed and compared bytewise
+    memset(key, 0, sizeof(estimate_cache_key_t));
+    for (int node = 0; node < GRID_MAX_NODES; node++) {
+        key->load[node] = fixed_steps(load[node], ESTIMATE_CACHE_QUANTUM);
+    }
+    key->offer = fixed_steps(offer, ESTIMATE_CACHE_QUANTUM);
+    key->buyer_node_id = buyer_node_id;
+    key->seller_node_id = seller_node_id;
+}
+
+bool estimate_cache_lookup(estimate_cache_t *cache, const estimate_cache_key_t *key, fixed_t *estimate) {
+    uint32_t hash = hash_key(key);
+
+    for (short index = cache->buckets[hash & (ESTIMATE_CACHE_BUCKETS - 1)]; index != ESTIMATE_CACHE_NONE; index = cache->entries[index].bucket_next) {
+        estimate_cache_entry_t *entry = &cache->entries[index];
+        if (entry->hash == hash && memcmp(&entry->key, key, sizeof(estimate_cache_key_t)) == 0) {
+            // Mark as most recently used
+            unlink_entry(cache, index);
+            push_newest(cache, index);
+
+            *estimate = entry->estimate;
+            cache->metrics.hits++;
+            return true;
+        }
+    }
+
+    cache->metrics.misses++;
+    return false;
+}
+
+void estimate_cache_insert(estimate_cache_t *cache, const estimate_cache_key_t *key, fixed_t estimate) {
+    uint32_t hash = hash_key(key);
+    short index;
+
+    // Update the estimate if the key is already cached
+    for (index = cache->buckets[hash & (ESTIMATE_CACHE_BUCKETS - 1)]; index != ESTIMATE_CACHE_NONE; index = cache->entries[index].bucket_next) {
+        if (cache->entries[index].hash == hash && memcmp(&cache->entries[index].key, key, sizeof(estimate_cache_key_t)) == 0) {
+            cache->entries[index].estimate = estimate;
+            unlink_entry(cache, index);
+            push_newest(cache, index);
+            return;
+        }
+    }
+
+    if (cache->entry_amount < ESTIMATE_CACHE_CAPACITY) {
+        index = cache->entry_amount++;
+    } else {
+        // Reuse the least recently used entry
+        index = cache->oldest;
+        unlink_entry(cache, index);
+        remove_from_bucket(cache, index);
+        cache->metrics.evictions++;
+    }
+
+    estimate_cache_entry_t *entry = &cache->entries[index];
+    entry->key = *key;
+    entry->estimate = estimate;
+    entry->hash = hash;
+    entry->bucket_next = cache->buckets[hash & (ESTIMATE_CACHE_BUCKETS - 1)];
+    cache->buckets[hash & (ESTIMATE_CACHE_BUCKETS - 1)] = index;
+    push_newest(cache, index);
+}
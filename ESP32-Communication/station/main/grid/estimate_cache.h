@@ -0,0 +1,68 @@
+#ifndef ESTIMATE_CACHE_H
+#define ESTIMATE_CACHE_H
+
+/* LRU cache of grid estimates, keyed by the quantized grid load plus buyer, seller and offer.
+ * Phases of the same trade (and other stations validating it) ask for nearly identical load states, so most
+ * requests can be answered without running the load flow or asking the simulator again.
+ * Only depends on the C standard library. Not thread safe, the caller must serialize access. */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "loadflow.h"
+
+// Amount of estimates kept before the least recently used one is evicted
+#define ESTIMATE_CACHE_CAPACITY 32
+
+// Amount of hash buckets (power of two)
+#define ESTIMATE_CACHE_BUCKETS 64
+
+// Loads and offers closer than this share a cache entry (0.1 A)
+#define ESTIMATE_CACHE_QUANTUM (FIXED_ONE / 10)
+
+#define ESTIMATE_CACHE_NONE -1
+
+typedef struct {
+    int32_t load[GRID_MAX_NODES];   // Load per node in ESTIMATE_CACHE_QUANTUM steps
+    int32_t offer;
+    short buyer_node_id;
+    short seller_node_id;
+} estimate_cache_key_t;
+
+typedef struct {
+    estimate_cache_key_t key;
+    fixed_t estimate;
+    uint32_t hash;
+    short bucket_next;      // Next entry in the same bucket
+    short newer;            // LRU list neighbours
+    short older;
+} estimate_cache_entry_t;
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+} estimate_cache_metrics_t;
+
+typedef struct {
+    estimate_cache_entry_t entries[ESTIMATE_CACHE_CAPACITY];
+    short buckets[ESTIMATE_CACHE_BUCKETS];
+    short newest;
+    short oldest;
+    int entry_amount;
+    estimate_cache_metrics_t metrics;
+} estimate_cache_t;
+
+// Empties the cache and resets its metrics.
+void estimate_cache_init(estimate_cache_t *cache);
+
+// Quantizes a load calculation request into a cache key.
+void estimate_cache_make_key(estimate_cache_key_t *key, const fixed_t load[GRID_MAX_NODES], int buyer_node_id, int seller_node_id, fixed_t offer);
+
+// Returns true and sets estimate if the key is cached. Counts a hit or a miss.
+bool estimate_cache_lookup(estimate_cache_t *cache, const estimate_cache_key_t *key, fixed_t *estimate);
+
+// Stores an estimate, evicting the least recently used one if the cache is full.
+void estimate_cache_insert(estimate_cache_t *cache, const estimate_cache_key_t *key, fixed_t estimate);
+
+#endif
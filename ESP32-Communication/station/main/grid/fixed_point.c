@@ -0,0 +1,163 @@
+#include "fixed_point.h"
+
+#include <stdio.h>
+#include <stdbool.h>
+
+// Mantissas stop taking digits here, so they always fit in 18 digits
+#define MANTISSA_LIMIT 100000000000000000ULL
+
+static const int64_t powers_of_ten[] = {
+    1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL, 100000000LL, 1000000000LL,
+    10000000000LL, 100000000000LL, 1000000000000LL, 10000000000000LL, 100000000000000LL,
+    1000000000000000LL, 10000000000000000LL, 100000000000000000LL, 1000000000000000000LL,
+};
+
+static fixed_t saturate(int64_t value) {
+    if (value > FIXED_MAX) return FIXED_MAX;
+    if (value < FIXED_MIN) return FIXED_MIN;
+    return (fixed_t)value;
+}
+
+// Division rounded half away from zero. divisor must be positive
+static int64_t divide_rounded(int64_t value, int64_t divisor) {
+    int64_t quotient = value / divisor;
+    int64_t remainder = value % divisor;
+    if (remainder < 0) remainder = -remainder;
+    if (2 * remainder >= divisor) {
+        quotient += (value < 0) ? -1 : 1;
+    }
+    return quotient;
+}
+
+int fixed_parse(const char *text, fixed_t *value) {
+    const char *c = text;
+    bool negative = (*c == '-');
+    if (*c == '-' || *c == '+') c++;
+
+    // The number is mantissa * 10^exponent
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    int digits = 0;
+    bool point = false;
+    for (;; c++) {
+        if (*c == '.' && !point) {
+            point = true;
+            continue;
+        }
+        if (*c < '0' || *c > '9') break;
+        digits++;
+        if (mantissa < MANTISSA_LIMIT) {
+            mantissa = mantissa * 10 + (*c - '0');
+            if (point) exponent--;
+        } else if (!point) {
+            exponent++;     // Integer digits past the mantissa only scale it
+        }
+    }
+    if (digits == 0) {
+        return -1;
+    }
+
+    if (*c == 'e' || *c == 'E') {
+        c++;
+        bool negative_exponent = (*c == '-');
+        if (*c == '-' || *c == '+') c++;
+        int exponent_digits = 0;
+        int written_exponent = 0;
+        for (; *c >= '0' && *c <= '9'; c++) {
+            if (written_exponent < 1000) {
+                written_exponent = written_exponent * 10 + (*c - '0');
+            }
+            exponent_digits++;
+        }
+        if (exponent_digits == 0) {
+            return -1;
+        }
+        exponent += negative_exponent ? -written_exponent : written_exponent;
+    }
+    if (*c != '\0' && *c != ',' && *c != ';') {
+        return -1;
+    }
+
+    int64_t result = 0;
+    int scale = exponent + FIXED_DECIMALS;
+    if (mantissa == 0) {
+        result = 0;
+    } else if (scale >= 0) {
+        // Any mantissa times 10^10 is past the range
+        if (scale > 9 || mantissa > (uint64_t)(FIXED_MAX / powers_of_ten[scale])) {
+            return -1;
+        }
+        result = (int64_t)mantissa * powers_of_ten[scale];
+    } else if (-scale <= 18) {
+        result = divide_rounded((int64_t)mantissa, powers_of_ten[-scale]);
+    }
+    // Smaller than 10^-22 rounds to 0
+
+    if (result > FIXED_MAX) {
+        return -1;
+    }
+    *value = negative ? (fixed_t)-result : (fixed_t)result;
+    return 0;
+}
+
+int fixed_format(fixed_t value, int decimals, char *text, size_t size) {
+    if (decimals < 0 || decimals > FIXED_DECIMALS) {
+        return -1;
+    }
+
+    int64_t rounded = divide_rounded(value, powers_of_ten[FIXED_DECIMALS - decimals]);
+    const char *sign = (rounded < 0) ? "-" : "";
+    int64_t magnitude = (rounded < 0) ? -rounded : rounded;
+    int64_t unit = powers_of_ten[decimals];
+
+    // The integer part has at most 6 digits, so long is enough (and needs no 64 bit printf on the device)
+    int length;
+    if (decimals == 0) {
+        length = snprintf(text, size, "%s%ld", sign, (long)magnitude);
+    } else {
+        length = snprintf(text, size, "%s%ld.%0*ld", sign, (long)(magnitude / unit), decimals, (long)(magnitude % unit));
+    }
+    if (length < 0 || (size_t)length >= size) {
+        return -1;
+    }
+    return length;
+}
+
+int32_t fixed_steps(fixed_t value, fixed_t step) {
+    if (step <= 0) {
+        return 0;
+    }
+    return (int32_t)divide_rounded(value, step);
+}
+
+fixed_t fixed_abs(fixed_t value) {
+    return (value < 0) ? saturate(-(int64_t)value) : value;
+}
+
+fixed_t fixed_add(fixed_t a, fixed_t b) {
+    return saturate((int64_t)a + b);
+}
+
+fixed_t fixed_mul(fixed_t a, fixed_t b) {
+    return saturate(divide_rounded((int64_t)a * b, FIXED_ONE));
+}
+
+fixed_t fixed_sum(const fixed_t *values, int amount) {
+    int64_t sum = 0;
+    for (int i = 0; i < amount; i++) {
+        sum += values[i];
+    }
+    return saturate(sum);
+}
+
+double fixed_to_double(fixed_t value) {
+    return (double)value / FIXED_ONE;
+}
+
+fixed_t fixed_from_double(double value) {
+    double scaled = value * FIXED_ONE;
+    // Written so that not a number fails every comparison and ends up at FIXED_MAX
+    if (!(scaled < FIXED_MAX)) return FIXED_MAX;
+    if (!(scaled > FIXED_MIN)) return FIXED_MIN;
+    return (fixed_t)(scaled + ((scaled < 0) ? -0.5 : 0.5));
+}
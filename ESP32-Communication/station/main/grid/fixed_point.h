@@ -0,0 +1,53 @@
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+/* Fixed point numbers for amperage, grid load and grid estimates. The ESP32 has no double precision FPU, so the
+ * load bookkeeping is done on integers: a fixed_t holds a value in ten thousandths, which is the precision
+ * validator.py rounds its estimates to. The range is +-214748.3647, and arithmetic saturates at it instead of
+ * wrapping. Only fixed_to_double and fixed_from_double use floating point, for the load flow solver. */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TAG_FIXED_POINT "LASET_FIXP"
+
+typedef int32_t fixed_t;
+
+#define FIXED_DECIMALS 4
+#define FIXED_ONE 10000
+
+// Symmetric, so negating a value never overflows
+#define FIXED_MAX INT32_MAX
+#define FIXED_MIN (-INT32_MAX)
+
+#define FIXED_FROM_INT(value) ((fixed_t)(value) * FIXED_ONE)
+
+// Longest text fixed_format writes: sign, 6 integer digits, point, 4 decimals and the terminating 0
+#define FIXED_TEXT_SIZE 13
+
+// Parses a decimal number ("-5", "12.25", "1e-05") ending at a 0, ',' or ';'. Digits after the 4th decimal are
+// rounded half away from zero. Returns 0, or -1 if the text is not a number or outside the range.
+int fixed_parse(const char *text, fixed_t *value);
+
+// Writes the value with 0 to FIXED_DECIMALS decimals, rounded half away from zero. Returns the amount of
+// characters written (without the 0), or -1 if they do not fit in size.
+int fixed_format(fixed_t value, int decimals, char *text, size_t size);
+
+// Value divided by step, rounded half away from zero. Used to round to whole amperes or to cache steps.
+int32_t fixed_steps(fixed_t value, fixed_t step);
+
+fixed_t fixed_abs(fixed_t value);
+
+// Saturating sum and product. The product is rounded half away from zero.
+fixed_t fixed_add(fixed_t a, fixed_t b);
+fixed_t fixed_mul(fixed_t a, fixed_t b);
+
+// Sum of the values of amount nodes, saturating once at the end so the order does not matter.
+fixed_t fixed_sum(const fixed_t *values, int amount);
+
+// Conversions for the load flow solver. fixed_from_double rounds half away from zero and saturates
+// (not a number becomes FIXED_MAX).
+double fixed_to_double(fixed_t value);
+fixed_t fixed_from_double(double value);
+
+#endif
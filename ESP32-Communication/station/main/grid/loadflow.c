@@ -0,0 +1,114 @@
+#include "loadflow.h"
+
+#include <math.h>
+#include <string.h>
+
+void loadflow_default_system(grid_system_t *system) {
+    // USING RASMUS's expanded grid, same as GridSimulator.system
+    static const grid_line_t default_lines[] = {
+        {1, 2, .01},
+        {2, 3, .5},
+        {2, 4, .3},
+        {4, 5, .2},
+        {4, 6, .1},
+    };
+
+    memset(system, 0, sizeof(grid_system_t));
+    system->base_voltage = GRID_BASE_VOLTAGE;
+    system->line_amount = sizeof(default_lines) / sizeof(default_lines[0]);
+    memcpy(system->lines, default_lines, sizeof(default_lines));
+}
+
+int loadflow_solve(const grid_system_t *system, const double load[GRID_MAX_NODES], loadflow_result_t *result) {
+    // Parent and cable resistance of every node, found from the line list
+    short parent[GRID_MAX_NODES];
+    double resistance[GRID_MAX_NODES];
+    // Nodes in breadth first order from the root, so parents always come before their children
+    short order[GRID_MAX_NODES];
+    int node_amount = 0;
+
+    memset(result, 0, sizeof(loadflow_result_t));
+    memset(parent, 0, sizeof(parent));
+    memset(resistance, 0, sizeof(resistance));
+
+    order[node_amount++] = GRID_ROOT_NODE;
+    for (int visited = 0; visited < node_amount; visited++) {
+        for (int i = 0; i < system->line_amount; i++) {
+            const grid_line_t *line = &system->lines[i];
+            if (line->from_node != order[visited]) {
+                continue;
+            }
+            if (line->to_node <= 0 || line->to_node >= GRID_MAX_NODES || line->to_node == GRID_ROOT_NODE || parent[line->to_node] != 0) {
+                return -1;  // Out of range or a loop, so the grid is not radial
+            }
+            parent[line->to_node] = line->from_node;
+            resistance[line->to_node] = line->resistance;
+            order[node_amount++] = line->to_node;
+        }
+    }
+
+    // Loads are given as amperage at base voltage and modelled as constant power
+    double power[GRID_MAX_NODES];
+    for (int node = 0; node < GRID_MAX_NODES; node++) {
+        power[node] = load[node] * system->base_voltage;
+        result->voltage[node] = system->base_voltage;
+    }
+
+    for (result->iterations = 1; result->iterations <= LOADFLOW_MAX_ITERATIONS; result->iterations++) {
+        // Backward sweep: sum the currents from the leaves towards the transformer
+        memset(result->line_current, 0, sizeof(result->line_current));
+        for (int i = node_amount - 1; i > 0; i--) {
+            short node = order[i];
+            result->line_current[node] += power[node] / result->voltage[node];
+            result->line_current[parent[node]] += result->line_current[node];
+        }
+
+        // Forward sweep: update the voltages from the transformer towards the leaves
+        double largest_change = 0;
+        for (int i = 1; i < node_amount; i++) {
+            short node = order[i];
+            double voltage = result->voltage[parent[node]] - result->line_current[node] * resistance[node];
+            if (fabs(voltage - result->voltage[node]) > largest_change) {
+                largest_change = fabs(voltage - result->voltage[node]);
+            }
+            result->voltage[node] = voltage;
+        }
+
+        if (largest_change < LOADFLOW_CONVERGENCE_V) {
+            result->converged = true;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+fixed_t loadflow_grid_estimate(const grid_system_t *system, const fixed_t load[GRID_MAX_NODES], int buyer_node_id, int seller_node_id, fixed_t offer) {
+    if (buyer_node_id <= 0 || buyer_node_id >= GRID_MAX_NODES || seller_node_id <= 0 || seller_node_id >= GRID_MAX_NODES) {
+        return FIXED_MAX;
+    }
+
+    // The buyer draws the seller's surplus on top of its own load
+    double trade_load[GRID_MAX_NODES];
+    for (int node = 0; node < GRID_MAX_NODES; node++) {
+        trade_load[node] = fixed_to_double(load[node]);
+    }
+    trade_load[buyer_node_id] += fixed_to_double(fixed_abs(offer));
+
+    loadflow_result_t result;
+    if (loadflow_solve(system, trade_load, &result) != 0) {
+        return FIXED_MAX;
+    }
+
+    double allowed_deviation = system->base_voltage * GRID_VOLTAGE_TOLERANCE;
+    double worst_violation = 0;
+    for (int node = 0; node < GRID_MAX_NODES; node++) {
+        double violation = fabs(result.voltage[node] - system->base_voltage) - allowed_deviation;
+        if (violation > worst_violation) {
+            worst_violation = violation;
+        }
+    }
+
+    // Rounds to 4 decimals, same as validator.py
+    return fixed_from_double(worst_violation);
+}
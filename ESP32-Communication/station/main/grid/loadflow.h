@@ -0,0 +1,60 @@
+#ifndef LOADFLOW_H
+#define LOADFLOW_H
+
+/* Radial load flow (backward/forward sweep) used to validate trade phases locally.
+ * This module only depends on the C standard library, so it builds both for the station and on Linux. */
+
+#include <stdbool.h>
+
+#include "fixed_point.h"
+
+// Node ids go from 1 (the transformer) and up. Same size as grid_load in main.c.
+#define GRID_MAX_NODES 10
+
+// The node the transformer is connected to. Its voltage is fixed to the base voltage.
+#define GRID_ROOT_NODE 1
+
+// Base voltage at the transformer
+#define GRID_BASE_VOLTAGE 230.0
+
+// Allowed deviation from the base voltage before a node is overloaded (+-10%, EN 50160)
+#define GRID_VOLTAGE_TOLERANCE 0.10
+
+// A heavily loaded grid converges slowly, 20 iterations gave up on cases that have a solution
+#define LOADFLOW_MAX_ITERATIONS 100
+#define LOADFLOW_CONVERGENCE_V 1e-6
+
+// A cable between two nodes, same layout as `system` in simulator.py: [source node ID, destination node ID, resistance]
+typedef struct {
+    short from_node;
+    short to_node;
+    double resistance;
+} grid_line_t;
+
+typedef struct {
+    double base_voltage;
+    int line_amount;
+    grid_line_t lines[GRID_MAX_NODES];
+} grid_system_t;
+
+typedef struct {
+    double voltage[GRID_MAX_NODES];         // Voltage at each node
+    double line_current[GRID_MAX_NODES];    // Current in the cable feeding each node
+    int iterations;
+    bool converged;
+} loadflow_result_t;
+
+// Loads the neighbourhood grid used by the simulator (simulator.py)
+void loadflow_default_system(grid_system_t *system);
+
+// Solves the load flow. load[node] is the amperage drawn at base voltage (negative when producing).
+// Returns 0 if the sweep converged, -1 if the topology is not radial or it did not converge.
+int loadflow_solve(const grid_system_t *system, const double load[GRID_MAX_NODES], loadflow_result_t *result);
+
+// Local replacement for the simulator's "rlc" request. The buyer draws the offered amperage on top of the
+// current load, and the result is how many volts the worst node is outside the allowed band (0 if none).
+// Takes and returns fixed point, so the result has the 4 decimals of validator.py. A result <= 0 means the phase
+// can be acknowledged, FIXED_MAX that the ids are invalid or the load flow failed.
+fixed_t loadflow_grid_estimate(const grid_system_t *system, const fixed_t load[GRID_MAX_NODES], int buyer_node_id, int seller_node_id, fixed_t offer);
+
+#endif
@@ -2,6 +2,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include <freertos/semphr.h>
+#include "freertos/queue.h"
 #include "freertos/event_groups.h"
 #include "esp_system.h"
 #include "esp_wifi.h"
@@ -11,6 +12,7 @@
 #include "lwip/sys.h"
 #include "esp_log.h"
 #include "esp_timer.h"
+#include "esp_heap_caps.h"
 
 #include <sys/select.h>
 #include <sys/time.h>
@@ -24,11 +26,31 @@
 #include "models/models.h"
 #include "networking/lasetsockets.h"
 #include "cryptography/crypto.h"
+#include "cryptography/key_fingerprint.h"
 #include "networking/communication.h"
+#include "networking/packet_pool.h"
+#include "networking/ingress.h"
+#include "networking/dedup.h"
+#include "networking/hex.h"
 #include "blockchain/chain.h"
+#include "blockchain/validation.h"
+#include "blockchain/ledger.h"
+#include "blockchain/block_tree.h"
+#include "blockchain/chain_tip.h"
+#include "blockchain/quorum.h"
+#include "blockchain/chain_digest.h"
+#include "market/auction.h"
+#include "grid/loadflow.h"
+#include "grid/estimate_cache.h"
+#include "diagnostics/trace.h"
+#include "diagnostics/metrics.h"
+#include "diagnostics/binlog.h"
+#include "diagnostics/profiler.h"
+#include "scheduling/task_plan.h"
 
 // display wip
 #include "graphics/graphics.h"
+#include "graphics/dashboard.h"
 
 // PSA CRYPTOGRAPHY API Attributes
 static node_key_credentials_t key_pair;
@@ -41,46 +63,607 @@ static node_public_key_t npk;
 #define SERVER_IP "192.168.0.100"
 #define SERVER_PORT 6666
 
+// 1 = trade in periodic call auctions (bid/ask), 0 = continuous first-come trading (bcd/atd)
+#define AUCTION_MODE 0
+
+// 1 = estimate the grid load locally with the native load flow, 0 = request it from the simulator (rlc)
+#define LOCAL_GRID_ESTIMATE 1
+
+// 1 = subscribe to amperage updates pushed by the simulator (sub), 0 = poll the simulator every 2 seconds (rql)
+#define AMPERAGE_SUBSCRIBE_MODE 1
+// Wait before connecting to the simulator again after it closed the connection, doubled after every failed attempt
+#define SIMULATOR_RECONNECT_MIN_MS 500
+#define SIMULATOR_RECONNECT_MAX_MS 16000
+// In subscribe mode, the amperage is only broadcasted when it changed by at least this much...
+#define AMPERAGE_BROADCAST_DELTA 1
+// ...or when this long has passed since the last broadcast (ms)
+#define AMPERAGE_HEARTBEAT_MS 10000
+
+// 1 = draw the market dashboard on the display, 0 = leave the display off
+#define DASHBOARD_ENABLED 1
+// How often the dashboard checks the snapshot for changes (ms)
+#define DASHBOARD_POLL_MS 100
+
+// 1 = store the ledger in NVS whenever blocks become final and continue from it after a restart, 0 = start from an empty chain
+#define LEDGER_PERSIST_SNAPSHOTS 1
+#define LEDGER_NVS_NAMESPACE "laset"
+#define LEDGER_NVS_KEY "snapshot"
+
+// Committed blocks sent for one chain sync request (rcs), oldest first. The requester asks again for the rest
+#define CHAIN_SYNC_BLOCKS 8
+// Replies to a chain sync (cbk and psn) do not fit a packet of the pool, they go to their own port and are read
+// into one large buffer
+#define CHAIN_SYNC_PORT 7779
+#define CHAIN_SYNC_FRAME_SIZE 1536
+// Members that must send the same snapshot before a station that is behind continues from it
+#define CHAIN_SNAPSHOT_AGREEMENT 2
+
+// Event bits for simulator_event_group
+#define AMPERAGE_CHANGED_BIT BIT0
+#define SIMULATOR_REPLY_BIT  BIT1
+
 static short node_id = -1;                  // Is set by requesting the server, default -1.
-static short node_amperage_reading = -1;    // Is set by requesting the server, default -1.
-static float estimated_grid_calculation = -1.0;
-static double grid_load[10] = {0.0001}; // Stores the amperage reading from each node in a list
-static double offer = -0.0001;
+static fixed_t node_amperage_reading = FIXED_FROM_INT(-1);  // Is set by requesting the server, default -1.
+static fixed_t estimated_grid_calculation = FIXED_FROM_INT(-1);
+static fixed_t grid_load[GRID_MAX_NODES] = {0};  // Stores the amperage reading from each node in a list
+static grid_system_t grid_system;       // Topology of the neighbourhood, used for the local grid estimate
+static estimate_cache_t estimate_cache; // Grid estimates already calculated (only used by blockchain_listener_task)
 static bool trade_deal_is_open = true;
 static char public_key[PUBLIC_KEY_SIZE];
 
 // Array containing public keys from other nodes.
 static char foreign_public_key_array[PK_KEY_ARRAY_SIZE][PUBLIC_KEY_SIZE];
 
-// Array containing how many acknowledgements for each phase of a block trade there are
-static short phase_acceptance_array[60/5];
+// Fingerprints of the keys in foreign_public_key_array, and the latest fingerprint each node announced in bca.
+// A key is requested (rpk) when the announced fingerprint does not match the stored one.
+static uint8_t foreign_key_fingerprint_array[PK_KEY_ARRAY_SIZE][KEY_FINGERPRINT_SIZE];
+static uint8_t announced_key_fingerprint_array[PK_KEY_ARRAY_SIZE][KEY_FINGERPRINT_SIZE];
+
+// Fingerprint of this node's own public key
+static uint8_t own_key_fingerprint[KEY_FINGERPRINT_SIZE];
+
+// Blocks whose phases are being validated, with the votes received for each. Votes are routed to a block by its
+// hash, so blocks that are validated at the same time do not count each other's votes
+#define VALIDATION_SLOTS 4
+
+typedef struct {
+    struct block_t *block;              // NULL for a free slot
+    int64_t deadline_us;                // Committed once its duration plus 2 seconds have passed
+    short phase_acceptance[60/5];       // How many acknowledgements for each phase there are
+    uint16_t phase_voters[60/5];        // Nodes that already voted for each phase, a vote is only counted once
+    quorum_certificate_t certificate;   // Signed votes and the modules known when validation started, kept with the block
+    uint32_t trade_id;
+    bool finishing;                     // Duration adjusted, being committed. Votes are not counted anymore
+} validation_slot_t;
+
+static validation_slot_t validation_slots[VALIDATION_SLOTS];
 
-// Mutex struct for phase_acceptance_array
-SemaphoreHandle_t phase_acceptance_array_mutex;
+// Mutex struct for validation_slots. Taken after block_tree_mutex when both are needed
+SemaphoreHandle_t validation_mutex;
 
 // init trade data
 broadcasted_deal_t trade_data;
 
-// Head of the blockchain
-struct block_t *chain_head = -1;
+// Committed blocks with their branches and orphans. Blocks leave it for the ledger once they are final.
+// The head it picks is published through chain_tip, which the other tasks read without locking
+static block_tree_t block_tree;
+
+// Mutex struct for block_tree, also taken by every chain_tip writer
+SemaphoreHandle_t block_tree_mutex;
+
+// Balances of every node, updated for each final block instead of walking the chain
+static ledger_t ledger;
+
+// Mutex struct for ledger
+SemaphoreHandle_t ledger_mutex;
+
+// Digest of the own chain state, broadcasted with every bca. Guarded by block_tree_mutex
+static chain_digest_t chain_digest;
+
+// The digests other stations announced, only used by laset_listener_task
+static chain_digest_peers_t chain_digest_peers;
+
+// Bids and asks collected for the current auction slot
+static auction_book_t auction_book;
+
+// Cleared allocations until their blocks are proposed and validated. Guarded by auction_book_mutex
+static auction_pending_t auction_pending;
+
+// Auction time shared with the other stations through bca, the slots are numbered from it. Guarded by auction_book_mutex
+static auction_clock_t auction_clock;
+
+// What the dashboard shows. Written by the network tasks, read by the dashboard task without locking
+static dashboard_snapshot_t dashboard_snapshot;
+
+// Mutex struct for auction_book, auction_pending and auction_clock
+SemaphoreHandle_t auction_book_mutex;
+
+// Signals pushed amperage updates and replies from the simulator, when simulator_listener_task owns the TCP socket
+static EventGroupHandle_t simulator_event_group;
+static bool simulator_listener_running = false;
+// The simulator TCP socket in subscribe mode. simulator_listener_task replaces it when it reconnects
+static volatile int simulator_sock = -1;
+
+// Metric ids, registered by register_metrics()
+static int packets_received_metric[4];  // Ports 7777, 8888, 8889 and CHAIN_SYNC_PORT
+static int decode_failures_metric;
+static int chain_height_metric;
+static int heap_free_metric;
+static int heap_largest_block_metric;
+static int packet_pool_empty_metric;
+static int packet_queue_full_metric;
+static int packet_unknown_header_metric;
+static int packet_rate_limited_metric;
+static int packet_duplicate_metric;
+static int ledger_balance_metric;
+static int orphan_blocks_metric;
+static int chain_sync_metric;
+
+// Packets of each priority waiting for the stage behind a receiver
+static const int ingress_queue_lengths[INGRESS_PRIORITY_AMOUNT] = {6, 3, 3};
+
+// Queues between a receiver and the task handling its packets. The handler always takes the highest priority first
+typedef struct {
+    QueueHandle_t queues[INGRESS_PRIORITY_AMOUNT];  // Hold packet_t pointers
+    SemaphoreHandle_t pending;                      // Given once for every queued packet
+} ingress_queues_t;
+
+typedef struct {
+    int udp_sock;
+    ingress_queues_t *ingress;
+    ingress_limiter_t limiter;
+    dedup_filter_t dedup;
+} udp_receiver_params_t;
+
+// Tasks whose stack high-water mark is exported
+#define MONITORED_TASK_AMOUNT 8
+static TaskHandle_t monitored_tasks[MONITORED_TASK_AMOUNT];
+static int monitored_task_metrics[MONITORED_TASK_AMOUNT];
+static int monitored_task_amount = 0;
+
+void register_metrics() {
+    packets_received_metric[0] = metrics_register("laset_udp_packets_received", "port=\"7777\"", METRIC_COUNTER);
+    packets_received_metric[1] = metrics_register("laset_udp_packets_received", "port=\"8888\"", METRIC_COUNTER);
+    packets_received_metric[2] = metrics_register("laset_udp_packets_received", "port=\"8889\"", METRIC_COUNTER);
+    packets_received_metric[3] = metrics_register("laset_udp_packets_received", "port=\"7779\"", METRIC_COUNTER);
+    decode_failures_metric = metrics_register("laset_decode_failures", NULL, METRIC_COUNTER);
+    chain_height_metric = metrics_register("laset_chain_height", NULL, METRIC_GAUGE);
+    heap_free_metric = metrics_register("laset_heap_free_bytes", NULL, METRIC_GAUGE);
+    heap_largest_block_metric = metrics_register("laset_heap_largest_free_block_bytes", NULL, METRIC_GAUGE);
+    packet_pool_empty_metric = metrics_register("laset_packet_pool_empty_waits", NULL, METRIC_COUNTER);
+    packet_queue_full_metric = metrics_register("laset_packets_dropped", "reason=\"queue_full\"", METRIC_COUNTER);
+    packet_unknown_header_metric = metrics_register("laset_packets_dropped", "reason=\"unknown_header\"", METRIC_COUNTER);
+    packet_rate_limited_metric = metrics_register("laset_packets_dropped", "reason=\"rate_limited\"", METRIC_COUNTER);
+    packet_duplicate_metric = metrics_register("laset_packets_dropped", "reason=\"duplicate\"", METRIC_COUNTER);
+    ledger_balance_metric = metrics_register("laset_ledger_balance", NULL, METRIC_GAUGE);
+    orphan_blocks_metric = metrics_register("laset_orphan_blocks", NULL, METRIC_GAUGE);
+    chain_sync_metric = metrics_register("laset_chain_sync_requests", NULL, METRIC_COUNTER);
+    validation_register_metrics();
+}
+
+// Exports the stack high-water mark of a task
+void monitor_task(TaskHandle_t task, const char *task_name) {
+    if (monitored_task_amount >= MONITORED_TASK_AMOUNT) {
+        return;
+    }
+    char labels[METRICS_LABELS_SIZE];
+    snprintf(labels, sizeof(labels), "task=\"%s\"", task_name);
+    monitored_tasks[monitored_task_amount] = task;
+    monitored_task_metrics[monitored_task_amount] = metrics_register("laset_task_stack_high_water_mark_bytes", labels, METRIC_GAUGE);
+    monitored_task_amount++;
+}
+
+// Counts a received packet, and whether it could be decoded (port_index 0 is 7777, 1 is 8888 and 2 is 8889)
+void count_received_packet(int port_index, const struct broadcast_data_t *MsgData) {
+    metrics_counter_add(packets_received_metric[port_index], 1);
+    if (MsgData->type == 0) {
+        metrics_counter_add(decode_failures_metric, 1);
+    }
+}
+
+// Enters a read-side section of the chain tip. When every slot is taken, the other readers get a tick to leave
+const chain_tip_t *read_chain_tip(int *reader) {
+    const chain_tip_t *tip = chain_tip_read_begin(reader);
+    while (tip == NULL) {
+        ESP_LOGW(TAG_CHAIN_TIP, "All %i reader slots are taken, retrying", CHAIN_TIP_READERS);
+        vTaskDelay(1);
+        tip = chain_tip_read_begin(reader);
+    }
+    return tip;
+}
+
+// Gauges are only read when scraped, so they are updated just before
+void update_health_metrics() {
+    int reader;
+    metrics_gauge_set(chain_height_metric, read_chain_tip(&reader)->height);
+    chain_tip_read_end(reader);
+    xSemaphoreTake(block_tree_mutex, portMAX_DELAY);
+    metrics_gauge_set(orphan_blocks_metric, block_tree_orphan_amount(&block_tree));
+    xSemaphoreGive(block_tree_mutex);
+    xSemaphoreTake(ledger_mutex, portMAX_DELAY);
+    metrics_gauge_set(ledger_balance_metric, (int32_t)ledger_balance(&ledger, node_id));
+    xSemaphoreGive(ledger_mutex);
+    metrics_gauge_set(heap_free_metric, esp_get_free_heap_size());
+    metrics_gauge_set(heap_largest_block_metric, heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+    for (int i = 0; i < monitored_task_amount; i++) {
+        metrics_gauge_set(monitored_task_metrics[i], uxTaskGetStackHighWaterMark(monitored_tasks[i]));
+    }
+}
+
+/* Serves the metrics as text on METRICS_PORT. A collector connects, reads until the station closes and is done */
+void metrics_server_task(void *pParam) {
+    static char metrics_text[4096];
+
+    int listen_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+    if (listen_sock < 0) {
+        ESP_LOGE(TAG_METRICS, "Unable to create socket: errno %d", errno);
+        vTaskDelete(NULL);
+    }
+
+    struct sockaddr_in local_addr;
+    local_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    local_addr.sin_family = AF_INET;
+    local_addr.sin_port = htons(METRICS_PORT);
+
+    if (bind(listen_sock, (struct sockaddr *)&local_addr, sizeof(local_addr)) < 0 || listen(listen_sock, 2) < 0) {
+        ESP_LOGE(TAG_METRICS, "Socket unable to bind: errno %d", errno);
+        close(listen_sock);
+        vTaskDelete(NULL);
+    }
+    ESP_LOGI(TAG_METRICS, "Serving metrics on " IPSTR ":%d", IP2STR(&node_ip), METRICS_PORT);
+
+    while (1) {
+        int client_sock = accept(listen_sock, NULL, NULL);
+        if (client_sock < 0) {
+            ESP_LOGE(TAG_METRICS, "accept failed: errno %d", errno);
+            vTaskDelay(500 / portTICK_PERIOD_MS);
+            continue;
+        }
+
+        update_health_metrics();
+        int length = metrics_render(metrics_text, sizeof(metrics_text));
+        if (length < 0) {
+            ESP_LOGE(TAG_METRICS, "Metrics do not fit in %d bytes", sizeof(metrics_text));
+        } else {
+            int sent = 0;
+            while (sent < length) {
+                int err = send(client_sock, metrics_text + sent, length - sent, 0);
+                if (err < 0) {
+                    ESP_LOGE(TAG_METRICS, "Error occurred during sending: errno %d", errno);
+                    break;
+                }
+                sent += err;
+            }
+        }
+        close(client_sock);
+    }
+}
+
+/* Receives datagrams straight into pooled packet buffers and queues them by priority for the task that handles them.
+ * Unknown headers, copies of recent packets and sources over their rate are dropped here, before anything is decoded */
+void udp_receiver_task(void *pParam) {
+    udp_receiver_params_t *params = (udp_receiver_params_t *)pParam;
+    struct sockaddr_in source_addr;
+    socklen_t socklen;
+
+    while (1) {
+        packet_t *packet = packet_acquire();
+        if (packet == NULL) {
+            // Every buffer is queued or being handled, give the handlers time to catch up
+            metrics_counter_add(packet_pool_empty_metric, 1);
+            vTaskDelay(10 / portTICK_PERIOD_MS);
+            continue;
+        }
+
+        socklen = sizeof(source_addr);
+        int len = recvfrom(params->udp_sock, packet->data, PACKET_BUFFER_SIZE - 1, 0, (struct sockaddr *)&source_addr, &socklen);
+        if (len < 0) {
+            ESP_LOGE(TAG, "recvfrom failed: errno %d", errno);
+            packet_release(packet);
+            vTaskDelay(500 / portTICK_PERIOD_MS);
+            continue;
+        }
+        packet_set_length(packet, len);
+        packet->source_ip = source_addr.sin_addr.s_addr;
+
+        int priority = ingress_classify(packet->data, packet->length);
+        if (priority == INGRESS_UNKNOWN) {
+            metrics_counter_add(packet_unknown_header_metric, 1);
+            packet_release(packet);
+            continue;
+        }
+        // Checked before the rate, so the copies of a broadcast do not use up the tokens of its sender
+        if (dedup_seen(&params->dedup, packet->source_ip, packet->data, packet->length, esp_timer_get_time() / 1000)) {
+            metrics_counter_add(packet_duplicate_metric, 1);
+            packet_release(packet);
+            continue;
+        }
+        if (!ingress_admit(&params->limiter, packet->source_ip, esp_timer_get_time() / 1000)) {
+            metrics_counter_add(packet_rate_limited_metric, 1);
+            packet_release(packet);
+            continue;
+        }
+
+        // The reference moves to the queue
+        if (xQueueSend(params->ingress->queues[priority], &packet, 0) != pdTRUE) {
+            metrics_counter_add(packet_queue_full_metric, 1);
+            packet_release(packet);
+            continue;
+        }
+        xSemaphoreGive(params->ingress->pending);
+    }
+}
+
+// Starts a udp_receiver_task for a bound socket and returns the queues it fills
+ingress_queues_t *start_udp_receiver(int udp_sock, const char *task_name) {
+    udp_receiver_params_t *params = (udp_receiver_params_t *)malloc(sizeof(udp_receiver_params_t));
+    ingress_queues_t *ingress = (ingress_queues_t *)malloc(sizeof(ingress_queues_t));
+    int pending_max = 0;
+    for (int priority = 0; priority < INGRESS_PRIORITY_AMOUNT; priority++) {
+        ingress->queues[priority] = xQueueCreate(ingress_queue_lengths[priority], sizeof(packet_t *));
+        pending_max += ingress_queue_lengths[priority];
+    }
+    ingress->pending = xSemaphoreCreateCounting(pending_max, 0);
+
+    params->udp_sock = udp_sock;
+    params->ingress = ingress;
+    ingress_limiter_init(&params->limiter);
+    dedup_init(&params->dedup, esp_timer_get_time() / 1000);
+    task_plan_create(udp_receiver_task, task_name, 4096, params, TASK_ROLE_NETWORK, NULL);
+    return ingress;
+}
+
+// Waits for the next packet from a receiver, highest priority first
+packet_t *receive_next_packet(ingress_queues_t *ingress) {
+    packet_t *packet = NULL;
+    while (1) {
+        xSemaphoreTake(ingress->pending, portMAX_DELAY);
+        for (int priority = 0; priority < INGRESS_PRIORITY_AMOUNT; priority++) {
+            if (xQueueReceive(ingress->queues[priority], &packet, 0) == pdTRUE) {
+                return packet;
+            }
+        }
+    }
+}
+
+/* Low priority task that formats the binary log records written by the hot paths */
+void binlog_drain_task(void *pParam) {
+    binlog_record_t record;
+    char line[160];
+    uint32_t reported_dropped = 0;
+
+    while (1) {
+        while (binlog_read(&record) == 0) {
+            binlog_format(&record, line, sizeof(line));
+            ESP_LOGI(TAG_BINLOG, "%s", line);
+        }
+
+        uint32_t dropped = binlog_dropped();
+        if (dropped != reported_dropped) {
+            ESP_LOGW(TAG_BINLOG, "%lu log record(s) dropped, the ring was full", (unsigned long)(dropped - reported_dropped));
+            reported_dropped = dropped;
+        }
+        vTaskDelay(200 / portTICK_PERIOD_MS);
+    }
+}
 
 void updatePublicKey(int target_node_id, const char public_key[]) {
     memcpy(foreign_public_key_array[target_node_id], public_key, PUBLIC_KEY_SIZE);
+    key_fingerprint((const uint8_t *)public_key, PUBLIC_KEY_SIZE, foreign_key_fingerprint_array[target_node_id]);
 }
 
-void updateGridLoad(int node_id, int amperage) {
+void updateGridLoad(int node_id, fixed_t amperage) {
     grid_load[node_id] = amperage;
+
+    if (node_id >= 0 && node_id < DASHBOARD_NODES) {
+        dashboard_state_t *dashboard_state = dashboard_begin_update(&dashboard_snapshot);
+        dashboard_state->grid_load[node_id] = amperage;
+        dashboard_end_update(&dashboard_snapshot);
+    }
+}
+
+// Publishes the votes of a block being validated to the dashboard. Called with validation_mutex taken
+void publish_phase_votes(const validation_slot_t *slot) {
+    dashboard_state_t *dashboard_state = dashboard_begin_update(&dashboard_snapshot);
+    for (int phase = 0; phase < DASHBOARD_PHASES; phase++) {
+        dashboard_state->phase_votes[phase] = slot->phase_acceptance[phase];
+    }
+    dashboard_end_update(&dashboard_snapshot);
+}
+
+// Writes a ledger snapshot to NVS, so the station can continue from it after a restart. Called with ledger_mutex taken
+void store_ledger_snapshot(const ledger_state_t *snapshot) {
+    static uint8_t encoded[LEDGER_SNAPSHOT_MAX_SIZE];
+    int length = ledger_snapshot_encode(snapshot, encoded, sizeof(encoded));
+
+    nvs_handle_t handle;
+    if (length < 0 || nvs_open(LEDGER_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        ESP_LOGE(TAG_LEDGER, "Could not store the snapshot at height %lu", (unsigned long)snapshot->height);
+        return;
+    }
+    esp_err_t err = nvs_set_blob(handle, LEDGER_NVS_KEY, encoded, length);
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    ESP_LOGI(TAG_LEDGER, "Snapshot at height %lu, %i bytes: %s", (unsigned long)snapshot->height, length, esp_err_to_name(err));
+}
+
+// Continues the ledger (and the chain) from the snapshot in NVS, if there is one. Called before any task runs
+void load_ledger_snapshot() {
+    static uint8_t encoded[LEDGER_SNAPSHOT_MAX_SIZE];
+    size_t length = sizeof(encoded);
+
+    nvs_handle_t handle;
+    if (nvs_open(LEDGER_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return;     // Nothing was stored yet
+    }
+    esp_err_t err = nvs_get_blob(handle, LEDGER_NVS_KEY, encoded, &length);
+    nvs_close(handle);
+
+    static ledger_state_t snapshot;
+    if (err != ESP_OK || ledger_snapshot_decode(encoded, length, &snapshot) != 0) {
+        return;
+    }
+    ledger_restore(&ledger, &snapshot);
+    chain_set_anchor((const char *)snapshot.tip_hash);
+    ESP_LOGI(TAG_LEDGER, "Continuing from the snapshot at height %lu", (unsigned long)snapshot.height);
 }
 
-void tcp_send_and_update(int sock, const char *message, const char* destinationIP, int port) {    // DestinationIP and port are ONLY for logging purposes
+// Applies the blocks that became final to the ledger, and stores it. Called with block_tree_mutex taken
+void apply_final_blocks() {
+    xSemaphoreTake(ledger_mutex, portMAX_DELAY);
+    uint32_t final_height = ledger.state.height;
+
+    struct block_t *block;
+    while ((block = block_tree_take_final(&block_tree)) != NULL) {
+        if (ledger_apply(&ledger, block->seller_node_id, block->buyer_node_id, block->price, block->duration, block->hash) != 0) {
+            ESP_LOGW(TAG_LEDGER, "Block %i>%i is not in the ledger, invalid node ids", block->seller_node_id, block->buyer_node_id);
+        }
+    }
+
+    // Stored at every final block, so a restart continues where the tree's root is and the blocks above it are
+    // still kept by the peers
+    if (LEDGER_PERSIST_SNAPSHOTS && ledger.state.height != final_height) {
+        store_ledger_snapshot(&ledger.state);
+    }
+    xSemaphoreGive(ledger_mutex);
+}
+
+// Block tree callbacks: keeps previous_block pointing at a block the tree still has, and frees dropped blocks
+// once no chain_tip reader can hold them anymore
+void link_block(void *block, void *parent) {
+    ((struct block_t *)block)->previous_block = (parent == NULL) ? -1 : parent;
+}
+
+void release_block(void *block) {
+    if (chain_tip_retire(block, free_block) != 0) {
+        ESP_LOGE(TAG_CHAIN_TIP, "No memory to retire a block, it is leaked");
+    }
+}
+
+// Adds the blocks from head back to amount blocks behind it to the block tree, oldest first. Called with block_tree_mutex taken
+void add_to_block_tree(struct block_t *head, int amount) {
+    if (amount == 0) {
+        return;
+    }
+    add_to_block_tree(head->previous_block, amount - 1);
+
+    block_tree_result_t result = block_tree_add(&block_tree, head->hash, head->previous_hash, head, esp_timer_get_time() / 1000);
+    if (result == BLOCK_TREE_REJECTED) {
+        ESP_LOGW(TAG_BLOCK_TREE, "Block %i>%i is known already or builds on a block behind the final one, discarding..", head->seller_node_id, head->buyer_node_id);
+        free_block(head);
+    } else if (result == BLOCK_TREE_ORPHANED) {
+        ESP_LOGW(TAG_BLOCK_TREE, "Block %i>%i waits for its parent", head->seller_node_id, head->buyer_node_id);
+    }
+}
+
+// Makes the chain digest again for a published tip, with the ledger as it is now. Called with block_tree_mutex taken
+void update_chain_digest(const chain_tip_t *tip) {
+    xSemaphoreTake(ledger_mutex, portMAX_DELAY);
+    uint64_t ledger_digest = ledger.state.digest;
+    xSemaphoreGive(ledger_mutex);
+    chain_digest_make(&chain_digest, tip->height, tip->hash, ledger_digest);
+}
+
+// Commits blocks: adds them to the block tree, publishes the head it picks, and applies the blocks that became
+// final to the ledger. Returns the chain height. Called with block_tree_mutex taken
+uint32_t commit_blocks(struct block_t *head, int amount) {
+    add_to_block_tree(head, amount);
+
+    // Published before apply_final_blocks drops the losing branches, one of them may hold the previous head
+    chain_tip_t tip = { .block = block_tree_head(&block_tree), .height = block_tree_height(&block_tree) };
+    block_tree_head_hash(&block_tree, tip.hash);
+    int reader;
+    const chain_tip_t *current = read_chain_tip(&reader);
+    if ((current->block != tip.block || current->height != tip.height) && chain_tip_publish(current, &tip) != 0) {
+        ESP_LOGE(TAG_CHAIN_TIP, "The chain tip was replaced outside block_tree_mutex");
+    }
+    chain_tip_read_end(reader);
+
+    apply_final_blocks();
+    update_chain_digest(&tip);
+    return tip.height;
+}
+
+// Publishes the chain head, and whether the own trade deal is still open, to the dashboard
+void publish_chain_state() {
+    int reader;
+    const chain_tip_t *tip = read_chain_tip(&reader);
+    int chain_height = tip->height;
+    struct block_t head;
+    bool has_head = (tip->block != NULL);
+    if (has_head) {
+        head = *(struct block_t *)tip->block;
+    }
+    chain_tip_read_end(reader);
+
+    dashboard_state_t *dashboard_state = dashboard_begin_update(&dashboard_snapshot);
+    dashboard_state->chain_height = chain_height;
+    dashboard_state->trade_open = trade_deal_is_open;
+    if (has_head) {
+        dashboard_state->has_trade = true;
+        dashboard_state->trade_seller = head.seller_node_id;
+        dashboard_state->trade_buyer = head.buyer_node_id;
+        dashboard_state->trade_price = head.price;
+        dashboard_state->trade_duration = head.duration;
+    }
+    dashboard_end_update(&dashboard_snapshot);
+}
+
+// Updates the node's state from a message received from the simulator
+void handle_simulator_message(struct broadcast_data_t *MsgData) {
+    if(MsgData->type == PROVIDE_NODE_ID) {
+        if(MsgData->node_id == -1) {
+            ESP_LOGE(TAG, "Got invalid node id!");
+        }
+        node_id = MsgData->node_id;
+        dashboard_begin_update(&dashboard_snapshot)->node_id = node_id;
+        dashboard_end_update(&dashboard_snapshot);
+    } else if(MsgData->type == PROVIDE_AMPERAGE_READING) {
+        node_amperage_reading = MsgData->amperage;
+        dashboard_begin_update(&dashboard_snapshot)->amperage = node_amperage_reading;
+        dashboard_end_update(&dashboard_snapshot);
+
+        // Update amperage on grid for provided amperage reading
+        updateGridLoad(node_id, node_amperage_reading);
+    } else if(MsgData->type == PROVIDE_LOAD_CALCULATION) {
+        estimated_grid_calculation = MsgData->estimated_grid;
+    }
+}
+
+// Sends a request to the simulator and updates the node's state from the reply. Returns 0, or -1 if no reply came
+// in time (subscribe mode), so the caller does not take a value from an earlier reply for this one
+int tcp_send_and_update(int sock, const char *message, const char* destinationIP, int port) {    // DestinationIP and port are ONLY for logging purposes
     struct sockaddr_in dest_addr;
     
     char rx_buffer[128];
     struct broadcast_data_t MsgData;
 
+    // simulator_listener_task receives everything on the socket, so only send and wait for it to get the reply.
+    // It may have reconnected since sock was handed out, so its current socket is used
+    if (simulator_listener_running) {
+        xEventGroupClearBits(simulator_event_group, SIMULATOR_REPLY_BIT);
+        PROFILE_BEGIN(PROFILE_TCP_SEND);
+        int err = send(simulator_sock, message, strlen(message), 0);
+        PROFILE_END(PROFILE_TCP_SEND);
+        if (err < 0) {
+            ESP_LOGE(TAG, "Error occurred during sending: errno %d", errno);
+            return -1;
+        }
+        EventBits_t bits = xEventGroupWaitBits(simulator_event_group, SIMULATOR_REPLY_BIT, pdTRUE, pdFALSE, 2000 / portTICK_PERIOD_MS);
+        if ((bits & SIMULATOR_REPLY_BIT) == 0) {
+            ESP_LOGE(TAG, "No reply from the simulator to <%s> in 2000 ms", message);
+            return -1;
+        }
+        return 0;
+    }
+
     while (1) {
         memset(rx_buffer, 0, sizeof(rx_buffer));
+        PROFILE_BEGIN(PROFILE_TCP_SEND);
         int err = send(sock, message, strlen(message), 0);
+        PROFILE_END(PROFILE_TCP_SEND);
         if (err < 0) {
             ESP_LOGE(TAG, "Error occurred during sending: errno %d", errno);
             vTaskDelay(500 / portTICK_PERIOD_MS);
@@ -94,28 +677,126 @@ void tcp_send_and_update(int sock, const char *message, const char* destinationI
             continue;
         }
 
-        payload_decoder(rx_buffer, sizeof(rx_buffer), &MsgData);
+        payload_decoder(rx_buffer, len, &MsgData);
+        handle_simulator_message(&MsgData);
+        return 0;
+    }
+}
+
+// Connects to the simulator again after the connection was lost, waiting longer after every failed attempt, and
+// subscribes again. Returns the new socket
+int reconnect_simulator(int tcp_sock) {
+    close(tcp_sock);
+    simulator_sock = -1;    // Requests fail right away until the connection is back
+
+    int delay_ms = SIMULATOR_RECONNECT_MIN_MS;
+    while ((tcp_sock = create_connect_tcp_socket(SERVER_IP, SERVER_PORT)) < 0) {
+        vTaskDelay(delay_ms / portTICK_PERIOD_MS);
+        delay_ms = (delay_ms * 2 > SIMULATOR_RECONNECT_MAX_MS) ? SIMULATOR_RECONNECT_MAX_MS : delay_ms * 2;
+    }
+    simulator_sock = tcp_sock;
+
+    char sub_msg[20];
+    sprintf(sub_msg, "sub,%d;", node_id);
+    send(tcp_sock, sub_msg, strlen(sub_msg), 0);
+    ESP_LOGI(TAG, "Reconnected to the simulator");
+    return tcp_sock;
+}
+
+/* Task that owns the simulator TCP socket in subscribe mode. Receives pushed amperage readings and replies to requests */
+void simulator_listener_task(void *pParam) {
+    int tcp_sock = (int *)pParam;
+    simulator_sock = tcp_sock;
+    char rx_buffer[256];
+    int buffered = 0;   // Start of a message whose ';' was not received yet
+    struct broadcast_data_t MsgData;
+
+    ESP_LOGI(TAG, "SimulatorListenerTask Started");
+
+    while (1) {
+        memset(rx_buffer + buffered, 0, sizeof(rx_buffer) - buffered);
+        int received = recv(tcp_sock, rx_buffer + buffered, sizeof(rx_buffer) - 1 - buffered, 0);
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            continue;
+        }
+        if (received <= 0) {
+            // The simulator closed the connection, or it broke. The part of a message read so far is lost with it
+            if (received == 0) {
+                ESP_LOGE(TAG, "The simulator closed the connection");
+            } else {
+                ESP_LOGE(TAG, "recv failed: errno %d", errno);
+            }
+            buffered = 0;
+            tcp_sock = reconnect_simulator(tcp_sock);
+            continue;
+        }
+        int len = buffered + received;
+
+        // One read can hold several messages, e.g. "par,-5;plc,0;", and end in the middle of the next one
+        int start = 0;
+        for (int i = 0; i < len; i++) {
+            if (rx_buffer[i] != ';') {
+                continue;
+            }
+            payload_decoder(rx_buffer + start, i - start + 1, &MsgData);
+            handle_simulator_message(&MsgData);
 
-        if(MsgData.type == PROVIDE_NODE_ID) {
-            if(MsgData.node_id == -1) {
-                ESP_LOGE(TAG, "Got invalid node id!");
+            if (MsgData.type == PROVIDE_AMPERAGE_READING) {
+                xEventGroupSetBits(simulator_event_group, AMPERAGE_CHANGED_BIT);
+            } else {
+                xEventGroupSetBits(simulator_event_group, SIMULATOR_REPLY_BIT);
             }
-            node_id = MsgData.node_id;
-        } else if(MsgData.type == PROVIDE_AMPERAGE_READING) {
-            node_amperage_reading = MsgData.amperage;
+            start = i + 1;
+        }
 
-            // Update amperage on grid for provided amperage reading
-            updateGridLoad(node_id, node_amperage_reading);
-        } else if(MsgData.type == PROVIDE_LOAD_CALCULATION) {
-            estimated_grid_calculation = MsgData.estimated_grid;
+        buffered = len - start;
+        if (buffered >= (int)sizeof(rx_buffer) - 1) {
+            ESP_LOGE(TAG, "No ';' in %i bytes from the simulator, dropping them", buffered);
+            buffered = 0;
         }
-        break;
+        memmove(rx_buffer, rx_buffer + start, buffered);
+    }
+
+    vTaskDelete(NULL);
+}
+
+// Signature stage of a message from another node: imports its cached public key and verifies the signature of msg
+int verify_node_signature(int sender_node_id, uint8_t *msg, size_t msg_size, uint8_t *signature) {
+    node_public_key_t sender_npk;
+    node_key_credentials_t sender_nkc;
+
+    memcpy(sender_npk.public_key_buffer, foreign_public_key_array[sender_node_id], PUBLIC_KEY_SIZE);
+    sender_npk.public_key_length = PUBLIC_KEY_SIZE;
+    if (import_public_key(sender_npk, &sender_nkc) != 0) {
+        return validation_record(VALIDATION_SIGNATURE, -1);
+    }
+    return validation_record(VALIDATION_SIGNATURE, verify_message(sender_nkc, msg, msg_size, signature, 64));
+}
+
+// Verifies the quorum certificate of a committed block without its phase window: the votes are for this block with
+// its duration before the adjustment, every signature is valid, and the phases with 2/3 of the modules recorded in
+// the certificate add up to the committed duration. Returns 0, or -1 if the block has no certificate or it does not hold
+int verify_block_certificate(struct block_t *block) {
+    if (block->certificate == NULL) {
+        return -1;
     }
+    struct block_t voted = *block;
+    voted.duration = block->certificate->duration;
+    create_block_hash(&voted);
+    if (memcmp(voted.hash, block->certificate->hash, SHA256_HASH_SIZE) != 0) {
+        return -1;
+    }
+    // The network may have grown since the block was validated. A certificate that records a much smaller network
+    // than the one known now, to lower its threshold, is refused
+    if (quorum_member_amount(block->certificate) * 3 < get_laset_module_amount(foreign_public_key_array) * 2) {
+        return -1;
+    }
+    return quorum_verify(block->certificate, quorum_needed(block->certificate), block->duration, verify_node_signature);
 }
 
 void create_trade_deal(int UDPsock, node_key_credentials_t key_pair, int pricePrkW, int durationInMin) {
     psa_status_t status;
-    const char msg[256];
+    char msg[256];
     memset(msg, 0, sizeof(msg));
 
     // Create signature
@@ -132,13 +813,17 @@ void create_trade_deal(int UDPsock, node_key_credentials_t key_pair, int pricePr
         ESP_LOGE(TAG, "Function sign_message() failed!, error: %li", status);
     }
 
-    sprintf(msg, "bcd,%i,%i,%i,", node_id, pricePrkW, durationInMin);
-    for (size_t i = 0; i < signature_length; ++i) {
-        sprintf(msg + strlen(msg), "%02x", signature[i]);
+    snprintf(msg, sizeof(msg), "bcd,%i,%i,%i,", node_id, pricePrkW, durationInMin);
+    int msg_length = hex_append(msg, sizeof(msg) - 1, signature, signature_length);   // Room left for the ;
+    if (msg_length < 0) {
+        ESP_LOGE(TAG, "Signature does not fit in the bcd message");
+        return;
     }
-    sprintf(msg + strlen(msg), ";");
+    msg[msg_length++] = ';';
+    msg[msg_length] = '\0';
 
-    send_udp_message(UDPsock, 1, msg, strlen(msg), "0.0.0.0", 7777);
+    send_udp_message(UDPsock, 1, msg, msg_length, "0.0.0.0", 7777);
+    trace_mark(trace_trade_id(node_id, pricePrkW, durationInMin), TRACE_BCD_BROADCAST);
 
     // Set trade deal attributes for use in adding a block to the chain.
     trade_data.price = pricePrkW;
@@ -146,6 +831,84 @@ void create_trade_deal(int UDPsock, node_key_credentials_t key_pair, int pricePr
     memcpy(trade_data.signature, signature, SIGNATURE_SIZE/2);
 }
 
+// The auction time now (ms), see auction_clock_t
+int64_t auction_time_ms() {
+    xSemaphoreTake(auction_book_mutex, portMAX_DELAY);
+    int64_t clock_ms = auction_clock_now(&auction_clock, esp_timer_get_time() / 1000);
+    xSemaphoreGive(auction_book_mutex);
+    return clock_ms;
+}
+
+// Signs and broadcasts a bid or an ask for the current auction slot.
+void create_auction_order(int UDPsock, node_key_credentials_t key_pair, const char *header, int price, int duration) {
+    uint32_t slot = auction_slot_from_clock(auction_time_ms());
+
+    // Create signature
+    uint8_t input[256];
+    auction_construct_order_message((char *)input, sizeof(input), header, node_id, price, duration, slot);
+
+    uint8_t signature[PSA_SIGNATURE_MAX_SIZE] = {0};
+    size_t signature_length;
+
+    int status = sign_message(key_pair, input, sizeof(input), signature, &signature_length);
+    if (status != 0) {
+        ESP_LOGE(TAG, "Function sign_message() failed!, error: %i", status);
+        return;
+    }
+
+    char msg[256];
+    memset(msg, 0, sizeof(msg));
+    snprintf(msg, sizeof(msg), "%s,%i,%i,%i,%lu,", header, node_id, price, duration, (unsigned long)slot);
+    int msg_length = hex_append(msg, sizeof(msg) - 1, signature, signature_length);   // Room left for the ;
+    if (msg_length < 0) {
+        ESP_LOGE(TAG, "Signature does not fit in the %s message", header);
+        return;
+    }
+    msg[msg_length++] = ';';
+    msg[msg_length] = '\0';
+
+    // Our own order is not received through the broadcast, so add it to the book directly.
+    auction_order_t order = { .node_id = node_id, .price = price, .duration = duration };
+    memcpy(order.signature, signature, SIGNATURE_SIZE/2);
+
+    xSemaphoreTake(auction_book_mutex, portMAX_DELAY);
+    if (auction_book.slot == slot) {
+        if (memcmp(header, "bid", 3) == 0) {
+            auction_add_bid(&auction_book, &order);
+        } else {
+            auction_add_ask(&auction_book, &order);
+        }
+    }
+    xSemaphoreGive(auction_book_mutex);
+
+    send_udp_message(UDPsock, 1, msg, msg_length, "0.0.0.0", 7777);
+}
+
+// Broadcast amperage to all LASET modules and the fingerprint of the node's own public key.
+// Nodes that do not know the key yet (or saw it change) fetch it once with rpk.
+void broadcast_amperage(int udp_sock) {
+    char amperage[FIXED_TEXT_SIZE];
+    fixed_format(node_amperage_reading, FIXED_DECIMALS, amperage, sizeof(amperage));
+
+    // The chain digest goes along, so the other stations notice when their chain differs
+    uint8_t digest[CHAIN_DIGEST_ENCODED_SIZE];
+    xSemaphoreTake(block_tree_mutex, portMAX_DELAY);
+    chain_digest_encode(&chain_digest, digest);
+    xSemaphoreGive(block_tree_mutex);
+
+    // And the auction time, so every station numbers the auction slots the same
+    uint8_t clock[AUCTION_CLOCK_ENCODED_SIZE];
+    auction_clock_encode(auction_time_ms(), clock);
+
+    char payload[64];
+    int payload_size_1 = snprintf(payload, sizeof(payload), "bca,%d,%s,", node_id, amperage);
+    memcpy(&payload[payload_size_1], own_key_fingerprint, KEY_FINGERPRINT_SIZE);
+    memcpy(&payload[payload_size_1 + KEY_FINGERPRINT_SIZE], digest, CHAIN_DIGEST_SIZE);
+    memcpy(&payload[payload_size_1 + KEY_FINGERPRINT_SIZE + CHAIN_DIGEST_SIZE], clock, AUCTION_CLOCK_SIZE);
+    send_udp_message(udp_sock, 1, payload, payload_size_1 + KEY_FINGERPRINT_SIZE + CHAIN_DIGEST_SIZE + AUCTION_CLOCK_SIZE, "", 7777); // Broadcast amperage to all nodes.
+    BINLOG(BINLOG_AMPERAGE_BROADCAST, node_amperage_reading);
+}
+
 void amperage_broadcaster_task(void *pParam) {
     ESP_LOGI(TAG, "AmperageBroadcasterTask Started");
     
@@ -155,21 +918,53 @@ void amperage_broadcaster_task(void *pParam) {
     int *tcp_sock = params->tcp_sock;
 
     char rql_msg[20];
-    sprintf(rql_msg, "rql,%d", node_id);
+    sprintf(rql_msg, "rql,%d;", node_id);
+
+    // What was broadcasted last, only used in subscribe mode
+    fixed_t broadcasted_amperage = node_amperage_reading;
+    int64_t last_broadcast_time = 0;
+
+    if (AMPERAGE_SUBSCRIBE_MODE) {
+        // The simulator replies with the current reading, and pushes a new one whenever it changes
+        char sub_msg[20];
+        sprintf(sub_msg, "sub,%d;", node_id);
+        send(tcp_sock, sub_msg, strlen(sub_msg), 0);
+    }
 
     while (1) {
-        // Delay task with 2000 ms.
-        vTaskDelay(2000 / portTICK_PERIOD_MS);
-        
-        tcp_send_and_update(tcp_sock, rql_msg, SERVER_IP, SERVER_PORT);
+        if (AMPERAGE_SUBSCRIBE_MODE) {
+            // Wake up on a pushed reading, or after 2000 ms to check for trade deals
+            xEventGroupWaitBits(simulator_event_group, AMPERAGE_CHANGED_BIT, pdTRUE, pdFALSE, 2000 / portTICK_PERIOD_MS);
+
+            int64_t now = esp_timer_get_time();
+            bool changed = fixed_abs(fixed_add(node_amperage_reading, -broadcasted_amperage)) >= FIXED_FROM_INT(AMPERAGE_BROADCAST_DELTA);
+            bool heartbeat = (now - last_broadcast_time) >= (int64_t)AMPERAGE_HEARTBEAT_MS * 1000;
+            if (changed || heartbeat) {
+                broadcasted_amperage = node_amperage_reading;
+                last_broadcast_time = now;
+                broadcast_amperage(udp_sock);
+            }
+        } else {
+            // Delay task with 2000 ms.
+            vTaskDelay(2000 / portTICK_PERIOD_MS);
 
-        // Broadcast amperage to all LASET modules and the node's own public key.
-        char payload[128];
-        sprintf(payload, "bca,%d,%d,", node_id, node_amperage_reading);
-        int payload_size_1 = strlen(payload);
-        memcpy(&payload[payload_size_1], npk.public_key_buffer, npk.public_key_length);
-        send_udp_message(udp_sock, 1, payload, sizeof(payload), "", 7777); // Broadcast amperage to all nodes.
-        ESP_LOGI(TAG, "\033[38;5;148mAmperage broacasted: %d", node_amperage_reading);
+            tcp_send_and_update(tcp_sock, rql_msg, SERVER_IP, SERVER_PORT);
+            broadcast_amperage(udp_sock);
+        }
+
+        if (AUCTION_MODE) {
+            // Initialize random seed, based on current time.
+            srand(time(NULL));
+
+            // Overproducing nodes ask, consuming nodes bid. Orders are cleared together at the end of the slot.
+            int durationInSec = ((rand() % 12) + 1)*5; // 5-60 seconds
+            if (node_amperage_reading < 0) {
+                create_auction_order(udp_sock, key_pair, "ask", (rand() % 20) + 1, durationInSec);
+            } else if (node_amperage_reading > 0) {
+                create_auction_order(udp_sock, key_pair, "bid", (rand() % AUCTION_BUYER_LIMIT_PRICE) + 1, durationInSec);
+            }
+            continue;
+        }
 
         // Check if we are overproducing!
         if (node_amperage_reading < 0) {
@@ -184,7 +979,9 @@ void amperage_broadcaster_task(void *pParam) {
             int pricePrkW = (rand() % 20) + 1;
             int durationInMin = ((rand() % 12) + 1)*5; // 5-60 seconds
             
-            ESP_LOGI(TAG, "\033[48;5;128mCreating trade deal with amperage <%i>, price<%i> and duration <%i>", node_amperage_reading, pricePrkW, durationInMin);
+            char amperage[FIXED_TEXT_SIZE];
+            fixed_format(node_amperage_reading, FIXED_DECIMALS, amperage, sizeof(amperage));
+            ESP_LOGI(TAG, "\033[48;5;128mCreating trade deal with amperage <%s>, price<%i> and duration <%i>", amperage, pricePrkW, durationInMin);
             create_trade_deal(udp_sock, key_pair, pricePrkW, durationInMin);
         }
     }
@@ -192,13 +989,88 @@ void amperage_broadcaster_task(void *pParam) {
     vTaskDelete(NULL);
 }
 
-/* Task for listening for other modules "phase acceptance" broadcasts in the duration of the block's trade. Then adds the block to the chain */
+// Finds the slot of a block being validated by its hash. Returns the index, or -1. Called with validation_mutex taken
+int find_validation_slot(const char *hash) {
+    for (int i = 0; i < VALIDATION_SLOTS; i++) {
+        if (validation_slots[i].block != NULL && memcmp(validation_slots[i].block->hash, hash, SHA256_HASH_SIZE) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Counts a vote that was verified already, unless the node voted for that phase before. Returns 0, or -1 if the
+// block is not being validated anymore or the vote was counted already
+int count_phase_vote(const char *hash, int voter_node_id, int phase, uint16_t phases, const uint8_t *signature) {
+    int counted = -1;
+    xSemaphoreTake(validation_mutex, portMAX_DELAY);
+    int slot_index = find_validation_slot(hash);
+    if (slot_index >= 0 && !validation_slots[slot_index].finishing
+        && (validation_slots[slot_index].phase_voters[phase-1] & (1 << voter_node_id)) == 0) {
+        validation_slot_t *slot = &validation_slots[slot_index];
+        slot->phase_voters[phase-1] |= (1 << voter_node_id);
+        slot->phase_acceptance[phase-1] += 1;
+        quorum_add_vote(&slot->certificate, voter_node_id, phases, signature);
+        publish_phase_votes(slot);
+        trace_mark(slot->trade_id, TRACE_PHASE_VOTE);
+        counted = 0;
+    }
+    xSemaphoreGive(validation_mutex);
+    return counted;
+}
+
+// Adjusts the duration of a block whose phases are over to the phases its votes accepted, and commits it
+void finish_validation(int slot_index) {
+    validation_slot_t *slot = &validation_slots[slot_index];
+
+    // Adjusted and hashed in the slot, so a block that already builds on the new hash finds its parent
+    xSemaphoreTake(validation_mutex, portMAX_DELAY);
+    struct block_t *block = slot->block;
+    uint32_t trade_id = slot->trade_id;
+    slot->finishing = true;
+    ESP_LOGW(TAG, "VALIDATION OF BLOCK %i>%i FINISHED. Amount of modules needed to approve a phase [%i]. PHASE_ACCEPTANCE_ARRAY:",
+        block->seller_node_id, block->buyer_node_id, quorum_needed(&slot->certificate));
+    for (int i = 0; i < sizeof(slot->phase_acceptance)/sizeof(slot->phase_acceptance[0]); i++) {
+        printf("%i ", slot->phase_acceptance[i]);
+    }
+    printf("\n");
+
+    // Duration adjustment. For each validated phase, 5 seconds are added to the trade deal duration.
+    // It is taken from the signed votes, so the certificate kept with the block proves it
+    block->duration = quorum_duration(&slot->certificate, quorum_needed(&slot->certificate));
+    block->certificate = (quorum_certificate_t *)malloc(sizeof(quorum_certificate_t));
+    if (block->certificate != NULL) {
+        memcpy(block->certificate, &slot->certificate, sizeof(quorum_certificate_t));
+    } else {
+        ESP_LOGE(TAG_QUORUM, "No memory for the quorum certificate, the block is committed without it");
+    }
+    ESP_LOGI(TAG, "Current Duration: %i", block->duration);
+    create_block_hash(block);
+    xSemaphoreGive(validation_mutex);
+
+    // Adds the block to the block tree, which makes it the new head if it wins the fork choice.
+    // The slot is freed under block_tree_mutex, so a received block always finds its parent in one of the two
+    struct block_t committed = *block;      // The block tree frees a block it does not take
+    xSemaphoreTake(block_tree_mutex, portMAX_DELAY);
+    uint32_t chain_height = commit_blocks(block, 1);
+    xSemaphoreTake(validation_mutex, portMAX_DELAY);
+    memset(slot, 0, sizeof(validation_slot_t));
+    xSemaphoreGive(validation_mutex);
+    xSemaphoreGive(block_tree_mutex);
+    trace_mark(trade_id, TRACE_COMMIT);
+    BINLOG(BINLOG_BLOCK_COMMITTED, chain_height, committed.seller_node_id, committed.buyer_node_id, committed.price, committed.duration);
+
+    trade_deal_is_open = true;
+    publish_chain_state();
+    dashboard_begin_update(&dashboard_snapshot)->phase_amount = 0;
+    dashboard_end_update(&dashboard_snapshot);
+}
+
+/* Task for listening for other modules "phase acceptance" broadcasts. A vote counts for the block being validated
+ * that it names by hash, and a block is added to the chain once its duration plus 2 extra seconds have passed */
 void blockchain_phase_listener(void *pParam) {
-    struct block_t *myBlock = (struct block_t *)pParam;
     ESP_LOGI(TAG, "BLOCKCHAIN_PHASE_LISTENER STARTED");
-    ESP_LOGI(TAG, "Buyer:%i | Seller %i", myBlock->buyer_node_id, myBlock->seller_node_id);
 
-    memset(phase_acceptance_array, 0, sizeof(phase_acceptance_array));
     // Create Blockchain socket
     int udp_sock = create_udp_socket();
     int port = 8889;
@@ -233,86 +1105,432 @@ void blockchain_phase_listener(void *pParam) {
     msg.msg_name = (struct sockaddr *)&source_addr;
     msg.msg_namelen = socklen;
 
-    // Get the time in microseconds (The task start time)
-    int64_t phase_task_start_time = esp_timer_get_time();
+    // Because we do not want to block on our upd sock we must construct and set a new file descripter
+    fd_set readfds;
+    
+    struct timeval timeout;
+
+    // Message data.
+    struct broadcast_data_t MsgData;
+
+    // A node only has a few votes to send per block, so one flooding this port is cut off before decoding
+    ingress_limiter_t limiter;
+    ingress_limiter_init(&limiter);
+    // Without the filter a copy of a vote is decoded and verified again, but still only counted once
+    dedup_filter_t *dedup = (dedup_filter_t *)malloc(sizeof(dedup_filter_t));
+    if (dedup != NULL) {
+        dedup_init(dedup, esp_timer_get_time() / 1000);
+    } else {
+        ESP_LOGE(TAG, "No memory for the duplicate filter of the phase listener");
+    }
+
+    while (1) {
+        // Commit the blocks whose phases are over. Only this task frees a slot
+        int64_t now_us = esp_timer_get_time();
+        for (int i = 0; i < VALIDATION_SLOTS; i++) {
+            xSemaphoreTake(validation_mutex, portMAX_DELAY);
+            bool over = (validation_slots[i].block != NULL && now_us >= validation_slots[i].deadline_us);
+            xSemaphoreGive(validation_mutex);
+            if (over) {
+                finish_validation(i);
+            }
+        }
+
+        FD_ZERO(&readfds);
+        FD_SET(udp_sock, &readfds);
+        timeout.tv_sec = 1;  // Set timeout to 1 seconds, so deadlines are checked without votes coming in
+        timeout.tv_usec = 0;
+        // Select returns of the status of the socket. Return 0 if it hits a timeout, -1 if an error occured and a positive number if a message is received
+        int result = select(udp_sock + 1, &readfds, NULL, NULL, &timeout);
+        if (result == 0) {
+            continue;
+        } else if (result < 0) {
+            ESP_LOGE(TAG, "Socket has error!? [%i]", result);
+            vTaskDelay(1000 / portTICK_PERIOD_MS);
+            continue;
+        } 
+
+        memset(rx_buffer, 0, sizeof(rx_buffer));
+        int len = recvmsg(udp_sock, &msg, 0);
+        if (len < 0) {
+            ESP_LOGE(TAG, "recvfrom failed: errno %d", errno); 
+            continue;
+        }
+
+        if (ingress_classify(rx_buffer, len) == INGRESS_UNKNOWN) {
+            metrics_counter_add(packet_unknown_header_metric, 1);
+            continue;
+        }
+        if (dedup != NULL && dedup_seen(dedup, source_addr.sin_addr.s_addr, rx_buffer, len, esp_timer_get_time() / 1000)) {
+            metrics_counter_add(packet_duplicate_metric, 1);
+            continue;
+        }
+        if (!ingress_admit(&limiter, source_addr.sin_addr.s_addr, esp_timer_get_time() / 1000)) {
+            metrics_counter_add(packet_rate_limited_metric, 1);
+            continue;
+        }
+        
+        // Decode the payload and pass the data into the MsgData struct by reference
+        payload_decoder(rx_buffer, len, &MsgData);
+        count_received_packet(2, &MsgData);
+
+        if (MsgData.type == BROADCAST_PHASE_ACCEPTANCE) {
+            // The duration the block is validated with, from the slot of the block the vote is for
+            xSemaphoreTake(validation_mutex, portMAX_DELAY);
+            int slot_index = find_validation_slot(MsgData.hash);
+            int voted_duration = (slot_index >= 0) ? validation_slots[slot_index].block->duration : 0;
+            bool voted_before = (slot_index >= 0 && validation_check_node_id(MsgData.node_id) == 0 && MsgData.phase >= 1 && MsgData.phase <= 60/5
+                && (validation_slots[slot_index].phase_voters[MsgData.phase-1] & (1 << MsgData.node_id)) != 0);
+            xSemaphoreGive(validation_mutex);
+            bool matches_block = (slot_index >= 0);
+            BINLOG(BINLOG_PHASE_ACCEPTANCE, MsgData.node_id, MsgData.phase, matches_block);
+
+            if (!matches_block)
+                continue;
+            // The signed phases must include the phase the vote is for
+            if (validation_record_bool(VALIDATION_HEADER, validation_check_node_id(MsgData.node_id) == 0 && validation_check_phase(MsgData.phase, voted_duration) == 0
+                && (MsgData.phases & (1 << (MsgData.phase-1))) != 0) != 0)
+                continue;
+            if (validation_record(VALIDATION_MEMBERSHIP, validation_check_member(foreign_public_key_array, MsgData.node_id)) != 0)
+                continue;
+            if (validation_record_bool(VALIDATION_REPLAY, !voted_before) != 0)
+                continue;
+            
+            // The vote goes into the quorum certificate, so it only counts with a valid signature. Verified
+            // without the lock, count_phase_vote checks again that the node did not vote meanwhile
+            uint8_t vote_msg[256];
+            quorum_vote_message(vote_msg, sizeof(vote_msg), MsgData.node_id, MsgData.phases, MsgData.hash);
+            if (verify_node_signature(MsgData.node_id, vote_msg, sizeof(vote_msg), (uint8_t *)MsgData.signature) != 0)
+                continue;
+
+            count_phase_vote(MsgData.hash, MsgData.node_id, MsgData.phase, MsgData.phases, (uint8_t *)MsgData.signature);
+        }
+    }
+
+    vTaskDelete(NULL);
+}
+
+// Starts validating the phases of a block, the phase listener commits it when its phases are over.
+// Returns 0, 1 if the block is being validated already, or -1 if every slot is taken. The block is only kept on 0
+int validate_block_phases(struct block_t *block) {
+    uint16_t members = get_laset_module_members(foreign_public_key_array);
+    int needed_laset_amount = 0;
+
+    xSemaphoreTake(validation_mutex, portMAX_DELAY);
+    int slot_index = -1;
+    bool validating = (find_validation_slot(block->hash) >= 0);
+    if (!validating) {
+        for (int i = 0; i < VALIDATION_SLOTS; i++) {
+            if (validation_slots[i].block == NULL) {
+                slot_index = i;
+                break;
+            }
+        }
+    }
+    if (slot_index >= 0) {
+        validation_slot_t *slot = &validation_slots[slot_index];
+        memset(slot, 0, sizeof(validation_slot_t));
+        slot->block = block;
+        slot->deadline_us = esp_timer_get_time() + (int64_t)(block->duration + 2) * 1000 * 1000;
+        // The duration is adjusted when the block is committed, so the trade id is taken from the agreed duration now
+        slot->trade_id = trace_trade_id(block->seller_node_id, block->price, block->duration);
+        quorum_init(&slot->certificate, block->hash, block->duration, members);
+        needed_laset_amount = quorum_needed(&slot->certificate);
+
+        dashboard_state_t *dashboard_state = dashboard_begin_update(&dashboard_snapshot);
+        dashboard_state->phase_amount = block->duration / 5;
+        dashboard_state->quorum = needed_laset_amount;
+        dashboard_end_update(&dashboard_snapshot);
+        publish_phase_votes(slot);
+    }
+    xSemaphoreGive(validation_mutex);
+
+    if (validating) {
+        return 1;
+    }
+    if (slot_index < 0) {
+        return -1;
+    }
+    ESP_LOGI(TAG, "Validating block %i>%i in slot %i, [%i/%i] modules needed to approve a phase", block->seller_node_id,
+        block->buyer_node_id, slot_index, needed_laset_amount, get_laset_module_amount(foreign_public_key_array));
+    return 0;
+}
+
+// Proposes an own block: starts validating its phases and broadcasts it as a bcb. Returns 0, or -1 if no
+// validation slot is free, the block is freed then
+int propose_block(int *udp_sock, struct block_t *block) {
+    // FORMAT: Header(char 3), Duration(int), Price(int), sellerNodeID(int), buyerNodeID(int), sellerSignature, buyerSignature, blockHash, previousBlockHash
+    // sizeof(char)*5 is the room for the commas
+    int block_msg_size = sizeof(char)*3 + sizeof(int)*4 + sizeof(char)*5 + SIGNATURE_SIZE + SHA256_HASH_SIZE*2;
+    char block_msg[block_msg_size];
+    memset(block_msg, 0, sizeof(block_msg));
+    construct_block_message(block, &block_msg[0]);    // Put the values of the block into the buffer
+
+    // Begin to listen for phases from the other LASET modules. The block belongs to the phase listener
+    // from here on, only the message and the copy are used below
+    struct block_t broadcast_block = *block;
+    if (validate_block_phases(block) != 0) {
+        free(block);
+        return -1;
+    }
+
+    // Broadcast block
+    send_udp_message(udp_sock, 1, block_msg, block_msg_size, "0.0.0.0", 8888);
+    trace_mark(trace_trade_id(broadcast_block.seller_node_id, broadcast_block.price, broadcast_block.duration), TRACE_BCB_BROADCAST);
+    BINLOG(BINLOG_BLOCK_BROADCAST, broadcast_block.seller_node_id, broadcast_block.price, broadcast_block.duration, broadcast_block.buyer_node_id);
+    return 0;
+}
+
+// Asks a station whose chain state differs for its blocks. The blocks above the last final one may be on another
+// branch, so they are asked for again. For its snapshot the height is 0, which is below every block it still keeps
+void request_chain_sync(int udp_sock, const char *destination_ip, const chain_digest_t *own, chain_digest_sync_t sync) {
+    uint32_t sync_height = (own->height > BLOCK_TREE_CONFIRMATIONS) ? own->height - BLOCK_TREE_CONFIRMATIONS : 0;
+    if (sync == CHAIN_DIGEST_SYNC_SNAPSHOT) {
+        sync_height = 0;
+    }
+    char rcs_msg[32];
+    snprintf(rcs_msg, sizeof(rcs_msg), "rcs,%d,%lu;", node_id, (unsigned long)sync_height);
+    metrics_counter_add(chain_sync_metric, 1);
+    send_udp_message(udp_sock, 0, rcs_msg, strlen(rcs_msg), destination_ip, 7777);
+}
+
+// Answers a chain sync (rcs): sends the blocks of the own branch above height with their quorum certificates to
+// the CHAIN_SYNC_PORT of the station, oldest first so each finds its parent. Blocks without a certificate are not
+// sent. Each block is encoded under block_tree_mutex and sent after it is released. Only called by the laset listener
+void send_committed_blocks(int udp_sock, const char *destination_ip, uint32_t height) {
+    static char block_msg[CHAIN_SYNC_FRAME_SIZE];
+    int sent = 0;
+
+    for (uint32_t next_height = height + 1; sent < CHAIN_SYNC_BLOCKS; next_height++) {
+        xSemaphoreTake(block_tree_mutex, portMAX_DELAY);
+        struct block_t *block = block_tree_head(&block_tree);
+        uint32_t block_height = block_tree_height(&block_tree);
+        while (block != NULL && block != -1 && block_height > next_height) {
+            block = block->previous_block;
+            block_height--;
+        }
+        bool kept = (block != NULL && block != -1 && block_height == next_height);
+        int block_msg_size = kept ? construct_committed_block_message(block, block_msg, sizeof(block_msg)) : -1;
+        xSemaphoreGive(block_tree_mutex);
+
+        if (!kept) {
+            break;      // Above the head, or no longer kept
+        }
+        if (block_msg_size < 0) {
+            continue;
+        }
+        send_udp_message(udp_sock, 0, block_msg, block_msg_size, destination_ip, CHAIN_SYNC_PORT);
+        sent++;
+    }
+    ESP_LOGI(TAG_CHAIN_DIGEST, "[RCS] Sent %i blocks above height %lu to %s", sent, (unsigned long)height, destination_ip);
+}
+
+// Answers a chain sync from a station that is behind the blocks kept here: sends the ledger as it is at the final
+// block (psn), signed, to the CHAIN_SYNC_PORT of the station. Only called by the laset listener
+void send_ledger_snapshot(int udp_sock, const char *destination_ip) {
+    static uint8_t encoded[LEDGER_SNAPSHOT_MAX_SIZE];
+    static char snapshot_msg[CHAIN_SYNC_FRAME_SIZE];
+
+    xSemaphoreTake(ledger_mutex, portMAX_DELAY);
+    uint32_t height = ledger.state.height;
+    int length = ledger_snapshot_encode(&ledger.state, encoded, sizeof(encoded));
+    xSemaphoreGive(ledger_mutex);
+
+    uint8_t signature[PSA_SIGNATURE_MAX_SIZE] = {0};
+    size_t signature_length;
+    if (length < 0 || sign_message(key_pair, encoded, length, signature, &signature_length) != 0) {
+        ESP_LOGE(TAG_LEDGER, "Could not sign the snapshot at height %lu", (unsigned long)height);
+        return;
+    }
+
+    // FORMAT: Header(char 3), nodeID, snapshotLength, snapshot, signature
+    int header_length = snprintf(snapshot_msg, sizeof(snapshot_msg), "psn,%d,%d,", node_id, length);
+    memcpy(snapshot_msg + header_length, encoded, length);
+    memcpy(snapshot_msg + header_length + length, signature, SIGNATURE_SIZE/2);
+    send_udp_message(udp_sock, 0, snapshot_msg, header_length + length + SIGNATURE_SIZE/2, destination_ip, CHAIN_SYNC_PORT);
+    ESP_LOGI(TAG_CHAIN_DIGEST, "[RCS] Sent the snapshot at height %lu, %i bytes, to %s", (unsigned long)height, length, destination_ip);
+}
+
+// Adds a block another station committed (cbk). Its phases are not validated again, the quorum certificate
+// shows the duration. Returns 0, or -1 if the block is known already or fails verification
+int add_committed_block(struct broadcast_data_t *MsgData) {
+    if (validation_record(VALIDATION_HEADER, validation_check_block_header(MsgData->node_id, MsgData->node_id_extra, MsgData->price, MsgData->duration_m)) != 0)
+        return -1;
+    if (validation_record_bool(VALIDATION_MEMBERSHIP, validation_check_member(foreign_public_key_array, MsgData->node_id) == 0
+            && validation_check_member(foreign_public_key_array, MsgData->node_id_extra) == 0) != 0)
+        return -1;
+    xSemaphoreTake(block_tree_mutex, portMAX_DELAY);
+    bool known_block = block_tree_contains(&block_tree, MsgData->hash);
+    xSemaphoreGive(block_tree_mutex);
+    if (validation_record_bool(VALIDATION_REPLAY, !known_block) != 0)
+        return -1;
+
+    quorum_certificate_t *certificate = (quorum_certificate_t *)malloc(sizeof(quorum_certificate_t));
+    if (certificate == NULL || quorum_decode(MsgData->certificate, MsgData->certificate_length, certificate) != 0) {
+        free(certificate);
+        return -1;
+    }
+    struct block_t *block = create_block(
+        MsgData->previous_hash,
+        MsgData->node_id,
+        MsgData->price,
+        MsgData->duration_m,
+        &MsgData->signature,
+        MsgData->node_id_extra,
+        &MsgData->signature_extra,
+        -1      // Linked by the block tree when it is committed
+    );
+    block->certificate = certificate;
+
+    if (validation_record(VALIDATION_HASH, validation_check_hash(block->hash, MsgData->hash)) != 0
+        || verify_block_certificate(block) != 0) {
+        free_block(block);
+        return -1;
+    }
+    // A bcd trade carries the signatures of both modules. An auction block carries the signatures of the orders
+    // it clears, which were verified when the orders came in, so it is only taken if it matches an allocation
+    // cleared here
+    bool cleared_here = false;
+    if (AUCTION_MODE) {
+        xSemaphoreTake(auction_book_mutex, portMAX_DELAY);
+        cleared_here = (auction_pending_cleared(&auction_pending, block) == 0);
+        xSemaphoreGive(auction_book_mutex);
+    }
+    if (validation_record(VALIDATION_SIGNATURE, cleared_here ? 0 : verify_block_signatures(block, foreign_public_key_array)) != 0) {
+        ESP_LOGE(TAG_CHAIN_DIGEST, "[CBK] Could not verify the signatures of block %i>%i, discarding..", block->seller_node_id, block->buyer_node_id);
+        free_block(block);
+        return -1;
+    }
+
+    // Blocks arrive oldest first, a block whose parent is still missing waits as an orphan
+    xSemaphoreTake(block_tree_mutex, portMAX_DELAY);
+    uint32_t chain_height = commit_blocks(block, 1);
+    xSemaphoreGive(block_tree_mutex);
+    ESP_LOGI(TAG_CHAIN_DIGEST, "[CBK] Added block %i>%i, chain height %lu", MsgData->node_id, MsgData->node_id_extra, (unsigned long)chain_height);
+    return 0;
+}
+
+// Continues from a snapshot of the peers: the ledger takes its state, and the block tree drops every block and
+// starts again on its tip. Returns 0, or -1 if the station got to the height of the snapshot meanwhile
+int adopt_ledger_snapshot(const ledger_state_t *snapshot) {
+    xSemaphoreTake(block_tree_mutex, portMAX_DELAY);
+    xSemaphoreTake(ledger_mutex, portMAX_DELAY);
+    if (snapshot->height <= ledger.state.height) {
+        xSemaphoreGive(ledger_mutex);
+        xSemaphoreGive(block_tree_mutex);
+        return -1;
+    }
+    ledger_restore(&ledger, snapshot);
+    if (LEDGER_PERSIST_SNAPSHOTS) {
+        store_ledger_snapshot(snapshot);
+    }
+    xSemaphoreGive(ledger_mutex);
+    chain_set_anchor((const char *)snapshot->tip_hash);
+
+    // Published before the tree drops the blocks, the old head may be one of them
+    chain_tip_t tip = { .block = NULL, .height = snapshot->height };
+    memcpy(tip.hash, snapshot->tip_hash, SHA256_HASH_SIZE);
+    int reader;
+    const chain_tip_t *current = read_chain_tip(&reader);
+    if (chain_tip_publish(current, &tip) != 0) {
+        ESP_LOGE(TAG_CHAIN_TIP, "The chain tip was replaced outside block_tree_mutex");
+    }
+    chain_tip_read_end(reader);
+    block_tree_reset(&block_tree, (const char *)snapshot->tip_hash, snapshot->height);
+    update_chain_digest(&tip);
+    xSemaphoreGive(block_tree_mutex);
 
-    // Because we do not want to block on our upd sock we must construct and set a new file descripter
-    fd_set readfds;
-    
-    struct timeval timeout;
-    timeout.tv_sec = 1;  // Set timeout to 1 seconds
-    timeout.tv_usec = 0;
+    ESP_LOGW(TAG_LEDGER, "Continuing from the snapshot of the peers at height %lu", (unsigned long)snapshot->height);
+    return 0;
+}
 
-    // Message data.
+/* Task for the replies to a chain sync, which are larger than a packet of the pool. Committed blocks (cbk) are added
+ * with their certificates. A station that is behind the blocks its peers keep gets their snapshots (psn), and
+ * continues from the highest one CHAIN_SNAPSHOT_AGREEMENT members sent, or every other member when there are fewer.
+ * Members that are at different heights send different snapshots, so each one counts its own senders */
+void chain_sync_listener_task(void *pParam) {
+    ESP_LOGI(TAG, "ChainSyncListenerTask Started");
+
+    int udp_sock = create_udp_socket();
+    struct sockaddr_in local_addr;
+    local_addr.sin_addr.s_addr = htonl(INADDR_ANY);  // Listen on 0.0.0.0
+    local_addr.sin_family = AF_INET;
+    local_addr.sin_port = htons(CHAIN_SYNC_PORT);
+    if (bind(udp_sock, (struct sockaddr *)&local_addr, sizeof(local_addr)) < 0) {
+        ESP_LOGE(TAG, "Socket unable to bind: errno %d", errno);
+        vTaskDelete(NULL);
+        return;
+    }
+    ESP_LOGI(TAG, "\033[38;5;245m[UDP] Socket bound on " IPSTR ":%d", IP2STR(&node_ip), CHAIN_SYNC_PORT);
+
+    static char rx_buffer[CHAIN_SYNC_FRAME_SIZE];
+    static ledger_state_t received;
+    static ledger_candidates_t candidates;
+    ledger_candidates_init(&candidates);
     struct broadcast_data_t MsgData;
 
-    // Get the module amount.
-    int laset_module_amount = get_laset_module_amount(foreign_public_key_array);
-    int needed_laset_amount = (laset_module_amount*2)/3;    // E.g. 5 nodes on the network require 3 acknowledgements
-    
-    // Continue listening for phases as long as the duration of the trade deal plus 2 extra seconds
-    while( ((esp_timer_get_time() - phase_task_start_time) / (1000 * 1000)) < ( myBlock->duration + 2) ) {
-        FD_ZERO(&readfds);
-        FD_SET(udp_sock, &readfds);
-        // Select returns of the status of the socket. Return 0 if it hits a timeout, -1 if an error occured and a positive number if a message is received
-        int result = select(udp_sock + 1, &readfds, NULL, NULL, &timeout);
-        if (result == 0) {
-            continue;
-        } else if (result < 0) {
-            ESP_LOGE(TAG, "Socket has error!? [%i]", result);
-            continue;
-        } 
+    // A sync reply costs a signature check, so a node flooding this port is cut off before it
+    ingress_limiter_t limiter;
+    ingress_limiter_init(&limiter);
 
-        memset(rx_buffer, 0, sizeof(rx_buffer));
-        int len = recvmsg(udp_sock, &msg, 0);
+    while (1) {
+        struct sockaddr_in source_addr;
+        socklen_t socklen = sizeof(source_addr);
+        int len = recvfrom(udp_sock, rx_buffer, sizeof(rx_buffer), 0, (struct sockaddr *)&source_addr, &socklen);
         if (len < 0) {
-            ESP_LOGE(TAG, "recvfrom failed: errno %d", errno); 
-            break;
+            ESP_LOGE(TAG, "recvfrom failed: errno %d", errno);
+            vTaskDelay(1000 / portTICK_PERIOD_MS);
+            continue;
+        }
+        if (ingress_classify(rx_buffer, len) == INGRESS_UNKNOWN) {
+            metrics_counter_add(packet_unknown_header_metric, 1);
+            continue;
+        }
+        if (!ingress_admit(&limiter, source_addr.sin_addr.s_addr, esp_timer_get_time() / 1000)) {
+            metrics_counter_add(packet_rate_limited_metric, 1);
+            continue;
         }
-        
-        // Decode the payload and pass the data into the MsgData struct by reference
-        payload_decoder(rx_buffer, sizeof(rx_buffer) / sizeof(rx_buffer[0]), &MsgData);
 
-        if (MsgData.type == BROADCAST_PHASE_ACCEPTANCE) {
-            ESP_LOGW(TAG, "PhaseAcceptance received -> NodeId:%i Phase:%i Duration:%i", MsgData.node_id, MsgData.phase, MsgData.duration_m);
-            
-            if (memcmp(MsgData.hash, myBlock->hash, SHA256_HASH_SIZE) == 0) {
-                xSemaphoreTake(phase_acceptance_array_mutex, portMAX_DELAY);
-                phase_acceptance_array[MsgData.phase-1] += 1;
-                xSemaphoreGive(phase_acceptance_array_mutex);
+        payload_decoder(rx_buffer, len, &MsgData);
+        count_received_packet(3, &MsgData);
+        if (MsgData.type == COMMITTED_BLOCK) {
+            if (add_committed_block(&MsgData) != 0) {
+                ESP_LOGW(TAG_CHAIN_DIGEST, "[CBK] Block %i>%i is known already or failed verification, discarding..", MsgData.node_id, MsgData.node_id_extra);
+                continue;
             }
+            publish_chain_state();
+            continue;
+        }
+        if (MsgData.type != PROVIDE_SNAPSHOT || MsgData.node_id == node_id) {
+            continue;
+        }
+        if (validation_record(VALIDATION_MEMBERSHIP, validation_check_member(foreign_public_key_array, MsgData.node_id)) != 0)
+            continue;
+        if (verify_node_signature(MsgData.node_id, (uint8_t *)MsgData.snapshot, MsgData.snapshot_length, (uint8_t *)MsgData.signature) != 0)
+            continue;
+        if (ledger_snapshot_decode(MsgData.snapshot, MsgData.snapshot_length, &received) != 0) {
+            ESP_LOGW(TAG_LEDGER, "[PSN] Snapshot from node %i does not decode, discarding..", MsgData.node_id);
+            continue;
         }
-    }
-
-    /* ---- Validation finished, adjusting duration and adding to blockchain now ---- */
-    
-    int64_t phase_task_current_time = (esp_timer_get_time() - phase_task_start_time) / (1000 * 1000);
-
-    ESP_LOGW(TAG, "VALIDATION OF BLOCK FINISHED. Amount of modules needed to approve a phase [%i/%i]", needed_laset_amount, laset_module_amount);
-    ESP_LOGE(TAG, "Time elapsed: %llu seconds. PHASE_ACCEPTANCE_ARRAY:", phase_task_current_time);
 
-    // Duration adjustment. For each validated phase, 5 seconds are added to the trade deal duration
-    myBlock->duration = 0;
-    for (int i = 0; i < sizeof(phase_acceptance_array)/sizeof(phase_acceptance_array[0]); i++) {
-        printf("%i ", phase_acceptance_array[i]);
-        if (phase_acceptance_array[i] >= needed_laset_amount) {
-            myBlock->duration += 5;
+        xSemaphoreTake(ledger_mutex, portMAX_DELAY);
+        uint32_t final_height = ledger.state.height;
+        xSemaphoreGive(ledger_mutex);
+        // One member could send any ledger, so it is only taken when others sent the same
+        int senders = ledger_candidates_add(&candidates, &received, MsgData.node_id, final_height);
+        if (senders < 0) {
+            continue;
+        }
+        int others = get_laset_module_amount(foreign_public_key_array) - 1;
+        int needed = (others < CHAIN_SNAPSHOT_AGREEMENT) ? others : CHAIN_SNAPSHOT_AGREEMENT;
+        ESP_LOGI(TAG_LEDGER, "[PSN] Snapshot at height %lu from node %i, [%i/%i] members agree", (unsigned long)received.height, MsgData.node_id, senders, needed);
+        const ledger_state_t *agreed = ledger_candidates_agreed(&candidates, needed);
+        if (agreed != NULL && adopt_ledger_snapshot(agreed) == 0) {
+            ledger_candidates_init(&candidates);
+            publish_chain_state();
         }
     }
-    printf("\n");
-    ESP_LOGI(TAG, "Current Duration: %i", myBlock->duration);
-    
-    // Update hash to fit with the new duration.
-    create_block_hash(myBlock);
-    // Adds the block as the new head of the chain
-    chain_head = myBlock;
-    print_blocks(chain_head);
-
-    // Closing socket and opening for new trades
-    shutdown(udp_sock, 0);
-    close(udp_sock);
-    trade_deal_is_open = true;
-    
+
     vTaskDelete(NULL);
 }
 
@@ -323,18 +1541,13 @@ void laset_listener_task(void *pParam) {
 
     uint8_t verification_msg[256];
     memset(verification_msg, 0, sizeof(verification_msg));
-    
-    char null_key[PUBLIC_KEY_SIZE];
-    memset(null_key, 0, PUBLIC_KEY_SIZE);
 
-    static node_key_credentials_t nkc;
-    static node_public_key_t provided_npk;
-
-    // Construct "ppk,RSA_BITS_IN_PUBLIC_KEY;"
-    const char ppk_msg[npk.public_key_length+5]; 
-    sprintf(ppk_msg, "ppk,");
-    memcpy(ppk_msg+4, npk.public_key_buffer, npk.public_key_length+4);
-    sprintf(ppk_msg + npk.public_key_length+4, ";");
+    // Construct "ppk,NODE_ID,RAW_PUBLIC_KEY", the reply to a rpk for this node's key
+    char ppk_msg[16 + PUBLIC_KEY_SIZE];
+    memset(ppk_msg, 0, sizeof(ppk_msg));
+    sprintf(ppk_msg, "ppk,%d,", node_id);
+    int ppk_msg_size = strlen(ppk_msg) + PUBLIC_KEY_SIZE;
+    memcpy(ppk_msg + strlen(ppk_msg), npk.public_key_buffer, PUBLIC_KEY_SIZE);
 
     // Cast the void pointer back to the correct type
     TaskParameters *params = (TaskParameters *)pParam;
@@ -355,83 +1568,134 @@ void laset_listener_task(void *pParam) {
     }
     ESP_LOGI(TAG, "\033[38;5;245m[UDP] Socket bound on " IPSTR ":%d", IP2STR(&node_ip), port);
 
-    struct sockaddr_in source_addr;
-    socklen_t socklen = sizeof(source_addr);
-
-    struct iovec iov;
-    struct msghdr msg;
-
-    u8_t cmsg_buf[CMSG_SPACE(sizeof(struct in_pktinfo))];
-
-    // Receive buffer
-    char rx_buffer[512];
-    iov.iov_base = rx_buffer;
-    iov.iov_len = sizeof(rx_buffer);
-
-    msg.msg_control = cmsg_buf;
-    msg.msg_controllen = sizeof(cmsg_buf);
-    msg.msg_flags = 0;
-    msg.msg_iov = &iov;
-    msg.msg_iovlen = 1;
-    msg.msg_name = (struct sockaddr *)&source_addr;
-    msg.msg_namelen = socklen;
+    // Packets are received by their own task, this task only handles them
+    ingress_queues_t *ingress = start_udp_receiver(udp_sock, "LasetReceiverTask");
+    chain_digest_replies_t chain_sync_replies;
+    chain_digest_replies_init(&chain_sync_replies);
+    packet_t *packet = NULL;
     
     // Message data.
     struct broadcast_data_t MsgData;
 
     while(1) {
-        // A small delay to avoid watchdog intervention
-        vTaskDelay(100 / portTICK_PERIOD_MS);
-        memset(rx_buffer, 0, sizeof(rx_buffer));
-
-        int len = recvmsg(udp_sock, &msg, 0);
-        if (len < 0) {
-            ESP_LOGE(TAG, "recvfrom failed: errno %d", errno);
-            break;
+        // Done with the previous packet, also when it was skipped with continue
+        if (packet != NULL) {
+            packet_release(packet);
         }
-        char client_ip[15]; // Convert source_addr to a string
-        inet_ntop(AF_INET, &(source_addr.sin_addr), client_ip, INET_ADDRSTRLEN);
+        packet = receive_next_packet(ingress);
+
+        char client_ip[16]; // Convert the source address to a string
+        inet_ntop(AF_INET, &packet->source_ip, client_ip, sizeof(client_ip));
 
         // Decode the payload and pass the data into the MsgData struct, by reference.
-        payload_decoder(rx_buffer, sizeof(rx_buffer) / sizeof(rx_buffer[0]), &MsgData);
+        payload_decoder(packet->data, packet->length, &MsgData);
+        count_received_packet(0, &MsgData);
         
         /* Handles different headers for each if statement */
         if (MsgData.type == PROVIDE_AMPERAGE_READING) {
-            ESP_LOGI(TAG, "\033[38;5;198mReceived amperage reading %i from node %i", MsgData.amperage, MsgData.node_id);
+            BINLOG(BINLOG_AMPERAGE_RECEIVED, MsgData.amperage, MsgData.node_id);
             updateGridLoad(MsgData.node_id, MsgData.amperage);
         }
         else if (MsgData.type == BROADCAST_AMPERAGE) {
-            ESP_LOGI(TAG, "\033[38;5;198mReceived amperage reading %i from node %i, with public key: %s.", MsgData.amperage, MsgData.node_id, MsgData.public_key);
+            BINLOG(BINLOG_AMPERAGE_RECEIVED, MsgData.amperage, MsgData.node_id);
+            if (MsgData.node_id < 0 || MsgData.node_id >= PK_KEY_ARRAY_SIZE) {
+                continue;
+            }
             updateGridLoad(MsgData.node_id, MsgData.amperage);
-            updatePublicKey(MsgData.node_id, MsgData.public_key);
+
+            // Follow the auction time of a member that is ahead, the own one is announced from then on
+            if (MsgData.node_id != node_id && validation_check_member(foreign_public_key_array, MsgData.node_id) == 0) {
+                int64_t announced_ms = auction_clock_decode((uint8_t *)MsgData.auction_clock);
+                xSemaphoreTake(auction_book_mutex, portMAX_DELAY);
+                bool moved = auction_clock_observe(&auction_clock, esp_timer_get_time() / 1000, announced_ms);
+                xSemaphoreGive(auction_book_mutex);
+                if (moved) {
+                    ESP_LOGI(TAG_AUCTION, "Auction time follows node %i, slot %lu", MsgData.node_id, (unsigned long)auction_slot_from_clock(announced_ms));
+                }
+            }
+
+            // Unknown or changed key, so request the full key from the node
+            memcpy(announced_key_fingerprint_array[MsgData.node_id], MsgData.key_fingerprint, KEY_FINGERPRINT_SIZE);
+            if (memcmp(foreign_key_fingerprint_array[MsgData.node_id], MsgData.key_fingerprint, KEY_FINGERPRINT_SIZE) != 0) {
+                char rpk_msg[16];
+                sprintf(rpk_msg, "rpk,%d;", MsgData.node_id);
+                ESP_LOGI(TAG, "[RPK] Requesting public key of node %i", MsgData.node_id);
+                send_udp_message(udp_sock, 0, rpk_msg, strlen(rpk_msg), client_ip, 7777);
+            }
+
+            // A station whose chain state keeps differing, and that is not behind, is asked for its blocks
+            chain_digest_t announced;
+            chain_digest_decode((uint8_t *)MsgData.chain_digest, &announced);
+            xSemaphoreTake(block_tree_mutex, portMAX_DELAY);
+            chain_digest_t own = chain_digest;
+            xSemaphoreGive(block_tree_mutex);
+            chain_digest_sync_t sync = (MsgData.node_id == node_id) ? CHAIN_DIGEST_SYNC_NONE
+                : chain_digest_observe(&chain_digest_peers, MsgData.node_id, &own, &announced, esp_timer_get_time() / 1000);
+            if (sync != CHAIN_DIGEST_SYNC_NONE) {
+                ESP_LOGW(TAG_CHAIN_DIGEST, "[RCS] Chain state differs from node %i (height %lu, own %lu), requesting its %s",
+                    MsgData.node_id, (unsigned long)announced.height, (unsigned long)own.height, (sync == CHAIN_DIGEST_SYNC_SNAPSHOT) ? "snapshot" : "blocks");
+                request_chain_sync(params->udp_sock, client_ip, &own, sync);
+            }
         }
-        else if (MsgData.type == ACCEPT_TRADE_DEAL) {
-            if (trade_deal_is_open != true) { // trade deal has already been accepted
-                ESP_LOGI(TAG, "[ATD] Trade deal was denied, since a buyer was already found!");
+        else if (MsgData.type == REQUEST_CHAIN_SYNC) {
+            // The request is not signed and the answer is much larger, so every source is answered only so often
+            if (MsgData.node_id == node_id || !chain_digest_may_reply(&chain_sync_replies, packet->source_ip, esp_timer_get_time() / 1000)) {
+                continue;
+            }
+            // Blocks up to the root are no longer kept, so a station that needs them gets the ledger instead
+            xSemaphoreTake(block_tree_mutex, portMAX_DELAY);
+            uint32_t root_height = block_tree_root_height(&block_tree);
+            xSemaphoreGive(block_tree_mutex);
+            if (MsgData.height < root_height) {
+                send_ledger_snapshot(params->udp_sock, client_ip);
+            } else {
+                send_committed_blocks(params->udp_sock, client_ip, MsgData.height);
+            }
+        }
+        else if (MsgData.type == REQUEST_PROFILE_DUMP) {
+            profiler_dump();
+        }
+        else if (MsgData.type == REQUEST_TRACE_DUMP) {
+            trace_print_report();
+        }
+        else if (MsgData.type == REQUEST_PUBLIC_KEY) {
+            if (MsgData.node_id != node_id) {
+                continue;
+            }
+            send_udp_message(udp_sock, 0, ppk_msg, ppk_msg_size, client_ip, 7777);
+        }
+        else if (MsgData.type == PROVIDE_PUBLIC_KEY) {
+            if (MsgData.node_id < 0 || MsgData.node_id >= PK_KEY_ARRAY_SIZE || MsgData.node_id == node_id) {
                 continue;
             }
-            ESP_LOGI(TAG, "\033[38;5;198mReceived accept trade deal from node %i with signature: %s", MsgData.node_id, MsgData.signature);
-            
-            /* ---- Verification Process ---- */
 
-            if (memcmp(foreign_public_key_array[MsgData.node_id], &null_key, PUBLIC_KEY_SIZE) == 0) {
-                ESP_LOGW(TAG, "No public key found for node id <%i>. Cannot validate this atd!", MsgData.node_id);
+            // Only cache the key the node announced itself
+            uint8_t provided_fingerprint[KEY_FINGERPRINT_SIZE];
+            key_fingerprint((const uint8_t *)MsgData.public_key, PUBLIC_KEY_SIZE, provided_fingerprint);
+            if (memcmp(provided_fingerprint, announced_key_fingerprint_array[MsgData.node_id], KEY_FINGERPRINT_SIZE) != 0) {
+                ESP_LOGW(TAG, "[PPK] Public key from node %i does not match its announced fingerprint", MsgData.node_id);
                 continue;
             }
-            // If we made it here, that means we have received a foreign public key - now lets import key!
-            ESP_LOGE(TAG, "Found a foreign public key! <%s>", foreign_public_key_array[MsgData.node_id]);
+            ESP_LOGI(TAG, "[PPK] Cached public key of node %i", MsgData.node_id);
+            updatePublicKey(MsgData.node_id, MsgData.public_key);
+        }
+        else if (MsgData.type == ACCEPT_TRADE_DEAL) {
+            BINLOG(BINLOG_ACCEPT_RECEIVED, MsgData.node_id);
             
-            // Import public key
-            memcpy(provided_npk.public_key_buffer, foreign_public_key_array[MsgData.node_id], PUBLIC_KEY_SIZE);
-            provided_npk.public_key_length = PUBLIC_KEY_SIZE;
-            int status = import_public_key(provided_npk, &nkc);
-            if (status != 0)
-                continue;
+            /* ---- Verification Process ---- */
 
             // Convert hex to binary
             uint8_t binary_signature[SIGNATURE_SIZE / 2]; // Since each byte is represented by 2 hex characters
-            for (size_t i = 0; i < SIGNATURE_SIZE / 2; i++) {
-                sscanf(MsgData.signature + 2 * i, "%2hhx", &binary_signature[i]);
+            bool signature_decoded = hex_decode(MsgData.signature, SIGNATURE_SIZE, binary_signature, sizeof(binary_signature)) == sizeof(binary_signature);
+            if (validation_record_bool(VALIDATION_HEADER, validation_check_node_id(MsgData.node_id) == 0 && signature_decoded) != 0)
+                continue;
+            if (validation_record(VALIDATION_MEMBERSHIP, validation_check_member(foreign_public_key_array, MsgData.node_id)) != 0) {
+                ESP_LOGW(TAG, "No public key found for node id <%i>. Cannot validate this atd!", MsgData.node_id);
+                continue;
+            }
+            if (validation_record_bool(VALIDATION_REPLAY, trade_deal_is_open) != 0) { // trade deal has already been accepted
+                ESP_LOGI(TAG, "[ATD] Trade deal was denied, since a buyer was already found!");
+                continue;
             }
 
             // Verifying the authenticity of the message
@@ -439,27 +1703,22 @@ void laset_listener_task(void *pParam) {
             memset(msg_to_verify, 0, sizeof(msg_to_verify));
             snprintf((char *)msg_to_verify, sizeof(msg_to_verify), "atd,%i", MsgData.node_id);
 
-            int verify_status = verify_message(nkc, msg_to_verify, sizeof(msg_to_verify), binary_signature, 64);
-            if (verify_status != 0)
+            if (verify_node_signature(MsgData.node_id, msg_to_verify, sizeof(msg_to_verify), binary_signature) != 0)
                 continue;
 
             trade_deal_is_open = false; // Don't accept multiple offers on the same deal (re-open if buyer cannot be verified)
+            publish_chain_state();
+            trace_mark(trace_trade_id(node_id, trade_data.price, trade_data.duration), TRACE_ATD_VERIFIED);
             
             // The drafted block
             struct block_t *draft_block;
             char previous_block_hash[SHA256_HASH_SIZE];
             
             // Push the trade deal onto a block and broadcast it
-            // If it is the first block in the chain create a default block
-            if (chain_head == -1) {
-                // SET PREVIOUS HASH TO BE "BASE HASH"
-                memset(previous_block_hash, 48, SHA256_HASH_SIZE); // 48 is as 0x30, which is interpreted as 0 in ascii
-            } else {
-                // If a previous block exits
-                memcpy(previous_block_hash, chain_head->hash, SHA256_HASH_SIZE);
-            }
-            ESP_LOGI(TAG, "\033[48;5;128mBROADCASTING BLOCK!, BLOCK SIZE: %i", sizeof(struct block_t));
-            
+            // If it is the first block in the chain, it links to the "base hash" (or the anchor of a restored snapshot)
+            int reader;
+            memcpy(previous_block_hash, read_chain_tip(&reader)->hash, SHA256_HASH_SIZE);
+            chain_tip_read_end(reader);
             draft_block = create_block(
                 previous_block_hash, 
                 node_id,
@@ -468,24 +1727,56 @@ void laset_listener_task(void *pParam) {
                 trade_data.signature, 
                 MsgData.node_id,
                 binary_signature,
-                chain_head
+                -1      // Linked by the block tree when it is committed
             );
             
-            // FORMAT: Header(char 3), Duration(int), Price(int), sellerNodeID(int), buyerNodeID(int), sellerSignature, buyerSignature, blockHash, previousBlockHash
-            // sizeof(char)*5 is the room for the commas
-            int block_msg_size = sizeof(char)*3 + sizeof(int)*4 + sizeof(char)*5 + SIGNATURE_SIZE + SHA256_HASH_SIZE*2;
-            char block_msg[block_msg_size];
-            memset(block_msg, 0, sizeof(block_msg));
-            construct_block_message(draft_block, &block_msg[0]);    // Put the values of the block into the buffer
+            if (propose_block(udp_sock, draft_block) != 0) {
+                ESP_LOGE(TAG, "No validation slot is free for the own block, reopening the trade deal");
+                trade_deal_is_open = true;
+                publish_chain_state();
+            }
+        }
+        else if (MsgData.type == BROADCAST_BID || MsgData.type == BROADCAST_ASK) {
+            const char *header = (MsgData.type == BROADCAST_BID) ? "bid" : "ask";
+            auction_order_t order = { .node_id = MsgData.node_id, .price = MsgData.price, .duration = MsgData.duration_m };
+
+            // Convert hex to binary
+            bool signature_decoded = hex_decode(MsgData.signature, SIGNATURE_SIZE, order.signature, sizeof(order.signature)) == sizeof(order.signature);
+            if (validation_record_bool(VALIDATION_HEADER, validation_check_node_id(MsgData.node_id) == 0 && signature_decoded) != 0)
+                continue;
+            if (validation_record(VALIDATION_MEMBERSHIP, validation_check_member(foreign_public_key_array, MsgData.node_id)) != 0) {
+                ESP_LOGW(TAG, "No public key found for node id <%i>. Cannot validate this %s!", MsgData.node_id, header);
+                continue;
+            }
+            // Orders for another slot can not be cleared together with this one
+            xSemaphoreTake(auction_book_mutex, portMAX_DELAY);
+            uint32_t current_slot = auction_book.slot;
+            xSemaphoreGive(auction_book_mutex);
+            if (validation_record_bool(VALIDATION_REPLAY, MsgData.slot == current_slot) != 0) {
+                ESP_LOGW(TAG, "[%s] Order from node %i is for slot %lu, current slot is %lu", header, MsgData.node_id, (unsigned long)MsgData.slot, (unsigned long)current_slot);
+                continue;
+            }
+
+            // Verifying the authenticity of the order
+            uint8_t msg_to_verify[256];
+            auction_construct_order_message((char *)msg_to_verify, sizeof(msg_to_verify), header, MsgData.node_id, MsgData.price, MsgData.duration_m, MsgData.slot);
 
-            // Broadcast block
-            send_udp_message(udp_sock, 1, block_msg, block_msg_size, "0.0.0.0", 8888);
+            if (verify_node_signature(MsgData.node_id, msg_to_verify, sizeof(msg_to_verify), order.signature) != 0)
+                continue;
 
-            // Begin to listen for phases from the other LASET modules
-            xTaskCreate(blockchain_phase_listener, "BlockchainPhaseListener", 4096*2, draft_block, 1, NULL);
+            // The slot may have been cleared while the signature was checked
+            xSemaphoreTake(auction_book_mutex, portMAX_DELAY);
+            if (auction_book.slot != MsgData.slot) {
+                ESP_LOGW(TAG, "[%s] Slot %lu was cleared before the order from node %i was verified", header, (unsigned long)MsgData.slot, MsgData.node_id);
+            } else if (MsgData.type == BROADCAST_BID) {
+                auction_add_bid(&auction_book, &order);
+            } else {
+                auction_add_ask(&auction_book, &order);
+            }
+            xSemaphoreGive(auction_book_mutex);
         }
         else if (MsgData.type == BROADCAST_TRADE_DEAL) {
-            ESP_LOGI(TAG, "\033[38;5;198m[BCD] Received trade deal from node %i for %i kW with a duration of %i minute(s).", MsgData.node_id, MsgData.price, MsgData.duration_m);
+            BINLOG(BINLOG_TRADE_DEAL_RECEIVED, MsgData.node_id, MsgData.price, MsgData.duration_m);
 
             if (MsgData.price > 6) {
                 ESP_LOGW(TAG, "Trade deal not accepted, price too high: <%i>", MsgData.price);
@@ -493,33 +1784,21 @@ void laset_listener_task(void *pParam) {
             }
                 
             // If price is acceptable, accept trade!
-            // If this module has not gotten the public key of the participants in the trade, we cant possibly verify the block
-            if(memcmp(foreign_public_key_array[MsgData.node_id], &null_key, PUBLIC_KEY_SIZE)==0)
+            // Convert hex to binary
+            uint8_t binary_signature[SIGNATURE_SIZE / 2]; // Since each byte is represented by 2 hex characters
+            bool signature_decoded = hex_decode(MsgData.signature, SIGNATURE_SIZE, binary_signature, sizeof(binary_signature)) == sizeof(binary_signature);
+            if (validation_record_bool(VALIDATION_HEADER, validation_check_node_id(MsgData.node_id) == 0 && signature_decoded) != 0)
                 continue;
-            
-            // If we made it here, that means we have previously received a foreign public key - now lets import key!
-            ESP_LOGI(TAG, "[BCD] Found a foreign public key from remote node! <%s>", foreign_public_key_array[MsgData.node_id]);
-
-            // Import public key
-            memcpy(provided_npk.public_key_buffer, foreign_public_key_array[MsgData.node_id], PUBLIC_KEY_SIZE);
-            provided_npk.public_key_length = PUBLIC_KEY_SIZE;
-            int status = import_public_key(provided_npk, &nkc);
-            if (status != 0)
+            // If this module has not gotten the public key of the participants in the trade, we cant possibly verify the block
+            if (validation_record(VALIDATION_MEMBERSHIP, validation_check_member(foreign_public_key_array, MsgData.node_id)) != 0)
                 continue;
 
-            // Convert hex to binary
-            uint8_t binary_signature[SIGNATURE_SIZE / 2]; // Since each byte is represented by 2 hex characters
-            for (size_t i = 0; i < SIGNATURE_SIZE / 2; i++) {
-                sscanf(MsgData.signature + 2 * i, "%2hhx", &binary_signature[i]);
-            }
-            
             // Construct message which can be verified
             uint8_t msg_to_verify[256];
             memset(msg_to_verify, 0, sizeof(msg_to_verify));
             snprintf((char *)msg_to_verify, sizeof(msg_to_verify), "bcd,%i,%i,%i", MsgData.node_id, MsgData.price, MsgData.duration_m);
 
-            int verify_status = verify_message(nkc, msg_to_verify, sizeof(msg_to_verify), binary_signature, 64);
-            if (verify_status != 0)
+            if (verify_node_signature(MsgData.node_id, msg_to_verify, sizeof(msg_to_verify), binary_signature) != 0)
                 continue;
 
             // Create signature
@@ -531,23 +1810,23 @@ void laset_listener_task(void *pParam) {
             uint8_t signature_atd[PSA_SIGNATURE_MAX_SIZE] = {0};
             size_t signature_length_atd;
 
-            status = sign_message(key_pair, msg_to_sign, msg_to_sign_length, signature_atd, &signature_length_atd);
+            int status = sign_message(key_pair, msg_to_sign, msg_to_sign_length, signature_atd, &signature_length_atd);
             if (status != 0) {
                 ESP_LOGE(TAG, "Function sign_message() failed!, error: %i", status);
                 continue;
             }
 
             // Create the "accept trade deal" message included this modules signature of the trade
-            const char msg_to_send[256];
+            char msg_to_send[256];
             memset(msg_to_send, 0, sizeof(msg_to_send));
-            sprintf(msg_to_send, "atd,%i,", node_id);
-            for (size_t i = 0; i < signature_length_atd; ++i) { // Append the signature also :)
-                sprintf(msg_to_send + strlen(msg_to_send), "%02x", signature_atd[i]);
-            }
-            sprintf(msg_to_send + strlen(msg_to_send), ";");
+            snprintf(msg_to_send, sizeof(msg_to_send), "atd,%i,", node_id);
+            int msg_to_send_length = hex_append(msg_to_send, sizeof(msg_to_send) - 1, signature_atd, signature_length_atd); // Append the signature also :)
+            if (msg_to_send_length < 0)
+                continue;
+            msg_to_send[msg_to_send_length++] = ';';
 
             ESP_LOGI(TAG, "[BCD] Sending ATD: <%s>", msg_to_send);
-            send_udp_message(udp_sock, 0, msg_to_send, strlen(msg_to_send), client_ip, 7777);
+            send_udp_message(udp_sock, 0, msg_to_send, msg_to_send_length, client_ip, 7777);
         }
     }
 
@@ -576,44 +1855,54 @@ void blockchain_listener_task(void *pParam) {
     }
     ESP_LOGI(TAG, "\033[38;5;245m[UDP] Socket bound on " IPSTR ":%d", IP2STR(&node_ip), port);
 
-    // struct sockaddr_storage source_addr. Large enough for IPv6 and IPv4
-    struct sockaddr_in source_addr;
-    socklen_t socklen = sizeof(source_addr);
-
-    struct iovec iov;
-    struct msghdr msg;
-    u8_t cmsg_buf[CMSG_SPACE(sizeof(struct in_pktinfo))];
-
-    // Receive buffer
-    char rx_buffer[512];
-    iov.iov_base = rx_buffer;
-    iov.iov_len = sizeof(rx_buffer);
-
-    msg.msg_control = cmsg_buf;
-    msg.msg_controllen = sizeof(cmsg_buf);
-    msg.msg_flags = 0;
-    msg.msg_iov = &iov;
-    msg.msg_iovlen = 1;
-    msg.msg_name = (struct sockaddr *)&source_addr;
-    msg.msg_namelen = socklen;
-    
+    // Packets are received by their own task, this task only validates them
+    ingress_queues_t *ingress = start_udp_receiver(udp_sock, "BlockchainReceiverTask");
+    packet_t *packet = NULL;
     
     struct broadcast_data_t MsgData;
     while (1) {
-        memset(rx_buffer, 0, sizeof(rx_buffer));
-        int len = recvmsg(udp_sock, &msg, 0);
-        if (len < 0) {      // No data received
-            ESP_LOGE(TAG, "recvfrom failed: errno %d", errno); 
-            break;
+        // Done with the previous packet, also when it was skipped with continue
+        if (packet != NULL) {
+            packet_release(packet);
         }
+        packet = receive_next_packet(ingress);
         
         // Decode the payload and pass the data into the MsgData struct, by reference
-        payload_decoder(rx_buffer, sizeof(rx_buffer) / sizeof(rx_buffer[0]), &MsgData);
+        payload_decoder(packet->data, packet->length, &MsgData);
+        count_received_packet(1, &MsgData);
 
         if (MsgData.type == BROADCAST_BLOCK) {
-            ESP_LOGI(TAG, "[Received Block Broadcast] seller node id: %i, price: %i, duration: %i, buyer node id: %i", MsgData.node_id, MsgData.price, MsgData.duration_m, MsgData.node_id_extra);
+            BINLOG(BINLOG_BLOCK_RECEIVED, MsgData.node_id, MsgData.price, MsgData.duration_m, MsgData.node_id_extra);
+
+            /* ---- Validation, cheapest stages first ---- */
+
+            if (validation_record(VALIDATION_HEADER, validation_check_block_header(MsgData.node_id, MsgData.node_id_extra, MsgData.price, MsgData.duration_m)) != 0) {
+                ESP_LOGW(TAG, "[BCB] Block fields out of range, discarding..");
+                continue;
+            }
+            if (validation_record_bool(VALIDATION_MEMBERSHIP, validation_check_member(foreign_public_key_array, MsgData.node_id) == 0
+                    && validation_check_member(foreign_public_key_array, MsgData.node_id_extra) == 0) != 0) {
+                ESP_LOGW(TAG, "[BCB] No public key for seller %i or buyer %i, discarding..", MsgData.node_id, MsgData.node_id_extra);
+                continue;
+            }
+            // A block may build on any block in the tree, not only the head. Its parent may also still be in
+            // phase validation here, it then waits as an orphan when it is committed
+            xSemaphoreTake(block_tree_mutex, portMAX_DELAY);
+            xSemaphoreTake(validation_mutex, portMAX_DELAY);
+            bool known_block = block_tree_contains(&block_tree, MsgData.hash);
+            bool known_parent = block_tree_contains(&block_tree, MsgData.previous_hash) || find_validation_slot(MsgData.previous_hash) >= 0;
+            xSemaphoreGive(validation_mutex);
+            xSemaphoreGive(block_tree_mutex);
+            if (validation_record_bool(VALIDATION_REPLAY, !known_block) != 0) {
+                ESP_LOGW(TAG, "[BCB] Block is already in the chain, discarding..");
+                continue;
+            }
+            if (validation_record_bool(VALIDATION_LINKAGE, known_parent) != 0) {
+                ESP_LOGW(TAG, "[BCB] Block does not build on a known block, discarding..");
+                continue;
+            }
 
-            // Setup struct containing block data
+            // Setup struct containing block data, this computes the hash from the content
             struct block_t *new_block = create_block(
                 MsgData.previous_hash,
                 MsgData.node_id,
@@ -622,54 +1911,126 @@ void blockchain_listener_task(void *pParam) {
                 &MsgData.signature,
                 MsgData.node_id_extra,
                 &MsgData.signature_extra,
-                chain_head
+                -1      // Linked by the block tree when it is committed
             );
             
-            // Try to verify the block if it matches with its hash and the signatures match
-            if (verify_block_hash(new_block, foreign_public_key_array) != 0) {
+            if (validation_record(VALIDATION_HASH, validation_check_hash(new_block->hash, MsgData.hash)) != 0) {
                 ESP_LOGE(TAG, "Could not verify block hash, discarding..");
                 // To prevent a memory leak, free the memory if a block is rejected.
                 free(new_block);
                 continue;
             }
-            ESP_LOGI(TAG, "Block has been verified");
 
+            // Only now the signatures of seller and buyer are verified. A block this station proposed itself was
+            // checked when it was made. An auction block carries the signatures of the orders it clears, which were
+            // verified when the orders came in, so it is checked against the allocations cleared here instead
+            xSemaphoreTake(validation_mutex, portMAX_DELAY);
+            bool own_block = (find_validation_slot(new_block->hash) >= 0);
+            xSemaphoreGive(validation_mutex);
+            bool cleared_here = false;
+            if (AUCTION_MODE && !own_block) {
+                xSemaphoreTake(auction_book_mutex, portMAX_DELAY);
+                cleared_here = (auction_pending_claim(&auction_pending, new_block) == 0);
+                xSemaphoreGive(auction_book_mutex);
+            }
+            PROFILE_BEGIN(PROFILE_VERIFY_BLOCK_SIGNATURES);
+            int verify_block_status = validation_record(VALIDATION_SIGNATURE, (own_block || cleared_here) ? 0 : verify_block_signatures(new_block, foreign_public_key_array));
+            PROFILE_END(PROFILE_VERIFY_BLOCK_SIGNATURES);
+            if (verify_block_status != 0) {
+                ESP_LOGE(TAG, "Could not verify block signatures, discarding..");
+                free(new_block);
+                continue;
+            }
+            BINLOG(BINLOG_BLOCK_VERIFIED, new_block->seller_node_id, new_block->price, new_block->duration, new_block->buyer_node_id);
+            trace_mark(trace_trade_id(new_block->seller_node_id, new_block->price, new_block->duration), TRACE_BCB_RECEIVED);
+
+            // The phase listener may commit (and the block tree free) the block while this loop still votes
+            struct block_t voted_block = *new_block;
             ESP_LOGI(TAG, "Validation of phases -> Started");
-            xTaskCreate(blockchain_phase_listener, "BlockchainPhaseListener", 4096*2, new_block, 1, NULL);
+            int validation = validate_block_phases(new_block);
+            if (validation < 0) {
+                ESP_LOGW(TAG, "[BCB] No validation slot is free, discarding..");
+                free(new_block);
+                continue;
+            }
+            if (validation > 0) {
+                free(new_block);    // Our own block, it is voted on all the same
+            }
+            new_block = &voted_block;
             vTaskDelay(100 / portTICK_PERIOD_MS);
 
             char rlc_msg[99];
-            char bpa_msg[60];
+            char bpa_msg[128];
+            uint16_t accepted_phases = 0;     // Every vote is signed over all phases accepted so far
             // For every phase a load calculation is requested and if it is 0 then the phase array is tallied up
             for (int phase = 1; phase <= (new_block->duration/5); phase++) {
-                memset(rlc_msg, 0, sizeof(rlc_msg));
-                sprintf(rlc_msg, "rlc,%f,%f,%f,%d,%d,%f", grid_load[3], grid_load[5], grid_load[6], new_block->buyer_node_id, new_block->seller_node_id, grid_load[new_block->seller_node_id]);
-                tcp_send_and_update(tcp_sock, rlc_msg, SERVER_IP, SERVER_PORT);
-                memset(rlc_msg, 0, sizeof(rlc_msg));
+                // Phases with (nearly) the same load state as an earlier request are answered from the cache
+                estimate_cache_key_t estimate_key;
+                fixed_t cached_estimate;
+                estimate_cache_make_key(&estimate_key, grid_load, new_block->buyer_node_id, new_block->seller_node_id, grid_load[new_block->seller_node_id]);
+
+                if (estimate_cache_lookup(&estimate_cache, &estimate_key, &cached_estimate)) {
+                    estimated_grid_calculation = cached_estimate;
+                } else if (LOCAL_GRID_ESTIMATE) {
+                    estimated_grid_calculation = loadflow_grid_estimate(&grid_system, grid_load, new_block->buyer_node_id, new_block->seller_node_id, grid_load[new_block->seller_node_id]);
+                    estimate_cache_insert(&estimate_cache, &estimate_key, estimated_grid_calculation);
+                } else {
+                    // Same fields as before, with 4 decimals instead of the 6 of %f
+                    char rlc_load[4][FIXED_TEXT_SIZE];
+                    fixed_format(grid_load[3], FIXED_DECIMALS, rlc_load[0], sizeof(rlc_load[0]));
+                    fixed_format(grid_load[5], FIXED_DECIMALS, rlc_load[1], sizeof(rlc_load[1]));
+                    fixed_format(grid_load[6], FIXED_DECIMALS, rlc_load[2], sizeof(rlc_load[2]));
+                    fixed_format(grid_load[new_block->seller_node_id], FIXED_DECIMALS, rlc_load[3], sizeof(rlc_load[3]));
+                    memset(rlc_msg, 0, sizeof(rlc_msg));
+                    snprintf(rlc_msg, sizeof(rlc_msg), "rlc,%s,%s,%s,%d,%d,%s;", rlc_load[0], rlc_load[1], rlc_load[2], new_block->buyer_node_id, new_block->seller_node_id, rlc_load[3]);
+                    if (tcp_send_and_update(tcp_sock, rlc_msg, SERVER_IP, SERVER_PORT) == 0) {
+                        estimate_cache_insert(&estimate_cache, &estimate_key, estimated_grid_calculation);
+                    } else {
+                        // Without a reply the phase is not acknowledged, and nothing is cached for it
+                        estimated_grid_calculation = FIXED_MAX;
+                    }
+                    memset(rlc_msg, 0, sizeof(rlc_msg));
+                }
                 
                 if (estimated_grid_calculation <= 0) {
-                    ESP_LOGI(TAG, "EstimatedGridCalculation %f | Acknowledging phase [%i]!", estimated_grid_calculation, phase);
+                    BINLOG(BINLOG_PHASE_ACKNOWLEDGED, phase, estimated_grid_calculation);
 
-                    if ( xSemaphoreTake(phase_acceptance_array_mutex, portMAX_DELAY) ) {
-                        phase_acceptance_array[phase - 1] += 1;
-                        xSemaphoreGive(phase_acceptance_array_mutex);
-                    } else {
-                        ESP_LOGE(TAG, "Mutex could not be taken(!)");
+                    // Sign the vote
+                    accepted_phases |= (1 << (phase - 1));
+                    uint8_t vote_msg[256];
+                    quorum_vote_message(vote_msg, sizeof(vote_msg), node_id, accepted_phases, new_block->hash);
+
+                    uint8_t vote_signature[PSA_SIGNATURE_MAX_SIZE] = {0};
+                    size_t vote_signature_length;
+
+                    int status = sign_message(key_pair, vote_msg, sizeof(vote_msg), vote_signature, &vote_signature_length);
+                    if (status != 0) {
+                        ESP_LOGE(TAG, "Function sign_message() failed!, error: %i", status);
                         continue;
                     }
+
+                    // Our own vote is not received through the broadcast, so add it to the certificate directly
+                    if (count_phase_vote(new_block->hash, node_id, phase, accepted_phases, vote_signature) != 0) {
+                        ESP_LOGW(TAG, "Phase %i ends after the validation of its block, not voting", phase);
+                        break;
+                    }
                     // Constructing BPA message
                     memset(bpa_msg, 0, sizeof(bpa_msg));
-                    sprintf(bpa_msg, "bpa,%i,%i,%i,", node_id, phase, new_block->duration);
-                    int bpa_msg_size = strlen(bpa_msg); // Add the hash.
-                    memcpy(bpa_msg + bpa_msg_size, new_block->hash, SHA256_HASH_SIZE);                  
+                    sprintf(bpa_msg, "bpa,%i,%i,%i,%u,", node_id, phase, new_block->duration, accepted_phases);
+                    int bpa_msg_size = strlen(bpa_msg); // Add the hash and the signature.
+                    memcpy(bpa_msg + bpa_msg_size, new_block->hash, SHA256_HASH_SIZE);
+                    memcpy(bpa_msg + bpa_msg_size + SHA256_HASH_SIZE, vote_signature, SIGNATURE_SIZE/2);
                     
                     send_udp_message(udp_sock, 1, bpa_msg, sizeof(bpa_msg), '0.0.0.0', 8889);
                 } else {
-                    ESP_LOGE(TAG, "EstimatedGridCalculation %f | Not validated! Phase[%i]!", estimated_grid_calculation, phase);
+                    char estimate[FIXED_TEXT_SIZE];
+                    fixed_format(estimated_grid_calculation, FIXED_DECIMALS, estimate, sizeof(estimate));
+                    ESP_LOGE(TAG, "EstimatedGridCalculation %s | Not validated! Phase[%i]!", estimate, phase);
                 }
                 vTaskDelay(5000 / portTICK_PERIOD_MS);
             }
-            ESP_LOGI(TAG, "Done validating phases!");
+            ESP_LOGI(TAG, "Done validating phases! Estimate cache hits: %lu, misses: %lu, evictions: %lu",
+                (unsigned long)estimate_cache.metrics.hits, (unsigned long)estimate_cache.metrics.misses, (unsigned long)estimate_cache.metrics.evictions);
         }
     }
     exit:
@@ -677,11 +2038,117 @@ void blockchain_listener_task(void *pParam) {
         vTaskDelete(NULL);
 }
 
+/* Task that clears the collected bids and asks at the end of every auction slot. Every station clears the same
+   signed orders, the seller of an allocation proposes it as a block, which is validated and voted on like a trade deal */
+void auction_task(void *pParam) {
+    ESP_LOGI(TAG, "AuctionTask Started");
+
+    TaskParameters *params = (TaskParameters *)pParam;
+    int *udp_sock = params->udp_sock;
+
+    xSemaphoreTake(auction_book_mutex, portMAX_DELAY);
+    auction_book_reset(&auction_book, auction_slot_from_clock(auction_clock_now(&auction_clock, esp_timer_get_time() / 1000)));
+    auction_pending_init(&auction_pending);
+    xSemaphoreGive(auction_book_mutex);
+
+    auction_result_t result;
+    char proposed_hash[SHA256_HASH_SIZE];
+    bool proposing = false;
+
+    while (1) {
+        // Sleep until the next slot boundary
+        int64_t now_ms = auction_time_ms();
+        int64_t slot_end_ms = ((int64_t)auction_slot_from_clock(now_ms) + 1) * AUCTION_SLOT_DURATION_S * 1000;
+        vTaskDelay((slot_end_ms - now_ms) / portTICK_PERIOD_MS + 1);
+
+        // Clear the finished slot and start collecting for the next one
+        xSemaphoreTake(auction_book_mutex, portMAX_DELAY);
+        uint32_t cleared_slot = auction_book.slot;
+        int allocation_amount = auction_clear(&auction_book, &result);
+        auction_book_reset(&auction_book, auction_slot_from_clock(auction_clock_now(&auction_clock, esp_timer_get_time() / 1000)));
+        if (allocation_amount > 0) {
+            auction_pending_add(&auction_pending, &result, cleared_slot);
+        }
+        xSemaphoreGive(auction_book_mutex);
+        if (allocation_amount > 0) {
+            ESP_LOGI(TAG, "Cleared %i allocation(s) in slot %lu", allocation_amount, (unsigned long)cleared_slot);
+        }
+
+        // Own allocations are proposed one at a time, each on top of the block before it
+        if (proposing) {
+            xSemaphoreTake(validation_mutex, portMAX_DELAY);
+            proposing = (find_validation_slot(proposed_hash) >= 0);
+            xSemaphoreGive(validation_mutex);
+            if (proposing) {
+                continue;
+            }
+        }
+
+        auction_pending_allocation_t allocation;
+        xSemaphoreTake(auction_book_mutex, portMAX_DELAY);
+        int taken = auction_pending_take(&auction_pending, node_id, &allocation);
+        xSemaphoreGive(auction_book_mutex);
+        if (taken != 0) {
+            continue;
+        }
+
+        char previous_block_hash[SHA256_HASH_SIZE];
+        int reader;
+        memcpy(previous_block_hash, read_chain_tip(&reader)->hash, SHA256_HASH_SIZE);
+        chain_tip_read_end(reader);
+        struct block_t *block = auction_create_block(&allocation, previous_block_hash);
+        if (block == NULL) {
+            ESP_LOGE(TAG, "No memory for the auction block %i>%i", allocation.allocation.seller_node_id, allocation.allocation.buyer_node_id);
+            continue;
+        }
+        memcpy(proposed_hash, block->hash, SHA256_HASH_SIZE);
+        if (propose_block(udp_sock, block) != 0) {
+            ESP_LOGE(TAG, "No validation slot is free for the auction block, its allocation is dropped");
+            continue;
+        }
+        proposing = true;
+    }
+
+    vTaskDelete(NULL);
+}
+
+/* Task that draws the dashboard. It only reads the dashboard snapshot, and only draws when it changed */
+void dashboard_task(void *pParam) {
+    static renderer_t renderer;
+    dashboard_t *dashboard = (dashboard_t *)malloc(sizeof(dashboard_t));
+    dashboard_state_t state;
+    dashboard_view_t view;
+
+    // The station works without its display, so a failed allocation only ends this task
+    if (dashboard == NULL) {
+        ESP_LOGE(TAG, "No memory for the dashboard (%u bytes), running without a display", (unsigned)sizeof(dashboard_t));
+        vTaskDelete(NULL);
+        return;
+    }
+
+    dashboard_init(dashboard);
+    setup_display(&renderer, dashboard_paint, dashboard);
+
+    uint32_t drawn_sequence = 1;    // Never a sequence a read returns, so the first state is drawn
+    while (1) {
+        uint32_t sequence = dashboard_read(&dashboard_snapshot, &state);
+        if (sequence != drawn_sequence) {
+            dashboard_layout(&state, &view);
+            dashboard_update_view(dashboard, &renderer, &view);
+            renderer_flush(&renderer);
+            drawn_sequence = sequence;
+        }
+        vTaskDelay(DASHBOARD_POLL_MS / portTICK_PERIOD_MS);
+    }
+}
+
 /* Main task */
 void laset_main(void *pParams) {
     wifi_init_sta();    // Will block flow until connection is established to WiFi
     ESP_LOGI(TAG, "Fully connected | Got IP:" IPSTR, IP2STR(&node_ip));
 
+    dashboard_snapshot_init(&dashboard_snapshot);
+
     // Intialize the psa library.
     psa_status_t psa_status = psa_crypto_init();
     if(psa_status != PSA_SUCCESS)
@@ -697,32 +2164,102 @@ void laset_main(void *pParams) {
     
 
     
-    // Create TCP socket and connect to server
-    int POC_tcp_sock = create_connect_tcp_socket(SERVER_IP, SERVER_PORT);
+    // Create TCP socket and connect to server, nothing works without the simulator so wait for it
+    int POC_tcp_sock;
+    while ((POC_tcp_sock = create_connect_tcp_socket(SERVER_IP, SERVER_PORT)) < 0) {
+        vTaskDelay(SIMULATOR_RECONNECT_MIN_MS / portTICK_PERIOD_MS);
+    }
     // Create UDP socket.
     int ESP_udp_sock = create_udp_socket();
 
     // Fetch Node ID
-    tcp_send_and_update(POC_tcp_sock, "rni", SERVER_IP, SERVER_PORT);
+    tcp_send_and_update(POC_tcp_sock, "rni;", SERVER_IP, SERVER_PORT);
     ESP_LOGI(TAG, "\033[38;5;148mNode ID fetched! <%d>", node_id);
 
+    // From here on one task receives everything from the simulator, so pushed readings are not mixed into replies
+    if (AMPERAGE_SUBSCRIBE_MODE) {
+        simulator_event_group = xEventGroupCreate();
+        simulator_listener_running = true;
+        TaskHandle_t simulator_listener_handle;
+        task_plan_create(simulator_listener_task, "SimulatorListenerTask", 4096, POC_tcp_sock, TASK_ROLE_NETWORK, &simulator_listener_handle);
+        monitor_task(simulator_listener_handle, "SimulatorListenerTask");
+    }
+
     // Put our own key into the public key array.
     updatePublicKey(node_id, (char *)npk.public_key_buffer);
+    key_fingerprint(npk.public_key_buffer, PUBLIC_KEY_SIZE, own_key_fingerprint);
     
+    // Load the grid topology for the local grid estimate
+    loadflow_default_system(&grid_system);
+    estimate_cache_init(&estimate_cache);
+
+    register_metrics();
+    packet_pool_init();
+    monitor_task(xTaskGetCurrentTaskHandle(), "laset_main");
+
     // Create the mutex
-    phase_acceptance_array_mutex = xSemaphoreCreateMutex();
+    validation_mutex = xSemaphoreCreateMutex();
+    auction_book_mutex = xSemaphoreCreateMutex();
+    auction_clock_init(&auction_clock);
+    ledger_mutex = xSemaphoreCreateMutex();
+    block_tree_mutex = xSemaphoreCreateMutex();
+    ledger_init(&ledger);
+    if (LEDGER_PERSIST_SNAPSHOTS) {
+        load_ledger_snapshot();
+    }
+    // The tree starts where the ledger is: the base hash, or the tip of the restored snapshot
+    char root_hash[SHA256_HASH_SIZE];
+    chain_previous_hash(-1, root_hash);
+    block_tree_init(&block_tree, root_hash, ledger.state.height, link_block, release_block);
+    chain_tip_t tip = { .block = NULL, .height = ledger.state.height };
+    memcpy(tip.hash, root_hash, SHA256_HASH_SIZE);
+    if (chain_tip_init(&tip) != 0) {
+        ESP_LOGE(TAG_CHAIN_TIP, "No memory for the chain tip, the station can not start");
+        vTaskDelete(NULL);
+        return;
+    }
+    chain_digest_peers_init(&chain_digest_peers);
+    update_chain_digest(&tip);
     
     // Pin Tasks with parameters
     TaskParameters *taskParams = (TaskParameters *)malloc(sizeof(TaskParameters));
     taskParams->udp_sock = ESP_udp_sock;
     taskParams->tcp_sock = POC_tcp_sock;
     
+    TaskHandle_t task_handle;
     // Create Amperage Broadcaster
-    xTaskCreate(amperage_broadcaster_task, "AmperageBroadcasterTask", 8192, taskParams, 1, NULL);
-    // Create Laset listener task
-    xTaskCreate(laset_listener_task, "LasetListenerTask", 8192, taskParams, 1, NULL);
+    task_plan_create(amperage_broadcaster_task, "AmperageBroadcasterTask", 8192, taskParams, TASK_ROLE_NETWORK, &task_handle);
+    monitor_task(task_handle, "AmperageBroadcasterTask");
+    // Create Laset listener task (verifies and signs accepts, so it runs with the crypto tasks)
+    task_plan_create(laset_listener_task, "LasetListenerTask", 8192, taskParams, TASK_ROLE_CRYPTO, &task_handle);
+    monitor_task(task_handle, "LasetListenerTask");
+    // Create Blockchain phase listener task, it verifies the signature of every vote
+    task_plan_create(blockchain_phase_listener, "BlockchainPhaseListener", 4096*2, NULL, TASK_ROLE_CRYPTO, &task_handle);
+    monitor_task(task_handle, "BlockchainPhaseListener");
+    // Create Chain sync listener task, it verifies the signature of every snapshot
+    task_plan_create(chain_sync_listener_task, "ChainSyncListenerTask", 4096*2, NULL, TASK_ROLE_CRYPTO, &task_handle);
+    monitor_task(task_handle, "ChainSyncListenerTask");
     // Create Blockchain listener task
-    xTaskCreate(blockchain_listener_task, "BlockchainListenerTask", 8192, POC_tcp_sock, 1, NULL);
+    task_plan_create(blockchain_listener_task, "BlockchainListenerTask", 8192, POC_tcp_sock, TASK_ROLE_CRYPTO, &task_handle);
+    monitor_task(task_handle, "BlockchainListenerTask");
+    // Create Metrics server task
+    task_plan_create(metrics_server_task, "MetricsServerTask", 4096, NULL, TASK_ROLE_BACKGROUND, NULL);
+    // Create Binary log drain task, below the priority of the tasks that write the log
+    task_plan_create(binlog_drain_task, "BinlogDrainTask", 4096, NULL, TASK_ROLE_BACKGROUND, NULL);
+
+    if (DASHBOARD_ENABLED) {
+        // Create Dashboard task
+        task_plan_create(dashboard_task, "DashboardTask", 4096, NULL, TASK_ROLE_BACKGROUND, NULL);
+    }
+
+    if (AUCTION_MODE) {
+        // Create Auction task
+        task_plan_create(auction_task, "AuctionTask", 8192, taskParams, TASK_ROLE_CRYPTO, &task_handle);
+        monitor_task(task_handle, "AuctionTask");
+    }
+
+    // Setup is done, so stop running above every task that was just created
+    task_plan_apply_to_self(TASK_ROLE_BACKGROUND);
 
     // Wait indefinitly
     while(1){vTaskDelay(1000 / portTICK_PERIOD_MS );}
@@ -0,0 +1,237 @@
+#include "auction.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+void auction_clock_init(auction_clock_t *clock) {
+    clock->offset_ms = 0;
+}
+
+int64_t auction_clock_now(const auction_clock_t *clock, int64_t local_ms) {
+    return local_ms + clock->offset_ms;
+}
+
+bool auction_clock_observe(auction_clock_t *clock, int64_t local_ms, int64_t announced_ms) {
+    if (announced_ms <= auction_clock_now(clock, local_ms)) {
+        return false;
+    }
+    clock->offset_ms = announced_ms - local_ms;
+    return true;
+}
+
+void auction_clock_encode(int64_t clock_ms, uint8_t buffer[AUCTION_CLOCK_ENCODED_SIZE]) {
+    for (int i = 0; i < AUCTION_CLOCK_ENCODED_SIZE; i++) {
+        buffer[i] = (uint8_t)((uint64_t)clock_ms >> (8 * i));
+    }
+}
+
+int64_t auction_clock_decode(const uint8_t buffer[AUCTION_CLOCK_ENCODED_SIZE]) {
+    uint64_t clock_ms = 0;
+    for (int i = 0; i < AUCTION_CLOCK_ENCODED_SIZE; i++) {
+        clock_ms |= (uint64_t)buffer[i] << (8 * i);
+    }
+    return (int64_t)clock_ms;
+}
+
+uint32_t auction_slot_from_clock(int64_t clock_ms) {
+    return (uint32_t)(clock_ms / (AUCTION_SLOT_DURATION_S * 1000));
+}
+
+void auction_book_reset(auction_book_t *book, uint32_t slot) {
+    memset(book, 0, sizeof(auction_book_t));
+    book->slot = slot;
+}
+
+// Adds or replaces the order of a node in one side of the book.
+static int add_order(auction_order_t orders[AUCTION_MAX_ORDERS], int *order_amount, const auction_order_t *order) {
+    // Quantities are traded in whole phases, anything shorter than a phase can not be validated.
+    if (order->duration < AUCTION_SLOT_DURATION_S || order->price <= 0) {
+        return -1;
+    }
+
+    for (int i = 0; i < *order_amount; i++) {
+        if (orders[i].node_id == order->node_id) {
+            orders[i] = *order;
+            return 0;
+        }
+    }
+
+    if (*order_amount >= AUCTION_MAX_ORDERS) {
+        ESP_LOGW(TAG_AUCTION, "Order book is full, dropping order from node %i", order->node_id);
+        return -1;
+    }
+
+    orders[*order_amount] = *order;
+    *order_amount += 1;
+    return 0;
+}
+
+int auction_add_bid(auction_book_t *book, const auction_order_t *bid) {
+    return add_order(book->bids, &book->bid_amount, bid);
+}
+
+int auction_add_ask(auction_book_t *book, const auction_order_t *ask) {
+    return add_order(book->asks, &book->ask_amount, ask);
+}
+
+// Demand curve: highest price first. Ties are broken on node id so every station sorts identically.
+static int compare_bids(const void *a, const void *b) {
+    const auction_order_t *bid_a = a;
+    const auction_order_t *bid_b = b;
+    if (bid_a->price != bid_b->price) {
+        return bid_b->price - bid_a->price;
+    }
+    return bid_a->node_id - bid_b->node_id;
+}
+
+// Supply curve: lowest price first, ties broken on node id.
+static int compare_asks(const void *a, const void *b) {
+    const auction_order_t *ask_a = a;
+    const auction_order_t *ask_b = b;
+    if (ask_a->price != ask_b->price) {
+        return ask_a->price - ask_b->price;
+    }
+    return ask_a->node_id - ask_b->node_id;
+}
+
+int auction_clear(auction_book_t *book, auction_result_t *result) {
+    memset(result, 0, sizeof(auction_result_t));
+
+    qsort(book->bids, book->bid_amount, sizeof(auction_order_t), compare_bids);
+    qsort(book->asks, book->ask_amount, sizeof(auction_order_t), compare_asks);
+
+    // Quantity left on the order currently being swept, rounded down to whole phases.
+    int bid_left = 0;
+    int ask_left = 0;
+    int marginal_bid_price = 0;
+    int marginal_ask_price = 0;
+
+    int i = 0;
+    int j = 0;
+    if (book->bid_amount > 0) bid_left = book->bids[0].duration - (book->bids[0].duration % AUCTION_SLOT_DURATION_S);
+    if (book->ask_amount > 0) ask_left = book->asks[0].duration - (book->asks[0].duration % AUCTION_SLOT_DURATION_S);
+
+    // Sweep both curves until the highest remaining bid no longer covers the lowest remaining ask.
+    while (i < book->bid_amount && j < book->ask_amount && book->bids[i].price >= book->asks[j].price) {
+        int matched = (bid_left < ask_left) ? bid_left : ask_left;
+
+        auction_allocation_t *allocation = &result->allocations[result->allocation_amount];
+        allocation->seller_node_id = book->asks[j].node_id;
+        allocation->buyer_node_id = book->bids[i].node_id;
+        allocation->duration = matched;
+        memcpy(allocation->seller_signature, book->asks[j].signature, SIGNATURE_SIZE/2);
+        memcpy(allocation->buyer_signature, book->bids[i].signature, SIGNATURE_SIZE/2);
+        result->allocation_amount++;
+        result->cleared_duration += matched;
+
+        marginal_bid_price = book->bids[i].price;
+        marginal_ask_price = book->asks[j].price;
+
+        bid_left -= matched;
+        ask_left -= matched;
+
+        if (bid_left == 0 && ++i < book->bid_amount) {
+            bid_left = book->bids[i].duration - (book->bids[i].duration % AUCTION_SLOT_DURATION_S);
+        }
+        if (ask_left == 0 && ++j < book->ask_amount) {
+            ask_left = book->asks[j].duration - (book->asks[j].duration % AUCTION_SLOT_DURATION_S);
+        }
+    }
+
+    // The uniform price is set between the marginal bid and ask, so nobody trades at a loss.
+    if (result->allocation_amount > 0) {
+        result->clearing_price = (marginal_bid_price + marginal_ask_price) / 2;
+    }
+
+    ESP_LOGI(TAG_AUCTION, "Slot %lu cleared %i allocation(s) at price %i (%i seconds in total)",
+        (unsigned long)book->slot, result->allocation_amount, result->clearing_price, result->cleared_duration);
+
+    return result->allocation_amount;
+}
+
+void auction_pending_init(auction_pending_t *pending) {
+    memset(pending, 0, sizeof(auction_pending_t));
+}
+
+int auction_pending_add(auction_pending_t *pending, const auction_result_t *result, uint32_t slot) {
+    int replaced = 0;
+    for (int i = 0; i < result->allocation_amount; i++) {
+        auction_pending_allocation_t *entry = &pending->allocations[pending->next];
+        if (entry->state == AUCTION_PENDING_CLEARED) {
+            replaced++;
+        }
+        entry->allocation = result->allocations[i];
+        entry->price = result->clearing_price;
+        entry->slot = slot;
+        entry->state = AUCTION_PENDING_CLEARED;
+        pending->next = (pending->next + 1) % AUCTION_PENDING_CAPACITY;
+    }
+    if (replaced > 0) {
+        ESP_LOGW(TAG_AUCTION, "%i cleared allocation(s) were replaced before their block was proposed", replaced);
+    }
+    return replaced;
+}
+
+int auction_pending_take(auction_pending_t *pending, short seller_node_id, auction_pending_allocation_t *allocation) {
+    // From the oldest to the newest
+    for (int i = 0; i < AUCTION_PENDING_CAPACITY; i++) {
+        auction_pending_allocation_t *entry = &pending->allocations[(pending->next + i) % AUCTION_PENDING_CAPACITY];
+        if (entry->state == AUCTION_PENDING_CLEARED && entry->allocation.seller_node_id == seller_node_id) {
+            entry->state = AUCTION_PENDING_CLAIMED;
+            *allocation = *entry;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// The allocation the block proposes: same seller, buyer, order signatures, clearing price and duration
+static bool pending_matches(const auction_pending_allocation_t *entry, const struct block_t *block) {
+    return entry->allocation.seller_node_id == block->seller_node_id
+        && entry->allocation.buyer_node_id == block->buyer_node_id
+        && entry->allocation.duration == block->duration
+        && entry->price == block->price
+        && memcmp(entry->allocation.seller_signature, block->seller_signature, SIGNATURE_SIZE/2) == 0
+        && memcmp(entry->allocation.buyer_signature, block->buyer_signature, SIGNATURE_SIZE/2) == 0;
+}
+
+int auction_pending_claim(auction_pending_t *pending, const struct block_t *block) {
+    for (int i = 0; i < AUCTION_PENDING_CAPACITY; i++) {
+        auction_pending_allocation_t *entry = &pending->allocations[i];
+        if (entry->state == AUCTION_PENDING_CLEARED && pending_matches(entry, block)) {
+            entry->state = AUCTION_PENDING_CLAIMED;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int auction_pending_cleared(auction_pending_t *pending, const struct block_t *block) {
+    for (int i = 0; i < AUCTION_PENDING_CAPACITY; i++) {
+        auction_pending_allocation_t *entry = &pending->allocations[i];
+        if (entry->state != AUCTION_PENDING_FREE && pending_matches(entry, block)) {
+            entry->state = AUCTION_PENDING_CLAIMED;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+struct block_t *auction_create_block(const auction_pending_allocation_t *allocation, char previous_hash[SHA256_HASH_SIZE]) {
+    return create_block(
+        previous_hash,
+        allocation->allocation.seller_node_id,
+        allocation->price,
+        allocation->allocation.duration,
+        (uint8_t *)allocation->allocation.seller_signature,
+        allocation->allocation.buyer_node_id,
+        (uint8_t *)allocation->allocation.buyer_signature,
+        -1      // Linked by the block tree when it is committed
+    );
+}
+
+void auction_construct_order_message(char *msg, size_t msg_size, const char *header, short node_id, short price, short duration, uint32_t slot) {
+    memset(msg, 0, msg_size);
+    snprintf(msg, msg_size, "%s,%i,%i,%i,%lu", header, node_id, price, duration, (unsigned long)slot);
+}
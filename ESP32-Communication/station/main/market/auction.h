@@ -0,0 +1,140 @@
+#ifndef AUCTION_H
+#define AUCTION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../models/models.h"
+#include "../blockchain/chain.h"
+
+#define TAG_AUCTION "LASET_AUCT"
+
+// Length of one auction slot in seconds. Matches the 5 second phase granularity of a block.
+#define AUCTION_SLOT_DURATION_S 5
+
+// The most orders of each side (bids/asks) that can be collected in one slot.
+#define AUCTION_MAX_ORDERS 16
+
+// The most allocations a single clearing can produce (every match consumes at least one order).
+#define AUCTION_MAX_ALLOCATIONS (AUCTION_MAX_ORDERS * 2)
+
+// The highest price a buyer bids with (same limit as when accepting a bcd trade deal).
+#define AUCTION_BUYER_LIMIT_PRICE 6
+
+// Auction time, which the slots are numbered from. The stations have no common wall clock (nothing sets it, so
+// time() counts from boot), so every bca announces the station's auction time and each station follows the one
+// furthest ahead. An announcement arrives late by the network delay, so the clocks never run ahead of the network.
+typedef struct {
+    int64_t offset_ms;      // Added to the local time since boot
+} auction_clock_t;
+
+// Encoded auction time in a bca, little endian. Same as AUCTION_CLOCK_SIZE in models.h
+#define AUCTION_CLOCK_ENCODED_SIZE 8
+
+// A signed bid (buyer) or ask (seller). Duration is the energy quantity in seconds.
+typedef struct {
+    short node_id;
+    short price;
+    short duration;
+    uint8_t signature[SIGNATURE_SIZE/2];
+} auction_order_t;
+
+// One matched pair from a clearing. Every allocation is cleared at the uniform price.
+typedef struct {
+    short seller_node_id;
+    short buyer_node_id;
+    short duration;
+    uint8_t seller_signature[SIGNATURE_SIZE/2];
+    uint8_t buyer_signature[SIGNATURE_SIZE/2];
+} auction_allocation_t;
+
+typedef struct {
+    int clearing_price;
+    int cleared_duration;   // Total duration (quantity) traded in the slot
+    int allocation_amount;
+    auction_allocation_t allocations[AUCTION_MAX_ALLOCATIONS];
+} auction_result_t;
+
+// Allocations of recent clearings, until each is proposed as a block by its seller and validated like a bcb
+// trade. Every station clears the same orders, so it recognises the block that proposes an allocation it cleared.
+#define AUCTION_PENDING_CAPACITY 16
+
+typedef enum {
+    AUCTION_PENDING_FREE = 0,
+    AUCTION_PENDING_CLEARED,    // Waits for its block
+    AUCTION_PENDING_CLAIMED,    // Its block was proposed or is being validated, it is not taken again
+} auction_pending_state_t;
+
+typedef struct {
+    auction_allocation_t allocation;
+    int price;                  // Clearing price of its slot
+    uint32_t slot;
+    uint8_t state;
+} auction_pending_allocation_t;
+
+typedef struct {
+    auction_pending_allocation_t allocations[AUCTION_PENDING_CAPACITY];
+    int next;                   // Written next, the oldest allocation
+} auction_pending_t;
+
+// All orders collected for a single slot.
+typedef struct {
+    uint32_t slot;
+    int bid_amount;
+    int ask_amount;
+    auction_order_t bids[AUCTION_MAX_ORDERS];
+    auction_order_t asks[AUCTION_MAX_ORDERS];
+} auction_book_t;
+
+void auction_clock_init(auction_clock_t *clock);
+
+// The auction time at a local time since boot (ms).
+int64_t auction_clock_now(const auction_clock_t *clock, int64_t local_ms);
+
+// Follows the auction time another station announced, if it is ahead of the own one. Returns true if the clock moved.
+bool auction_clock_observe(auction_clock_t *clock, int64_t local_ms, int64_t announced_ms);
+
+void auction_clock_encode(int64_t clock_ms, uint8_t buffer[AUCTION_CLOCK_ENCODED_SIZE]);
+int64_t auction_clock_decode(const uint8_t buffer[AUCTION_CLOCK_ENCODED_SIZE]);
+
+// Returns the slot number an auction time (ms) belongs to.
+uint32_t auction_slot_from_clock(int64_t clock_ms);
+
+// Empties the book and sets the slot it collects orders for.
+void auction_book_reset(auction_book_t *book, uint32_t slot);
+
+// Adds an already verified order. A node only has one order per side, so a new order replaces the old one.
+// Returns 0 on success, -1 if the book is full or the order is invalid.
+int auction_add_bid(auction_book_t *book, const auction_order_t *bid);
+int auction_add_ask(auction_book_t *book, const auction_order_t *ask);
+
+// Computes the uniform clearing price and the allocations with a sort-and-sweep over the aggregate curves.
+// The book is sorted in place. Returns the amount of allocations.
+int auction_clear(auction_book_t *book, auction_result_t *result);
+
+void auction_pending_init(auction_pending_t *pending);
+
+// Adds every allocation of a clearing, replacing the oldest ones when it is full.
+// Returns the amount of replaced allocations that never got a block.
+int auction_pending_add(auction_pending_t *pending, const auction_result_t *result, uint32_t slot);
+
+// Claims the oldest allocation that seller_node_id sold and copies it into allocation, for the seller to propose.
+// Returns 0, or -1 if the seller has none waiting.
+int auction_pending_take(auction_pending_t *pending, short seller_node_id, auction_pending_allocation_t *allocation);
+
+// Claims the allocation a received block proposes: same seller, buyer, order signatures, clearing price and duration.
+// Returns 0, or -1 if no waiting allocation matches (never cleared here, or claimed already).
+int auction_pending_claim(auction_pending_t *pending, const struct block_t *block);
+
+// Like auction_pending_claim, but also matches an allocation that was claimed already, for a block that was
+// committed elsewhere. Returns 0 if the block proposes an allocation cleared here, or -1.
+int auction_pending_cleared(auction_pending_t *pending, const struct block_t *block);
+
+// Makes the block that proposes an allocation, on top of the block with previous_hash.
+struct block_t *auction_create_block(const auction_pending_allocation_t *allocation, char previous_hash[SHA256_HASH_SIZE]);
+
+// Constructs the message an order is signed with, e.g. "ask,3,5,20,340912" into msg.
+void auction_construct_order_message(char *msg, size_t msg_size, const char *header, short node_id, short price, short duration, uint32_t slot);
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef STRUCTURES_H
 #define STRUCTURES_H
 
+#include "../grid/fixed_point.h"
+
 #define PROVIDE_NODE_ID 1
 #define PROVIDE_AMPERAGE_READING 2
 #define PROVIDE_PUBLIC_KEY 3
@@ -12,6 +14,13 @@
 #define REQUEST_PUBLIC_KEY 9
 #define BROADCAST_BLOCK 10
 #define BROADCAST_PHASE_ACCEPTANCE 11
+#define BROADCAST_BID 12
+#define BROADCAST_ASK 13
+#define REQUEST_PROFILE_DUMP 14
+#define REQUEST_CHAIN_SYNC 15
+#define COMMITTED_BLOCK 16
+#define REQUEST_TRACE_DUMP 17
+#define PROVIDE_SNAPSHOT 18
 
 #define AMOUNT_OF_HOUSEHOLDS 3
 #define PUBLIC_KEY_SIZE 74
@@ -19,6 +28,15 @@
 
 #define SHA256_HASH_SIZE 32
 
+// Size of the public key fingerprint broadcasted in bca, instead of the full key
+#define KEY_FINGERPRINT_SIZE 8
+
+// Size of the chain state digest broadcasted in bca, after the key fingerprint
+#define CHAIN_DIGEST_SIZE 12
+
+// Size of the auction time broadcasted in bca, after the chain state digest
+#define AUCTION_CLOCK_SIZE 8
+
 // The amount of different laset public keys that can be stored in an array.
 #define PK_KEY_ARRAY_SIZE 10
 
@@ -26,16 +44,26 @@ typedef struct broadcast_data_t{
     short type;
     short node_id;          // Is also used to contain seller node id
     short node_id_extra;    // Could be buyer (maybe)
-    short amperage;
+    fixed_t amperage;
     short price;
     short duration_m;
     short phase;
-    double estimated_grid;
+    uint16_t phases;        // Phases a phase acceptance vote covers, bit 0 is phase 1
+    uint32_t slot;          // Auction slot of a bid/ask
+    uint32_t height;        // Height a chain sync (rcs) asks for the blocks above
+    fixed_t estimated_grid;
     char signature[128]; // Size of the signature (double due to hex)
     char signature_extra[128];
     char public_key[74]; // Size of public key
+    char key_fingerprint[KEY_FINGERPRINT_SIZE];
+    char chain_digest[CHAIN_DIGEST_SIZE];
+    char auction_clock[AUCTION_CLOCK_SIZE];
     char previous_hash[SHA256_HASH_SIZE];
     char hash[SHA256_HASH_SIZE];
+    const uint8_t *certificate;     // Encoded quorum certificate of a committed block (cbk), points into the packet
+    int certificate_length;
+    const uint8_t *snapshot;        // Encoded ledger snapshot (psn), points into the packet
+    int snapshot_length;
 };
 
 typedef struct {
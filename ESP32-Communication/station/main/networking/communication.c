@@ -11,6 +11,7 @@
 #include "esp_log.h"
 
 #include "communication.h"
+#include "diagnostics/profiler.h"
 
 esp_ip4_addr_t node_ip;
 
@@ -28,15 +29,28 @@ void send_udp_message(int sock, int enable_broadcast, const char* message, int m
 
         setsockopt(sock, SOL_SOCKET, SO_BROADCAST, &enable_broadcast, sizeof(enable_broadcast));
     }
+    PROFILE_BEGIN(PROFILE_UDP_SEND);
     int sendto_err = sendto(sock, message, message_length, 0, (struct sockaddr *)&dest_addr, sizeof(dest_addr));
+    PROFILE_END(PROFILE_UDP_SEND);
     if (sendto_err < 0) {
         ESP_LOGE(TAG_COM, "Error occurred during sending: errno %d", errno);
         return;
     }
 }
 
+// Copies a binary field of a fixed length that starts at offset. Returns -1 and copies nothing if the datagram ends
+// before the field does, so a short packet never reads the bytes a previous packet left in the buffer.
+static int copy_binary_field(char *destination, const char rx_buffer[], int rx_bufferSize, int offset, int length) {
+    if (offset < 0 || offset + length > rx_bufferSize) {
+        return -1;
+    }
+    memcpy(destination, rx_buffer + offset, length);
+    return 0;
+}
+
 // Takes any message and decodes it into the broadcast_data_t struct
 void payload_decoder(char rx_buffer[], int rx_bufferSize, struct broadcast_data_t *pPayload_struct) {
+    PROFILE_BEGIN(PROFILE_PAYLOAD_DECODER);
     char tmp_parameters[9][256];
     // Reset the values before they are assigned (so they dont keep their old values from a previous packet)
     memset(tmp_parameters, 0, sizeof(tmp_parameters));
@@ -44,6 +58,14 @@ void payload_decoder(char rx_buffer[], int rx_bufferSize, struct broadcast_data_
 
     short StartIndex = 0;
     short commaCounter = 0;
+    int certificate_index = 0;      // Where the quorum certificate of a cbk starts
+    int snapshot_index = 0;         // Where the ledger snapshot of a psn starts
+    int truncated = 0;              // A binary field runs past the end of the datagram
+
+    if (rx_bufferSize < 3) {
+        PROFILE_END(PROFILE_PAYLOAD_DECODER);
+        return;
+    }
 
     char pni_header[3] = "pni";
     char par_header[3] = "par";
@@ -51,81 +73,137 @@ void payload_decoder(char rx_buffer[], int rx_bufferSize, struct broadcast_data_
     char bcd_header[3] = "bcd";
     char atd_header[3] = "atd";
     char plc_header[3] = "plc";
+    char rpk_header[3] = "rpk";
+    char ppk_header[3] = "ppk";
+    char dpr_header[3] = "dpr";
+    char dtr_header[3] = "dtr";
+    char rcs_header[3] = "rcs";
+    char psn_header[3] = "psn";
 
     // Blockchain headers
     char bcb_header[3] = "bcb";
     char bpa_header[3] = "bpa";
+    char cbk_header[3] = "cbk";
+
+    // Auction headers
+    char bid_header[3] = "bid";
+    char ask_header[3] = "ask";
 
     // Run through all bytes and split it at the commas
     for (int i = 0; i < rx_bufferSize; ++i) {
         if (rx_buffer[i] == ',' || rx_buffer[i] == ';') {
             commaCounter++;
-            if(commaCounter >= 1) {
-                memcpy(tmp_parameters[commaCounter-1], rx_buffer+StartIndex, i-StartIndex);
+            if(commaCounter >= 1 && commaCounter <= 9) {
+                int parameter_length = i - StartIndex;
+                if (parameter_length > (int)sizeof(tmp_parameters[0]) - 1) {
+                    parameter_length = sizeof(tmp_parameters[0]) - 1;
+                }
+                memcpy(tmp_parameters[commaCounter-1], rx_buffer+StartIndex, parameter_length);
             }
             StartIndex = i+1;
             // If it was the last variable, the message is done'
 
-            // BCB
-            if( (commaCounter == 5) && (memcmp(rx_buffer, &bcb_header, 3) == 0) ) {
-                memcpy(tmp_parameters[5], rx_buffer + i + 1, SHA256_HASH_SIZE);
-                memcpy(tmp_parameters[6], rx_buffer + i + 1 + SHA256_HASH_SIZE, SIGNATURE_SIZE/2);
-                memcpy(tmp_parameters[7], rx_buffer + i + 1 + SHA256_HASH_SIZE + SIGNATURE_SIZE/2, SIGNATURE_SIZE/2);
-                memcpy(tmp_parameters[8], rx_buffer + i + 1 + SHA256_HASH_SIZE + SIGNATURE_SIZE, SHA256_HASH_SIZE);
+            // BCB, and CBK which is a committed block followed by its quorum certificate
+            if( (commaCounter == 5) && (memcmp(rx_buffer, &bcb_header, 3) == 0 || memcmp(rx_buffer, &cbk_header, 3) == 0) ) {
+                truncated |= copy_binary_field(tmp_parameters[5], rx_buffer, rx_bufferSize, i + 1, SHA256_HASH_SIZE);
+                truncated |= copy_binary_field(tmp_parameters[6], rx_buffer, rx_bufferSize, i + 1 + SHA256_HASH_SIZE, SIGNATURE_SIZE/2);
+                truncated |= copy_binary_field(tmp_parameters[7], rx_buffer, rx_bufferSize, i + 1 + SHA256_HASH_SIZE + SIGNATURE_SIZE/2, SIGNATURE_SIZE/2);
+                truncated |= copy_binary_field(tmp_parameters[8], rx_buffer, rx_bufferSize, i + 1 + SHA256_HASH_SIZE + SIGNATURE_SIZE, SHA256_HASH_SIZE);
+                certificate_index = i + 1 + SHA256_HASH_SIZE*2 + SIGNATURE_SIZE;
+                break;
+            }
+            // PSN, a ledger snapshot of the length given before it, followed by the signature of the sender over it
+            if ( (commaCounter == 3) && (memcmp(rx_buffer, &psn_header, 3) == 0) ) {
+                int snapshot_length = atoi(tmp_parameters[2]);
+                truncated |= (snapshot_length <= 0 || snapshot_length > rx_bufferSize) ? -1 : 0;
+                truncated |= copy_binary_field(tmp_parameters[3], rx_buffer, rx_bufferSize, i + 1 + snapshot_length, SIGNATURE_SIZE/2);
+                snapshot_index = i + 1;
                 break;
             }
             // BCA
             if ( (commaCounter == 3) && (memcmp(rx_buffer, &bca_header, 3) == 0) ) { 
-                memcpy(tmp_parameters[3], rx_buffer + i+1, PUBLIC_KEY_SIZE);
+                truncated |= copy_binary_field(tmp_parameters[3], rx_buffer, rx_bufferSize, i+1, KEY_FINGERPRINT_SIZE);
+                truncated |= copy_binary_field(tmp_parameters[4], rx_buffer, rx_bufferSize, i+1 + KEY_FINGERPRINT_SIZE, CHAIN_DIGEST_SIZE);
+                truncated |= copy_binary_field(tmp_parameters[5], rx_buffer, rx_bufferSize, i+1 + KEY_FINGERPRINT_SIZE + CHAIN_DIGEST_SIZE, AUCTION_CLOCK_SIZE);
+                break;
+            }
+
+            // PPK
+            if ( (commaCounter == 2) && (memcmp(rx_buffer, &ppk_header, 3) == 0) ) {
+                truncated |= copy_binary_field(tmp_parameters[2], rx_buffer, rx_bufferSize, i+1, PUBLIC_KEY_SIZE);
                 break;
             }
             
             // BPA
-            if ( (commaCounter == 4) && (memcmp(rx_buffer, &bpa_header, 3) == 0) ) { 
-                memcpy(tmp_parameters[4], rx_buffer + i + 1, SHA256_HASH_SIZE);
+            if ( (commaCounter == 5) && (memcmp(rx_buffer, &bpa_header, 3) == 0) ) { 
+                truncated |= copy_binary_field(tmp_parameters[5], rx_buffer, rx_bufferSize, i + 1, SHA256_HASH_SIZE);
+                truncated |= copy_binary_field(tmp_parameters[6], rx_buffer, rx_bufferSize, i + 1 + SHA256_HASH_SIZE, SIGNATURE_SIZE/2);
                 break;
             }
             
             // Every other header, that does not require memcpy()
-            if ( (memcmp(rx_buffer, &bca_header, 3) != 0) && (memcmp(rx_buffer, &bcb_header, 3) != 0) ) {
+            if ( (memcmp(rx_buffer, &bca_header, 3) != 0) && (memcmp(rx_buffer, &bcb_header, 3) != 0) && (memcmp(rx_buffer, &cbk_header, 3) != 0) && (memcmp(rx_buffer, &ppk_header, 3) != 0) ) {
                 if(rx_buffer[i] == ';') { break; }
             }
         }
     }
 
+    // A packet that is shorter than its fields stays an unknown message
+    if (truncated) {
+        ESP_LOGW(TAG_COM, "Dropped a %.3s packet of %d bytes, it ends inside a field", rx_buffer, rx_bufferSize);
+        PROFILE_END(PROFILE_PAYLOAD_DECODER);
+        return;
+    }
+
     // Depending the header, load the struct with its values
     if (memcmp(rx_buffer, &pni_header, 3) == 0) {
         pPayload_struct->type = PROVIDE_NODE_ID;
         pPayload_struct->node_id = atoi(tmp_parameters[1]);
     }
     else if(memcmp(rx_buffer, &par_header, 3) == 0) {
-        pPayload_struct->type = PROVIDE_AMPERAGE_READING;
-        pPayload_struct->amperage = atoi(tmp_parameters[1]);
+        // Readings that are not a number are left as an unknown message, instead of reading as 0 A
+        if (fixed_parse(tmp_parameters[1], &pPayload_struct->amperage) == 0) {
+            pPayload_struct->type = PROVIDE_AMPERAGE_READING;
+        }
     }
     else if (memcmp(rx_buffer, &bca_header, 3) == 0) {
-        pPayload_struct->type = BROADCAST_AMPERAGE;
+        if (fixed_parse(tmp_parameters[2], &pPayload_struct->amperage) == 0) {
+            pPayload_struct->type = BROADCAST_AMPERAGE;
+        }
         pPayload_struct->node_id = atoi(tmp_parameters[1]);
-        pPayload_struct->amperage = atoi(tmp_parameters[2]);
-        memcpy(pPayload_struct->public_key, tmp_parameters[3], PUBLIC_KEY_SIZE);
+        memcpy(pPayload_struct->key_fingerprint, tmp_parameters[3], KEY_FINGERPRINT_SIZE);
+        memcpy(pPayload_struct->chain_digest, tmp_parameters[4], CHAIN_DIGEST_SIZE);
+        memcpy(pPayload_struct->auction_clock, tmp_parameters[5], AUCTION_CLOCK_SIZE);
+    }
+    else if (memcmp(rx_buffer, &rpk_header, 3) == 0) {
+        pPayload_struct->type = REQUEST_PUBLIC_KEY;
+        pPayload_struct->node_id = atoi(tmp_parameters[1]);                                     // Node id of the requested key
+    }
+    else if (memcmp(rx_buffer, &ppk_header, 3) == 0) {
+        pPayload_struct->type = PROVIDE_PUBLIC_KEY;
+        pPayload_struct->node_id = atoi(tmp_parameters[1]);                                     // Node id of the key
+        memcpy(pPayload_struct->public_key, tmp_parameters[2], PUBLIC_KEY_SIZE);                // Public key (raw)
     }
     else if (memcmp(rx_buffer, &bcd_header, 3) == 0) {
         pPayload_struct->type = BROADCAST_TRADE_DEAL;
         pPayload_struct->node_id = atoi(tmp_parameters[1]);
         pPayload_struct->price = atoi(tmp_parameters[2]);
         pPayload_struct->duration_m = atoi(tmp_parameters[3]);
-        memcpy(pPayload_struct->signature, tmp_parameters[4], 256);
+        memcpy(pPayload_struct->signature, tmp_parameters[4], SIGNATURE_SIZE);                  // Signature (hex)
     }
     else if (memcmp(rx_buffer, &atd_header, 3) == 0) {
         pPayload_struct->type = ACCEPT_TRADE_DEAL;
         pPayload_struct->node_id = atoi(tmp_parameters[1]);
-        memcpy(pPayload_struct->signature, tmp_parameters[2], sizeof(tmp_parameters[2]));
+        memcpy(pPayload_struct->signature, tmp_parameters[2], SIGNATURE_SIZE);                  // Signature (hex)
     }
     else if(memcmp(rx_buffer, &plc_header, 3) == 0) {
-        pPayload_struct->type = PROVIDE_LOAD_CALCULATION;
-        pPayload_struct->estimated_grid = atof(tmp_parameters[1]);    
+        // An estimate that is not a number must not read as 0 V, which would acknowledge the phase
+        if (fixed_parse(tmp_parameters[1], &pPayload_struct->estimated_grid) == 0) {
+            pPayload_struct->type = PROVIDE_LOAD_CALCULATION;
+        }
     }
-    else if(memcmp(rx_buffer, &bcb_header, 3) == 0) {
-        pPayload_struct->type = BROADCAST_BLOCK;
+    else if(memcmp(rx_buffer, &bcb_header, 3) == 0 || memcmp(rx_buffer, &cbk_header, 3) == 0) {
+        pPayload_struct->type = (memcmp(rx_buffer, &bcb_header, 3) == 0) ? BROADCAST_BLOCK : COMMITTED_BLOCK;
         pPayload_struct->node_id = atoi(tmp_parameters[1]);                                     // Node id
         pPayload_struct->price = atoi(tmp_parameters[2]);                                       // price
         pPayload_struct->duration_m = atoi(tmp_parameters[3]);                                  // duration
@@ -134,15 +212,48 @@ void payload_decoder(char rx_buffer[], int rx_bufferSize, struct broadcast_data_
         memcpy(pPayload_struct->signature, tmp_parameters[6], SIGNATURE_SIZE/2);                // seller_signature
         memcpy(pPayload_struct->signature_extra, tmp_parameters[7], SIGNATURE_SIZE/2);          // buyer_signature
         memcpy(pPayload_struct->hash, tmp_parameters[8], SHA256_HASH_SIZE);                     // hash
+        if (pPayload_struct->type == COMMITTED_BLOCK && certificate_index > 0 && certificate_index < rx_bufferSize) {
+            pPayload_struct->certificate = (const uint8_t *)rx_buffer + certificate_index;    // Decoded by quorum_decode
+            pPayload_struct->certificate_length = rx_bufferSize - certificate_index;
+        }
 
     } else if(memcmp(rx_buffer, &bpa_header, 3) == 0) {
         pPayload_struct->type = BROADCAST_PHASE_ACCEPTANCE;
         pPayload_struct->node_id = atoi(tmp_parameters[1]);                                     // Node id
         pPayload_struct->phase = atoi(tmp_parameters[2]);                                       // Phase
         pPayload_struct->duration_m = atoi(tmp_parameters[3]);                                  // Duration
-        memcpy(pPayload_struct->hash, tmp_parameters[4], SHA256_HASH_SIZE);                     // block_hash
+        pPayload_struct->phases = (uint16_t)atoi(tmp_parameters[4]);                            // Phases accepted so far
+        memcpy(pPayload_struct->hash, tmp_parameters[5], SHA256_HASH_SIZE);                     // block_hash
+        memcpy(pPayload_struct->signature, tmp_parameters[6], SIGNATURE_SIZE/2);                // Vote signature
+    }
+    else if(memcmp(rx_buffer, &bid_header, 3) == 0 || memcmp(rx_buffer, &ask_header, 3) == 0) {
+        pPayload_struct->type = (memcmp(rx_buffer, &bid_header, 3) == 0) ? BROADCAST_BID : BROADCAST_ASK;
+        pPayload_struct->node_id = atoi(tmp_parameters[1]);                                     // Node id
+        pPayload_struct->price = atoi(tmp_parameters[2]);                                       // Price
+        pPayload_struct->duration_m = atoi(tmp_parameters[3]);                                  // Duration
+        pPayload_struct->slot = strtoul(tmp_parameters[4], NULL, 10);                           // Auction slot
+        memcpy(pPayload_struct->signature, tmp_parameters[5], SIGNATURE_SIZE);                  // Signature (hex)
+    }
+    else if (memcmp(rx_buffer, &dpr_header, 3) == 0) {
+        pPayload_struct->type = REQUEST_PROFILE_DUMP;
+    }
+    else if (memcmp(rx_buffer, &dtr_header, 3) == 0) {
+        pPayload_struct->type = REQUEST_TRACE_DUMP;
+    }
+    else if (memcmp(rx_buffer, &psn_header, 3) == 0 && snapshot_index > 0) {
+        pPayload_struct->type = PROVIDE_SNAPSHOT;
+        pPayload_struct->node_id = atoi(tmp_parameters[1]);                                     // Node id of the sender
+        pPayload_struct->snapshot = (const uint8_t *)rx_buffer + snapshot_index;               // Decoded by ledger_snapshot_decode
+        pPayload_struct->snapshot_length = atoi(tmp_parameters[2]);
+        memcpy(pPayload_struct->signature, tmp_parameters[3], SIGNATURE_SIZE/2);                // Signature over the snapshot
+    }
+    else if (memcmp(rx_buffer, &rcs_header, 3) == 0) {
+        pPayload_struct->type = REQUEST_CHAIN_SYNC;
+        pPayload_struct->node_id = atoi(tmp_parameters[1]);                                     // Node id of the requester
+        pPayload_struct->height = strtoul(tmp_parameters[2], NULL, 10);                         // Height it has the blocks up to
     }
     else {
         ESP_LOGW(TAG_COM, "Received unknown header. Rx_buffer: %s", rx_buffer);
     }
+    PROFILE_END(PROFILE_PAYLOAD_DECODER);
 }
\ No newline at end of file
@@ -9,6 +9,8 @@
 // Send udp message to a destination ip.
 void send_udp_message(int sock, int enable_broadcast, const char* message, int message_length, const char* destinationIP, int port);
 
+// Decodes a received message. rx_bufferSize is the amount of bytes received, not the size of the buffer, so
+// the certificate of a cbk and the snapshot of a psn end where the datagram does.
 void payload_decoder(char rx_buffer[], int rx_bufferSize, struct broadcast_data_t *pPayload_struct);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "dedup.h"
+
+#include <string.h>
+
+void dedup_init(dedup_filter_t *filter, int64_t now_ms) {
+    memset(filter, 0, sizeof(dedup_filter_t));
+    filter->rotated_ms = now_ms;
+}
+
+uint64_t dedup_digest(uint32_t source_ip, const char *data, int length) {
+    uint64_t digest = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < 4; i++) {
+        digest ^= (uint8_t)(source_ip >> (8 * i));
+        digest *= 0x100000001b3ULL;
+    }
+    for (int i = 0; i < length; i++) {
+        digest ^= (uint8_t)data[i];
+        digest *= 0x100000001b3ULL;
+    }
+    return (digest == 0) ? 1 : digest;
+}
+
+// Empties the older generation and makes it the current one
+static void rotate(dedup_filter_t *filter, int64_t now_ms) {
+    int older = filter->current ^ 1;
+    memset(filter->digests[older], 0, sizeof(filter->digests[older]));
+    filter->fill[older] = 0;
+    filter->current = older;
+    filter->rotated_ms = now_ms;
+}
+
+// Slot of the digest in a generation, or the empty slot where it belongs
+static int find_slot(const uint64_t digests[DEDUP_SLOTS], uint64_t digest) {
+    int slot = (int)(digest & (DEDUP_SLOTS - 1));
+    while (digests[slot] != 0 && digests[slot] != digest) {
+        slot = (slot + 1) & (DEDUP_SLOTS - 1);
+    }
+    return slot;
+}
+
+bool dedup_seen(dedup_filter_t *filter, uint32_t source_ip, const char *data, int length, int64_t now_ms) {
+    if (now_ms - filter->rotated_ms >= DEDUP_WINDOW_MS) {
+        // After two windows without a rotation both generations are stale
+        if (now_ms - filter->rotated_ms >= 2 * DEDUP_WINDOW_MS) {
+            rotate(filter, now_ms);
+        }
+        rotate(filter, now_ms);
+    }
+
+    uint64_t digest = dedup_digest(source_ip, data, length);
+    for (int generation = 0; generation < 2; generation++) {
+        if (filter->digests[generation][find_slot(filter->digests[generation], digest)] == digest) {
+            filter->duplicates++;
+            return true;
+        }
+    }
+
+    if (filter->fill[filter->current] >= DEDUP_MAX_FILL) {
+        rotate(filter, now_ms);
+    }
+    int current = filter->current;
+    filter->digests[current][find_slot(filter->digests[current], digest)] = digest;
+    filter->fill[current]++;
+    return false;
+}
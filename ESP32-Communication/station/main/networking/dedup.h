@@ -0,0 +1,39 @@
+#ifndef DEDUP_H
+#define DEDUP_H
+
+/* Filter for packets that were already received. Broadcasts on a shared LAN often arrive more than once, and
+ * every copy of a bcb would otherwise be decoded, verified and get its own phase listener. The filter keeps the
+ * digests of recent packets in two generations: new digests go into the current one, and every DEDUP_WINDOW_MS
+ * the older generation is emptied and becomes the current one. A packet is therefore remembered for at least
+ * one window and at most two. */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TAG_DEDUP "LASET_DDUP"
+
+#define DEDUP_WINDOW_MS 1000
+
+// Slots of one generation, a power of two. A generation is rotated early when it is three quarters full.
+#define DEDUP_SLOTS 128
+#define DEDUP_MAX_FILL (DEDUP_SLOTS * 3 / 4)
+
+typedef struct {
+    uint64_t digests[2][DEDUP_SLOTS];   // 0 is an empty slot
+    int fill[2];
+    int current;                        // Generation new digests go into
+    int64_t rotated_ms;
+    uint32_t duplicates;                // Packets reported as seen before
+} dedup_filter_t;
+
+void dedup_init(dedup_filter_t *filter, int64_t now_ms);
+
+// 64-bit FNV-1a digest of the sender address (network byte order) and a packet, never 0.
+uint64_t dedup_digest(uint32_t source_ip, const char *data, int length);
+
+// Returns true if the same packet was received from the same sender within the window, otherwise remembers it and
+// returns false. The packet is not decoded yet, so the address stands in for the node id: two nodes that send the
+// same bytes are not copies of each other. A filter belongs to one task, it has no lock.
+bool dedup_seen(dedup_filter_t *filter, uint32_t source_ip, const char *data, int length, int64_t now_ms);
+
+#endif
@@ -0,0 +1,122 @@
+#include "hex.h"
+
+#include <string.h>
+
+#if defined(__SSE2__) && !defined(ESP_PLATFORM)
+#include <emmintrin.h>
+#define HEX_SSE2 1
+#else
+#define HEX_SSE2 0
+#endif
+
+static const char digits[16] = "0123456789abcdef";
+
+// Value of every character, -1 for characters that are not hex
+static const int8_t values[256] = {
+    ['0'] = 1, ['1'] = 2, ['2'] = 3, ['3'] = 4, ['4'] = 5, ['5'] = 6, ['6'] = 7, ['7'] = 8, ['8'] = 9, ['9'] = 10,
+    ['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+    ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+};  // Stored plus one, so the zero initialized entries are the invalid ones
+
+#if HEX_SSE2
+// 16 bytes into 32 characters
+static void encode_16(const uint8_t *data, char *hex) {
+    const __m128i low_mask = _mm_set1_epi8(0x0F);
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i letter_offset = _mm_set1_epi8('a' - '0' - 10);
+
+    __m128i bytes = _mm_loadu_si128((const __m128i *)data);
+    __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), low_mask);
+    __m128i low = _mm_and_si128(bytes, low_mask);
+
+    // '0' + nibble, plus the distance to 'a' for nibbles above 9
+    high = _mm_add_epi8(_mm_add_epi8(high, _mm_set1_epi8('0')), _mm_and_si128(_mm_cmpgt_epi8(high, nine), letter_offset));
+    low = _mm_add_epi8(_mm_add_epi8(low, _mm_set1_epi8('0')), _mm_and_si128(_mm_cmpgt_epi8(low, nine), letter_offset));
+
+    _mm_storeu_si128((__m128i *)hex, _mm_unpacklo_epi8(high, low));
+    _mm_storeu_si128((__m128i *)(hex + 16), _mm_unpackhi_epi8(high, low));
+}
+
+// Nibble values of 16 characters, with the lanes of invalid characters set in invalid
+static __m128i nibbles_16(const char *hex, __m128i *invalid) {
+    __m128i characters = _mm_loadu_si128((const __m128i *)hex);
+
+    // Digits: '0' to '9'. Letters: 'a' to 'f' after setting the lower case bit
+    __m128i digit = _mm_sub_epi8(characters, _mm_set1_epi8('0'));
+    __m128i is_digit = _mm_and_si128(_mm_cmpgt_epi8(digit, _mm_set1_epi8(-1)), _mm_cmplt_epi8(digit, _mm_set1_epi8(10)));
+    __m128i letter = _mm_sub_epi8(_mm_or_si128(characters, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i is_letter = _mm_and_si128(_mm_cmpgt_epi8(letter, _mm_set1_epi8(-1)), _mm_cmplt_epi8(letter, _mm_set1_epi8(6)));
+
+    *invalid = _mm_or_si128(*invalid, _mm_andnot_si128(_mm_or_si128(is_digit, is_letter), _mm_set1_epi8(-1)));
+    return _mm_or_si128(_mm_and_si128(is_digit, digit), _mm_and_si128(is_letter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+}
+
+// 32 characters into 16 bytes. Returns -1 if a character is not hex.
+static int decode_16(const char *hex, uint8_t *data) {
+    __m128i invalid = _mm_setzero_si128();
+    __m128i first = nibbles_16(hex, &invalid);
+    __m128i second = nibbles_16(hex + 16, &invalid);
+    if (_mm_movemask_epi8(invalid) != 0) {
+        return -1;
+    }
+
+    // Every 16-bit lane holds a high nibble in its low byte and a low nibble in its high byte
+    const __m128i byte_mask = _mm_set1_epi16(0x00FF);
+    __m128i first_bytes = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(first, byte_mask), 4), _mm_srli_epi16(first, 8));
+    __m128i second_bytes = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(second, byte_mask), 4), _mm_srli_epi16(second, 8));
+    _mm_storeu_si128((__m128i *)data, _mm_packus_epi16(first_bytes, second_bytes));
+    return 0;
+}
+#endif
+
+int hex_encode(const uint8_t *data, size_t length, char *hex, size_t hex_size) {
+    if (hex_size < HEX_ENCODED_SIZE(length)) {
+        return -1;
+    }
+
+    size_t i = 0;
+#if HEX_SSE2
+    for (; i + 16 <= length; i += 16) {
+        encode_16(data + i, hex + 2 * i);
+    }
+#endif
+    for (; i < length; i++) {
+        hex[2 * i] = digits[data[i] >> 4];
+        hex[2 * i + 1] = digits[data[i] & 0x0F];
+    }
+    hex[2 * length] = '\0';
+    return (int)(2 * length);
+}
+
+int hex_decode(const char *hex, size_t hex_length, uint8_t *data, size_t length) {
+    if (hex_length < 2 * length) {
+        return -1;
+    }
+
+    size_t i = 0;
+#if HEX_SSE2
+    for (; i + 16 <= length; i += 16) {
+        if (decode_16(hex + 2 * i, data + i) != 0) {
+            return -1;
+        }
+    }
+#endif
+    for (; i < length; i++) {
+        int high = values[(uint8_t)hex[2 * i]] - 1;
+        int low = values[(uint8_t)hex[2 * i + 1]] - 1;
+        if (high < 0 || low < 0) {
+            return -1;
+        }
+        data[i] = (uint8_t)((high << 4) | low);
+    }
+    return (int)length;
+}
+
+int hex_append(char *message, size_t message_size, const uint8_t *data, size_t length) {
+    size_t message_length = strnlen(message, message_size);
+    if (message_length >= message_size) {
+        return -1;  // Not terminated
+    }
+    int written = hex_encode(data, length, message + message_length, message_size - message_length);
+    return (written < 0) ? -1 : (int)message_length + written;
+}
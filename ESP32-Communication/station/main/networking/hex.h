@@ -0,0 +1,28 @@
+#ifndef HEX_H
+#define HEX_H
+
+/* Hex codec for the binary fields of messages (signatures, hashes). Encoding and decoding are table driven and
+ * write into buffers of the caller in one pass; on x86 host builds 16 bytes are handled at a time with SSE2.
+ * Every function checks the sizes it is given, and returns -1 instead of writing past a buffer. */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TAG_HEX "LASET_HEX"
+
+// Characters needed for length bytes, with the terminating 0
+#define HEX_ENCODED_SIZE(length) ((length) * 2 + 1)
+
+// Writes length bytes as lower case hex and a terminating 0. Returns the amount of characters written (without
+// the 0), or -1 if hex_size is smaller than HEX_ENCODED_SIZE(length).
+int hex_encode(const uint8_t *data, size_t length, char *hex, size_t hex_size);
+
+// Reads length bytes from 2 * length hex characters (upper or lower case). Returns length, or -1 if hex_length is
+// shorter than 2 * length or a character is not hex.
+int hex_decode(const char *hex, size_t hex_length, uint8_t *data, size_t length);
+
+// Appends length bytes as hex to the 0 terminated string in message. Returns the new length of the string,
+// or -1 if it does not fit in message_size (the message is left unchanged).
+int hex_append(char *message, size_t message_size, const uint8_t *data, size_t length);
+
+#endif
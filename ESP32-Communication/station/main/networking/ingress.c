@@ -0,0 +1,81 @@
+#include "ingress.h"
+
+#include <string.h>
+
+typedef struct {
+    char header[3];
+    ingress_priority_t priority;
+} ingress_header_t;
+
+static const ingress_header_t headers[] = {
+    {"bcb", INGRESS_PRIORITY_HIGH},
+    {"bpa", INGRESS_PRIORITY_HIGH},
+    {"bcd", INGRESS_PRIORITY_HIGH},
+    {"atd", INGRESS_PRIORITY_HIGH},
+    {"bid", INGRESS_PRIORITY_HIGH},
+    {"ask", INGRESS_PRIORITY_HIGH},
+    {"rpk", INGRESS_PRIORITY_NORMAL},
+    {"ppk", INGRESS_PRIORITY_NORMAL},
+    {"rcs", INGRESS_PRIORITY_NORMAL},
+    {"cbk", INGRESS_PRIORITY_NORMAL},
+    {"psn", INGRESS_PRIORITY_NORMAL},
+    {"bca", INGRESS_PRIORITY_LOW},
+    {"par", INGRESS_PRIORITY_LOW},
+    {"dpr", INGRESS_PRIORITY_LOW},
+    {"dtr", INGRESS_PRIORITY_LOW},
+};
+
+int ingress_classify(const char *data, int length) {
+    if (length < 4) {   // Header and separator
+        return INGRESS_UNKNOWN;
+    }
+    for (size_t i = 0; i < sizeof(headers) / sizeof(headers[0]); i++) {
+        if (memcmp(data, headers[i].header, 3) == 0) {
+            return headers[i].priority;
+        }
+    }
+    return INGRESS_UNKNOWN;
+}
+
+void ingress_limiter_init(ingress_limiter_t *limiter) {
+    memset(limiter, 0, sizeof(ingress_limiter_t));
+}
+
+// Bucket of a source. New sources start with a full bucket, replacing the one seen longest ago when full
+static ingress_source_t *find_source(ingress_limiter_t *limiter, uint32_t source_ip, int64_t now_ms) {
+    ingress_source_t *oldest = NULL;
+
+    for (int i = 0; i < limiter->source_amount; i++) {
+        if (limiter->sources[i].ip == source_ip) {
+            return &limiter->sources[i];
+        }
+        if (oldest == NULL || limiter->sources[i].last_ms < oldest->last_ms) {
+            oldest = &limiter->sources[i];
+        }
+    }
+
+    ingress_source_t *source = (limiter->source_amount < INGRESS_MAX_SOURCES) ? &limiter->sources[limiter->source_amount++] : oldest;
+    source->ip = source_ip;
+    source->milli_tokens = INGRESS_BURST * 1000;
+    source->last_ms = now_ms;
+    return source;
+}
+
+bool ingress_admit(ingress_limiter_t *limiter, uint32_t source_ip, int64_t now_ms) {
+    ingress_source_t *source = find_source(limiter, source_ip, now_ms);
+
+    // Refill for the time since the last packet, one thousandth of a token per millisecond per token/s
+    if (now_ms > source->last_ms) {
+        int64_t refill = (now_ms - source->last_ms) * INGRESS_RATE_PER_S;
+        int64_t tokens = source->milli_tokens + refill;
+        source->milli_tokens = (tokens > INGRESS_BURST * 1000) ? INGRESS_BURST * 1000 : (uint32_t)tokens;
+    }
+    source->last_ms = now_ms;
+
+    if (source->milli_tokens < 1000) {
+        limiter->rate_limited++;
+        return false;
+    }
+    source->milli_tokens -= 1000;
+    return true;
+}
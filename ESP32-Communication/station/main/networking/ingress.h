@@ -0,0 +1,51 @@
+#ifndef INGRESS_H
+#define INGRESS_H
+
+/* Ingress checks done on a received packet before it is decoded. The header decides the priority the packet is
+ * handled with (blocks and trades before keys before amperage), and packets with unknown headers are dropped.
+ * Every source address gets a token bucket, so one flooding node cannot fill the queues of the others. */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TAG_INGRESS "LASET_INGR"
+
+// Packets a source may send per second on average, and in one burst
+#define INGRESS_RATE_PER_S 20
+#define INGRESS_BURST 40
+
+// Amount of sources with their own bucket. When it is full the source seen longest ago is forgotten
+#define INGRESS_MAX_SOURCES 16
+
+typedef enum {
+    INGRESS_PRIORITY_HIGH = 0,  // Blocks, trade deals, accepts, bids and asks
+    INGRESS_PRIORITY_NORMAL,    // Public key requests and replies
+    INGRESS_PRIORITY_LOW,       // Amperage readings and diagnostics
+    INGRESS_PRIORITY_AMOUNT
+} ingress_priority_t;
+
+// Returned by ingress_classify for headers that are not handled
+#define INGRESS_UNKNOWN -1
+
+typedef struct {
+    uint32_t ip;
+    uint32_t milli_tokens;  // Tokens in thousandths, so slow refills are not rounded away
+    int64_t last_ms;
+} ingress_source_t;
+
+typedef struct {
+    ingress_source_t sources[INGRESS_MAX_SOURCES];
+    int source_amount;
+    uint32_t rate_limited;  // Packets refused by a token bucket
+} ingress_limiter_t;
+
+// Priority of a packet from its header, or INGRESS_UNKNOWN. Only looks at the first three bytes.
+int ingress_classify(const char *data, int length);
+
+void ingress_limiter_init(ingress_limiter_t *limiter);
+
+// Takes a token from the bucket of the source. Returns true if the packet may be handled.
+// A limiter belongs to one task, it has no lock.
+bool ingress_admit(ingress_limiter_t *limiter, uint32_t source_ip, int64_t now_ms);
+
+#endif
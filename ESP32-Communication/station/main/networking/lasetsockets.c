@@ -35,7 +35,8 @@ int create_connect_tcp_socket(const char* server_ip, int server_port)
         err = connect(POCsock, (struct sockaddr *)&dest_addr, sizeof(dest_addr));
         if (err != 0) {
             ESP_LOGE(TAG_SOCKET, "Socket unable to connect: errno %d", errno);
-            return POCsock;
+            close(POCsock);
+            return -1;
         }
         vTaskDelay(500 / portTICK_PERIOD_MS);
     }
@@ -12,6 +12,7 @@ typedef struct {
 
 int create_udp_socket();
 
+// Returns the connected socket, or -1 if it could not connect.
 int create_connect_tcp_socket(const char* server_ip, int server_port);
 
 #endif
\ No newline at end of file
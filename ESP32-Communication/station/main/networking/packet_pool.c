@@ -0,0 +1,79 @@
+#include "packet_pool.h"
+
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+
+static portMUX_TYPE packet_pool_lock = portMUX_INITIALIZER_UNLOCKED;
+#define PACKET_POOL_LOCK() portENTER_CRITICAL(&packet_pool_lock)
+#define PACKET_POOL_UNLOCK() portEXIT_CRITICAL(&packet_pool_lock)
+#define PACKET_POOL_ERROR(...) ESP_LOGE(TAG_PACKET_POOL, __VA_ARGS__)
+#else
+#include <stdio.h>
+#include <pthread.h>
+
+static pthread_mutex_t packet_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+#define PACKET_POOL_LOCK() pthread_mutex_lock(&packet_pool_lock)
+#define PACKET_POOL_UNLOCK() pthread_mutex_unlock(&packet_pool_lock)
+#define PACKET_POOL_ERROR(...) do { fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); } while (0)
+#endif
+
+static packet_t packets[PACKET_POOL_SIZE];
+
+// Stack of the free buffers
+static uint8_t free_packets[PACKET_POOL_SIZE];
+static int free_amount = 0;
+
+void packet_pool_init(void) {
+    PACKET_POOL_LOCK();
+    for (int i = 0; i < PACKET_POOL_SIZE; i++) {
+        packets[i].index = i;
+        packets[i].in_use = 0;
+        free_packets[i] = i;
+    }
+    free_amount = PACKET_POOL_SIZE;
+    PACKET_POOL_UNLOCK();
+}
+
+packet_t *packet_acquire(void) {
+    packet_t *packet = NULL;
+
+    PACKET_POOL_LOCK();
+    if (free_amount > 0) {
+        packet = &packets[free_packets[--free_amount]];
+    }
+    PACKET_POOL_UNLOCK();
+
+    if (packet != NULL) {
+        packet->length = 0;
+        packet->data[0] = '\0';
+        packet->source_ip = 0;
+        __atomic_store_n(&packet->in_use, 1, __ATOMIC_RELAXED);
+    }
+    return packet;
+}
+
+void packet_release(packet_t *packet) {
+    if (__atomic_exchange_n(&packet->in_use, 0, __ATOMIC_ACQ_REL) == 0) {
+        // Released twice, the buffer is in the pool already
+        PACKET_POOL_ERROR("Packet %d released while it was not in use", packet->index);
+        return;
+    }
+
+    PACKET_POOL_LOCK();
+    free_packets[free_amount++] = packet->index;
+    PACKET_POOL_UNLOCK();
+}
+
+int packet_set_length(packet_t *packet, int length) {
+    if (length < 0 || length >= PACKET_BUFFER_SIZE) {
+        packet->length = 0;
+        packet->data[0] = '\0';
+        return -1;
+    }
+    packet->length = length;
+    packet->data[length] = '\0';
+    return 0;
+}
@@ -0,0 +1,39 @@
+#ifndef PACKET_POOL_H
+#define PACKET_POOL_H
+
+/* Fixed pool of packet buffers for the laset port (7777). The receiver task takes a buffer from the pool, receives
+ * straight into it and passes the pointer through a queue to laset_listener_task, so the handoff between the two
+ * tasks is not a copy (payload_decoder still copies the fields out). The listener releases the buffer once it
+ * handled the packet. Buffers are not cleared when they are acquired, only the bytes up to length belong to the
+ * current packet. */
+
+#include <stdint.h>
+
+#define TAG_PACKET_POOL "LASET_PKTP"
+
+#define PACKET_POOL_SIZE 32
+// Committed blocks and snapshots (cbk, psn) are larger, they are received on the chain sync port instead
+#define PACKET_BUFFER_SIZE 512
+
+typedef struct {
+    char data[PACKET_BUFFER_SIZE];
+    int length;             // Bytes received, data[length] is always 0
+    uint32_t source_ip;     // Sender address in network byte order
+    uint32_t in_use;        // 1 from packet_acquire to packet_release
+    uint8_t index;          // Position in the pool
+} packet_t;
+
+// Fills the pool. Must be called before the first packet_acquire.
+void packet_pool_init(void);
+
+// Takes a free buffer, or returns NULL if all buffers are in use.
+packet_t *packet_acquire(void);
+
+// Returns the buffer to the pool. A buffer that is released twice is only returned once.
+void packet_release(packet_t *packet);
+
+// Sets the length after a receive and terminates the data, so it can be printed and parsed as a string.
+// Lengths outside 0 to PACKET_BUFFER_SIZE - 1 are set to 0. Returns 0, or -1 if the length was invalid.
+int packet_set_length(packet_t *packet, int length);
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef ESP_PLATFORM
+#define _GNU_SOURCE     // For the thread affinity functions
+#endif
+
+#include "task_plan.h"
+
+#include <stdlib.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_log.h"
+
+#define TASK_PLAN_CORE_AMOUNT portNUM_PROCESSORS
+#else
+#include <limits.h>
+#include <sched.h>
+#include <unistd.h>
+
+#define TASK_PLAN_CORE_AMOUNT ((int)sysconf(_SC_NPROCESSORS_ONLN))
+#endif
+
+static const int role_cores[TASK_ROLE_AMOUNT] = {
+    TASK_PLAN_NETWORK_CORE,
+    TASK_PLAN_CRYPTO_CORE,
+    TASK_PLAN_NETWORK_CORE,
+};
+
+static const int role_priorities[TASK_ROLE_AMOUNT] = {
+    TASK_PLAN_NETWORK_PRIORITY,
+    TASK_PLAN_CRYPTO_PRIORITY,
+    TASK_PLAN_BACKGROUND_PRIORITY,
+};
+
+static const char *role_names[TASK_ROLE_AMOUNT] = {
+    "network",
+    "crypto",
+    "background",
+};
+
+int task_plan_core(task_role_t role) {
+    if (role >= TASK_ROLE_AMOUNT) {
+        return 0;
+    }
+    int core_amount = TASK_PLAN_CORE_AMOUNT;
+    return (core_amount > 0) ? role_cores[role] % core_amount : 0;
+}
+
+int task_plan_priority(task_role_t role) {
+    return (role < TASK_ROLE_AMOUNT) ? role_priorities[role] : TASK_PLAN_BACKGROUND_PRIORITY;
+}
+
+const char *task_plan_role_name(task_role_t role) {
+    return (role < TASK_ROLE_AMOUNT) ? role_names[role] : "unknown";
+}
+
+#ifdef ESP_PLATFORM
+
+int task_plan_create(task_plan_function_t function, const char *name, uint32_t stack_size, void *param, task_role_t role, task_plan_handle_t *handle) {
+    BaseType_t created = xTaskCreatePinnedToCore(function, name, stack_size, param, task_plan_priority(role), handle, task_plan_core(role));
+    if (created != pdPASS) {
+        ESP_LOGE(TAG_TASK_PLAN, "Could not create task %s", name);
+        return -1;
+    }
+    ESP_LOGI(TAG_TASK_PLAN, "%s -> core %d, priority %d (%s)", name, task_plan_core(role), task_plan_priority(role), task_plan_role_name(role));
+    return 0;
+}
+
+int task_plan_apply_to_self(task_role_t role) {
+    // A running task cannot be moved to another core, only its priority changes
+    vTaskPrioritySet(NULL, task_plan_priority(role));
+    return 0;
+}
+
+#else
+
+typedef struct {
+    task_plan_function_t function;
+    void *param;
+} task_plan_start_t;
+
+static void *task_plan_thread(void *arg) {
+    task_plan_start_t start = *(task_plan_start_t *)arg;
+    free(arg);
+    start.function(start.param);
+    return NULL;
+}
+
+static void set_core(cpu_set_t *cpus, task_role_t role) {
+    CPU_ZERO(cpus);
+    CPU_SET(task_plan_core(role), cpus);
+}
+
+int task_plan_create(task_plan_function_t function, const char *name, uint32_t stack_size, void *param, task_role_t role, task_plan_handle_t *handle) {
+    (void)name;
+    pthread_attr_t attributes;
+    cpu_set_t cpus;
+    pthread_t thread;
+
+    task_plan_start_t *start = malloc(sizeof(task_plan_start_t));
+    if (start == NULL) {
+        return -1;
+    }
+    start->function = function;
+    start->param = param;
+
+    pthread_attr_init(&attributes);
+    set_core(&cpus, role);
+    pthread_attr_setaffinity_np(&attributes, sizeof(cpus), &cpus);
+    if (stack_size < PTHREAD_STACK_MIN) {
+        stack_size = PTHREAD_STACK_MIN;
+    }
+    pthread_attr_setstacksize(&attributes, stack_size);
+
+    int err = pthread_create(&thread, &attributes, task_plan_thread, start);
+    pthread_attr_destroy(&attributes);
+    if (err != 0) {
+        free(start);
+        return -1;
+    }
+
+    if (handle != NULL) {
+        *handle = thread;
+    }
+    return 0;
+}
+
+int task_plan_apply_to_self(task_role_t role) {
+    cpu_set_t cpus;
+    set_core(&cpus, role);
+    return (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0) ? 0 : -1;
+}
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef TASK_PLAN_H
+#define TASK_PLAN_H
+
+/* Scheduling plan of the station tasks. Every task gets a role, and the role decides the core it is pinned to and
+ * its priority. Networking runs next to the WiFi/lwIP tasks on core 0, the RSA and hashing heavy tasks on core 1,
+ * so packet handling does not wait behind signature checks.
+ * On host builds tasks are threads, and the core becomes the thread affinity (the priority is not used). */
+
+#include <stdint.h>
+
+#define TAG_TASK_PLAN "LASET_TASK"
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+// Cores and priorities of the roles, set under "LASET station" in menuconfig. On a single core chip every role
+// runs on core 0. The WiFi task runs at 23 and lwIP at 18, so all roles stay below them
+#ifdef CONFIG_LASET_TASK_NETWORK_CORE
+#define TASK_PLAN_NETWORK_CORE CONFIG_LASET_TASK_NETWORK_CORE
+#define TASK_PLAN_CRYPTO_CORE CONFIG_LASET_TASK_CRYPTO_CORE
+#define TASK_PLAN_NETWORK_PRIORITY CONFIG_LASET_TASK_NETWORK_PRIORITY
+#define TASK_PLAN_CRYPTO_PRIORITY CONFIG_LASET_TASK_CRYPTO_PRIORITY
+#define TASK_PLAN_BACKGROUND_PRIORITY CONFIG_LASET_TASK_BACKGROUND_PRIORITY
+#else
+#define TASK_PLAN_NETWORK_CORE 0
+#define TASK_PLAN_CRYPTO_CORE 1
+#define TASK_PLAN_NETWORK_PRIORITY 5
+#define TASK_PLAN_CRYPTO_PRIORITY 4
+#define TASK_PLAN_BACKGROUND_PRIORITY 1
+#endif
+
+typedef enum {
+    TASK_ROLE_NETWORK = 0,  // Receives and answers packets (listeners that mostly wait on sockets)
+    TASK_ROLE_CRYPTO,       // Verifies signatures, signs and hashes blocks
+    TASK_ROLE_BACKGROUND,   // Logging, metrics and the idle main task
+    TASK_ROLE_AMOUNT
+} task_role_t;
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+typedef TaskHandle_t task_plan_handle_t;
+#else
+#include <pthread.h>
+
+typedef pthread_t task_plan_handle_t;
+#endif
+
+typedef void (*task_plan_function_t)(void *param);
+
+// Core a role runs on, limited to the cores that exist.
+int task_plan_core(task_role_t role);
+
+// Priority of a role.
+int task_plan_priority(task_role_t role);
+
+// Name of a role, for printing.
+const char *task_plan_role_name(task_role_t role);
+
+// Creates a task pinned to the core of its role, with the priority of the role. handle can be NULL.
+// Returns 0 if the task was created, -1 if not.
+int task_plan_create(task_plan_function_t function, const char *name, uint32_t stack_size, void *param, task_role_t role, task_plan_handle_t *handle);
+
+// Moves the calling task to the priority of a role (on host builds also to its core). Returns 0 or -1.
+int task_plan_apply_to_self(task_role_t role);
+
+#endif
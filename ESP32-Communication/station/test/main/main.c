@@ -2,6 +2,7 @@
 #include "test_crypto.c"
 #include "test_lasetsockets.c"
 #include "test_wifi_connect.c"
+#include "test_auction.c"
 #include "unity.h"
 
 static void print_banner(const char* text) {
@@ -28,6 +29,9 @@ void app_main(void) {
   RUN_TEST(test_create_udp_socket);
   RUN_TEST(test_send_udp_message);
   RUN_TEST(test_payload_decoder);
+  RUN_TEST(test_auction_clear);
+  RUN_TEST(test_auction_pending);
+  RUN_TEST(test_auction_clock);
 
   // Stop the Unity framework 
   UNITY_END();
@@ -0,0 +1,147 @@
+#include "market/auction.h"
+#include "unity.h"
+
+static auction_order_t make_order(short node_id, short price, short duration) {
+  auction_order_t order = {.node_id = node_id, .price = price, .duration = duration};
+  memset(order.signature, node_id, sizeof(order.signature));
+  return order;
+}
+
+void test_auction_clear(void) {
+  auction_book_t book;
+  auction_result_t result;
+  auction_book_reset(&book, 42);
+
+  // Demand curve: 30s at 6, 20s at 4, 10s at 1
+  auction_order_t bid_1 = make_order(3, 6, 30);
+  auction_order_t bid_2 = make_order(5, 4, 20);
+  auction_order_t bid_3 = make_order(7, 1, 10);
+  // Supply curve: 20s at 2, 40s at 5
+  auction_order_t ask_1 = make_order(6, 2, 20);
+  auction_order_t ask_2 = make_order(4, 5, 40);
+
+  TEST_ASSERT_EQUAL_INT(0, auction_add_bid(&book, &bid_2));
+  TEST_ASSERT_EQUAL_INT(0, auction_add_bid(&book, &bid_3));
+  TEST_ASSERT_EQUAL_INT(0, auction_add_bid(&book, &bid_1));
+  TEST_ASSERT_EQUAL_INT(0, auction_add_ask(&book, &ask_2));
+  TEST_ASSERT_EQUAL_INT(0, auction_add_ask(&book, &ask_1));
+
+  // Shorter than a phase, so it is rejected
+  auction_order_t too_short = make_order(8, 3, 4);
+  TEST_ASSERT_EQUAL_INT(-1, auction_add_ask(&book, &too_short));
+
+  int allocation_amount = auction_clear(&book, &result);
+
+  // 20s from node 6 and 10s from node 4 to node 3. Node 5 (price 4) is below ask 5, so the sweep stops
+  TEST_ASSERT_EQUAL_INT(2, allocation_amount);
+  TEST_ASSERT_EQUAL_INT(30, result.cleared_duration);
+  TEST_ASSERT_EQUAL_INT((6 + 5) / 2, result.clearing_price);
+
+  TEST_ASSERT_EQUAL_INT(6, result.allocations[0].seller_node_id);
+  TEST_ASSERT_EQUAL_INT(3, result.allocations[0].buyer_node_id);
+  TEST_ASSERT_EQUAL_INT(20, result.allocations[0].duration);
+  TEST_ASSERT_EQUAL_MEMORY(ask_1.signature, result.allocations[0].seller_signature, SIGNATURE_SIZE / 2);
+  TEST_ASSERT_EQUAL_MEMORY(bid_1.signature, result.allocations[0].buyer_signature, SIGNATURE_SIZE / 2);
+
+  TEST_ASSERT_EQUAL_INT(4, result.allocations[1].seller_node_id);
+  TEST_ASSERT_EQUAL_INT(3, result.allocations[1].buyer_node_id);
+  TEST_ASSERT_EQUAL_INT(10, result.allocations[1].duration);
+}
+
+void test_auction_pending(void) {
+  auction_book_t book;
+  auction_result_t result;
+  auction_pending_t pending;
+  auction_book_reset(&book, 42);
+  auction_pending_init(&pending);
+
+  auction_order_t bid = make_order(3, 5, 15);
+  auction_order_t ask_1 = make_order(5, 1, 10);
+  auction_order_t ask_2 = make_order(6, 2, 10);
+  auction_add_bid(&book, &bid);
+  auction_add_ask(&book, &ask_1);
+  auction_add_ask(&book, &ask_2);
+  auction_clear(&book, &result);
+  TEST_ASSERT_EQUAL_INT(0, auction_pending_add(&pending, &result, 42));
+
+  // The seller of node 6 proposes its allocation at the uniform price
+  auction_pending_allocation_t allocation;
+  TEST_ASSERT_EQUAL_INT(-1, auction_pending_take(&pending, 3, &allocation));
+  TEST_ASSERT_EQUAL_INT(0, auction_pending_take(&pending, 6, &allocation));
+  TEST_ASSERT_EQUAL_INT(-1, auction_pending_take(&pending, 6, &allocation));
+
+  char previous_hash[SHA256_HASH_SIZE] = {0};
+  struct block_t *block = auction_create_block(&allocation, previous_hash);
+  TEST_ASSERT_EQUAL_INT(3, block->price);
+  TEST_ASSERT_EQUAL_INT(6, block->seller_node_id);
+  TEST_ASSERT_EQUAL_INT(3, block->buyer_node_id);
+  TEST_ASSERT_EQUAL_INT(5, block->duration);
+
+  // Another station that cleared the same orders recognises the block once
+  auction_pending_t other;
+  auction_pending_init(&other);
+  auction_pending_add(&other, &result, 42);
+  TEST_ASSERT_EQUAL_INT(0, auction_pending_claim(&other, block));
+  TEST_ASSERT_EQUAL_INT(-1, auction_pending_claim(&other, block));
+  // A synced block matches whether or not its allocation was claimed
+  TEST_ASSERT_EQUAL_INT(0, auction_pending_cleared(&other, block));
+
+  // A block at another price was not cleared
+  auction_pending_init(&other);
+  auction_pending_add(&other, &result, 42);
+  block->price = 4;
+  TEST_ASSERT_EQUAL_INT(-1, auction_pending_claim(&other, block));
+  TEST_ASSERT_EQUAL_INT(-1, auction_pending_cleared(&other, block));
+
+  free(block);
+}
+
+// Two stations that booted at different times number their slots the same once one heard the other's bca,
+// so each book takes the order the other station stamped
+void test_auction_clock(void) {
+  auction_clock_t clock_a, clock_b;
+  auction_clock_init(&clock_a);
+  auction_clock_init(&clock_b);
+  int64_t local_a = 600000;   // Booted ten minutes ago
+  int64_t local_b = 3000;
+
+  TEST_ASSERT_NOT_EQUAL(auction_slot_from_clock(auction_clock_now(&clock_a, local_a)),
+                        auction_slot_from_clock(auction_clock_now(&clock_b, local_b)));
+
+  // B hears A's time, A ignores B's time which is behind. Encoded like in a bca, arriving 20 ms later
+  uint8_t encoded[AUCTION_CLOCK_ENCODED_SIZE];
+  auction_clock_encode(auction_clock_now(&clock_a, local_a), encoded);
+  local_a += 20;
+  local_b += 20;
+  TEST_ASSERT_TRUE(auction_clock_observe(&clock_b, local_b, auction_clock_decode(encoded)));
+  auction_clock_encode(auction_clock_now(&clock_b, local_b), encoded);
+  TEST_ASSERT_FALSE(auction_clock_observe(&clock_a, local_a, auction_clock_decode(encoded)));
+
+  // Both stations stamp their own order and reset their book from their own clock
+  local_a += 1000;
+  local_b += 1000;
+  uint32_t slot_a = auction_slot_from_clock(auction_clock_now(&clock_a, local_a));
+  uint32_t slot_b = auction_slot_from_clock(auction_clock_now(&clock_b, local_b));
+  TEST_ASSERT_EQUAL_UINT32(slot_a, slot_b);
+
+  auction_book_t book_a, book_b;
+  auction_book_reset(&book_a, slot_a);
+  auction_book_reset(&book_b, slot_b);
+  auction_order_t ask = make_order(4, 2, 10);   // From station A
+  auction_order_t bid = make_order(7, 5, 10);   // From station B
+
+  // The listener drops orders for another slot, here both match
+  TEST_ASSERT_EQUAL_UINT32(book_b.slot, slot_a);
+  TEST_ASSERT_EQUAL_UINT32(book_a.slot, slot_b);
+  auction_add_ask(&book_a, &ask);
+  auction_add_bid(&book_a, &bid);
+  auction_add_ask(&book_b, &ask);
+  auction_add_bid(&book_b, &bid);
+
+  auction_result_t result_a, result_b;
+  TEST_ASSERT_EQUAL_INT(1, auction_clear(&book_a, &result_a));
+  TEST_ASSERT_EQUAL_INT(1, auction_clear(&book_b, &result_b));
+  TEST_ASSERT_EQUAL_INT(result_a.clearing_price, result_b.clearing_price);
+  TEST_ASSERT_EQUAL_INT(4, result_b.allocations[0].seller_node_id);
+  TEST_ASSERT_EQUAL_INT(7, result_b.allocations[0].buyer_node_id);
+}
@@ -1,4 +1,5 @@
 #include "networking/communication.c"
+#include "networking/hex.h"
 #include "unity.h"
 
 static int status_from_udp_server = -1;
@@ -120,28 +121,68 @@ void _test_payload_decoder_par() {
   payload_decoder(buffer, strlen(buffer), &data);
 
   TEST_ASSERT_EQUAL_INT(PROVIDE_AMPERAGE_READING, data.type);
-  TEST_ASSERT_EQUAL_INT(amperage, data.amperage);
+  TEST_ASSERT_EQUAL_INT(FIXED_FROM_INT(amperage), data.amperage);
 }
 
 void _test_payload_decoder_bca() {
-  // FORMAT: "bca,3,10,RAW_PUBLIC_KEY;"
+  // FORMAT: "bca,3,10,RAW_KEY_FINGERPRINT"
   struct broadcast_data_t data;
   char buffer[128] = {0};
 
-  // Note that the public key is not encoded. We append it last to the buffer
+  // Note that the fingerprint is not encoded. We append it last to the buffer
   sprintf(buffer, "bca,%i,%i,", node_id, amperage);
-  memcpy(&buffer[strlen(buffer)], random_public_key, PUBLIC_KEY_SIZE);
+  int header_size = strlen(buffer);
+  memcpy(&buffer[header_size], random_public_key, KEY_FINGERPRINT_SIZE);
 
-  payload_decoder(buffer, strlen(buffer), &data);
+  payload_decoder(buffer, header_size + KEY_FINGERPRINT_SIZE, &data);
 
   TEST_ASSERT_EQUAL_INT(BROADCAST_AMPERAGE, data.type);
   TEST_ASSERT_EQUAL_INT(node_id, data.node_id);
-  TEST_ASSERT_EQUAL_INT(amperage, data.amperage);
+  TEST_ASSERT_EQUAL_INT(FIXED_FROM_INT(amperage), data.amperage);
 
   // Because it is not encoded we must then compare it directly with our memory
+  TEST_ASSERT_EQUAL_MEMORY(random_public_key, data.key_fingerprint, KEY_FINGERPRINT_SIZE);
+}
+
+void _test_payload_decoder_rpk() {
+  // FORMAT: "rpk,3;"
+  struct broadcast_data_t data;
+  char buffer[128] = {0};
+
+  sprintf(buffer, "rpk,%i;", node_id);
+
+  payload_decoder(buffer, strlen(buffer), &data);
+
+  TEST_ASSERT_EQUAL_INT(REQUEST_PUBLIC_KEY, data.type);
+  TEST_ASSERT_EQUAL_INT(node_id, data.node_id);
+}
+
+void _test_payload_decoder_ppk() {
+  // FORMAT: "ppk,3,RAW_PUBLIC_KEY"
+  struct broadcast_data_t data;
+  char buffer[128] = {0};
+
+  sprintf(buffer, "ppk,%i,", node_id);
+  int header_size = strlen(buffer);
+  memcpy(&buffer[header_size], random_public_key, PUBLIC_KEY_SIZE);
+
+  payload_decoder(buffer, header_size + PUBLIC_KEY_SIZE, &data);
+
+  TEST_ASSERT_EQUAL_INT(PROVIDE_PUBLIC_KEY, data.type);
+  TEST_ASSERT_EQUAL_INT(node_id, data.node_id);
   TEST_ASSERT_EQUAL_MEMORY(random_public_key, data.public_key, PUBLIC_KEY_SIZE);
 }
 
+void _test_payload_decoder_dpr() {
+  // FORMAT: "dpr;"
+  struct broadcast_data_t data;
+  char buffer[16] = "dpr;";
+
+  payload_decoder(buffer, strlen(buffer), &data);
+
+  TEST_ASSERT_EQUAL_INT(REQUEST_PROFILE_DUMP, data.type);
+}
+
 void _test_payload_decoder_bcd() {
   // FORMAT: "bcd,3,13,32,SIGNATURE_IN_HEXADECIMAL_IN_ASCII;"
   struct broadcast_data_t data;
@@ -152,10 +193,10 @@ void _test_payload_decoder_bcd() {
   sprintf(buffer, "bcd,%i,%i,%i,", node_id, price, duration);
 
   // the signature is encoded as hexadecimal in ascii
-  for (size_t i = 0; i < sizeof(random_signature); i++) {
-    sprintf(buffer + strlen(buffer), "%02x", random_signature[i]);
-  }
-  sprintf(buffer + strlen(buffer), ";");
+  int length = hex_append(buffer, sizeof(buffer) - 1, random_signature, sizeof(random_signature));
+  TEST_ASSERT_GREATER_THAN_INT(0, length);
+  buffer[length++] = ';';
+  buffer[length] = '\0';
 
   payload_decoder(buffer, strlen(buffer), &data);
 
@@ -167,9 +208,7 @@ void _test_payload_decoder_bcd() {
   // We convert the returned signature for the payload decoder back to raw
   // format
   uint8_t signature_raw[64];
-  for (size_t i = 0; i < 64; i++) {
-    sscanf(data.signature + 2 * i, "%2hhx", &signature_raw[i]);
-  }
+  TEST_ASSERT_EQUAL_INT(64, hex_decode(data.signature, 128, signature_raw, 64));
 
   TEST_ASSERT_EQUAL_MEMORY(random_signature, signature_raw, 64);
 }
@@ -182,10 +221,10 @@ void _test_payload_decoder_atd() {
   sprintf(buffer, "atd,%i,", node_id);
 
   // the signature is encoded as hexadecimal in ascii
-  for (size_t i = 0; i < 64; ++i) {
-    sprintf(buffer + strlen(buffer), "%02x", random_signature[i]);
-  }
-  sprintf(buffer + strlen(buffer), ";");
+  int length = hex_append(buffer, sizeof(buffer) - 1, random_signature, sizeof(random_signature));
+  TEST_ASSERT_GREATER_THAN_INT(0, length);
+  buffer[length++] = ';';
+  buffer[length] = '\0';
 
   payload_decoder(buffer, strlen(buffer), &data);
 
@@ -195,9 +234,7 @@ void _test_payload_decoder_atd() {
   // We convert the returned signature for the payload decoder
   // back to raw format
   uint8_t signature_raw[64];
-  for (size_t i = 0; i < 64; i++) {
-    sscanf(data.signature + 2 * i, "%2hhx", &signature_raw[i]);
-  }
+  TEST_ASSERT_EQUAL_INT(64, hex_decode(data.signature, 128, signature_raw, 64));
 
   TEST_ASSERT_EQUAL_MEMORY(random_signature, signature_raw, 64);
 }
@@ -213,7 +250,7 @@ void _test_payload_decoder_plc() {
   payload_decoder(buffer, strlen(buffer), &data);
 
   TEST_ASSERT_EQUAL_INT(PROVIDE_LOAD_CALCULATION, data.type);
-  TEST_ASSERT_EQUAL_INT(estimated_grid, data.estimated_grid);
+  TEST_ASSERT_EQUAL_INT(FIXED_FROM_INT(estimated_grid), data.estimated_grid);
 }
 
 void test_payload_decoder(void) {
@@ -221,6 +258,9 @@ void test_payload_decoder(void) {
   _test_payload_decoder_pni();
   _test_payload_decoder_par();
   _test_payload_decoder_bca();
+  _test_payload_decoder_rpk();
+  _test_payload_decoder_ppk();
+  _test_payload_decoder_dpr();
   _test_payload_decoder_bcd();
   _test_payload_decoder_atd();
   _test_payload_decoder_plc();
@@ -15,7 +15,7 @@ s = socket.socket(socket.AF_INET,
 s.connect(('127.0.0.1', port))
 
 # Send a message to the server
-message = 'rql,3'
+message = 'rql,3;'
 s.sendall(message.encode('utf-8'))
 print("sending message")
 
@@ -0,0 +1,52 @@
+# Load tests a simulator server with many simulated stations over TCP.
+# Each station does "rni" once, then loops "rql" and "rlc" like a LASET module does.
+# Usage: python3 Testing/load_test.py [stations] [requests per station] [port]
+import selectors
+import socket
+import sys
+import time
+
+stations = int(sys.argv[1]) if len(sys.argv) > 1 else 200
+requests = int(sys.argv[2]) if len(sys.argv) > 2 else 50
+port = int(sys.argv[3]) if len(sys.argv) > 3 else 6666
+
+selector = selectors.DefaultSelector()
+state = {}
+
+for station in range(stations):
+    s = socket.create_connection(('127.0.0.1', port))
+    s.setblocking(False)
+    state[s] = {'sent': 0, 'node_id': None}
+    selector.register(s, selectors.EVENT_READ)
+    s.sendall(b'rni;')
+
+start = time.monotonic()
+replies = 0
+open_stations = stations
+
+while open_stations:
+    for key, _ in selector.select(timeout=5):
+        s = key.fileobj
+        data = s.recv(1024).decode('utf-8')
+        if not data:
+            raise SystemExit('Server closed a connection')
+        replies += 1
+        station = state[s]
+
+        if data.startswith('pni'):
+            station['node_id'] = int(data[4:].rstrip(';'))
+
+        if station['sent'] == requests:
+            selector.unregister(s)
+            s.close()
+            open_stations -= 1
+            continue
+
+        station['sent'] += 1
+        if station['sent'] % 2:
+            s.sendall(f"rql,{station['node_id']};".encode('utf-8'))
+        else:
+            s.sendall(b'rlc,10.000000,25.000000,-5.000000,3,6,-5.000000;')
+
+elapsed = time.monotonic() - start
+print(f'{stations} stations, {replies} replies in {elapsed:.2f} s ({replies / elapsed:.0f} replies/s)')
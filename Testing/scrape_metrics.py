@@ -0,0 +1,37 @@
+# Scrapes the metrics endpoint of every station and prints them with the station ip in front.
+# Usage: python3 Testing/scrape_metrics.py 192.168.0.101 192.168.0.102 ... [--port 9100]
+import socket
+import sys
+
+port = 9100
+stations = []
+args = sys.argv[1:]
+while args:
+    arg = args.pop(0)
+    if arg == '--port':
+        port = int(args.pop(0))
+    else:
+        stations.append(arg)
+
+
+def scrape(ip):
+    # The station writes all metrics and closes the connection
+    with socket.create_connection((ip, port), timeout=3) as s:
+        chunks = []
+        while True:
+            data = s.recv(4096)
+            if not data:
+                break
+            chunks.append(data)
+    return b''.join(chunks).decode('utf-8')
+
+
+for ip in stations:
+    try:
+        text = scrape(ip)
+    except OSError as e:
+        print(f'{ip} unreachable: {e}')
+        continue
+    for line in text.splitlines():
+        if not line.startswith('#'):
+            print(f'{ip} {line}')
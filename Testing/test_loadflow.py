@@ -0,0 +1,108 @@
+# Cross-checks the station's native load flow, and the Python stand-in (loadflow.py), against an independent
+# reference: nodal analysis solved with Newton-Raphson instead of the backward/forward sweep both of them use.
+# Usage: python3 Testing/test_loadflow.py <path to test_loadflow binary>
+import math
+import os
+import random
+import subprocess
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..'))
+
+import loadflow  # noqa: E402
+
+CASES = 500
+BASE_VOLTAGE = 230
+ROOT_NODE = 1
+
+random.seed(6666)
+# Same grid as GridSimulator.system
+system = [
+    [1, 2, .01],
+    [2, 3, .5],
+    [2, 4, .3],
+    [4, 5, .2],
+    [4, 6, .1],]
+
+
+
+def solve_linear(matrix, vector):
+    """Gaussian elimination with partial pivoting, matrix and vector are changed in place."""
+    size = len(vector)
+    for column in range(size):
+        pivot = max(range(column, size), key=lambda row: abs(matrix[row][column]))
+        matrix[column], matrix[pivot] = matrix[pivot], matrix[column]
+        vector[column], vector[pivot] = vector[pivot], vector[column]
+        for row in range(column + 1, size):
+            factor = matrix[row][column] / matrix[column][column]
+            for k in range(column, size):
+                matrix[row][k] -= factor * matrix[column][k]
+            vector[row] -= factor * vector[column]
+    solution = [0.0] * size
+    for row in reversed(range(size)):
+        solution[row] = (vector[row] - sum(matrix[row][k] * solution[k] for k in range(row + 1, size))) / matrix[row][row]
+    return solution
+
+
+def reference_estimate(amps, buyer, offer):
+    """
+    Every node but the root: sum of G * (V - V_neighbour) + P / V = 0, with constant power P = I * V_base.
+    Solved for the voltages with Newton-Raphson on the conductance matrix, so it shares no code or algorithm
+    with the sweep. Returns the estimate the way validator.py rounds it, or inf if it does not converge.
+    """
+    load = {index + 2: amperage for index, amperage in enumerate(amps)}
+    load[buyer] += abs(offer)
+    nodes = sorted({node for line in system for node in line[:2]} - {ROOT_NODE})
+    index = {node: i for i, node in enumerate(nodes)}
+
+    voltage = {node: float(BASE_VOLTAGE) for node in nodes + [ROOT_NODE]}
+    for _ in range(50):
+        mismatch = [load.get(node, 0) * BASE_VOLTAGE / voltage[node] for node in nodes]
+        jacobian = [[0.0] * len(nodes) for _ in nodes]
+        for i, node in enumerate(nodes):
+            jacobian[i][i] = -load.get(node, 0) * BASE_VOLTAGE / voltage[node] ** 2
+        for source, destination, resistance in system:
+            conductance = 1 / resistance
+            for node, other in ((source, destination), (destination, source)):
+                if node == ROOT_NODE:
+                    continue
+                mismatch[index[node]] += conductance * (voltage[node] - voltage[other])
+                jacobian[index[node]][index[node]] += conductance
+                if other != ROOT_NODE:
+                    jacobian[index[node]][index[other]] -= conductance
+
+        step = solve_linear(jacobian, [-value for value in mismatch])
+        for node, change in zip(nodes, step):
+            voltage[node] += change
+        if max(abs(change) for change in step) < 1e-10:
+            worst = max(abs(v - BASE_VOLTAGE) - BASE_VOLTAGE * 0.10 for v in voltage.values())
+            return round(max(0, worst), 4)
+    return math.inf
+
+
+cases = []
+for _ in range(CASES):
+    amps = [round(random.uniform(-40, 60), 3) for _ in range(5)]
+    buyer, seller = random.sample([3, 5, 6], 2)
+    offer = round(random.uniform(-60, 0), 3)
+    cases.append((amps, buyer, seller, offer))
+
+stdin = '\n'.join(' '.join(str(v) for v in amps + [buyer, seller, offer])
+                  for amps, buyer, seller, offer in cases)
+output = subprocess.run([sys.argv[1], '--cases'], input=stdin,
+                        capture_output=True, text=True, check=True).stdout.split()
+
+assert len(output) == CASES, f'expected {CASES} results, got {len(output)}'
+
+mismatches = 0
+for (amps, buyer, seller, offer), native in zip(cases, output):
+    expected = reference_estimate(amps, buyer, offer)
+    stand_in = loadflow.estimate_grid(BASE_VOLTAGE, amps, buyer, seller, offer, system)
+    for name, value in (('native', float(native)), ('loadflow.py', stand_in)):
+        if value != expected and not abs(value - expected) <= 1e-3:
+            mismatches += 1
+            print(f'MISMATCH {amps} buyer={buyer} seller={seller} offer={offer}: {name}={value} reference={expected}')
+
+violations = sum(1 for value in output if float(value) > 0)
+print(f'test_loadflow.py: {CASES} cases, {violations} overloaded, {mismatches} mismatches')
+sys.exit(1 if mismatches else 0)
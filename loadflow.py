@@ -0,0 +1,68 @@
+"""
+Pure Python backward/forward sweep. Stand-in for the Octave grid_estimate script, and the reference the
+station's native load flow (ESP32-Communication/station/main/grid/loadflow.c) is cross-checked against.
+"""
+
+VOLTAGE_TOLERANCE = 0.10    # Allowed deviation from the base voltage (+-10%, EN 50160)
+MAX_ITERATIONS = 100
+CONVERGENCE_V = 1e-6
+ROOT_NODE = 1
+
+
+def solve(base_voltage: float, load: dict, system: list):
+    """
+    Solves the radial grid. load maps node ID -> amperage at base voltage (negative when producing).
+    Returns a dict of node ID -> voltage, or None if the sweep does not converge.
+    """
+    parent = {}
+    resistance = {}
+    order = [ROOT_NODE]
+    for node in order:
+        for source, destination, r in system:
+            if source == node:
+                parent[destination] = source
+                resistance[destination] = r
+                order.append(destination)
+
+    power = {node: load.get(node, 0) * base_voltage for node in order}
+    voltage = {node: base_voltage for node in order}
+
+    for _ in range(MAX_ITERATIONS):
+        # Backward sweep
+        current = {node: 0.0 for node in order}
+        for node in reversed(order[1:]):
+            current[node] += power[node] / voltage[node]
+            current[parent[node]] += current[node]
+
+        # Forward sweep
+        largest_change = 0
+        for node in order[1:]:
+            new_voltage = voltage[parent[node]] - current[node] * resistance[node]
+            largest_change = max(largest_change, abs(new_voltage - voltage[node]))
+            voltage[node] = new_voltage
+
+        if largest_change < CONVERGENCE_V:
+            return voltage
+
+    return None
+
+
+def estimate_grid(base_voltage: int, I_amperage: list, buyer_index: float, seller_index: float, offer: float, system: list):
+    """
+    Same parameters as validator.estimate_grid. I_amperage is per cable (Cable ID := node ID - 1), so
+    I_amperage[0] is node 2. Returns how many volts the worst node is outside the allowed band (0 if none).
+    """
+    load = {index + 2: amperage for index, amperage in enumerate(I_amperage)}
+
+    # The buyer draws the seller's surplus on top of its own load
+    load[int(buyer_index)] = load.get(int(buyer_index), 0) + abs(offer)
+
+    voltage = solve(base_voltage, load, system)
+    if voltage is None:
+        return float('inf')
+
+    allowed_deviation = base_voltage * VOLTAGE_TOLERANCE
+    worst_violation = max(
+        [0] + [abs(v - base_voltage) - allowed_deviation for v in voltage.values()])
+
+    return round(worst_violation, 4)
@@ -10,6 +10,10 @@ class Server():
         self.simulator = GridSimulator()
         self.server_socket = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
         self.threads = {}
+        # node ID -> household socket, for households subscribed to amperage updates (sub)
+        self.subscribers = {}
+        self.send_locks = {}
+        self.simulator.amperage_listeners.append(self.push_amperage)
 
         self.port = port
         self.server_socket.setsockopt(
@@ -52,14 +56,29 @@ class Server():
                 print(e)
                 continue
 
+    def push_amperage(self, node_id, amperage):
+        """
+        Pushes a new amperage reading to the household subscribed to the node, if any.
+        """
+        LASET = self.subscribers.get(int(node_id))
+        if LASET is None:
+            return
+        try:
+            with self.send_locks[LASET]:
+                LASET.sendall(f'par,{amperage};'.encode('utf-8'))
+        except OSError:
+            self.subscribers.pop(int(node_id), None)
+
     def thread_handler(self, *args):
         LASET = args[0]
         LASET_addr = args[1]
+        self.send_locks[LASET] = threading.Lock()
 
         while True:
             try:
                 print("Awaiting content from household %s " % (LASET_addr,))
-                content = LASET.recv(1024).decode('utf-8')
+                # Requests end in ';'
+                content = LASET.recv(1024).decode('utf-8').strip().rstrip(';')
 
                 # Get header from content
                 header = content.split(',')[0]
@@ -74,6 +93,13 @@ class Server():
                         amperage = self.simulator.get_amperage_by_node(node_id)
                         message = f'par,{amperage};'
 
+                    case 'sub':
+                        # Reply with the current reading now, and push the next ones when they change
+                        node_id = int(content.split(',')[1])
+                        self.subscribers[node_id] = LASET
+                        amperage = self.simulator.get_amperage_by_node(node_id)
+                        message = f'par,{amperage};'
+
                     case 'rlc':
                         amp1, amp2, amp3, buyer_index, seller_index, offer = content.split(',')[
                             1:]
@@ -91,7 +117,8 @@ class Server():
                         break
 
                 # Send node ID back to household
-                LASET.sendall(message.encode('utf-8'))
+                with self.send_locks[LASET]:
+                    LASET.sendall(message.encode('utf-8'))
                 print("Sent %s to household (node %s)" %
                       (message, node_id))
                 print("")
@@ -21,6 +21,8 @@ class GridSimulator():
         self.I_amperage = [[2, 0], [3, 0], [4, 0], [5, 0], [6, 0]]
         self.available_nodes = [3, 5, 6]
         self.taken_nodes = []
+        # Called with (node ID, amperage) whenever the amperage of a node changes
+        self.amperage_listeners = []
 
         # init octave!
         self.oc = initialize_octave()
@@ -30,8 +32,13 @@ class GridSimulator():
         Update amperage in amps per household and calculate new grid values (Cable ID := node ID - 1)
         """
         for index, _ in enumerate(self.I_amperage):
+            if self.I_amperage[index][1] == amperage[index]:
+                continue
             self.I_amperage[index][1] = amperage[index]
 
+            for listener in self.amperage_listeners:
+                listener(self.I_amperage[index][0], amperage[index])
+
     def get_amperage_by_node(self, node_id: int):
         """
         Gets the amperage in amps for a specific household based on its node id - Used for the server reply to household!